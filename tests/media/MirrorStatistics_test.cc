@@ -0,0 +1,98 @@
+#include <fstream>
+#include <boost/test/unit_test.hpp>
+
+#include <zypp-curl/MirrorStatistics>
+#include <zypp-core/fs/TmpPath.h>
+#include <zypp-core/fs/PathInfo.h>
+
+using namespace zypp;
+using namespace zypp::media;
+
+BOOST_AUTO_TEST_CASE(mirrorstats_store_and_merge)
+{
+  filesystem::TmpDir tmp;
+  MirrorStatistics stats( tmp.path() / "mirrorstats.d" );
+
+  const Url mirror( "https://mirror.example.org/pub/opensuse/" );
+  BOOST_CHECK( !stats.lookup( mirror ) );
+
+  MirrorStatistics::Entry sample;
+  sample.latencyMs      = 100;
+  sample.bytesPerSecond = 4000;
+  sample.successes      = 2;
+  BOOST_REQUIRE( stats.update( mirror, sample ) );
+
+  // keyed by scheme, host and port only
+  auto entry = MirrorStatistics( tmp.path() / "mirrorstats.d" ).lookup( Url("https://mirror.example.org/other/path") );
+  BOOST_REQUIRE( entry );
+  BOOST_CHECK_EQUAL( entry->latencyMs, 100 );
+  BOOST_CHECK_EQUAL( entry->bytesPerSecond, 4000 );
+  BOOST_CHECK_EQUAL( entry->failures, 0 );
+  BOOST_CHECK_EQUAL( entry->successes, 2 );
+  BOOST_CHECK( !stats.lookup( Url("http://mirror.example.org/pub/opensuse/") ) );
+
+  // values are smoothed, unknown values keep the stored ones
+  sample.latencyMs      = 500;
+  sample.bytesPerSecond = 0;
+  sample.failures       = 1;
+  sample.successes      = 1;
+  BOOST_REQUIRE( stats.update( mirror, sample ) );
+  entry = stats.lookup( mirror );
+  BOOST_REQUIRE( entry );
+  BOOST_CHECK_EQUAL( entry->latencyMs, 200 );
+  BOOST_CHECK_EQUAL( entry->bytesPerSecond, 4000 );
+  BOOST_CHECK_EQUAL( entry->failures, 1 );
+  BOOST_CHECK_EQUAL( entry->successes, 3 );
+}
+
+BOOST_AUTO_TEST_CASE(mirrorstats_expire)
+{
+  filesystem::TmpDir tmp;
+  const Url mirror( "http://mirror.example.org:8080/" );
+  {
+    std::ofstream out( ( tmp.path() / MirrorStatistics::makeKey( mirror ) ).c_str() );
+    out << "100 4000 0 1 " << ( ::time( nullptr ) - 3600 ) << std::endl;
+  }
+
+  BOOST_CHECK( MirrorStatistics( tmp.path() ).lookup( mirror ) );
+  BOOST_CHECK( !MirrorStatistics( tmp.path(), std::chrono::minutes(30) ).lookup( mirror ) );
+  // looking up does not touch the cache
+  BOOST_CHECK( PathInfo( tmp.path() / MirrorStatistics::makeKey( mirror ) ).isExist() );
+
+  // the writer removes expired entries
+  MirrorStatistics( tmp.path() ).removeExpired();
+  BOOST_CHECK( PathInfo( tmp.path() / MirrorStatistics::makeKey( mirror ) ).isExist() );
+  MirrorStatistics( tmp.path(), std::chrono::minutes(30) ).removeExpired();
+  BOOST_CHECK( !PathInfo( tmp.path() / MirrorStatistics::makeKey( mirror ) ).isExist() );
+}
+
+BOOST_AUTO_TEST_CASE(mirrorstats_sort)
+{
+  filesystem::TmpDir tmp;
+  MirrorStatistics stats( tmp.path() );
+
+  const Url failing( "http://failing.example.org/" );
+  const Url unknown1( "http://unknown1.example.org/" );
+  const Url slow( "http://slow.example.org/" );
+  const Url unknown2( "http://unknown2.example.org/" );
+  const Url fast( "http://fast.example.org/" );
+
+  MirrorStatistics::Entry sample;
+  sample.latencyMs = 10;
+  sample.failures  = 5;
+  stats.update( failing, sample );
+  sample.failures  = 0;
+  sample.bytesPerSecond = 100 * 1024;
+  stats.update( slow, sample );
+  sample.bytesPerSecond = 10 * 1024 * 1024;
+  stats.update( fast, sample );
+
+  std::vector<Url> urls { failing, unknown1, slow, unknown2, fast };
+  stats.sortUrls( urls );
+  BOOST_REQUIRE_EQUAL( urls.size(), 5 );
+  BOOST_CHECK_EQUAL( urls[0], fast );
+  BOOST_CHECK_EQUAL( urls[1], slow );
+  BOOST_CHECK_EQUAL( urls[2], unknown1 );
+  BOOST_CHECK_EQUAL( urls[3], unknown2 );
+  BOOST_CHECK_EQUAL( urls[4], failing );
+}
@@ -0,0 +1,163 @@
+#include <boost/test/unit_test.hpp>
+
+#include <zypp/base/Logger.h>
+#include <zypp/TmpPath.h>
+#include <zypp/PathInfo.h>
+#include <zypp/PoolQuery.h>
+#include <zypp/RepoManager.h>
+#include <zypp/ResPool.h>
+#include <zypp/Resolver.h>
+#include <zypp/ZYppFactory.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/PoolSnapshot.h>
+#include <zypp/sat/LookupAttr.h>
+
+#include "KeyRingTestReceiver.h"
+
+#define BOOST_TEST_MODULE LazyFilelists
+
+using std::endl;
+using namespace zypp;
+
+namespace
+{
+  const std::string notInPrimary( "/opt/gnome/include/libglabels/paper.h" );
+
+  unsigned lookupFile( const std::string & file_r )
+  {
+    unsigned ret = 0;
+    for_( it, sat::LookupAttr( sat::SolvAttr::filelist ).begin(), sat::LookupAttr( sat::SolvAttr::filelist ).end() )
+      if ( it.asString() == file_r )
+        ++ret;
+    return ret;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(filelists_on_demand)
+{
+  getZYpp();
+  ZConfig::instance().setSystemArchitecture( Arch("i586") );
+  sat::Pool satpool( sat::Pool::instance() );
+
+  filesystem::TmpDir tmp;
+  RepoManagerOptions opts( RepoManagerOptions::makeTestSetup( tmp.path() ) );
+  RepoManager mgr( opts );
+
+  KeyRingTestReceiver keyring_callbacks;
+  KeyRingTestSignalReceiver receiver;
+  keyring_callbacks.answerAcceptKey( KeyRingReport::KEY_TRUST_TEMPORARILY );
+  keyring_callbacks.answerAcceptVerFailed( true );
+  keyring_callbacks.answerAcceptUnknownKey( true );
+
+  RepoInfo info;
+  info.setAlias( "updates" );
+  info.addBaseUrl( Pathname( TESTS_SRC_DIR "/repo/yum/data/10.2-updates-subset" ).asUrl() );
+  mgr.refreshMetadata( info );
+  mgr.buildCache( info );
+  mgr.loadFromCache( info );
+  BOOST_REQUIRE( ! satpool.reposEmpty() );
+
+  // primary lists just a few files
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 0 );
+
+  // a filelist query just searches the loaded filelists
+  PoolQuery q;
+  q.addAttribute( sat::SolvAttr::filelist, notInPrimary );
+  q.setMatchExact();
+  q.setFilesMatchFullpath();
+  BOOST_CHECK( q.empty() );
+  BOOST_CHECK( ! PathInfo( opts.repoRawCachePath / info.escaped_alias() / "repodata/filelists.xml.gz" ).isExist() );
+
+  // fetched on request
+  BOOST_CHECK( satpool.provideFilelists() );
+  BOOST_CHECK( lookupFile( notInPrimary ) );
+  BOOST_CHECK( ! q.empty() );
+  BOOST_CHECK( PathInfo( opts.repoRawCachePath / info.escaped_alias() / "repodata/filelists.xml.gz" ).isFile() );
+
+  // only once
+  BOOST_CHECK( ! satpool.provideFilelists() );
+
+  // a reloaded repo takes them from the raw cache
+  satpool.reposEraseAll();
+  mgr.loadFromCache( info );
+  BOOST_CHECK( satpool.provideFilelists() );
+  BOOST_CHECK( lookupFile( notInPrimary ) );
+
+  // the pool snapshot does not keep the filelists added after loading
+  sat::PoolSnapshot::saveRemembered();
+  BOOST_REQUIRE( PathInfo( opts.repoSolvCachePath / sat::PoolSnapshot::defaultFile ).isFile() );
+  satpool.reposEraseAll();
+  mgr.loadFromCache( info );
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 0 );
+  BOOST_CHECK( satpool.provideFilelists() );
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(filelists_for_the_resolver)
+{
+  getZYpp();
+  ZConfig::instance().setSystemArchitecture( Arch("i586") );
+  sat::Pool satpool( sat::Pool::instance() );
+  satpool.reposEraseAll();
+
+  filesystem::TmpDir tmp;
+  RepoManagerOptions opts( RepoManagerOptions::makeTestSetup( tmp.path() ) );
+  RepoManager mgr( opts );
+
+  KeyRingTestReceiver keyring_callbacks;
+  KeyRingTestSignalReceiver receiver;
+  keyring_callbacks.answerAcceptKey( KeyRingReport::KEY_TRUST_TEMPORARILY );
+  keyring_callbacks.answerAcceptVerFailed( true );
+  keyring_callbacks.answerAcceptUnknownKey( true );
+
+  // The same repo twice, the one with the higher priority is asked first.
+  RepoInfo low;
+  low.setAlias( "low" );
+  low.setPriority( 99 );
+  RepoInfo high;
+  high.setAlias( "high" );
+  high.setPriority( 10 );
+  for ( RepoInfo * info : { &low, &high } )
+  {
+    info->addBaseUrl( Pathname( TESTS_SRC_DIR "/repo/yum/data/10.2-updates-subset" ).asUrl() );
+    mgr.refreshMetadata( *info );
+    mgr.buildCache( *info );
+    mgr.loadFromCache( *info );
+  }
+  // file requirements in primary's subset (/bin/sh) don't need the filelists
+  BOOST_CHECK( ! satpool.provideNeededFilelists() );
+
+  Repository repo( satpool.addRepoHelix( TESTS_SRC_DIR "/repo/yum/data/lazyfilelists/needsfile.xml", "needsfile" ) );
+  BOOST_REQUIRE_EQUAL( repo.solvablesSize(), 1 );
+  PoolItem needsfile( *repo.solvablesBegin() );
+  needsfile.status().setToBeInstalled( ResStatus::USER );
+
+  // no repo may provide the file yet
+  BOOST_CHECK( ! satpool.provideNeededFilelists() );
+
+  // the installed glabels owns another file in its directory
+  satpool.systemRepo().addTesttags( TESTS_SRC_DIR "/repo/yum/data/lazyfilelists/installed.testtags" );
+
+  // the resolver fetches nothing unless asked to
+  BOOST_REQUIRE( ! ZConfig::instance().solverFetchFilelists() );
+  getZYpp()->resolver()->resolvePool();
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 0 );
+
+  // resolving fetches just the filelists of 'high'
+  ZConfig::instance().solverFetchFilelists( true );
+  BOOST_REQUIRE( getZYpp()->resolver()->resolvePool() );
+  ZConfig::instance().solverFetchFilelists( false );
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 1 );
+  BOOST_CHECK( PathInfo( opts.repoRawCachePath / "high" / "repodata/filelists.xml.gz" ).isFile() );
+  BOOST_CHECK( ! PathInfo( opts.repoRawCachePath / "low" / "repodata/filelists.xml.gz" ).isExist() );
+
+  bool glabels = false;
+  for ( const PoolItem & pi : ResPool::instance().byIdent( ResKind::package, "glabels" ) )
+    if ( pi.status().isToBeInstalled() )
+      glabels = true;
+  BOOST_CHECK( glabels );
+
+  // the others are still fetched on demand
+  BOOST_CHECK( satpool.provideFilelists() );
+  BOOST_CHECK_EQUAL( lookupFile( notInPrimary ), 2 );
+}
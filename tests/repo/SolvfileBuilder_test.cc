@@ -0,0 +1,91 @@
+#include <iostream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C"
+{
+#include <solv/solvversion.h>
+}
+
+#include <zypp/base/LogTools.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/RepoInfo.h>
+#include <zypp/Repository.h>
+#include <zypp/Package.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/LookupAttr.h>
+#include <zypp/repo/RepoException.h>
+#include <zypp/repo/SolvfileBuilder.h>
+#include <zypp/sat/TrigramIndex.h>
+
+using namespace zypp;
+using namespace zypp::repo;
+
+namespace
+{
+  /** Build the solv file for \a dir_r and load it into the pool as \a alias_r. */
+  Repository buildAndLoad( const filesystem::TmpDir & tmp_r, const std::string & alias_r, const RepoType & type_r, const Pathname & dir_r )
+  {
+    RepoInfo info;
+    info.setAlias( alias_r );
+    const Pathname solvfile( tmp_r.path() / "solv" );
+    buildSolvFile( info, type_r, dir_r, solvfile, true );
+
+    BOOST_REQUIRE( PathInfo( solvfile ).isFile() );
+    BOOST_CHECK( PathInfo( solvfile.extend( ".idx" ) ).isFile() );
+    BOOST_CHECK( PathInfo( sat::TrigramIndex::indexFile( solvfile ) ).isFile() );
+    return sat::Pool::instance().addRepoSolv( solvfile, info );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(rpmmd)
+{
+  filesystem::TmpDir tmp;
+  Repository repo( buildAndLoad( tmp, "rpmmd", RepoType::RPMMD, Pathname(TESTS_SRC_DIR) / "repo/yum/data/extensions" ) );
+
+  BOOST_CHECK_EQUAL( repo.generatedTimestamp(), Date(1227279057) );
+  BOOST_CHECK_EQUAL( repo.solvablesSize(), 16 );
+  // loadFromCache rebuilds the cache if the stamp does not match
+  BOOST_CHECK_EQUAL( sat::LookupRepoAttr( sat::SolvAttr::repositoryToolVersion, repo ).begin().asString(), LIBSOLV_TOOLVERSION );
+  sat::Pool::instance().reposErase( "rpmmd" );
+}
+
+BOOST_AUTO_TEST_CASE(rpmmd_partial_raw_cache)
+{
+  // refresh does not download filelists and other by default
+  filesystem::TmpDir tmp;
+  const Pathname raw( tmp.path() / "raw" );
+  filesystem::assert_dir( raw );
+  BOOST_REQUIRE_EQUAL( filesystem::copy_dir_content( Pathname(TESTS_SRC_DIR) / "repo/yum/data/extensions", raw ), 0 );
+  filesystem::unlink( raw / "repodata/filelists.xml.gz" );
+  filesystem::unlink( raw / "repodata/other.xml.gz" );
+
+  Repository repo( buildAndLoad( tmp, "partial", RepoType::RPMMD, raw ) );
+  BOOST_CHECK_EQUAL( repo.solvablesSize(), 16 );
+  sat::Pool::instance().reposErase( "partial" );
+}
+
+BOOST_AUTO_TEST_CASE(susetags)
+{
+  filesystem::TmpDir tmp;
+  Repository repo( buildAndLoad( tmp, "susetags", RepoType::YAST2, Pathname(TESTS_SRC_DIR) / "repo/susetags/data/stable-x86-subset" ) );
+
+  unsigned packages = 0;
+  for ( const sat::Solvable & solv : repo.solvables() )
+  {
+    if ( solv.isKind<Package>() && solv.name() == "kdelibs3" )
+      ++packages;
+  }
+  BOOST_CHECK_EQUAL( packages, 1 );
+  sat::Pool::instance().reposErase( "susetags" );
+}
+
+BOOST_AUTO_TEST_CASE(missing_metadata)
+{
+  filesystem::TmpDir tmp;
+  RepoInfo info;
+  info.setAlias( "missing" );
+  BOOST_CHECK_THROW( buildSolvFile( info, RepoType::RPMMD, tmp.path() / "nothere", tmp.path() / "solv", false ), RepoException );
+}
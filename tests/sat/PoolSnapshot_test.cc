@@ -0,0 +1,146 @@
+#include <fstream>
+#include <utime.h>
+#include <boost/test/unit_test.hpp>
+
+#include <zypp/base/Logger.h>
+#include <zypp/TmpPath.h>
+#include <zypp/PathInfo.h>
+#include <zypp/RepoManager.h>
+#include <zypp/ZYppFactory.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/PoolSnapshot.h>
+#include <zypp/sat/LookupAttr.h>
+
+#include "KeyRingTestReceiver.h"
+
+#define BOOST_TEST_MODULE PoolSnapshot
+
+using std::endl;
+using namespace zypp;
+
+BOOST_AUTO_TEST_CASE(snapshot)
+{
+  getZYpp();
+  ZConfig::instance().setSystemArchitecture( Arch("i586") );
+  sat::Pool satpool( sat::Pool::instance() );
+
+  filesystem::TmpDir tmp;
+  RepoManagerOptions opts( RepoManagerOptions::makeTestSetup( tmp.path() ) );
+  RepoManager mgr( opts );
+
+  KeyRingTestReceiver keyring_callbacks;
+  KeyRingTestSignalReceiver receiver;
+  keyring_callbacks.answerAcceptKey( KeyRingReport::KEY_TRUST_TEMPORARILY );
+  keyring_callbacks.answerAcceptVerFailed( true );
+  keyring_callbacks.answerAcceptUnknownKey( true );
+
+  RepoInfo info;
+  info.setAlias( "updates" );
+  info.addBaseUrl( Pathname( TESTS_SRC_DIR "/repo/yum/data/10.2-updates-subset" ).asUrl() );
+  mgr.buildCache( info );
+  mgr.loadFromCache( info );
+
+  const Pathname solvfile( opts.repoSolvCachePath / info.escaped_alias() / "solv" );
+  const Pathname snapshot( tmp.path() / "pool.snapshot" );
+  const sat::PoolSnapshot::Entry entry( solvfile, info );
+
+  const sat::Pool::size_type solvables = satpool.solvablesSize();
+  BOOST_REQUIRE( solvables );
+  sat::PoolSnapshot::save( snapshot, { entry } );
+  BOOST_CHECK( PathInfo( snapshot ).isFile() );
+
+  // the repo must not be loaded
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+
+  satpool.reposEraseAll();
+  BOOST_REQUIRE( sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+  BOOST_CHECK_EQUAL( satpool.solvablesSize(), solvables );
+  BOOST_CHECK_EQUAL( satpool.reposFind( "updates" ).info().alias(), "updates" );
+  satpool.prepare();
+
+  // other repo wanted
+  satpool.reposEraseAll();
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, sat::PoolSnapshot::Entry::systemRepo( solvfile ) ) );
+  BOOST_CHECK( satpool.reposEmpty() );
+
+  // repo cache changed
+  {
+    std::ofstream cookie( ( solvfile.dirname() / "cookie" ).c_str(), std::ios_base::app );
+    cookie << "changed" << endl;
+  }
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+  BOOST_CHECK( satpool.reposEmpty() );
+
+  // damaged
+  {
+    std::ofstream file( snapshot.c_str(), std::ios_base::app );
+    file << "garbage";
+  }
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+  BOOST_CHECK( satpool.reposEmpty() );
+}
+
+BOOST_AUTO_TEST_CASE(load_from_cache)
+{
+  getZYpp();
+  ZConfig::instance().setSystemArchitecture( Arch("i586") );
+  sat::Pool satpool( sat::Pool::instance() );
+  satpool.reposEraseAll();
+
+  filesystem::TmpDir tmp;
+  RepoManagerOptions opts( RepoManagerOptions::makeTestSetup( tmp.path() ) );
+  RepoManager mgr( opts );
+
+  KeyRingTestReceiver keyring_callbacks;
+  KeyRingTestSignalReceiver receiver;
+  keyring_callbacks.answerAcceptKey( KeyRingReport::KEY_TRUST_TEMPORARILY );
+  keyring_callbacks.answerAcceptVerFailed( true );
+  keyring_callbacks.answerAcceptUnknownKey( true );
+
+  RepoInfo info;
+  info.setAlias( "updates" );
+  info.addBaseUrl( Pathname( TESTS_SRC_DIR "/repo/yum/data/10.2-updates-subset" ).asUrl() );
+  mgr.buildCache( info );
+
+  const Pathname snapshot( opts.repoSolvCachePath / sat::PoolSnapshot::defaultFile );
+  const sat::PoolSnapshot::Entry entry( opts.repoSolvCachePath / info.escaped_alias() / "solv", info );
+  const sat::SolvAttr addedFileProvides( "repository:addedfileprovides" );
+
+  // loaded from the solv file, the snapshot is written on request, not when the pool is prepared
+  mgr.loadFromCache( info );
+  satpool.prepare();
+  BOOST_CHECK( ! PathInfo( snapshot ).isExist() );
+  sat::PoolSnapshot::saveRemembered();
+  BOOST_REQUIRE( PathInfo( snapshot ).isFile() );
+  // a copy was written, the repo in the pool is unchanged
+  BOOST_CHECK( sat::LookupRepoAttr( addedFileProvides, satpool.reposFind( "updates" ) ).empty() );
+  const sat::Pool::size_type solvables = satpool.solvablesSize();
+  const unsigned long long written = PathInfo( snapshot ).ino();
+
+  // already in the pool
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+
+  satpool.reposEraseAll();
+  BOOST_REQUIRE( sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+  BOOST_CHECK_EQUAL( satpool.solvablesSize(), solvables );
+
+  // loadFromCache takes it from the snapshot, which is not rewritten
+  satpool.reposEraseAll();
+  mgr.loadFromCache( info );
+  BOOST_CHECK_EQUAL( satpool.solvablesSize(), solvables );
+  BOOST_CHECK_EQUAL( satpool.reposFind( "updates" ).info().alias(), "updates" );
+  sat::PoolSnapshot::saveRemembered();
+  BOOST_CHECK_EQUAL( PathInfo( snapshot ).ino(), written );
+
+  // a changed solv file invalidates the snapshot, it's rewritten after loading
+  satpool.reposEraseAll();
+  struct utimbuf past { 1000000000, 1000000000 };
+  BOOST_REQUIRE( ::utime( entry._solvfile.c_str(), &past ) == 0 );
+  BOOST_CHECK( ! sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+  BOOST_CHECK( satpool.reposEmpty() );
+  mgr.loadFromCache( info );
+  sat::PoolSnapshot::saveRemembered();
+  BOOST_CHECK( PathInfo( snapshot ).ino() != written );
+  satpool.reposEraseAll();
+  BOOST_CHECK( sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+}
@@ -0,0 +1,147 @@
+#include <boost/test/unit_test.hpp>
+
+#include <zypp/base/Logger.h>
+#include <zypp/ResPool.h>
+#include <zypp/sat/SolverSnapshot.h>
+#include "TestSetup.h"
+
+#define BOOST_TEST_MODULE SolverSnapshot
+
+using std::endl;
+using namespace zypp;
+
+static TestSetup test( TestSetup::initLater );
+static misc::testcase::LoadTestcase::TestcaseTrials trials;
+
+struct TestInit {
+  TestInit() {
+    test = TestSetup();
+    test.loadTestcaseRepos( TESTS_SRC_DIR"/data/TCSolverSnapshot", &trials );
+  }
+  ~TestInit() { test.reset(); }
+};
+BOOST_GLOBAL_FIXTURE( TestInit );
+
+inline PoolItem getPi( const std::string & name_r, bool installed_r )
+{
+  for ( const auto & pi : test.pool().byName( name_r ) )
+  { if ( pi.isSystem() == installed_r ) return pi; }
+  BOOST_FAIL( "Not in pool: " << name_r );
+  return PoolItem();
+}
+
+inline sat::detail::IdType install( const PoolItem & pi_r )
+{ return pi_r.id(); }
+inline sat::detail::IdType erase( const PoolItem & pi_r )
+{ return -install( pi_r ); }
+
+inline std::set<sat::detail::IdType> decisions( const sat::SolverSnapshot::Result & result_r )
+{ return { result_r._decisions.begin(), result_r._decisions.end() }; }
+
+BOOST_AUTO_TEST_CASE(whatif)
+{
+  PoolItem Ip	{ getPi( "aspell", true ) };
+  PoolItem Ap	{ getPi( "aspell", false ) };
+  PoolItem Apde	{ getPi( "aspell-de", false ) };
+  PoolItem Aprec	{ getPi( "recommended-pkg", false ) };
+
+  sat::SolverSnapshot snapshot;
+  BOOST_CHECK( snapshot.valid() );
+  BOOST_CHECK( snapshot.size() );
+
+  std::vector<sat::SolverSnapshot::Request> requests( 4 );
+  requests[0]._name = "update";
+  requests[0]._install.push_back( Ap.satSolvable() );
+  requests[1]._name = "onlyRequires";
+  requests[1]._install.push_back( Ap.satSolvable() );
+  requests[1]._onlyRequires = true;
+  requests[2]._name = "remove";
+  requests[2]._remove.push_back( Ip.satSolvable() );
+  requests[3]._name = "locked";
+  requests[3]._install.push_back( Ap.satSolvable() );
+  requests[3]._lock.push_back( Ip.satSolvable() );
+
+  std::vector<sat::SolverSnapshot::Result> results { snapshot.solve( requests, 2 ) };
+  BOOST_REQUIRE_EQUAL( results.size(), requests.size() );
+
+  BOOST_CHECK_EQUAL( results[0]._name, "update" );
+  BOOST_CHECK( results[0].ok() );
+  BOOST_CHECK( decisions( results[0] ) == std::set<sat::detail::IdType>({ install(Ap), erase(Ip), install(Apde), install(Aprec) }) );
+
+  BOOST_CHECK( results[1].ok() );
+  BOOST_CHECK( decisions( results[1] ) == std::set<sat::detail::IdType>({ install(Ap), erase(Ip), install(Apde) }) );
+
+  BOOST_CHECK( results[2].ok() );
+  BOOST_CHECK( decisions( results[2] ).count( erase(Ip) ) );
+
+  BOOST_CHECK( ! results[3].ok() );
+  BOOST_CHECK( results[3]._decisions.empty() );
+
+  // the global pool is untouched
+  for ( const PoolItem & pi : test.pool() )
+    BOOST_CHECK( ! pi.status().transacts() );
+
+  // same results when solving in the calling thread
+  for ( unsigned i = 0; i < requests.size(); ++i )
+  {
+    sat::SolverSnapshot::Result single { snapshot.solve( requests[i] ) };
+    BOOST_CHECK_EQUAL( single.ok(), results[i].ok() );
+    BOOST_CHECK( decisions( single ) == decisions( results[i] ) );
+  }
+
+  sat::Transaction trans { results[0].transaction() };
+  BOOST_CHECK( trans.valid() );
+  BOOST_CHECK( trans.find( Ap )->stepType() == sat::Transaction::TRANSACTION_INSTALL );
+  BOOST_CHECK( results[3].transaction().empty() );
+}
+
+/** The transaction \ref Resolver::resolvePool computes for \a request_r. */
+inline std::set<sat::detail::IdType> resolvePool( const sat::SolverSnapshot::Request & request_r, bool & ok_r )
+{
+  for ( const sat::Solvable & solv : request_r._install )
+    PoolItem( solv ).status().setTransact( true, ResStatus::USER );
+  for ( const sat::Solvable & solv : request_r._remove )
+    PoolItem( solv ).status().setTransact( true, ResStatus::USER );
+  for ( const sat::Solvable & solv : request_r._lock )
+    PoolItem( solv ).status().setLock( true, ResStatus::USER );
+
+  std::set<sat::detail::IdType> ret;
+  ok_r = test.resolver().resolvePool();
+  if ( ok_r )
+  {
+    for ( const PoolItem & pi : test.pool() )
+    {
+      if ( pi.status().transacts() )
+        ret.insert( pi.status().isInstalled() ? erase( pi ) : install( pi ) );
+    }
+  }
+  for ( const PoolItem & pi : test.pool() )
+    pi.statusReset();	// also the pool lock
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(resolve_pool)
+{
+  // Solving the testcase trials must result in the same transaction as resolvePool.
+  BOOST_REQUIRE_EQUAL( trials.size(), 3 );
+  PoolItem Apde	{ getPi( "aspell-de", false ) };
+
+  sat::SolverSnapshot snapshot;
+  for ( bool poolLock : { false, true } )
+  {
+    for ( const auto & trial : trials )
+    {
+      if ( poolLock )
+        Apde.status().setLock( true, ResStatus::USER );	// obeyed by the snapshot too
+
+      sat::SolverSnapshot::Request request { sat::SolverSnapshot::Request::fromTestcase( trial ) };
+      sat::SolverSnapshot::Result result { snapshot.solve( request ) };
+
+      bool ok = false;
+      std::set<sat::detail::IdType> expected { resolvePool( request, ok ) };
+      BOOST_CHECK_EQUAL( result.ok(), ok );
+      BOOST_CHECK( decisions( result ) == expected );
+      BOOST_CHECK_EQUAL( bool( decisions( result ).count( install(Apde) ) ), ! poolLock && ok && ! request._install.empty() );
+    }
+  }
+}
@@ -0,0 +1,171 @@
+#include <boost/test/unit_test.hpp>
+
+#include <unistd.h>
+#include <fstream>
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/StrMatcher.h>
+#include <zypp/sat/LookupAttr.h>
+#include <zypp/sat/TrigramIndex.h>
+#include <zypp/PoolQuery.h>
+#include <zypp/ZConfig.h>
+#include <zypp/TmpPath.h>
+#include "TestSetup.h"
+
+#define BOOST_TEST_MODULE TrigramIndex
+
+using std::endl;
+using namespace zypp;
+
+static TestSetup test( TestSetup::initLater );
+
+struct TestInit {
+  TestInit() {
+    test = TestSetup( Arch_x86_64 );
+    ZConfig::instance().repoSearchIndex( true );
+    test.loadRepo( TESTS_SRC_DIR "/data/openSUSE-11.1", "opensuse" );
+  }
+  ~TestInit() { test.reset(); }
+};
+BOOST_GLOBAL_FIXTURE( TestInit );
+
+inline std::vector<std::string> literals( const StrMatcher & matcher_r )
+{
+  std::vector<std::string> ret;
+  if ( ! sat::TrigramIndex::requiredLiterals( matcher_r, ret ) )
+    ret.push_back( "(none)" );
+  return ret;
+}
+
+inline std::set<sat::Solvable> lookup( const Repository & repo_r, const StrMatcher & matcher_r )
+{
+  std::set<sat::Solvable> ret;
+  for ( const sat::SolvAttr & attr : { sat::SolvAttr::summary, sat::SolvAttr::description } )
+  {
+    sat::LookupAttr q( attr, repo_r );
+    q.setStrMatcher( matcher_r );
+    for_( it, q.begin(), q.end() )
+      ret.insert( it.inSolvable() );
+  }
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(required_literals)
+{
+  using Literals = std::vector<std::string>;
+  BOOST_CHECK( literals( StrMatcher( "kde", Match::SUBSTRING ) )	== Literals({ "kde" }) );
+  BOOST_CHECK( literals( StrMatcher( "kde", Match::STRINGSTART ) )	== Literals({ "kde" }) );
+  BOOST_CHECK( literals( StrMatcher( "kde*base?x", Match::GLOB ) )	== Literals({ "kde", "base", "x" }) );
+  BOOST_CHECK( literals( StrMatcher( "*[a-z]lib*", Match::GLOB ) )	== Literals({ "lib" }) );
+  BOOST_CHECK( literals( StrMatcher( "^kde.*bases?$", Match::REGEX ) )	== Literals({ "kde", "base" }) );
+  BOOST_CHECK( literals( StrMatcher( "lib[0-9]+x", Match::REGEX ) )	== Literals({ "lib", "x" }) );
+  BOOST_CHECK( literals( StrMatcher( "kd\xc3\xa9?x", Match::REGEX ) )	== Literals({ "kd", "x" }) );	// no partial UTF-8 char
+  BOOST_CHECK( literals( StrMatcher( "*[[:alpha:]]lib*", Match::GLOB ) )	== Literals({ "(none)" }) );
+  BOOST_CHECK( literals( StrMatcher( "lib[[:digit:]]+x", Match::REGEX ) )	== Literals({ "(none)" }) );
+  BOOST_CHECK( literals( StrMatcher( "kde|gnome", Match::REGEX ) )	== Literals({ "(none)" }) );
+  BOOST_CHECK( literals( StrMatcher( "kde\\.", Match::REGEX ) )	== Literals({ "(none)" }) );
+  BOOST_CHECK( literals( StrMatcher( "kde", Match::FILES ) )		== Literals({ "(none)" }) );
+  BOOST_CHECK( literals( StrMatcher( "" ) )				== Literals({ "(none)" }) );
+}
+
+BOOST_AUTO_TEST_CASE(index_file)
+{
+  Pathname solvfile { RepoManagerOptions::makeTestSetup( test.root() ).repoSolvCachePath / "opensuse" / "solv" };
+  BOOST_REQUIRE( PathInfo( solvfile ).isFile() );
+  BOOST_CHECK( PathInfo( sat::TrigramIndex::indexFile( solvfile ) ).isFile() );
+  BOOST_CHECK( sat::TrigramIndex::upToDate( solvfile ) );
+  BOOST_CHECK( ! sat::TrigramIndex::upToDate( solvfile.extend( ".nonexistent" ) ) );
+}
+
+BOOST_AUTO_TEST_CASE(corrupt_index)
+{
+  filesystem::TmpDir tmpdir;
+  Pathname solvfile { tmpdir.path() / "solv" };
+  BOOST_REQUIRE_EQUAL( filesystem::copy( RepoManagerOptions::makeTestSetup( test.root() ).repoSolvCachePath / "opensuse" / "solv", solvfile ), 0 );
+  sat::TrigramIndex::write( solvfile );
+  BOOST_REQUIRE( sat::TrigramIndex::read( solvfile, 1 ) );
+
+  // a posting pointing beyond the data
+  {
+    std::fstream file( sat::TrigramIndex::indexFile( solvfile ).c_str(), std::ios::binary | std::ios::in | std::ios::out );
+    file.seekp( 40 + 4 );	// 1st posting's _count
+    const char bad[4] = { '\xff', '\xff', '\xff', '\x7f' };
+    BOOST_REQUIRE( file.write( bad, sizeof(bad) ) );
+  }
+  BOOST_CHECK( ! sat::TrigramIndex::read( solvfile, 1 ) );
+
+  // truncated
+  sat::TrigramIndex::write( solvfile );
+  BOOST_REQUIRE( sat::TrigramIndex::read( solvfile, 1 ) );
+  BOOST_REQUIRE_EQUAL( ::truncate( sat::TrigramIndex::indexFile( solvfile ).c_str(), PathInfo( sat::TrigramIndex::indexFile( solvfile ) ).size() - 1 ), 0 );
+  BOOST_CHECK( ! sat::TrigramIndex::read( solvfile, 1 ) );
+}
+
+BOOST_AUTO_TEST_CASE(candidates)
+{
+  Repository repo { test.satpool().reposFind( "opensuse" ) };
+  shared_ptr<const sat::TrigramIndex> index { sat::TrigramIndex::forRepo( repo ) };
+  BOOST_REQUIRE( index );
+  BOOST_CHECK( index->size() >= repo.solvablesSize() );	// incompatible archs are dropped on load
+
+  StrMatcher matcher( "KDE", Match::SUBSTRING | Match::NOCASE );
+  std::vector<sat::detail::SolvableIdType> ids;
+  BOOST_REQUIRE( index->candidates( matcher, ids ) );
+  BOOST_CHECK( std::is_sorted( ids.begin(), ids.end() ) );
+  BOOST_CHECK( ids.size() < repo.solvablesSize() );
+
+  std::set<sat::Solvable> expected { lookup( repo, matcher ) };
+  BOOST_CHECK( ! expected.empty() );
+  for ( const sat::Solvable & solv : expected )
+    BOOST_CHECK( std::binary_search( ids.begin(), ids.end(), solv.id() ) );
+
+  // can't tell:
+  ids.clear();
+  BOOST_CHECK( ! index->candidates( StrMatcher( "kd", Match::SUBSTRING ), ids ) );
+  BOOST_CHECK( ! index->candidates( StrMatcher( "kde|gnome", Match::REGEX ), ids ) );
+  BOOST_CHECK( ids.empty() );
+
+  // a missing trigram:
+  BOOST_CHECK( index->candidates( StrMatcher( "zzzqqqxxx", Match::SUBSTRING ), ids ) );
+  BOOST_CHECK( ids.empty() );
+}
+
+BOOST_AUTO_TEST_CASE(pool_query)
+{
+  // Results using the index must be the same as a plain lookup:
+  Repository repo { test.satpool().reposFind( "opensuse" ) };
+  std::vector<std::pair<std::string,Match>> searches {
+    { "kde",		Match::SUBSTRING },
+    { "lib*devel",	Match::GLOB },
+    { "^yast2-[a-z]+",	Match::REGEX },
+  };
+  for ( const auto & search : searches )
+  {
+    PoolQuery q;
+    q.addString( search.first );
+    if ( search.second == Match::GLOB )
+      q.setMatchGlob();
+    else if ( search.second == Match::REGEX )
+      q.setMatchRegex();
+    q.setCaseSensitive( false );
+    q.addAttribute( sat::SolvAttr::summary );
+    q.addAttribute( sat::SolvAttr::description );
+
+    std::set<sat::Solvable> found( q.begin(), q.end() );
+    BOOST_CHECK_EQUAL( found.size(), q.size() );
+    BOOST_CHECK( found == lookup( repo, StrMatcher( search.first, search.second | Match::NOCASE ) ) );
+  }
+
+  PoolQuery q;
+  q.addString( "yast2" );
+  q.setMatchExact();
+  q.addAttribute( sat::SolvAttr::provides );
+
+  std::set<sat::Solvable> expected;
+  sat::LookupAttr l( sat::SolvAttr::provides, repo );
+  l.setStrMatcher( StrMatcher( "yast2", Match::STRING ) );
+  for_( it, l.begin(), l.end() )
+    expected.insert( it.inSolvable() );
+  BOOST_CHECK( ! expected.empty() );
+  BOOST_CHECK( std::set<sat::Solvable>( q.begin(), q.end() ) == expected );
+}
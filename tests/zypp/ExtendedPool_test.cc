@@ -99,3 +99,49 @@ BOOST_AUTO_TEST_CASE(t_1) {
     repocheck();
   }
 }
+
+///////////////////////////////////////////////////////////////////
+// Check that the incrementally updated store and ident index match
+// the sat::Pool content after adding and removing single repos.
+///////////////////////////////////////////////////////////////////
+void identcheck()
+{
+  ResPool pool( ResPool::instance() );
+  for ( const sat::Solvable & solv : sat::Pool::instance().solvables() )
+  {
+    PoolItem pi( pool.find( solv ) );
+    BOOST_CHECK_EQUAL( pi.satSolvable(), solv );
+    checkpi( pi );
+    unsigned found = 0;
+    for ( const PoolItem & cand : pool.byIdent( pi ) )
+    {
+      BOOST_CHECK( cand.satSolvable() );	// no stale items in the index
+      if ( cand == pi )
+        ++found;
+    }
+    BOOST_CHECK_EQUAL( found, 1 );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(t_2) {
+  sat::Pool satpool( sat::Pool::instance() );
+  satpool.reposEraseAll();
+
+  BOOST_TEST_CONTEXT("Add repos") {
+    satpool.reposInsert( "A" ).addTesttags( TESTS_SRC_DIR"/data/PoolReuseIds/SeqA/SEQA.repo" );
+    identcheck();
+    satpool.reposInsert( "B" ).addTesttags( TESTS_SRC_DIR"/data/PoolReuseIds/SeqB/SeqB.repo" );
+    identcheck();
+  }
+
+  BOOST_TEST_CONTEXT("Remove a repo") {
+    satpool.reposErase( "A" );
+    identcheck();
+    BOOST_CHECK_EQUAL( ResPool::instance().reposFind( "A" ), Repository::noRepository );
+  }
+
+  BOOST_TEST_CONTEXT("Re-add a repo") {
+    satpool.reposInsert( "C" ).addTesttags( TESTS_SRC_DIR"/data/PoolReuseIds/SeqA/SEQA.repo" );
+    identcheck();
+  }
+}
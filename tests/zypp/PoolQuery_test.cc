@@ -1,6 +1,11 @@
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include "TestSetup.h"
+#include <zypp/base/LogControl.h>
 #include <zypp/PoolQuery.h>
 #include <zypp/PoolQueryUtil.tcc>
+#include <zypp/ZConfig.h>
 
 #define BOOST_TEST_MODULE PoolQuery
 
@@ -9,6 +14,9 @@ static TestSetup test( TestSetup::initLater );
 struct TestInit {
   TestInit() {
     test = TestSetup( Arch_x86_64 );
+    // PoolQueryIndexed_test: build the repos search index and query through it
+    if ( ::getenv( "ZYPP_TESTSUITE_SEARCHINDEX" ) )
+      ZConfig::instance().repoSearchIndex( true );
 
     // Abuse;) vbox as System repo:
     test.loadTargetRepo( TESTS_SRC_DIR "/data/obs_virtualbox_11_1" );
@@ -635,6 +643,106 @@ BOOST_AUTO_TEST_CASE(pool_predicated_matcher)
   }
 }
 
+/** Collects the log lines written while in scope. */
+struct LogCollector
+{
+  struct Writer : public log::LineWriter
+  {
+    void writeOut( const std::string & formated_r ) override
+    {
+      std::lock_guard lk( _lock );
+      _lines.push_back( formated_r );
+    }
+    std::mutex _lock;
+    std::vector<std::string> _lines;
+  };
+
+  /** The first line containing \a tag_r, waiting up to 10s for it. */
+  std::string waitForLine( const std::string & tag_r )
+  {
+    for ( int i = 0; i < 1000; ++i )
+    {
+      {
+        std::lock_guard lk( _writer->_lock );
+        for ( const std::string & line : _writer->_lines )
+          if ( line.find( tag_r ) != std::string::npos )
+            return line;
+      }
+      std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    }
+    return std::string();
+  }
+
+  shared_ptr<Writer> _writer { new Writer };
+  base::LogControl::TmpLineWriter _guard { _writer };
+};
+
+BOOST_AUTO_TEST_CASE(pool_query_parallel)
+{
+  cout << "****parallel****"  << endl;
+  std::vector<PoolQuery> queries( 4 );
+  queries[0].addString("kde");
+  queries[0].addAttribute(sat::SolvAttr::description);
+  queries[1].addString("^lib.*devel$");
+  queries[1].addAttribute(sat::SolvAttr::name);
+  queries[1].addAttribute(sat::SolvAttr::summary);
+  queries[1].setMatchRegex();
+  queries[2].addString("zypp");
+  queries[2].addRepo("opensuse");
+  queries[2].addRepo("zyppsvn");
+  queries[2].setUninstalledOnly();
+  queries[2].addAttribute(sat::SolvAttr::name);
+  queries[2].addAttribute(sat::SolvAttr::summary, "package");
+  queries[3].addString("libzypp");	// all attributes: runs sequential
+  for ( PoolQuery & q : queries )
+  {
+    std::vector<sat::Solvable> sequential( q.begin(), q.end() );
+    q.setParallel();
+    BOOST_CHECK( q.parallel() );
+    LogCollector log;
+    std::vector<sat::Solvable> parallel( q.begin(), q.end() );
+    if ( &q != &queries[3] )
+      BOOST_CHECK_MESSAGE( log.waitForLine( "Search in " ).find( ", parallel)" ) != std::string::npos, q );
+    else
+      BOOST_CHECK( ! log.waitForLine( "Sequential search" ).empty() );
+    BOOST_CHECK( ! sequential.empty() );
+    BOOST_CHECK( parallel == sequential );
+
+    // matches are provided as usual
+    for_( it, q.begin(), q.end() )
+    {
+      BOOST_CHECK( it.matchesSize() );
+      for_( m, it.matchesBegin(), it.matchesEnd() )
+        BOOST_CHECK_EQUAL( m->inSolvable(), *it );
+    }
+  }
+
+  // parallel is not part of the query
+  PoolQuery q;
+  q.addString("kde");
+  PoolQuery p( q );
+  p.setParallel();
+  BOOST_CHECK( q == p );
+  BOOST_CHECK( ! ( q < p ) && ! ( p < q ) );
+}
+
+BOOST_AUTO_TEST_CASE(pool_query_indexed)
+{
+  if ( ! ZConfig::instance().repoSearchIndex() )
+    return;	// run as PoolQueryIndexed_test
+
+  cout << "****indexed****"  << endl;
+  PoolQuery q;
+  q.addString("kde");
+  q.addAttribute(sat::SolvAttr::summary);
+  q.addAttribute(sat::SolvAttr::description);
+  LogCollector log;
+  std::vector<sat::Solvable> found( q.begin(), q.end() );
+  BOOST_CHECK( ! found.empty() );
+  std::string line { log.waitForLine( "Search in " ) };
+  BOOST_CHECK_MESSAGE( ! line.empty() && line.find( "(0 indexed" ) == std::string::npos, line );
+}
+
 BOOST_AUTO_TEST_CASE(pool_query_serialize)
 {
   std::vector<PoolQuery> queries;
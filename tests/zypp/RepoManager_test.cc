@@ -257,7 +257,11 @@ BOOST_AUTO_TEST_CASE(repomanager_test)
   // now cache should build normally
   manager.buildCache(repo);
 
+  // loading a fresh cache must not rebuild it (a rebuild removes the whole solv dir)
+  Pathname marker = base / "marker";
+  BOOST_REQUIRE( filesystem::touch( marker ) == 0 );
   manager.loadFromCache(repo);
+  BOOST_CHECK_MESSAGE( PathInfo(marker).isExist(), "Fresh cache was rebuilt on load" );
 
   if ( manager.isCached(repo ) )
   {
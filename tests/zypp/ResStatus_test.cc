@@ -1,5 +1,6 @@
 #include "TestSetup.h"
 #include <zypp/ResStatus.h>
+#include <zypp/pool/ChangeJournal.h>
 
 #define BOOST_TEST_MODULE ResStatus
 
@@ -21,6 +22,47 @@ BOOST_AUTO_TEST_CASE(Default)
   }
 }
 
+BOOST_AUTO_TEST_CASE(ChangeJournal)
+{
+  pool::ChangeJournal & journal( pool::ChangeJournal::instance() );
+  pool::ChangeJournal::Cursor cursor;
+  std::vector<pool::ChangeJournal::IdType> changed;
+  BOOST_CHECK( ! journal.changedSince( cursor, changed ) );	// new cursor
+
+  ResStatus s;
+  pool::ChangeJournal::StatusIds statusIds { { &s, 42 } };	// as if owned by a PoolItem
+  journal.watch( &statusIds );
+  ResStatus t( s );	// copies do not report
+
+  BOOST_CHECK( s.maySetTransact( true, ResStatus::USER ) );
+  BOOST_CHECK( t.setTransact( true, ResStatus::USER ) );
+  s.setLicenceConfirmed();
+  BOOST_CHECK( journal.changedSince( cursor, changed ) );
+  BOOST_CHECK( changed.empty() );
+
+  BOOST_CHECK( s.setTransact( true, ResStatus::USER ) );
+  BOOST_CHECK( s.setTransact( true, ResStatus::USER ) );	// no change
+  BOOST_CHECK( journal.changedSince( cursor, changed ) );
+  BOOST_CHECK( changed == std::vector<pool::ChangeJournal::IdType>{ 42 } );
+
+  changed.clear();
+  s = ResStatus();	// plain assignment does not report
+  BOOST_CHECK( s.isUninstalled() );
+  BOOST_CHECK( journal.changedSince( cursor, changed ) );
+  BOOST_CHECK( changed.empty() );
+  BOOST_CHECK( s.setStatus( ResStatus::toBeInstalled ) );	// setStatus does
+  BOOST_CHECK( journal.changedSince( cursor, changed ) );
+  BOOST_CHECK( changed == std::vector<pool::ChangeJournal::IdType>{ 42 } );
+
+  changed.clear();
+  s.setLock( true, ResStatus::USER );
+  journal.reset();
+  BOOST_CHECK( ! journal.changedSince( cursor, changed ) );
+  BOOST_CHECK( changed.empty() );
+  BOOST_CHECK( journal.changedSince( cursor, changed ) );
+  journal.watch( nullptr );
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // tools
 ////////////////////////////////////////////////////////////////////////////////
@@ -1,7 +1,12 @@
+#include <fstream>
+
 #include "TestSetup.h"
 
 #include <zypp/target/rpm/RpmDb.h>
+#include <zypp/target/rpm/RpmPackageVerifyPool.h>
 using target::rpm::RpmDb;
+using target::rpm::RpmPackageVerifyPool;
+using target::rpm::VerifyPackageResult;
 
 #define DATADIR (Pathname(TESTS_SRC_DIR) / "/zypp/data/RpmPkgSigCheck")
 
@@ -81,6 +86,7 @@ namespace
     return res;
   }
 
+
   CheckResult gcheckPackageSignature( const Pathname & path_r )
   {
     CheckResult res;
@@ -89,6 +95,16 @@ namespace
 //     cout << res << endl;
     return res;
   }
+
+  /** verifyPackageSignature must tell the same as checkPackageSignature. */
+  VerifyPackageResult gverifyPackageSignature( const Pathname & path_r )
+  {
+    VerifyPackageResult res { test.target().rpmDb().verifyPackageSignature( path_r ) };
+    CheckResult cs { gcheckPackageSignature( path_r ) };
+    BOOST_CHECK_EQUAL( res.result, cs.result );
+    BOOST_CHECK_EQUAL( res.detail, cs.detail );
+    return res;
+  }
 } // namespace
 
 
@@ -213,6 +229,27 @@ BOOST_AUTO_TEST_CASE(signed_broken_header_pkg_nokey)
 }
 
 
+BOOST_AUTO_TEST_CASE(verify_unsigned_pkg)
+{
+  Pathname rpm { DATADIR/"unsigned.rpm" };
+  BOOST_CHECK_EQUAL( gverifyPackageSignature( rpm ).result, RpmDb::CHK_NOSIG );
+  BOOST_CHECK_EQUAL( test.target().rpmDb().verifyPackageSignature( rpm, false ).result, RpmDb::CHK_OK );
+}
+
+BOOST_AUTO_TEST_CASE(verify_broken_pkg)
+{
+  BOOST_CHECK_EQUAL( gverifyPackageSignature( DATADIR/"unsigned_broken.rpm" ).result, RpmDb::CHK_FAIL );
+  BOOST_CHECK_EQUAL( gverifyPackageSignature( DATADIR/"signed_broken.rpm" ).result, RpmDb::CHK_FAIL );
+  BOOST_CHECK_EQUAL( test.target().rpmDb().verifyPackageSignature( DATADIR/"no.rpm" ).result, RpmDb::CHK_ERROR );
+}
+
+BOOST_AUTO_TEST_CASE(verify_signed_pkg_nokey)
+{
+  VerifyPackageResult res { gverifyPackageSignature( DATADIR/"signed.rpm" ) };
+  BOOST_CHECK_EQUAL( res.result, RpmDb::CHK_NOKEY );
+  BOOST_CHECK_EQUAL( str::toLower( res.keyID ), "b88b2fd43dbdc284" );
+}
+
 ///////////////////////////////////////////////////////////////////
 BOOST_AUTO_TEST_CASE(add_key)
 {
@@ -276,3 +313,75 @@ BOOST_AUTO_TEST_CASE(signed_broken_header_pkg_withkey)
   } };
   BOOST_CHECK_EQUAL( xpct, cs );
 }
+
+BOOST_AUTO_TEST_CASE(verify_signed_pkg_withkey)
+{
+  VerifyPackageResult res { gverifyPackageSignature( DATADIR/"signed.rpm" ) };
+  BOOST_CHECK_EQUAL( res.result, RpmDb::CHK_OK );
+  BOOST_CHECK( res.keyID.empty() );
+}
+
+BOOST_AUTO_TEST_CASE(verify_pool)
+{
+  filesystem::TmpDir tmp;
+  Pathname signedRpm { tmp/"signed.rpm" };
+  BOOST_REQUIRE_EQUAL( filesystem::copy( DATADIR/"signed.rpm", signedRpm ), 0 );
+
+  RpmPackageVerifyPool pool( test.target().root(), 2 );
+  BOOST_CHECK( ! pool.submit( DATADIR/"no.rpm" ) );
+  BOOST_CHECK( pool.submit( signedRpm ) );
+  BOOST_CHECK( pool.submit( DATADIR/"unsigned_broken.rpm" ) );
+  BOOST_CHECK_EQUAL( pool.size(), 2 );
+
+  // a hardlink is the same package
+  Pathname linked { tmp/"linked.rpm" };
+  BOOST_REQUIRE_EQUAL( filesystem::hardlink( signedRpm, linked ), 0 );
+  BOOST_CHECK( pool.queued( linked ) );
+
+  std::optional<RpmPackageVerifyPool::Output> out { pool.take( linked ) };
+  BOOST_REQUIRE( out );
+  BOOST_CHECK_EQUAL( out->exitCode, 0 );
+  BOOST_CHECK( ! pool.queued( signedRpm ) );
+  BOOST_CHECK( ! pool.take( signedRpm ) );	// already taken
+
+  // rpm's output is evaluated like checkPackageSignature does
+  CheckResult cs { gcheckPackageSignature( DATADIR/"unsigned_broken.rpm" ) };
+  VerifyPackageResult broken { test.target().rpmDb().verifyPackageSignature( DATADIR/"unsigned_broken.rpm", true, pool ) };
+  BOOST_CHECK_EQUAL( broken.result, RpmDb::CHK_FAIL );
+  BOOST_CHECK_EQUAL( broken.detail, cs.detail );
+  BOOST_CHECK_EQUAL( pool.size(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE(verify_pool_stream)
+{
+  filesystem::TmpDir tmp;
+  Pathname signedRpm { tmp/"signed.rpm" };
+  BOOST_REQUIRE_EQUAL( filesystem::copy( DATADIR/"signed.rpm", signedRpm ), 0 );
+  std::string data;
+  {
+    std::ifstream in( signedRpm.c_str() );
+    data.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+  }
+  BOOST_REQUIRE( data.size() > 1000 );
+
+  RpmPackageVerifyPool pool( test.target().root(), 2 );
+
+  // rpm checks the data passed in chunks, the file is queued afterwards
+  shared_ptr<RpmPackageVerifyPool::Stream> stream { pool.stream() };
+  for ( size_t off = 0; off < data.size(); off += 1000 )
+    BOOST_REQUIRE( stream->write( data.data() + off, std::min<size_t>( 1000, data.size() - off ) ) );
+  BOOST_CHECK_EQUAL( stream->size(), off_t(data.size()) );
+  BOOST_CHECK( pool.submit( *stream, signedRpm ) );
+  BOOST_CHECK( pool.queued( signedRpm ) );
+  BOOST_CHECK( ! stream->write( data.data(), 1 ) );	// done
+
+  VerifyPackageResult res { test.target().rpmDb().verifyPackageSignature( signedRpm, true, pool ) };
+  BOOST_CHECK_EQUAL( res.result, RpmDb::CHK_OK );
+  BOOST_CHECK_EQUAL( res.detail, gverifyPackageSignature( signedRpm ).detail );
+
+  // a stream missing data is not queued
+  stream = pool.stream();
+  BOOST_REQUIRE( stream->write( data.data(), 1000 ) );
+  BOOST_CHECK( ! pool.submit( *stream, signedRpm ) );
+  BOOST_CHECK( ! pool.queued( signedRpm ) );
+}
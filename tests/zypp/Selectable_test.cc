@@ -81,6 +81,36 @@ BOOST_AUTO_TEST_CASE(candiadatenoarch)
   BOOST_CHECK_EQUAL( s->updateCandidateObj(), s->candidateObj() );
 }
 
+BOOST_AUTO_TEST_CASE(available_order)
+{
+  ResPoolProxy poolProxy( test.poolProxy() );
+  {
+    ui::Selectable::Ptr s( poolProxy.lookup( ResKind::package, "candidate" ) );
+    std::vector<std::string> expect {
+      "RepoHIGH 4-1.x86_64", "RepoHIGH 4-1.i586",
+      "RepoMID 0-1.x86_64",  "RepoMID 0-1.i586",
+      "RepoLOW 2-1.x86_64",  "RepoLOW 2-1.i586",
+    };
+    std::vector<std::string> got;
+    for ( const PoolItem & pi : s->available() )
+      got.push_back( pi->repoInfo().alias()+" "+pi.edition().asString()+"."+pi.arch().asString() );
+    BOOST_CHECK_EQUAL_COLLECTIONS( got.begin(), got.end(), expect.begin(), expect.end() );
+  }
+  // The sorted lists agree with the comparators (AVOrder ignores the arch if one is noarch).
+  for ( const ui::Selectable::Ptr & s : poolProxy.byKind<Package>() )
+  {
+    for ( auto it = s->availableBegin(); it != s->availableEnd() && std::next(it) != s->availableEnd(); ++it )
+    {
+      const PoolItem & lhs( *it );
+      const PoolItem & rhs( *std::next(it) );
+      if ( lhs.arch() != Arch_noarch && rhs.arch() != Arch_noarch )
+        BOOST_CHECK_MESSAGE( !ui::SelectableTraits::AVOrder()( rhs, lhs ), lhs << " before " << rhs );
+    }
+    for ( auto it = s->installedBegin(); it != s->installedEnd() && std::next(it) != s->installedEnd(); ++it )
+      BOOST_CHECK( !ui::SelectableTraits::IOrder()( *std::next(it), *it ) );
+  }
+}
+
 
 /////////////////////////////////////////////////////////////////////////////
 //
@@ -0,0 +1,114 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zypp/base/LogControl.h>
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+
+using namespace zypp;
+
+namespace
+{
+  struct CollectingLineWriter : public log::LineWriter
+  {
+    void writeOut( const std::string & formated_r ) override
+    {
+      std::lock_guard lk( _lock );
+      _lines.push_back( formated_r );
+    }
+
+    std::vector<std::string> lines()
+    {
+      std::lock_guard lk( _lock );
+      return _lines;
+    }
+
+    std::mutex _lock;
+    std::vector<std::string> _lines;
+  };
+
+  /** Lines containing \a tag_r, waiting up to 10s for \a count_r of them. */
+  template <class TLines>
+  std::vector<std::string> waitForLines( TLines && getLines_r, const std::string & tag_r, size_t count_r )
+  {
+    std::vector<std::string> ret;
+    for ( int i = 0; i < 1000; ++i )
+    {
+      ret.clear();
+      for ( const std::string & line : getLines_r() )
+        if ( line.find( tag_r ) != std::string::npos )
+          ret.push_back( line );
+      if ( ret.size() >= count_r )
+        break;
+      std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+    }
+    return ret;
+  }
+
+  void logLines( const std::string & tag_r, unsigned thread_r, unsigned lines_r )
+  {
+    for ( unsigned i = 0; i < lines_r; ++i )
+      MIL << tag_r << " " << thread_r << " " << i << std::endl;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(log_from_threads_in_order)
+{
+  shared_ptr<CollectingLineWriter> collector( new CollectingLineWriter );
+  base::LogControl::TmpLineWriter guard( collector );
+  uint64_t dropped = base::LogControl::instance().droppedLines();
+
+  constexpr unsigned threads = 4;
+  constexpr unsigned lines = 2000;
+  std::vector<std::thread> workers;
+  for ( unsigned t = 0; t < threads; ++t )
+    workers.emplace_back( logLines, "logtest", t, lines );
+  for ( auto & w : workers )
+    w.join();
+
+  std::vector<std::string> got { waitForLines( [&](){ return collector->lines(); }, "logtest ", threads * lines ) };
+  BOOST_CHECK_EQUAL( got.size() + ( base::LogControl::instance().droppedLines() - dropped ), threads * lines );
+
+  // lines of each thread arrive in order
+  std::vector<int> last( threads, -1 );
+  for ( const std::string & line : got )
+  {
+    std::vector<std::string> words;
+    str::split( line.substr( line.find( "logtest " ) ), std::back_inserter(words) );
+    BOOST_REQUIRE_EQUAL( words.size(), 3 );
+    unsigned t = str::strtonum<unsigned>( words[1] );
+    int n = str::strtonum<int>( words[2] );
+    BOOST_REQUIRE_LT( t, threads );
+    BOOST_CHECK_GT( n, last[t] );
+    last[t] = n;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(log_to_file)
+{
+  filesystem::TmpDir tmp;
+  Pathname logfile { tmp / "zypp.log" };
+  {
+    base::LogControl::TmpLineWriter guard( new log::FileLineWriter( logfile ) );
+    std::thread( logLines, "filetest", 0, 500 ).join();
+
+    auto readLines = [&]() {
+      std::vector<std::string> ret;
+      std::ifstream in( logfile.c_str() );
+      for ( std::string line; std::getline( in, line ); )
+        ret.push_back( line );
+      return ret;
+    };
+    std::vector<std::string> got { waitForLines( readLines, "filetest ", 500 ) };
+    BOOST_CHECK_EQUAL( got.size(), 500 );
+    if ( ! got.empty() )
+      BOOST_CHECK( str::endsWith( got.back(), "filetest 0 499" ) );
+  }
+}
@@ -0,0 +1,63 @@
+#include <boost/test/unit_test.hpp>
+#include <zypp-core/zyppng/thread/ThreadPool>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+BOOST_AUTO_TEST_CASE(threadpool_limits_concurrency)
+{
+  std::atomic<int> running( 0 );
+  std::atomic<int> maxRunning( 0 );
+  std::atomic<int> done( 0 );
+
+  {
+    zyppng::ThreadPool pool( 3 );
+    BOOST_CHECK_EQUAL( pool.maxThreads(), 3 );
+
+    for ( int i = 0; i < 20; ++i ) {
+      pool.submit( [&](){
+        int now = ++running;
+        int seen = maxRunning.load();
+        while ( now > seen && !maxRunning.compare_exchange_weak( seen, now ) )
+          ;
+        std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+        --running;
+        ++done;
+      });
+    }
+    // the destructor runs all queued jobs
+  }
+
+  BOOST_CHECK_EQUAL( done.load(), 20 );
+  BOOST_CHECK_LE( maxRunning.load(), 3 );
+  BOOST_CHECK_GE( maxRunning.load(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_cpu_pool)
+{
+  BOOST_CHECK_GE( zyppng::ThreadPool::cpuPool().maxThreads(), 1 );
+  if ( std::thread::hardware_concurrency() )
+    BOOST_CHECK_EQUAL( zyppng::ThreadPool::cpuPool().maxThreads(), std::thread::hardware_concurrency() );
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_shutdown)
+{
+  std::atomic<int> done( 0 );
+  zyppng::ThreadPool pool( 2 );
+  for ( int i = 0; i < 10; ++i )
+    pool.submit( [&](){ ++done; } );
+
+  pool.shutdown();
+  BOOST_CHECK_EQUAL( done.load(), 10 );
+  BOOST_CHECK_EQUAL( pool.pendingJobs(), 0 );
+
+  // no threads left, jobs run in the caller
+  const auto caller = std::this_thread::get_id();
+  std::thread::id executor;
+  pool.submit( [&](){ executor = std::this_thread::get_id(); ++done; } );
+  BOOST_CHECK_EQUAL( done.load(), 11 );
+  BOOST_CHECK( executor == caller );
+
+  pool.shutdown();
+}
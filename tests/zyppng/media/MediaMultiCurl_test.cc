@@ -0,0 +1,212 @@
+#include <zypp/MediaSetAccess.h>
+#include <zypp/PathInfo.h>
+#include <zypp/Url.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include "WebServer.h"
+#include "TestTools.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace zypp;
+
+namespace
+{
+  //create one URL line for a metalink template file
+  std::string makeUrl ( int pref, const Url &url )
+  {
+    return ( str::Format( "<url preference=\"%1%\" location=\"de\" type=\"%2%\">%3%</url>" ) % pref % url.getScheme() % url.asCompleteString() );
+  }
+
+  bool requestWantsMetaLink ( const WebServer::Request &req )
+  {
+    auto it = req.params.find( "HTTP_ACCEPT" );
+    if ( it != req.params.end() ) {
+      if ( (*it).second.find("application/metalink+xml")  != std::string::npos ||
+           (*it).second.find("application/metalink4+xml") != std::string::npos ) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //a one shot event request handlers can block on, opening it wakes up all waiters
+  class Gate
+  {
+  public:
+    void open ()
+    {
+      std::lock_guard<std::mutex> guard( _mut );
+      _open = true;
+      _cv.notify_all();
+    }
+
+    //returns false if the gate was not opened in time
+    bool wait ( std::chrono::milliseconds timeout )
+    {
+      std::unique_lock<std::mutex> guard( _mut );
+      return _cv.wait_for( guard, timeout, [this]{ return _open; } );
+    }
+
+  private:
+    std::mutex _mut;
+    std::condition_variable _cv;
+    bool _open = false;
+  };
+
+  //a byte range, both ends inclusive
+  using Range = std::pair<off_t, off_t>;
+
+  //all ranges of the request, the whole \a size if there is no Range header
+  std::vector<Range> requestedRanges ( const WebServer::Request &req, off_t size )
+  {
+    std::vector<Range> ranges;
+    auto it = req.params.find( "HTTP_RANGE" );
+    if ( it != req.params.end() && str::startsWith( it->second, "bytes=" ) ) {
+      //bytes=786432-1048575[,...]
+      std::vector<std::string> words;
+      str::split( it->second.substr( 6 ), std::back_inserter(words), "," );
+      for ( const auto &word : words ) {
+        std::string range = str::trim( word );
+        size_t dash = range.find_first_of( "-" );
+        if ( dash == std::string::npos )
+          continue;
+        off_t start = std::stoll( range.substr( 0, dash ) );
+        off_t end = dash + 1 < range.size() ? std::stoll( range.substr( dash+1 ) ) : size - 1;
+        ranges.push_back( Range( start, end ) );
+      }
+    }
+    if ( ranges.empty() )
+      ranges.push_back( Range( 0, size - 1 ) );
+    return ranges;
+  }
+
+  //the ranges the handler of a mirror was asked for or served
+  class RangeLog
+  {
+  public:
+    void add ( const std::vector<Range> &ranges )
+    {
+      std::lock_guard<std::mutex> guard( _mut );
+      _ranges.insert( _ranges.end(), ranges.begin(), ranges.end() );
+    }
+
+    std::vector<Range> ranges ()
+    {
+      std::lock_guard<std::mutex> guard( _mut );
+      return _ranges;
+    }
+
+  private:
+    std::mutex _mut;
+    std::vector<Range> _ranges;
+  };
+
+  //creates a request handler that serves the first requested range of \a content,
+  //\a beforeServe is called first with all requested ranges and may block to
+  //simulate a stalling mirror
+  WebServer::RequestHandler makeRangeHandler ( const std::string &content, std::function<void( const std::vector<Range> & )> beforeServe )
+  {
+    return [ &content, beforeServe ]( WebServer::Request &req ) {
+      const std::vector<Range> ranges = requestedRanges( req, content.size() );
+      beforeServe( ranges );
+
+      //we only serve the first range
+      const off_t start = ranges.front().first;
+      const off_t end = ranges.front().second;
+
+      req.rout << "Status: 206 Partial Content\r\n"
+               << "Accept-Ranges: bytes\r\n"
+               << "Content-Length: "<< ( end - start + 1 ) <<"\r\n"
+               << "Content-Range: bytes "<<start<<"-"<<end<<"/"<<content.size()<<"\r\n"
+               <<"\r\n"
+               << content.substr( start, end - start + 1 );
+    };
+  }
+}
+
+// The stalling mirror is preferred, so its worker claims the whole file first.
+// It does not deliver anything before the download is done, so the download can
+// only finish if the fast mirror's worker splits the unclaimed blocks off that
+// stripe and races for the remaining ones. The fast mirror only starts serving
+// once the stalling one was asked for data, so the stripe is claimed by then.
+// All blocks the stalling mirror was asked for must have been reassigned to
+// and served by the fast mirror, and no block must have been fetched twice.
+BOOST_AUTO_TEST_CASE( multicurl_split_stalled_stripe )
+{
+  const Pathname testRoot = Pathname(TESTS_SRC_DIR)/"zyppng/data/downloader";
+  const std::string content = TestTools::readFile( testRoot/"test.txt" );
+  BOOST_REQUIRE_EQUAL( content.size(), 2148018 );
+  std::string metaTempl = TestTools::readFile( testRoot/"test.txt.meta" );
+  BOOST_REQUIRE( !metaTempl.empty() );
+
+  // only a safety net, so a broken implementation fails instead of hanging
+  const std::chrono::milliseconds maxWait( 60000 );
+  Gate stalledRequested;
+  Gate downloadDone;
+  std::atomic<bool> stalledTimedOut( false );
+  std::atomic<bool> fastTimedOut( false );
+  RangeLog stalledAsked;
+  RangeLog fastServed;
+
+  WebServer slow( testRoot.c_str(), 10002 );
+  slow.addRequestHandler( "stalled", makeRangeHandler( content, [&]( const std::vector<Range> &ranges ){
+    stalledAsked.add( ranges );
+    stalledRequested.open();
+    if ( !downloadDone.wait( maxWait ) )
+      stalledTimedOut = true;
+  }) );
+  BOOST_REQUIRE( slow.start() );
+
+  WebServer web( testRoot.c_str(), 10001 );
+  web.addRequestHandler( "fast", makeRangeHandler( content, [&]( const std::vector<Range> &ranges ){
+    if ( !stalledRequested.wait( maxWait ) )
+      fastTimedOut = true;
+    fastServed.add( { ranges.front() } );
+  }) );
+  Url slowUrl( slow.url().asCompleteString() + "/handler/stalled" );
+  Url fastUrl( web.url().asCompleteString() + "/handler/fast" );
+  std::string metaFile = str::Format( metaTempl ) % ( makeUrl( 100, slowUrl ) + "\n" + makeUrl( 10, fastUrl ) + "\n" );
+  web.addRequestHandler( "test.txt", [ &metaFile ]( WebServer::Request &req ) {
+    if ( requestWantsMetaLink( req ) ) {
+      req.rout << WebServer::makeResponseString( "200", { "Content-Type: application/metalink+xml; charset=utf-8\r\n" }, metaFile );
+      return;
+    }
+    req.rout << "Location: /test.txt\r\n\r\n";
+  });
+  BOOST_REQUIRE( web.start() );
+
+  MediaSetAccess media( web.url() );
+  Pathname file = media.provideFile( OnMediaLocation("/handler/test.txt") );
+  downloadDone.open();
+
+  BOOST_REQUIRE( PathInfo( file ).isFile() );
+  BOOST_CHECK_EQUAL( filesystem::sha1sum( file ), "52cabd59ecb55096447322ca99364d50094997a0" );
+  BOOST_CHECK( !fastTimedOut );
+  BOOST_CHECK( !stalledTimedOut );
+
+  // the stalling mirror did not serve anything before the download was done
+  std::vector<Range> served = fastServed.ranges();
+  std::sort( served.begin(), served.end() );
+  for ( size_t i = 1; i < served.size(); i++ )
+    BOOST_CHECK_MESSAGE( served[i-1].second < served[i].first, "range " << served[i].first << "-" << served[i].second << " was fetched twice" );
+
+  const std::vector<Range> asked = stalledAsked.ranges();
+  BOOST_REQUIRE( !asked.empty() );
+  for ( const Range &range : asked ) {
+    off_t next = range.first;
+    for ( const Range &s : served ) {
+      if ( s.first <= next && next <= s.second )
+        next = s.second + 1;
+    }
+    BOOST_CHECK_MESSAGE( next > range.second, "stalled range " << range.first << "-" << range.second << " was not reassigned" );
+  }
+
+  media.release();
+  web.stop();
+  slow.stop();
+}
@@ -12,6 +12,7 @@
 #include <zypp/PathInfo.h>
 
 #include <iostream>
+#include <set>
 #include <thread>
 #include <chrono>
 
@@ -734,3 +735,120 @@ BOOST_DATA_TEST_CASE(nwdispatcher_multipart_many_chunks_dl, bdata::make( withSSL
   }
 }
 
+
+// The test WebServer only speaks HTTP/1.1, so curl opens one connection per
+// request here. This covers the per host accounting of running requests, it
+// does not cover actual HTTP/2 multiplexing.
+BOOST_DATA_TEST_CASE(nwdispatcher_multiplex_streams_per_host, bdata::make( withSSL ), withSSL )
+{
+  std::string dummyContent = "This is just some dummy content,\nto test downloading and signals.";
+
+  auto ev = zyppng::EventLoop::create();
+  auto disp = std::make_shared<zyppng::NetworkRequestDispatcher>();
+  disp->sigQueueFinished().connect( [&ev]( const zyppng::NetworkRequestDispatcher& ){
+    ev->quit();
+  });
+
+  // the global limit is not used for multiplexing, requests are limited per host
+  disp->setMaximumConcurrentConnections( 1 );
+  disp->setMaximumStreamsPerHost( 2 );
+  disp->setMultiplexingEnabled( true );
+  BOOST_REQUIRE( disp->multiplexingEnabled() );
+
+  WebServer web1((zypp::Pathname(TESTS_SRC_DIR)/"data"/"dummywebroot").c_str(), 10001, withSSL );
+  web1.addRequestHandler("getData", WebServer::makeResponse("200 OK", dummyContent ) );
+  BOOST_REQUIRE( web1.start() );
+
+  WebServer web2((zypp::Pathname(TESTS_SRC_DIR)/"data"/"dummywebroot").c_str(), 10002, withSSL );
+  web2.addRequestHandler("getData", WebServer::makeResponse("200 OK", dummyContent ) );
+  BOOST_REQUIRE( web2.start() );
+
+  std::size_t maxHosts = 0;
+  int maxStreams = 0;
+  std::set<std::string> hosts;
+  disp->sigDownloadStarted().connect( [&]( zyppng::NetworkRequestDispatcher &d, zyppng::NetworkRequest & ){
+    maxHosts = std::max( maxHosts, d.runningStreamsPerHost().size() );
+    for ( const auto &host : d.runningStreamsPerHost() ) {
+      maxStreams = std::max( maxStreams, host.second );
+      hosts.insert( host.first );
+    }
+  });
+
+  std::vector<zyppng::NetworkRequest::Ptr> requests;
+  std::vector<std::shared_ptr<zypp::filesystem::TmpFile>> targets;
+  for ( WebServer *web : { &web1, &web2 } ) {
+    zyppng::Url weburl (web->url());
+    weburl.setPathName("/handler/getData");
+    for ( int i = 0; i < 4; i++ ) {
+      targets.push_back( std::make_shared<zypp::filesystem::TmpFile>() );
+      auto req = std::make_shared<zyppng::NetworkRequest>( weburl, targets.back()->path() );
+      req->transferSettings() = web->transferSettings();
+      requests.push_back( req );
+      disp->enqueue( req );
+    }
+  }
+
+  disp->run();
+  if ( disp->count () ) ev->run();
+
+  for ( const auto &req : requests ) {
+    BOOST_TEST_REQ_SUCCESS( req );
+  }
+  BOOST_REQUIRE_EQUAL( maxHosts, 2 );
+  BOOST_REQUIRE_EQUAL( maxStreams, 2 );
+  BOOST_REQUIRE( disp->runningStreamsPerHost().empty() );
+
+  // streams are counted per scheme, host and port
+  std::set<std::string> expectedHosts;
+  for ( WebServer *web : { &web1, &web2 } ) {
+    zyppng::Url weburl( web->url() );
+    expectedHosts.insert( weburl.getScheme() + "://" + weburl.getHost() + ":" + weburl.getPort() );
+  }
+  BOOST_REQUIRE( hosts == expectedHosts );
+}
+
+BOOST_DATA_TEST_CASE(nwdispatcher_shared_connections, bdata::make( withSSL ), withSSL )
+{
+  std::string dummyContent = "This is just some dummy content,\nto test downloading and signals.";
+
+  WebServer web((zypp::Pathname(TESTS_SRC_DIR)/"data"/"dummywebroot").c_str(), 10001, withSSL );
+  web.addRequestHandler("getData", WebServer::makeResponse("200 OK", dummyContent ) );
+  BOOST_REQUIRE( web.start() );
+
+  zyppng::Url weburl (web.url());
+  weburl.setPathName("/handler/getData");
+
+  auto ev = zyppng::EventLoop::create();
+  std::vector<std::shared_ptr<zyppng::NetworkRequestDispatcher>> disps;
+  for ( int i = 0; i < 2; i++ ) {
+    auto disp = std::make_shared<zyppng::NetworkRequestDispatcher>();
+    disp->sigQueueFinished().connect( [&ev]( const zyppng::NetworkRequestDispatcher& ){
+      ev->quit();
+    });
+    disp->run();
+    disps.push_back( disp );
+  }
+
+  const auto download = [&]( zyppng::NetworkRequestDispatcher &disp ) {
+    zypp::filesystem::TmpFile targetFile;
+    auto req = std::make_shared<zyppng::NetworkRequest>( weburl, targetFile.path() );
+    req->transferSettings() = web.transferSettings();
+    disp.enqueue( req );
+    if ( disp.count () ) ev->run();
+    BOOST_TEST_REQ_SUCCESS( req );
+  };
+
+  const auto statsBefore = zyppng::NetworkRequestDispatcher::shareStatistics();
+
+  // connections are not shared between dispatchers, only reused within one
+  download( *disps[0] );
+  download( *disps[1] );
+  download( *disps[0] );
+
+  const auto statsAfter = zyppng::NetworkRequestDispatcher::shareStatistics();
+  BOOST_REQUIRE_EQUAL( statsAfter.connectionMisses - statsBefore.connectionMisses, uint64_t(2) );
+  BOOST_REQUIRE_EQUAL( statsAfter.connectionHits - statsBefore.connectionHits, uint64_t(1) );
+  // DNS and TLS sessions are only looked at for new connections
+  BOOST_REQUIRE_LE( ( statsAfter.dnsHits + statsAfter.dnsMisses ) - ( statsBefore.dnsHits + statsBefore.dnsMisses ), uint64_t(2) );
+  BOOST_REQUIRE_LE( ( statsAfter.tlsSessionHits + statsAfter.tlsSessionMisses ) - ( statsBefore.tlsSessionHits + statsBefore.tlsSessionMisses ), uint64_t( withSSL ? 2 : 0 ) );
+}
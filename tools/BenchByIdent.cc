@@ -0,0 +1,140 @@
+#define INCLUDE_TESTSETUP_WITHOUT_BOOST
+#include "../tests/lib/TestSetup.h"
+#undef  INCLUDE_TESTSETUP_WITHOUT_BOOST
+
+#include <fstream>
+
+#include <zypp/base/Measure.h>
+#include <zypp/ResPoolProxy.h>
+
+static std::string appname( "BenchByIdent" );
+
+/** The resident set size of this process as reported in /proc/self/status. */
+std::string vmRSS()
+{
+  std::ifstream status( "/proc/self/status" );
+  for ( std::string line; std::getline( status, line ); )
+  {
+    if ( str::startsWith( line, "VmRSS:" ) )
+      return str::trim( line.substr( 6 ) );
+  }
+  return "?";
+}
+
+int errexit( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  return exit_r;
+}
+
+int usage( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  cerr << "Usage: " << appname << " [OPTIONS] REPO..." << endl;
+  cerr << "  Micro benchmark for the ResPool ident index (ResPool::byIdent)." << endl;
+  cerr << "  Load the REPOs (e.g. tests/data/openSUSE-11.1) and measure building" << endl;
+  cerr << "  the index, the ResPoolProxy and looking up the idents of all solvables." << endl;
+  cerr << "  The RSS is reported after building the store, and after creating the" << endl;
+  cerr << "  ResObjects of all items, as a store built them up front before." << endl;
+  cerr << "  Item access via PoolItem::operator-> measures the reference counting." << endl;
+  cerr << "  -n ROUNDS  Number of lookup rounds (default 10)." << endl;
+  cerr << "" << endl;
+  return exit_r;
+}
+
+/******************************************************************
+**
+**      FUNCTION NAME : main
+**      FUNCTION TYPE : int
+*/
+int main( int argc, char * argv[] )
+{
+  appname = Pathname::basename( argv[0] );
+  --argc,++argv;
+
+  unsigned rounds = 10;
+  while ( argc && (*argv)[0] == '-' )
+  {
+    if ( (*argv) == std::string("-n") )
+    {
+      --argc,++argv;
+      if ( ! argc )
+        return errexit("-n requires an argument.");
+      rounds = str::strtonum<unsigned>( *argv );
+    }
+    else
+      return usage( str::Str() << "Unknown option '" << *argv << "'" );
+    --argc,++argv;
+  }
+
+  if ( ! argc )
+    return usage();
+
+  TestSetup test( Arch_x86_64 );
+  for ( ; argc; --argc,++argv )
+  {
+    cout << "*** load repo '" << *argv << "'" << endl;
+    test.loadRepo( Pathname( *argv ).absolutename() );
+  }
+
+  ResPool pool( test.pool() );
+  sat::Pool satpool( test.satpool() );
+  cout << "*** " << satpool.solvablesSize() << " solvables in " << satpool.reposSize() << " repos" << endl;
+  cout << "*** RSS " << vmRSS() << " before building the store" << endl;
+
+  {
+    debug::Measure m( "build store", cout );
+    pool.size();
+    pool.begin();
+  }
+  cout << "*** RSS " << vmRSS() << " after building the store" << endl;
+  {
+    debug::Measure m( "create all ResObjects", cout );
+    for ( const PoolItem & pi : pool )
+      pi.resolvable();
+  }
+  cout << "*** RSS " << vmRSS() << " with all ResObjects created" << endl;
+  {
+    // PoolItem::operator-> returns a ResObject::constPtr, so this is dominated
+    // by the (atomic) reference counting.
+    debug::Measure m( str::Str() << rounds << " x access all items", cout );
+    unsigned long size = 0;
+    for ( unsigned round = 0; round < rounds; ++round )
+    {
+      for ( const PoolItem & pi : pool )
+        size += pi->installSize();
+    }
+    cout << "*** " << ByteCount( size ) << " total install size" << endl;
+  }
+  {
+    debug::Measure m( "build ident index", cout );
+    pool.byIdentBegin( IdString( "glibc" ) );
+  }
+  {
+    debug::Measure m( "build ResPoolProxy", cout );
+    pool.proxy();
+  }
+  {
+    debug::Measure m( str::Str() << rounds << " x byIdent of all solvables", cout );
+    unsigned long hits = 0;
+    for ( unsigned round = 0; round < rounds; ++round )
+    {
+      for ( const sat::Solvable & solv : satpool.solvables() )
+      {
+        for ( const PoolItem & pi : pool.byIdent( solv ) )
+        {
+          if ( pi.satSolvable() == solv )
+            ++hits;
+        }
+      }
+    }
+    cout << "*** " << hits << " hits" << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+#define INCLUDE_TESTSETUP_WITHOUT_BOOST
+#include "../tests/lib/TestSetup.h"
+#undef  INCLUDE_TESTSETUP_WITHOUT_BOOST
+
+#include <chrono>
+#include <thread>
+
+#include <zypp/base/Measure.h>
+#include <zypp/PoolQuery.h>
+
+static std::string appname( "BenchPoolQuery" );
+
+int errexit( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  return exit_r;
+}
+
+int usage( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  cerr << "Usage: " << appname << " [OPTIONS] REPO..." << endl;
+  cerr << "  Micro benchmark for sequential vs. parallel PoolQuery (PoolQuery::setParallel)." << endl;
+  cerr << "  Load the REPOs (e.g. tests/data/openSUSE-11.1 tests/data/11.0-update" << endl;
+  cerr << "  tests/data/OBS_zypp_svn-11.1) and search names, summaries and descriptions." << endl;
+  cerr << "  Prints the elapsed time of either run and the parallel speedup." << endl;
+  cerr << "  -n ROUNDS  Number of query rounds (default 10)." << endl;
+  cerr << "  -s STRING  Substring to search (default 'lib')." << endl;
+  cerr << "" << endl;
+  return exit_r;
+}
+
+/** Run \a rounds_r times \a query_r, remember the matches of the last round and return the elapsed time. */
+std::chrono::duration<double> run( const PoolQuery & query_r, unsigned rounds_r, std::vector<sat::Solvable> & matches_r )
+{
+  debug::Measure m( str::Str() << rounds_r << " x " << ( query_r.parallel() ? "parallel" : "sequential" ), cout );
+  auto start = std::chrono::steady_clock::now();
+  for ( unsigned round = 0; round < rounds_r; ++round )
+    matches_r.assign( query_r.begin(), query_r.end() );
+  return std::chrono::steady_clock::now() - start;
+}
+
+/******************************************************************
+**
+**      FUNCTION NAME : main
+**      FUNCTION TYPE : int
+*/
+int main( int argc, char * argv[] )
+{
+  appname = Pathname::basename( argv[0] );
+  --argc,++argv;
+
+  unsigned rounds = 10;
+  std::string search( "lib" );
+  while ( argc && (*argv)[0] == '-' )
+  {
+    if ( (*argv) == std::string("-n") )
+    {
+      --argc,++argv;
+      if ( ! argc )
+        return errexit("-n requires an argument.");
+      rounds = str::strtonum<unsigned>( *argv );
+    }
+    else if ( (*argv) == std::string("-s") )
+    {
+      --argc,++argv;
+      if ( ! argc )
+        return errexit("-s requires an argument.");
+      search = *argv;
+    }
+    else
+      return usage( str::Str() << "Unknown option '" << *argv << "'" );
+    --argc,++argv;
+  }
+
+  if ( ! argc )
+    return usage();
+
+  TestSetup test( Arch_x86_64 );
+  for ( ; argc; --argc,++argv )
+  {
+    cout << "*** load repo '" << *argv << "'" << endl;
+    test.loadRepo( Pathname( *argv ).absolutename() );
+  }
+
+  sat::Pool satpool( test.satpool() );
+  cout << "*** " << satpool.solvablesSize() << " solvables in " << satpool.reposSize() << " repos" << endl;
+
+  PoolQuery q;
+  q.addString( search );
+  q.addAttribute( sat::SolvAttr::name );
+  q.addAttribute( sat::SolvAttr::summary );
+  q.addAttribute( sat::SolvAttr::description );
+
+  // A parallel query loads paged descriptions into memory. Warm up, so both
+  // runs search the same in-memory data.
+  std::vector<sat::Solvable> sequential;
+  std::vector<sat::Solvable> parallel;
+  PoolQuery warmup( q );
+  warmup.setParallel();
+  run( warmup, 1, parallel );
+
+  std::chrono::duration<double> tseq { run( q, rounds, sequential ) };
+  q.setParallel();
+  std::chrono::duration<double> tpar { run( q, rounds, parallel ) };
+
+  cout << "*** " << sequential.size() << " matches" << endl;
+  cout << "*** sequential " << tseq.count() << "s, parallel " << tpar.count() << "s on "
+       << std::thread::hardware_concurrency() << " cpus: speedup " << ( tpar.count() ? tseq.count() / tpar.count() : 0.0 ) << endl;
+  if ( parallel != sequential )
+    return errexit( str::Str() << "Parallel query returned " << parallel.size() << " different matches!", 1 );
+  return 0;
+}
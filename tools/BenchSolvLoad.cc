@@ -0,0 +1,116 @@
+extern "C"
+{
+#include <fcntl.h>
+}
+
+#define INCLUDE_TESTSETUP_WITHOUT_BOOST
+#include "../tests/lib/TestSetup.h"
+#undef  INCLUDE_TESTSETUP_WITHOUT_BOOST
+
+#include <zypp/base/Measure.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/sat/WhatProvides.h>
+
+static std::string appname( "BenchSolvLoad" );
+
+int errexit( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  return exit_r;
+}
+
+int usage( const std::string & msg_r = std::string(), int exit_r = 100 )
+{
+  if ( ! msg_r.empty() )
+  {
+    cerr << endl << msg_r << endl << endl;
+  }
+  cerr << "Usage: " << appname << " [OPTIONS] SOLVFILE..." << endl;
+  cerr << "  Startup benchmark: load the SOLVFILEs (e.g. the solv files in /var/cache/zypp/solv)" << endl;
+  cerr << "  and measure the time to load them and the time to the first query." << endl;
+  cerr << "  Compare the results of two builds to see the effect of a change." << endl;
+  cerr << "  -n ROUNDS  Number of load rounds (default 5)." << endl;
+  cerr << "  -q NAME    Capability to query (default 'glibc')." << endl;
+  cerr << "  --cold     Drop the files from the page cache before each round." << endl;
+  cerr << "" << endl;
+  return exit_r;
+}
+
+/** Ask the kernel to drop the (clean) cached pages of \a file_r. */
+void dropFromPageCache( const Pathname & file_r )
+{
+  AutoFD fd( ::open( file_r.c_str(), O_RDONLY | O_CLOEXEC ) );
+  if ( fd != -1 )
+    ::posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+}
+
+/******************************************************************
+**
+**      FUNCTION NAME : main
+**      FUNCTION TYPE : int
+*/
+int main( int argc, char * argv[] )
+{
+  appname = Pathname::basename( argv[0] );
+  --argc,++argv;
+
+  unsigned rounds = 5;
+  std::string query( "glibc" );
+  bool cold = false;
+  while ( argc && (*argv)[0] == '-' )
+  {
+    if ( (*argv) == std::string("-n") )
+    {
+      --argc,++argv;
+      if ( ! argc )
+        return errexit("-n requires an argument.");
+      rounds = str::strtonum<unsigned>( *argv );
+    }
+    else if ( (*argv) == std::string("-q") )
+    {
+      --argc,++argv;
+      if ( ! argc )
+        return errexit("-q requires an argument.");
+      query = *argv;
+    }
+    else if ( (*argv) == std::string("--cold") )
+      cold = true;
+    else
+      return usage( str::Str() << "Unknown option '" << *argv << "'" );
+    --argc,++argv;
+  }
+
+  if ( ! argc )
+    return usage();
+
+  std::vector<Pathname> solvfiles;
+  for ( ; argc; --argc,++argv )
+    solvfiles.push_back( Pathname( *argv ).absolutename() );
+
+  TestSetup test( Arch_x86_64 );
+  sat::Pool satpool( test.satpool() );
+
+  for ( unsigned round = 0; round < rounds; ++round )
+  {
+    satpool.reposEraseAll();
+    if ( cold )
+    {
+      for ( const Pathname & file : solvfiles )
+        dropFromPageCache( file );
+    }
+
+    cout << "*** round " << round+1 << " of " << rounds << (cold ? " (cold)" : "") << endl;
+    debug::Measure m( "time to first query", cout );
+    {
+      debug::Measure l( str::Str() << "load " << solvfiles.size() << " solv files", cout );
+      for ( const Pathname & file : solvfiles )
+        satpool.addRepoSolv( file );
+    }
+    sat::WhatProvides q( (Capability( query )) );
+    cout << "*** " << satpool.solvablesSize() << " solvables, " << q.size() << " provide '" << query << "'" << endl;
+  }
+  return 0;
+}
@@ -11,6 +11,7 @@
 #include <zypp-core/zyppng/base/EventDispatcher>
 #include <zypp-core/zyppng/base/Signals>
 #include <zypp-core/base/String.h>
+#include <algorithm>
 #include <iostream>
 
 namespace zyppng {
@@ -18,6 +19,9 @@ namespace zyppng {
   constexpr uint penaltyIncrease = 100;
   constexpr uint defaultSampleTime = 2;
   constexpr uint defaultMaxConnections = 5;
+  constexpr uint adaptiveMaxConnections = 2 * defaultMaxConnections; // upper limit for fast mirrors without a metalink maxconnections value
+  constexpr double slowMirrorShare = 0.25; // mirrors below this share of the best throughput are considered slow
+  constexpr double fastMirrorShare = 0.5;  // mirrors above this share of the best throughput may get more connections
 
   MirrorControl::Mirror::Mirror( MirrorControl &parent ) : _parent( parent )
   {}
@@ -27,15 +31,34 @@ namespace zyppng {
     runningTransfers++;
   }
 
-  void MirrorControl::Mirror::finishTransfer(const bool success)
+  void MirrorControl::Mirror::finishTransfer( const bool success, const zypp::ByteCount bytes, const std::chrono::microseconds duration )
   {
+    const uint curLimit = maxConnections();
+    _measured = true;
     if ( success ) {
-      if ( penalty >= penaltyIncrease ) penalty -= penaltyIncrease;
       successfulTransfers++;
       failedTransfers = 0;
+
+      if ( bytes > 0 && duration.count() > 0 ) {
+        const uint64_t sample = static_cast<uint64_t>( bytes ) * 1000000 / duration.count();
+        // exponential moving average, so a single slow or fast chunk does not flip the picture
+        bytesPerSecond = ( _liveSamples ? ( 3 * bytesPerSecond + sample ) / 4 : sample );
+        _liveSamples++;
+
+        const uint upperLimit = ( _maxConnections > 0 ? _maxConnections : adaptiveMaxConnections );
+        const double share = relativeThroughput();
+        if ( share < slowMirrorShare ) {
+          _connectionLimit = std::max<uint>( 1, curLimit / 2 );
+        } else if ( share >= fastMirrorShare && runningTransfers >= curLimit && curLimit < upperLimit ) {
+          _connectionLimit = curLimit + 1;
+        }
+
+        if ( _connectionLimit && _connectionLimit != curLimit )
+          DBG_MEDIA << "Mirror " << mirrorUrl << " throughput " << zypp::ByteCount( bytesPerSecond ) << "/s, connections " << curLimit << " -> " << _connectionLimit << std::endl;
+      }
     } else {
-      penalty += penaltyIncrease;
       failedTransfers++;
+      _connectionLimit = std::max<uint>( 1, curLimit / 2 );
     }
     transferUnref();
   }
@@ -47,9 +70,56 @@ namespace zyppng {
 
   uint MirrorControl::Mirror::maxConnections() const
   {
+    if ( _connectionLimit > 0 )
+      return _connectionLimit;
     return ( _maxConnections > 0 ? _maxConnections : defaultMaxConnections ); //max connections per mirror @todo make this configurable
   }
 
+  double MirrorControl::Mirror::relativeThroughput() const
+  {
+    if ( !_liveSamples )
+      return 1.0;
+
+    uint64_t best = 0;
+    for ( const auto &hdl : _parent._handles ) {
+      if ( hdl.second->_liveSamples )
+        best = std::max( best, hdl.second->bytesPerSecond );
+    }
+    return ( best ? static_cast<double>( bytesPerSecond ) / best : 1.0 );
+  }
+
+  double MirrorControl::Mirror::relativeThroughput( const std::vector<Url> &peers ) const
+  {
+    if ( !_liveSamples )
+      return 1.0;
+
+    uint64_t best = bytesPerSecond;
+    for ( const auto &url : peers ) {
+      const auto hdlIt = _parent._handles.find( _parent.makeKey( url ) );
+      if ( hdlIt != _parent._handles.end() && hdlIt->second->_liveSamples )
+        best = std::max( best, hdlIt->second->bytesPerSecond );
+    }
+    return ( best ? static_cast<double>( bytesPerSecond ) / best : 1.0 );
+  }
+
+  bool MirrorControl::Mirror::isSlow( const std::vector<Url> &peers ) const
+  {
+    return ( relativeThroughput( peers ) < slowMirrorShare );
+  }
+
+  bool MirrorControl::Mirror::isFast( const std::vector<Url> &peers ) const
+  {
+    return ( _liveSamples && relativeThroughput( peers ) >= fastMirrorShare );
+  }
+
+  uint64_t MirrorControl::Mirror::score() const
+  {
+    uint64_t msPerMiB = 0;
+    if ( bytesPerSecond )
+      msPerMiB = ( uint64_t(1024) * 1024 * 1000 ) / bytesPerSecond;
+    return uint64_t( rating ) + uint64_t( failedTransfers ) * penaltyIncrease + msPerMiB;
+  }
+
   bool MirrorControl::Mirror::hasFreeConnections() const
   {
     return ( runningTransfers < maxConnections() );
@@ -121,6 +191,25 @@ namespace zyppng {
       }
     }
 
+    if ( _stats ) {
+      for ( const auto &mirr : _handles ) {
+        const auto &hdl = mirr.second;
+        if ( !hdl->_measured )
+          continue;
+        zypp::media::MirrorStatistics::Entry sample;
+        sample.latencyMs      = hdl->_connectTime;
+        sample.bytesPerSecond = hdl->bytesPerSecond;
+        sample.failures       = hdl->failedTransfers + ( hdl->_probeFailed ? 1 : 0 );
+        sample.successes      = hdl->successfulTransfers;
+        _stats->update( hdl->mirrorUrl, sample );
+      }
+      _stats->removeExpired();
+    }
+  }
+
+  void MirrorControl::setStatistics( std::shared_ptr<zypp::media::MirrorStatistics> stats )
+  {
+    _stats = std::move(stats);
   }
 
   void MirrorControl::registerMirrors( const std::vector<zypp::media::MetalinkMirror> &urls )
@@ -146,6 +235,19 @@ namespace zyppng {
         mirrorHandle->mirrorUrl       = mirror.url;
         mirrorHandle->mirrorUrl.setPathName("/");
 
+        // a mirror we know from a previous run does not need to be probed again
+        if ( _stats ) {
+          if ( const auto entry = _stats->lookup( mirrorHandle->mirrorUrl ) ) {
+            mirrorHandle->rating         += entry->latencyMs;
+            mirrorHandle->bytesPerSecond  = entry->bytesPerSecond;
+            mirrorHandle->failedTransfers = entry->failures;
+            DBG_MEDIA << "Seeded mirror " << mirrorHandle->mirrorUrl << " from statistics, rating is " << mirrorHandle->rating << std::endl;
+            _handles.insert( std::make_pair(urlKey, mirrorHandle ) );
+            doesKnowSomeMirrors = true;
+            continue;
+          }
+        }
+
         mirrorHandle->_request = std::make_shared<NetworkRequest>( mirrorHandle->mirrorUrl, "/dev/null", NetworkRequest::WriteShared );
         mirrorHandle->_request->setOptions( NetworkRequest::ConnectionTest );
         mirrorHandle->_request->transferSettings().setTimeout( defaultSampleTime );
@@ -154,6 +256,7 @@ namespace zyppng {
 
           if ( req.hasError() )
             ERR << "Mirror request failed: " << req.error().toString() << " ; " << req.extendedErrorString() << "; for url: "<<req.url()<<std::endl;
+          mirrorHandle->_probeFailed = req.hasError();
 
           const auto timings = req.timings();
           std::chrono::milliseconds connTime;
@@ -166,6 +269,8 @@ namespace zyppng {
 
           DBG_MEDIA << "Got rating for mirror: " <<  mirrorHandle->mirrorUrl << ", rating was " << mirrorHandle->rating;
           mirrorHandle->rating += connTime.count();
+          mirrorHandle->_connectTime = connTime.count();
+          mirrorHandle->_measured = true;
           DBG_MEDIA << " rating is now " << mirrorHandle->rating << " conn time was " << connTime.count() << std::endl;
 
           // clean the request up
@@ -212,8 +317,9 @@ namespace zyppng {
       return PickResult{ PickResult::Again, std::make_pair( mirrors.end(), MirrorHandle() ) };
     }
 
+    // measured throughput and recent failures are taken into account, not only the initial connect time
     std::stable_sort( possibleMirrs.begin(), possibleMirrs.end(), []( const auto &a, const auto &b ) {
-      return a.second->rating < b.second->rating;
+      return a.second->score() < b.second->score();
     });
 
     bool hasLoadedOne = false; // do we have a mirror that will be ready again later?
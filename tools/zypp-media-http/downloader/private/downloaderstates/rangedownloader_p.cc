@@ -50,8 +50,10 @@ namespace zyppng {
 
     //feed the working URL back into the mirrors in case there are still running requests that might fail
     // @TODO , finishing the transfer might never be called in case of cancelling the request, need a better way to track running transfers
-    if ( reqLocked->_myMirror )
-      reqLocked->_myMirror->finishTransfer( !err.isError() );
+    if ( reqLocked->_myMirror ) {
+      const auto timings = req.timings();
+      reqLocked->_myMirror->finishTransfer( !err.isError(), req.downloadedByteCount(), ( timings ? timings->total : std::chrono::microseconds() ) );
+    }
 
     if ( err.isError() ) {
       return handleRequestError( reqLocked, err );
@@ -76,10 +78,23 @@ namespace zyppng {
       return true;
     };
 
+    //steer the remaining blocks away from a slow mirror if there are other mirrors left to pick from,
+    //it goes to the end of the list and is still used when the others are busy
+    if ( ( _ranges.size() || _failedRanges.size() ) && reqLocked->_myMirror && reqLocked->_myMirror->isSlow( _mirrorsOfFile ) ) {
+      _fileMirrors.erase( std::remove( _fileMirrors.begin(), _fileMirrors.end(), reqLocked->_originalUrl ), _fileMirrors.end() );
+      const bool haveOthers = !_fileMirrors.empty();
+      _fileMirrors.push_back( reqLocked->_originalUrl );
+      if ( haveOthers ) {
+        MIL  << req.nativeHandle() << " " << "Mirror " << reqLocked->_originalUrl << " is slow, not reusing it for the remaining blocks." << std::endl;
+        ensureDownloadsRunning();
+        return;
+      }
+    }
+
     //check if we already have enqueued all blocks if not reuse the request
     if ( _ranges.size() ) {
       MIL  << req.nativeHandle() << " " << "Reusing to download blocks: "<<std::endl;
-      if ( !restartReqWithBlock( reqLocked, getNextBlocks( reqLocked->url().getScheme() ) ) ) {
+      if ( !restartReqWithBlock( reqLocked, getNextBlocks( reqLocked->url().getScheme(), chunkSizeFor( reqLocked->_myMirror ) ) ) ) {
         return setFailed( "Failed to restart request with new blocks." );
       }
       return;
@@ -98,7 +113,9 @@ namespace zyppng {
     }
 
     //feed the working URL back into the mirrors in case there are still running requests that might fail
-    _fileMirrors.push_back( reqLocked->_originalUrl );
+    //(a fast mirror may still be in the list)
+    if ( std::find( _fileMirrors.begin(), _fileMirrors.end(), reqLocked->_originalUrl ) == _fileMirrors.end() )
+      _fileMirrors.push_back( reqLocked->_originalUrl );
 
     // make sure downloads are running, at this point
     ensureDownloadsRunning();
@@ -224,7 +241,7 @@ namespace zyppng {
       return;
     }
 
-    auto blocks = getNextBlocks( myUrl.getScheme() );
+    auto blocks = getNextBlocks( myUrl.getScheme(), chunkSizeFor( mirror.second ) );
     if ( !blocks.size() )
       blocks = getNextFailedBlocks( myUrl.getScheme() );
 
@@ -253,11 +270,14 @@ namespace zyppng {
       return;
     }
 
-    // we just use a mirror once per file, remove it from the list
-    _fileMirrors.erase( mirror.first );
-
     addNewRequest( req );
 
+    // we usually use a mirror once per file, remove it from the list. A mirror that proved to be
+    // fast is kept, so it gets more of the connections it is allowed to (see MirrorControl::Mirror::maxConnections)
+    const bool keepMirror = ( mirror.second && mirror.second->isFast( _mirrorsOfFile ) && mirror.second->hasFreeConnections() );
+    if ( !keepMirror )
+      _fileMirrors.erase( mirror.first );
+
     // trigger next downloads
     ensureDownloadsRunning();
   }
@@ -364,10 +384,18 @@ namespace zyppng {
     }
   }
 
-  std::vector<RangeDownloaderBaseState::Block> RangeDownloaderBaseState::getNextBlocks( const std::string &urlScheme )
+  zypp::ByteCount RangeDownloaderBaseState::chunkSizeFor( const MirrorControl::MirrorHandle &mirror ) const
+  {
+    // slower mirrors get smaller chunks, so they hold back less of the download
+    if ( !mirror )
+      return _preferredChunkSize;
+    return zypp::ByteCount( static_cast<zypp::ByteCount::SizeType>( _preferredChunkSize * mirror->relativeThroughput( _mirrorsOfFile ) ) );
+  }
+
+  std::vector<RangeDownloaderBaseState::Block> RangeDownloaderBaseState::getNextBlocks( const std::string &urlScheme, const zypp::ByteCount chunkSize )
   {
     std::vector<Block> blocks;
-    const auto prefSize = std::max<zypp::ByteCount>( _preferredChunkSize, zypp::ByteCount(4, zypp::ByteCount::K) );
+    const auto prefSize = std::max<zypp::ByteCount>( chunkSize, zypp::ByteCount(4, zypp::ByteCount::K) );
     size_t accumulatedSize = 0;
 
     bool canDoRandomBlocks = ( zypp::str::hasPrefixCI( urlScheme, "http") );
@@ -32,6 +32,7 @@ namespace zyppng {
     RangeDownloaderBaseState ( std::vector<Url> &&mirrors, DownloadPrivate &parent ) :
       MirrorHandlingStateBase(parent) {
       _fileMirrors = std::move(mirrors);
+      _mirrorsOfFile = _fileMirrors;
     }
 
     void ensureDownloadsRunning ();
@@ -72,6 +73,8 @@ namespace zyppng {
 
     std::vector< std::shared_ptr<Request> > _runningRequests;
 
+    std::vector<Url> _mirrorsOfFile; //< all mirrors of the file, including the ones currently in use, to compare their throughput
+
     // we only define the signals here and add the accessor functions in the subclasses, static casting of
     // the class type is not allowed at compile time, so they would not be useable in the transition table otherwise
     Signal< void () > _sigFinished;
@@ -83,7 +86,8 @@ namespace zyppng {
     void addNewRequest     (const std::shared_ptr<Request>& req, const bool connectSignals = true );
     bool assertExpectedFilesize ( off_t currentFilesize );
 
-    std::vector<Block> getNextBlocks ( const std::string &urlScheme );
+    zypp::ByteCount chunkSizeFor ( const MirrorControl::MirrorHandle &mirror ) const;
+    std::vector<Block> getNextBlocks ( const std::string &urlScheme, const zypp::ByteCount chunkSize );
     std::vector<Block> getNextFailedBlocks( const std::string &urlScheme );
   };
 
@@ -21,6 +21,8 @@
 #include <zypp-curl/ng/network/networkrequestdispatcher.h>
 #include <zypp-curl/ng/network/request.h>
 #include <zypp-curl/parser/MetaLinkParser>
+#include <zypp-curl/MirrorStatistics>
+#include <chrono>
 #include <vector>
 #include <unordered_map>
 
@@ -34,19 +36,55 @@ namespace zyppng {
 
       Url mirrorUrl;
       uint rating              = 100; // rating based on connection time higher is worse
-      uint penalty             = 0; //additional value that is added to the rating when sorting the mirrors, is increased and lowered for failed or successful transactions
       uint maxRanges           = 0; //the maximum number of ranges that can be requested from this mirror
       uint finishedTransfers   = 0; //how many transfers did we already send to the mirror
       uint runningTransfers    = 0; //currently running transfers
-      uint failedTransfers     = 0; //how many transfers have failed in a row using this mirror
+      uint failedTransfers     = 0; //how many transfers have failed in a row using this mirror, each adds a penalty to the score
       uint successfulTransfers = 0; //how many transfers were successful
+      uint64_t bytesPerSecond  = 0; //smoothed throughput measured during transfers, 0 if not yet known
 
       void startTransfer();
-      void finishTransfer( const bool success );
+      /*!
+       * Finish a transfer. If \a bytes and \a duration are given, they are used to update
+       * the mirrors throughput and to adapt the number of concurrent connections:
+       * fast mirrors that are fully loaded get more connections, slow or failing ones less.
+       */
+      void finishTransfer( const bool success, const zypp::ByteCount bytes = 0, const std::chrono::microseconds duration = {} );
       void cancelTransfer();
       uint maxConnections () const;
       bool hasFreeConnections () const;
 
+      /*!
+       * The mirrors throughput relative to the fastest mirror measured in this run (0..1],
+       * 1 if the throughput was not yet measured. Throughputs just seeded from the
+       * \ref zypp::media::MirrorStatistics are not compared.
+       */
+      double relativeThroughput () const;
+
+      /*!
+       * \overload Relative to the fastest of the mirrors \a peers (e.g. those serving the same file).
+       */
+      double relativeThroughput ( const std::vector<Url> &peers ) const;
+
+      /*!
+       * Whether the mirror is much slower than the fastest of \a peers, so remaining
+       * work should rather be steered to other mirrors.
+       */
+      bool isSlow ( const std::vector<Url> &peers ) const;
+
+      /*!
+       * Whether the mirror has a measured throughput close to the fastest of \a peers,
+       * so it may take more than one connection per file.
+       */
+      bool isFast ( const std::vector<Url> &peers ) const;
+
+      /*!
+       * The value used to sort the mirrors, lower is better.
+       * Combines rating, a penalty for the failed transfers in a row and the time it takes
+       * to transfer 1MiB at the measured throughput.
+       */
+      uint64_t score () const;
+
     private:
       Mirror( MirrorControl &parent );
       void transferUnref ();
@@ -58,6 +96,11 @@ namespace zyppng {
       sigc::connection _finishedConn;
 
       uint _maxConnections      = 0; //the maximum number of concurrent connections to this mirror, 0 means use system default
+      uint _connectionLimit     = 0; //the adapted number of concurrent connections to this mirror, 0 means not yet adapted
+      uint64_t _connectTime     = 0; //connect time in ms measured when probing the mirror, 0 if not probed
+      bool _probeFailed         = false; //the probing request failed
+      bool _measured            = false; //we have measurements worth storing in the statistics cache
+      uint _liveSamples         = 0; //throughput samples taken in this run, bytesPerSecond may just be seeded from the statistics
     };
 
     using Ptr = std::shared_ptr<MirrorControl>;
@@ -68,6 +111,13 @@ namespace zyppng {
     ~MirrorControl() override;
     void registerMirrors( const std::vector<zypp::media::MetalinkMirror> &urls );
 
+    /*!
+     * Use \a stats to seed the ratings of newly registered mirrors, mirrors with a
+     * valid entry are not probed again. The measurements of this run are merged back
+     * into \a stats when the MirrorControl is destroyed.
+     */
+    void setStatistics( std::shared_ptr<zypp::media::MirrorStatistics> stats );
+
     /*!
      * Tries to pick the best mirror from the set of URLs passed.
      * In case of a pending request, the result code will be set to "Again".
@@ -92,6 +142,7 @@ namespace zyppng {
     sigc::connection _queueEmptyConn;
     NetworkRequestDispatcher::Ptr _dispatcher; //Mirror Control using its own NetworkRequestDispatcher, to avoid waiting for other downloads
     std::unordered_map<std::string, MirrorHandle> _handles;
+    std::shared_ptr<zypp::media::MirrorStatistics> _stats;
 
     Timer::Ptr _newMirrSigDelay; // we use a delay timer to emit the "someMirrorsReady" signal
 
@@ -12,10 +12,13 @@
 #include <zypp-curl/parser/MetaLinkParser>
 #include <zypp-core/fs/PathInfo.h>
 #include <zypp-core/CheckSum.h>
+#include <zypp-core/base/String.h>
 #include <zypp-media/ng/private/providedbg_p.h>
+#include <zypp-media/MediaConfig>
 
 #include <downloader/downloader.h>
 #include <downloader/downloadspec.h>
+#include <downloader/private/mirrorcontrol_p.h>
 
 
 #undef ZYPP_BASE_LOGGER_LOGGROUP
@@ -89,7 +92,8 @@ void NetworkProvideItem::onAuthRequired( zyppng::Download &, zyppng::NetworkAuth
 
 NetworkProvider::NetworkProvider( std::string_view workerName )
   : zyppng::worker::ProvideWorker( workerName )
-  , _dlManager( std::make_shared<zyppng::Downloader>() )
+  , _mirrorControl( zyppng::MirrorControl::create() )
+  , _dlManager( std::make_shared<zyppng::Downloader>( _mirrorControl ) )
 {
   // we only want to hear about new provides
   setProvNotificationMode( ProvideWorker::ONLY_NEW_PROVIDES );
@@ -113,6 +117,11 @@ zyppng::expected<zyppng::worker::WorkerCaps> NetworkProvider::initialize( const
     MIL << "Got anonymous ID setting from controller" << std::endl;
     _dlManager->requestDispatcher()->setHostSpecificHeader("download.opensuse.org", "X-ZYpp-AnonymousId", val );
   }
+  if ( const auto &i = conf.find( std::string(zyppng::MIRROR_STATS_PATH) ); i != iEnd ) {
+    const auto &val = i->second;
+    MIL << "Using mirror statistics from: " << val << std::endl;
+    _mirrorControl->setStatistics( std::make_shared<zypp::media::MirrorStatistics>( val ) );
+  }
   if ( const auto &i = conf.find( std::string(zyppng::ATTACH_POINT) ); i != iEnd ) {
     const auto &val = i->second;
     MIL << "Got attachpoint from controller: " << val << std::endl;
@@ -121,6 +130,10 @@ zyppng::expected<zyppng::worker::WorkerCaps> NetworkProvider::initialize( const
     return zyppng::expected<zyppng::worker::WorkerCaps>::error(ZYPP_EXCPT_PTR( zypp::Exception("Attach point required to work.") ));
   }
 
+  // the zconfig://main settings were already applied to the MediaConfig
+  if ( zypp::MediaConfig::instance().download_http2_multiplexing() )
+    _dlManager->requestDispatcher()->setMultiplexingEnabled( true );
+
   zyppng::worker::WorkerCaps caps;
   caps.set_worker_type ( zyppng::worker::WorkerCaps::Downloading );
   caps.set_cfg_flags(
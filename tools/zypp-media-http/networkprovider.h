@@ -17,6 +17,7 @@
 
 namespace zyppng {
   class Downloader;
+  class MirrorControl;
   class Download;
 }
 
@@ -69,6 +70,7 @@ protected:
   void itemAuthRequired (NetworkProvideItemRef item, zyppng::NetworkAuthData &auth, const std::string &);
 
 private:
+  std::shared_ptr<zyppng::MirrorControl> _mirrorControl;
   std::shared_ptr<zyppng::Downloader> _dlManager;
   zypp::Pathname _attachPoint;
 };
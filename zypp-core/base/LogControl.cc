@@ -25,8 +25,6 @@
 #include <zypp-core/AutoDispose.h>
 
 #include <utility>
-#include <zypp-core/zyppng/io/Socket>
-#include <zypp-core/zyppng/io/SockAddr>
 #include <zypp-core/zyppng/base/EventLoop>
 #include <zypp-core/zyppng/base/EventDispatcher>
 #include <zypp-core/zyppng/base/Timer>
@@ -38,7 +36,13 @@
 #include <thread>
 #include <variant>
 #include <atomic>
+#include <algorithm>
 #include <csignal>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
 
 extern "C"
 {
@@ -47,6 +51,7 @@ extern "C"
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/uio.h>
 }
 
 using std::endl;
@@ -81,6 +86,72 @@ namespace zypp
     std::atomic_flag _atomicLock = ATOMIC_FLAG_INIT;
   };
 
+  /*!
+   * \internal A lock-free single producer, single consumer ring of log lines.
+   *
+   * The thread owning the ring appends complete lines (each terminated by NL),
+   * the \ref LogThread drains whatever is available in one go. As the data are
+   * just consecutive lines, a drain is at most two contiguous chunks, which can
+   * be written to a file with a single writev.
+   *
+   * If a line does not fit, the producer gives the log thread a short chance
+   * to catch up. After that the line is dropped and counted.
+   */
+  class LogRing
+  {
+  public:
+    static constexpr size_t capacity = 512 * 1024;	// must be a power of 2
+
+    LogRing()
+    : _buf( new char[capacity] )
+    {}
+
+    /** Producer: Append \a line_r, \c false if it does not fit. */
+    bool push( std::string_view line_r )
+    {
+      size_t head = _head.load( std::memory_order_relaxed );
+      size_t tail = _tail.load( std::memory_order_acquire );
+      if ( line_r.size() > capacity - ( head - tail ) )
+        return false;
+
+      size_t off   = head & ( capacity - 1 );
+      size_t first = std::min( line_r.size(), capacity - off );
+      ::memcpy( _buf.get() + off, line_r.data(), first );
+      ::memcpy( _buf.get(), line_r.data() + first, line_r.size() - first );
+      // seq_cst: pairs with LogThread::_sleeping, see LogThread::notifyData
+      _head.store( head + line_r.size() );
+      return true;
+    }
+
+    /** Consumer: The available data as up to two chunks. \returns their total size. */
+    size_t peek( std::string_view (&chunks_r)[2] ) const
+    {
+      size_t tail = _tail.load( std::memory_order_relaxed );
+      size_t size = _head.load() - tail;
+      size_t off  = tail & ( capacity - 1 );
+      size_t first = std::min( size, capacity - off );
+      chunks_r[0] = std::string_view( _buf.get() + off, first );
+      chunks_r[1] = std::string_view( _buf.get(), size - first );
+      return size;
+    }
+
+    /** Consumer: Release \a size_r bytes returned by \ref peek. */
+    void consume( size_t size_r )
+    { _tail.store( _tail.load( std::memory_order_relaxed ) + size_r, std::memory_order_release ); }
+
+    bool empty() const
+    { return _head.load() == _tail.load( std::memory_order_relaxed ); }
+
+    std::atomic<bool>     _closed { false };	///< the producing thread is gone
+    std::atomic<uint64_t> _dropped { 0 };	///< lines dropped because the ring was full
+    uint64_t              _droppedReported = 0;	///< consumer: dropped lines already reported
+
+  private:
+    std::unique_ptr<char[]> _buf;
+    std::atomic<size_t> _head { 0 };	///< written by the producer
+    std::atomic<size_t> _tail { 0 };	///< written by the consumer
+  };
+
   class LogThread
   {
 
@@ -110,7 +181,7 @@ namespace zypp
 
     void stop () {
       _stopSignal.notify();
-      if ( _thread.get_id() != std::this_thread::get_id() )
+      if ( _thread.joinable() && _thread.get_id() != std::this_thread::get_id() )
         _thread.join();
     }
 
@@ -118,9 +189,34 @@ namespace zypp
       return _thread.get_id();
     }
 
-    static std::string sockPath () {
-      static std::string path = zypp::str::Format("zypp-logsocket-%1%") % getpid();
-      return path;
+    /*!
+     * Creates the ring buffer a thread writes its log lines to.
+     */
+    std::shared_ptr<LogRing> registerRing () {
+      auto ring = std::make_shared<LogRing>();
+      std::lock_guard lk( _ringsLock );
+      _rings.push_back( ring );
+      return ring;
+    }
+
+    /*!
+     * Called by a producer after pushing to its ring. Wakes up the log
+     * thread, unless it is still draining anyway.
+     */
+    void notifyData () {
+      // _sleeping is set by the log thread before it checks the rings a last
+      // time. Both sides use seq_cst, so either we see the flag or the log
+      // thread sees our data.
+      if ( _sleeping.exchange( false ) )
+        _dataSignal.notify();
+    }
+
+    void countDropped () {
+      ++_droppedLines;
+    }
+
+    uint64_t droppedLines () const {
+      return _droppedLines.load( std::memory_order_relaxed );
     }
 
   private:
@@ -142,71 +238,95 @@ namespace zypp
       zyppng::ThreadData::current().setName("Zypp-Log");
 
       auto ev = zyppng::EventLoop::create();
-      auto server = zyppng::Socket::create( AF_UNIX, SOCK_STREAM, 0 );
       auto stopNotifyWatch = _stopSignal.makeNotifier( );
+      auto dataNotifyWatch = _dataSignal.makeNotifier( );
 
-      std::vector<zyppng::Socket::Ptr> clients;
-
-      // bind to a abstract unix domain socket address, which means we do not need to care about cleaning it up
-      server->bind( std::make_shared<zyppng::UnixSockAddr>( sockPath(), true ) );
-      server->listen();
-
-      // wait for incoming connections from other threads
-      server->connectFunc( &zyppng::Socket::sigIncomingConnection, [&](){
-
-        auto cl = server->accept();
-        if ( !cl ) return;
-        clients.push_back( cl );
-
-        // wait until data is available, we operate line by line so we only
-        // log a string once we encounter \n
-        cl->connectFunc( &zyppng::Socket::sigReadyRead, [ this, sock = cl.get() ](){
-          auto writer = getLineWriter();
-          if ( !writer ) return;
-          while ( sock->canReadLine() ) {
-            auto br = sock->readLine();
-            writer->writeOut( std::string( br.data(), br.size() - 1 ) );
-          }
-        }, *cl);
-
-        // once a client disconnects we remove it from the std::vector so that the socket is not leaked
-        cl->connectFunc( &zyppng::Socket::sigDisconnected, [&clients, sock = std::weak_ptr(cl)](){
-          auto lock = sock.lock();
-          if ( !lock  )
-            return;
-
-          auto idx = std::find_if( clients.begin(), clients.end(), [lock]( const auto &s ){ return lock.get() == s.get(); } );
-          clients.erase( idx );
-        });
-
+      dataNotifyWatch->connectFunc( &zyppng::SocketNotifier::sigActivated, [this]( const auto &, auto ) {
+        _dataSignal.ack();
+        drainAll();
       });
 
       stopNotifyWatch->connectFunc( &zyppng::SocketNotifier::sigActivated, [&ev]( const auto &, auto ) {
         ev->quit();
       });
 
+      drainAll();
       ev->run();
 
       // make sure we have written everything
-      auto writer = getLineWriter();
-      if ( writer ) {
-        for ( auto &sock : clients ){
-          auto br = sock->readLine();
-          while ( !br.empty() ) {
-            if ( br.back () == '\n' )
-              writer->writeOut( std::string( br.data(), br.size() - 1 ) );
-            else
-              writer->writeOut( std::string( br.data(), br.size() ) );
-
-            br = sock->readLine();
+      drainAll();
+    }
+
+    /*!
+     * Drain all rings until they are empty, then go to sleep.
+     */
+    void drainAll () {
+      while ( true ) {
+        std::vector<std::shared_ptr<LogRing>> rings;
+        {
+          std::lock_guard lk( _ringsLock );
+          // rings of finished threads are dropped once they are drained
+          _rings.erase( std::remove_if( _rings.begin(), _rings.end(), []( const auto & r ) { return r->_closed && r->empty(); } ), _rings.end() );
+          rings = _rings;
+        }
+
+        auto writer = getLineWriter();
+        for ( const auto & ring : rings )
+          drainRing( *ring, writer );
+
+        _sleeping.store( true );
+        if ( std::none_of( rings.begin(), rings.end(), []( const auto & r ) { return !r->empty(); } ) )
+          break;
+        // lost the race against a producer that did not notify
+        _sleeping.store( false );
+      }
+    }
+
+    void drainRing ( LogRing & ring, const zypp::shared_ptr<log::LineWriter> & writer ) {
+      uint64_t dropped = ring._dropped.load( std::memory_order_relaxed );
+      if ( dropped != ring._droppedReported && writer ) {
+        writer->writeOut( str::Str() << "---<LOG BUFFER FULL] " << ( dropped - ring._droppedReported ) << " lines dropped" );
+        ring._droppedReported = dropped;
+      }
+
+      std::string_view chunks[2];
+      size_t size = ring.peek( chunks );
+      if ( !size )
+        return;
+
+      if ( !writer ) {
+        // discard
+      } else if ( typeid(*writer) == typeid(log::FileLineWriter) ) {
+        // not derived, so writeOut is not overloaded
+        static_cast<log::FileLineWriter &>(*writer).writeBatch( chunks[0], chunks[1] );
+      } else {
+        std::string wrapped;
+        for ( std::string_view chunk : chunks ) {
+          for ( size_t pos = chunk.find( '\n' ); pos != std::string_view::npos; pos = chunk.find( '\n' ) ) {
+            if ( wrapped.empty() ) {
+              writer->writeOut( std::string( chunk.substr( 0, pos ) ) );
+            } else {
+              wrapped.append( chunk.substr( 0, pos ) );
+              writer->writeOut( wrapped );
+              wrapped.clear();
+            }
+            chunk.remove_prefix( pos + 1 );
           }
+          wrapped.append( chunk );
         }
       }
+      ring.consume( size );
     }
 
   private:
     std::thread _thread;
     zyppng::Wakeup _stopSignal;
+    zyppng::Wakeup _dataSignal;
+    std::atomic<bool> _sleeping { false };	///< log thread waits for _dataSignal
+
+    std::mutex _ringsLock;
+    std::vector<std::shared_ptr<LogRing>> _rings;
+    std::atomic<uint64_t> _droppedLines { 0 };
 
     // since the public API uses boost::shared_ptr (via the alias zypp::shared_ptr) we can not use the atomic
     // functionalities provided in std.
@@ -229,22 +349,11 @@ namespace zypp
     LogClient &operator=(const LogClient &) = delete;
     LogClient &operator=(LogClient &&) = delete;
 
-    ~LogClient() { if (_sockFD >= 0) ::close(_sockFD); }
-
-    /*!
-     * Tries to connect to the log threads socket, returns true on success or
-     * if the socket is already connected
-     */
-    bool ensureConnection () {
-      if ( _sockFD >= 0 )
-        return true;
-
-      _sockFD = ::socket( AF_UNIX, SOCK_STREAM, 0 );
-      if ( _sockFD == -1 )
-        return false;
-
-      zyppng::UnixSockAddr addr( LogThread::sockPath(), true );
-      return zyppng::trySocketConnection( _sockFD, addr, 100 );
+    ~LogClient() {
+      if ( _ring ) {
+        _ring->_closed = true;
+        LogThread::instance().notifyData();
+      }
     }
 
     /*!
@@ -261,7 +370,7 @@ namespace zypp
       });
       inPushMessage = true;
 
-      // if we are in the same thread as the Log worker we can directly push our messages out, no need to use the socket
+      // if we are in the same thread as the Log worker we can directly push our messages out, no need to use the ring
       if ( std::this_thread::get_id() == LogThread::instance().threadId() ) {
         auto writer = LogThread::instance().getLineWriter();
         if ( writer )
@@ -269,27 +378,28 @@ namespace zypp
         return;
       }
 
-      if(!ensureConnection())
-        return;
+      if ( !_ring )
+        _ring = LogThread::instance().registerRing();
 
-      if ( msg.back() != '\n' )
+      if ( msg.empty() || msg.back() != '\n' )
         msg.push_back('\n');
 
-      size_t written = 0;
-      while ( written < msg.size() ) {
-        const auto res = zyppng::eintrSafeCall( ::send, _sockFD, msg.data() + written, msg.size() - written, MSG_NOSIGNAL );
-        if ( res == -1 ) {
-          //assume broken socket
-          ::close( _sockFD );
-          _sockFD = -1;
+      // bounded wait for the log thread to make room, then drop the line
+      for ( unsigned retry = 0; !_ring->push( msg ); ++retry ) {
+        if ( retry == maxPushRetries ) {
+          ++_ring->_dropped;
+          LogThread::instance().countDropped();
           return;
         }
-        written += res;
+        LogThread::instance().notifyData();
+        std::this_thread::yield();
       }
+      LogThread::instance().notifyData();
     }
 
     private:
-      int _sockFD = -1;
+      static constexpr unsigned maxPushRetries = 100;
+      std::shared_ptr<LogRing> _ring;
       bool inPushMessage = false;
   };
 
@@ -369,6 +479,18 @@ namespace zypp
       : StreamLineWriter( std::cerr )
     {}
 
+    namespace
+    {
+      /** The open logfile: the stream for \ref StreamLineWriter::writeOut and
+       * an fd (also appending) for \ref FileLineWriter::writeBatch.
+       */
+      struct FileLineWriterOuts
+      {
+        std::ofstream _str;
+        AutoFD _fd;
+      };
+    }
+
     FileLineWriter::FileLineWriter( const Pathname & file_r, mode_t mode_r )
     {
       if ( file_r == Pathname("-") )
@@ -386,10 +508,52 @@ namespace zypp
             ::close( fd );
         }
         // set unbuffered write
-        std::ofstream * fstr = 0;
-        _outs.reset( (fstr = new std::ofstream( file_r.asString().c_str(), std::ios_base::app )) );
-        fstr->rdbuf()->pubsetbuf(0,0);
-        _str = &(*fstr);
+        shared_ptr<FileLineWriterOuts> outs( new FileLineWriterOuts );
+        outs->_str.open( file_r.asString().c_str(), std::ios_base::app );
+        outs->_str.rdbuf()->pubsetbuf(0,0);
+        outs->_fd = ::open( file_r.c_str(), O_WRONLY|O_APPEND|O_CLOEXEC );
+        _str = &outs->_str;
+        _outs = outs;
+      }
+    }
+
+    void FileLineWriter::writeBatch( std::string_view first_r, std::string_view second_r )
+    {
+      int fd = _outs ? static_cast<FileLineWriterOuts *>( _outs.get() )->_fd.value() : STDERR_FILENO;
+      if ( fd == -1 )
+      {
+        // fallback to the stream
+        (*_str) << first_r << second_r << std::flush;
+        return;
+      }
+
+      struct iovec iov[2] = {
+        { const_cast<char *>( first_r.data() ),  first_r.size() },
+        { const_cast<char *>( second_r.data() ), second_r.size() }
+      };
+      int iovcnt = second_r.empty() ? 1 : 2;
+      struct iovec * next = iov;
+      while ( iovcnt )
+      {
+        ssize_t res = ::writev( fd, next, iovcnt );
+        if ( res == -1 )
+        {
+          if ( errno == EINTR )
+            continue;
+          return;	// nowhere to log this
+        }
+        // partial write: skip what was written
+        while ( iovcnt && size_t(res) >= next->iov_len )
+        {
+          res -= next->iov_len;
+          ++next;
+          --iovcnt;
+        }
+        if ( iovcnt )
+        {
+          next->iov_base = static_cast<char *>( next->iov_base ) + res;
+          next->iov_len -= res;
+        }
       }
     }
 
@@ -692,7 +856,6 @@ namespace zypp
         using StreamTable = std::map<std::string, StreamSet>;
         /** one streambuffer per group and level */
         StreamTable _streamtable;
-        zyppng::Socket::Ptr _sock;
 
       private:
 
@@ -928,6 +1091,11 @@ namespace zypp
       LogThread::instance().stop();
     }
 
+    uint64_t LogControl::droppedLines() const
+    {
+      return LogThread::instance().droppedLines();
+    }
+
     void LogControl::notifyFork()
     {
       logger::logControlValidFlag () = 0;
@@ -14,6 +14,8 @@
 
 #include <iosfwd>
 #include <ostream> //for std::endl
+#include <string_view>
+#include <cstdint>
 
 #include <zypp-core/base/Logger.h>
 #include <zypp-core/base/PtrTypes.h>
@@ -72,6 +74,12 @@ namespace zypp
     struct ZYPP_API FileLineWriter : public StreamLineWriter
     {
       FileLineWriter( const Pathname & file_r, mode_t mode_r = 0 );
+
+      /** Write consecutive NL terminated lines with a single syscall.
+       * Used by the log thread to write a whole batch of lines.
+       */
+      void writeBatch( std::string_view first_r, std::string_view second_r = std::string_view() );
+
       protected:
         shared_ptr<void> _outs;
     };
@@ -152,9 +160,12 @@ namespace zypp
       /** Log to std::err. */
       void logToStdErr();
 
-      /** will cause the log thread to exit and flush all sockets */
+      /** will cause the log thread to exit and flush all log buffers */
       void emergencyShutdown();
 
+      /** Number of log lines dropped because a threads log buffer was full. */
+      uint64_t droppedLines() const;
+
       /**
        *  This will completely disable logging.
        *  It is supposed to be called in the child process after fork()
@@ -12,6 +12,7 @@
 #ifndef ZYPP_CORE_BASE_REFERENCECOUNTED_H
 #define ZYPP_CORE_BASE_REFERENCECOUNTED_H
 
+#include <atomic>
 #include <iosfwd>
 
 #include <zypp-core/Globals.h>
@@ -29,7 +30,8 @@ namespace zypp
     //	CLASS NAME : ReferenceCounted
     //
     /** Base class for reference counted objects.
-     * \todo Make counter thread safe.
+     * The counter is atomic, so references to a shared object may be
+     * added and released in different threads.
     */
     class ZYPP_API ReferenceCounted
     {
@@ -75,8 +77,8 @@ namespace zypp
       {
         if ( !_counter )
           unrefException(); // will throw!
-        if ( --_counter )
-          unref_to( _counter );
+        if ( unsigned cnt = --_counter )
+          unref_to( cnt );
         else
           delete this;
       }
@@ -108,7 +110,7 @@ namespace zypp
 
     private:
       /** The reference counter. */
-      mutable unsigned _counter;
+      mutable std::atomic<unsigned> _counter;
 
       /** Throws Exception on unref. */
       void unrefException() const;
@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+#include "threadpool.h"
+#include <algorithm>
+
+#include <zypp-core/base/Logger.h>
+
+namespace zyppng {
+
+  ThreadPool::ThreadPool( size_t maxThreads )
+    : _maxThreads( maxThreads )
+  {
+    if ( !_maxThreads )
+      _maxThreads = std::max( 1U, std::thread::hardware_concurrency() );
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    shutdown();
+  }
+
+  ThreadPool &ThreadPool::cpuPool()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  void ThreadPool::shutdown()
+  {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard lk( _lock );
+      _stop = true;
+      threads.swap( _threads );
+    }
+    _cond.notify_all();
+    for ( auto &t : threads )
+      t.join();
+  }
+
+  void ThreadPool::submit( Job job )
+  {
+    {
+      std::unique_lock lk( _lock );
+      if ( _stop ) {
+        // no more threads after shutdown
+        lk.unlock();
+        job();
+        return;
+      }
+      _jobs.push_back( std::move(job) );
+      if ( _idleThreads < _jobs.size() && _threads.size() < _maxThreads ) {
+        MIL << "ThreadPool starting worker " << _threads.size() + 1 << " of " << _maxThreads << std::endl;
+        _threads.emplace_back( &ThreadPool::workerMain, this );
+      }
+    }
+    _cond.notify_one();
+  }
+
+  size_t ThreadPool::maxThreads() const
+  {
+    return _maxThreads;
+  }
+
+  size_t ThreadPool::pendingJobs() const
+  {
+    std::lock_guard lk( _lock );
+    return _jobs.size() + _runningJobs;
+  }
+
+  void ThreadPool::workerMain()
+  {
+    std::unique_lock lk( _lock );
+    while ( true ) {
+      ++_idleThreads;
+      _cond.wait( lk, [this]{ return _stop || !_jobs.empty(); } );
+      --_idleThreads;
+
+      // drain the queue before stopping
+      if ( _jobs.empty() )
+        return;
+
+      Job job = std::move( _jobs.front() );
+      _jobs.pop_front();
+      ++_runningJobs;
+
+      lk.unlock();
+      job();
+      lk.lock();
+
+      --_runningJobs;
+    }
+  }
+
+}
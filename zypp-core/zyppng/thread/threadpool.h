@@ -0,0 +1,92 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+----------------------------------------------------------------------*/
+#ifndef ZYPP_NG_THREAD_THREADPOOL_H_INCLUDED
+#define ZYPP_NG_THREAD_THREADPOOL_H_INCLUDED
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zyppng {
+
+  /*!
+   * A fixed upper bound of worker threads executing jobs in FIFO order.
+   *
+   * Threads are started on demand until \ref maxThreads is reached, after that
+   * jobs wait in the queue for the next free thread. Jobs must not throw, report
+   * results back to the submitting thread e.g. via \ref zyppng::Wakeup.
+   *
+   * \ref shutdown, also called by the destructor, runs all jobs that are still
+   * queued and joins the threads.
+   */
+  class ThreadPool
+  {
+  public:
+    using Job = std::function<void()>;
+
+    /*!
+     * Creates a pool running at most \a maxThreads jobs at once,
+     * 0 means one thread per CPU core.
+     */
+    explicit ThreadPool( size_t maxThreads = 0 );
+    ~ThreadPool();
+
+    ThreadPool( const ThreadPool & ) = delete;
+    ThreadPool & operator=( const ThreadPool & ) = delete;
+
+    /*!
+     * The process wide pool for CPU bound work, limited to the number of cores.
+     * Use this instead of spawning threads, so concurrent workflows do not
+     * oversubscribe the machine.
+     *
+     * \note The pool is a function local static. Unless \ref shutdown was called
+     * before, its destructor drains the queue and joins the threads during static
+     * destruction at exit. Jobs still running then must not use other static
+     * objects (e.g. the logger) which may already be destroyed.
+     */
+    static ThreadPool & cpuPool();
+
+    /*!
+     * Queue \a job for execution in one of the worker threads.
+     * After \ref shutdown the job is executed right away in the calling thread.
+     */
+    void submit( Job job );
+
+    /*!
+     * Runs all jobs that are still queued and joins the threads. Call this e.g. before
+     * leaving main() to stop \ref cpuPool explicitly. Calling it twice is a no-op.
+     */
+    void shutdown();
+
+    size_t maxThreads() const;
+
+    /*!
+     * Number of jobs queued or currently executed.
+     */
+    size_t pendingJobs() const;
+
+  private:
+    void workerMain();
+
+    mutable std::mutex _lock;
+    std::condition_variable _cond;
+    std::deque<Job> _jobs;
+    std::vector<std::thread> _threads;
+    size_t _maxThreads = 1;
+    size_t _idleThreads = 0;
+    size_t _runningJobs = 0;
+    bool _stop = false;
+  };
+
+}
+
+#endif // ZYPP_NG_THREAD_THREADPOOL_H_INCLUDED
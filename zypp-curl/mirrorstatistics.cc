@@ -0,0 +1,179 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file zypp-curl/mirrorstatistics.cc
+ *
+*/
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <unistd.h>
+
+#include <zypp-core/base/Logger.h>
+#include <zypp-core/base/String.h>
+#include <zypp-core/fs/PathInfo.h>
+
+#include <zypp-curl/MirrorStatistics>
+
+using std::endl;
+
+namespace zypp
+{
+  namespace media
+  {
+    namespace
+    {
+      constexpr unsigned failingMirror = 3;          // failures in a row that mark a mirror as failing
+      constexpr uint64_t failurePenaltyMs = 1000;    // added to the score for each failure in a row
+
+      /** Smooth \a sample_r into \a value_r, taking the sample if there is no value yet. */
+      inline uint64_t ewma( uint64_t value_r, uint64_t sample_r )
+      {
+        if ( ! sample_r )
+          return value_r;
+        return ( value_r ? ( 3 * value_r + sample_r ) / 4 : sample_r );
+      }
+    } // namespace
+
+    uint64_t MirrorStatistics::Entry::score() const
+    {
+      uint64_t msPerMiB = 0;
+      if ( bytesPerSecond )
+        msPerMiB = ( uint64_t(1024) * 1024 * 1000 ) / bytesPerSecond;
+      return latencyMs + msPerMiB + failures * failurePenaltyMs;
+    }
+
+    MirrorStatistics::MirrorStatistics( Pathname cacheDir_r, std::chrono::seconds maxAge_r )
+    : _cacheDir( std::move(cacheDir_r) )
+    , _maxAge( maxAge_r )
+    {}
+
+    std::string MirrorStatistics::makeKey( const Url & url_r )
+    {
+      std::string ret( url_r.getScheme() + "_" + url_r.getHost() );
+      if ( ! url_r.getPort().empty() )
+        ret += "_" + url_r.getPort();
+      // never leave the cache dir
+      std::replace( ret.begin(), ret.end(), '/', '_' );
+      return ret;
+    }
+
+    std::optional<MirrorStatistics::Entry> MirrorStatistics::lookup( const Url & url_r ) const
+    {
+      if ( _cacheDir.empty() || url_r.getHost().empty() )
+        return std::nullopt;
+
+      return readEntry( _cacheDir / makeKey( url_r ) );
+    }
+
+    std::optional<MirrorStatistics::Entry> MirrorStatistics::readEntry( const Pathname & file_r ) const
+    {
+      std::ifstream in( file_r.c_str() );
+      if ( ! in.is_open() )
+        return std::nullopt;
+
+      Entry entry;
+      in >> entry.latencyMs >> entry.bytesPerSecond >> entry.failures >> entry.successes >> entry.updated;
+      if ( in.fail() )
+      {
+        WAR << "Ignoring broken mirror statistics " << file_r << endl;
+        return std::nullopt;
+      }
+
+      if ( entry.updated + _maxAge.count() < ::time( nullptr ) )
+      {
+        DBG << "Ignoring expired mirror statistics " << file_r << endl;
+        return std::nullopt;
+      }
+      return entry;
+    }
+
+    void MirrorStatistics::removeExpired() const
+    {
+      if ( _cacheDir.empty() || ! PathInfo( _cacheDir ).isDir() )
+        return;
+
+      filesystem::dirForEach( _cacheDir, [this]( const Pathname & dir_r, const char *const name_r ) {
+        // hidden files are the temp files of running writers
+        if ( name_r[0] != '.' && ! readEntry( dir_r / name_r ) )
+        {
+          DBG << "Removing mirror statistics " << ( dir_r / name_r ) << endl;
+          filesystem::unlink( dir_r / name_r );
+        }
+        return true;
+      });
+    }
+
+    bool MirrorStatistics::update( const Url & url_r, const Entry & sample_r )
+    {
+      if ( _cacheDir.empty() || url_r.getHost().empty() )
+        return false;
+
+      Entry entry( lookup( url_r ).value_or( Entry() ) );
+      entry.latencyMs      = ewma( entry.latencyMs, sample_r.latencyMs );
+      entry.bytesPerSecond = ewma( entry.bytesPerSecond, sample_r.bytesPerSecond );
+      entry.failures       = sample_r.failures;
+      entry.successes     += sample_r.successes;
+      entry.updated        = ::time( nullptr );
+
+      if ( filesystem::assert_dir( _cacheDir ) != 0 )
+      {
+        WAR << "Unable to create mirror statistics cache " << _cacheDir << endl;
+        return false;
+      }
+
+      // write a temp file and rename it, so concurrent readers never see a partial entry
+      const Pathname file( _cacheDir / makeKey( url_r ) );
+      const Pathname tmpfile( _cacheDir / ( str::Format(".%1%.%2%") % makeKey( url_r ) % ::getpid() ).str() );
+      {
+        std::ofstream out( tmpfile.c_str(), std::ios_base::trunc );
+        if ( ! out.is_open() )
+        {
+          WAR << "Failed to create mirror statistics " << tmpfile << endl;
+          return false;
+        }
+        out << entry.latencyMs << " " << entry.bytesPerSecond << " " << entry.failures << " " << entry.successes << " " << entry.updated << endl;
+        if ( out.fail() )
+        {
+          filesystem::unlink( tmpfile );
+          return false;
+        }
+      }
+      if ( filesystem::rename( tmpfile, file ) != 0 )
+      {
+        filesystem::unlink( tmpfile );
+        return false;
+      }
+      return true;
+    }
+
+    void MirrorStatistics::sortUrls( std::vector<Url> & urls_r ) const
+    {
+      // 0: known good, 1: unknown, 2: known failing; then by score
+      std::vector<std::pair<std::pair<int,uint64_t>,Url>> ranked;
+      ranked.reserve( urls_r.size() );
+      for ( const Url & url : urls_r )
+      {
+        std::optional<Entry> entry( lookup( url ) );
+        if ( ! entry )
+          ranked.push_back( { { 1, 0 }, url } );
+        else
+          ranked.push_back( { { entry->failures >= failingMirror ? 2 : 0, entry->score() }, url } );
+      }
+
+      std::stable_sort( ranked.begin(), ranked.end(), []( const auto & lhs, const auto & rhs ) {
+        return lhs.first < rhs.first;
+      });
+
+      urls_r.clear();
+      for ( auto & el : ranked )
+        urls_r.push_back( std::move(el.second) );
+    }
+
+  } // namespace media
+} // namespace zypp
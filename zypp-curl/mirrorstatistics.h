@@ -0,0 +1,98 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file zypp-curl/MirrorStatistics
+*/
+#ifndef ZYPP_CURL_MIRRORSTATISTICS_H_INCLUDED
+#define ZYPP_CURL_MIRRORSTATISTICS_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <zypp-core/Pathname.h>
+#include <zypp-core/Url.h>
+
+namespace zypp
+{
+  namespace media
+  {
+
+  /**
+   * On disk cache of the mirror health measured by the downloader, so the
+   * next run can start with the best known mirror instead of probing all of them.
+   *
+   * The cache directory contains one small file per mirror, named after the
+   * mirrors scheme, host and port. Each file holds the smoothed connect latency,
+   * the smoothed throughput and the failure counts of the mirror. Entries older
+   * than the maximum age are ignored, the writer removes them (\ref removeExpired).
+   */
+  class MirrorStatistics
+  {
+  public:
+    struct Entry
+    {
+      uint64_t latencyMs      = 0;  //< smoothed connect latency in ms
+      uint64_t bytesPerSecond = 0;  //< smoothed throughput, 0 if unknown
+      unsigned failures       = 0;  //< failed transfers in a row
+      unsigned successes      = 0;  //< successful transfers
+      time_t   updated        = 0;  //< time of the last update
+
+      /** Value to sort mirrors by, lower is better. Combines latency, the time
+       * to transfer 1MiB and a penalty for failures in a row. */
+      uint64_t score() const;
+    };
+
+    static constexpr std::chrono::hours defaultMaxAge = std::chrono::hours( 24 * 7 );
+
+    /** Use the cache in \a cacheDir_r, entries older than \a maxAge_r are ignored. */
+    MirrorStatistics( Pathname cacheDir_r, std::chrono::seconds maxAge_r = defaultMaxAge );
+
+    const Pathname & cacheDir() const
+    { return _cacheDir; }
+
+    /** The stored entry for the mirror \a url_r, if there is a valid one.
+     * Broken or expired entries are ignored but not removed, so looking up
+     * never modifies the cache. */
+    std::optional<Entry> lookup( const Url & url_r ) const;
+
+    /** Merge the measurements in \a sample_r into the stored entry for \a url_r
+     * and write it. Latency and throughput are smoothed, the failure count is
+     * replaced and the success count is added.
+     * \return whether the entry was written.
+     */
+    bool update( const Url & url_r, const Entry & sample_r );
+
+    /** Remove the broken and expired entries from the cache.
+     * Meant to be called by the writer after its \ref update calls. */
+    void removeExpired() const;
+
+    /** Stable sort \a urls_r so the mirrors with the best stored entry come first.
+     * Mirrors without an entry keep their order and are placed after the known good
+     * ones but before the known failing ones. */
+    void sortUrls( std::vector<Url> & urls_r ) const;
+
+    /** The cache file name for the mirror \a url_r (scheme, host and port). */
+    static std::string makeKey( const Url & url_r );
+
+  private:
+    /** The entry in \a file_r, if it is valid and not expired. */
+    std::optional<Entry> readEntry( const Pathname & file_r ) const;
+
+  private:
+    Pathname _cacheDir;
+    std::chrono::seconds _maxAge;
+  };
+
+  } // namespace media
+} // namespace zypp
+
+#endif /*ZYPP_CURL_MIRRORSTATISTICS_H_INCLUDED*/
@@ -16,6 +16,8 @@
 #include <zypp-core/zyppng/base/EventDispatcher>
 #include <zypp-curl/private/curlhelper_p.h>
 #include <assert.h>
+#include <algorithm>
+#include <openssl/ssl.h>
 
 #include <zypp/base/Logger.h>
 #include <zypp/base/String.h>
@@ -44,9 +46,155 @@ static const std::string & defaultAgentString()
 }
 
 
+std::atomic<uint64_t> CurlShare::_connectionHits   = 0;
+std::atomic<uint64_t> CurlShare::_connectionMisses = 0;
+std::atomic<uint64_t> CurlShare::_dnsHits          = 0;
+std::atomic<uint64_t> CurlShare::_dnsMisses        = 0;
+std::atomic<uint64_t> CurlShare::_tlsSessionHits   = 0;
+std::atomic<uint64_t> CurlShare::_tlsSessionMisses = 0;
+
+std::shared_ptr<CurlShare> CurlShare::instance()
+{
+  static std::mutex mutex;
+  static std::weak_ptr<CurlShare> current;
+
+  std::lock_guard<std::mutex> guard( mutex );
+  std::shared_ptr<CurlShare> share = current.lock();
+  if ( !share ) {
+    share.reset( new CurlShare() );
+    current = share;
+  }
+  return share;
+}
+
+CurlShare::CurlShare()
+{
+  ::internal::globalInitCurlOnce();
+
+  _share = curl_share_init();
+  if ( !_share ) {
+    WAR << "Unable to create the curl share handle, requests will not share DNS and TLS sessions" << std::endl;
+    return;
+  }
+
+  curl_share_setopt( _share, CURLSHOPT_LOCKFUNC, CurlShare::lock );
+  curl_share_setopt( _share, CURLSHOPT_UNLOCKFUNC, CurlShare::unlock );
+  curl_share_setopt( _share, CURLSHOPT_USERDATA, reinterpret_cast<void *>( this ) );
+  curl_share_setopt( _share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS );
+  curl_share_setopt( _share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION );
+}
+
+CurlShare::~CurlShare()
+{
+  // all requests were detached when leaving their dispatcher
+  if ( _share && curl_share_cleanup( _share ) != CURLSHE_OK )
+    WAR << "Curl share handle still in use, leaking it" << std::endl;
+}
+
+void CurlShare::lock( CURL *, curl_lock_data data, curl_lock_access, void *userp )
+{
+  reinterpret_cast<CurlShare *>( userp )->_locks[data].lock();
+}
+
+void CurlShare::unlock( CURL *, curl_lock_data data, void *userp )
+{
+  reinterpret_cast<CurlShare *>( userp )->_locks[data].unlock();
+}
+
+int CurlShare::resolverStart( void *, void *, void *clientp )
+{
+  // only called if the host name is not in the DNS cache
+  ++reinterpret_cast<NetworkRequestPrivate *>( clientp )->_shareInfo._resolves;
+  return 0;
+}
+
+int CurlShare::prereq( void *clientp, char *, char *, int, int )
+{
+  // called once the connection is established, the TLS handshake is done by now
+  NetworkRequestPrivate *req = reinterpret_cast<NetworkRequestPrivate *>( clientp );
+  long newConnections = 0;
+  const curl_tlssessioninfo *tlsInfo = nullptr;
+  if ( curl_easy_getinfo( req->_easyHandle, CURLINFO_NUM_CONNECTS, &newConnections ) == CURLE_OK && newConnections > 0
+       && curl_easy_getinfo( req->_easyHandle, CURLINFO_TLS_SSL_PTR, &tlsInfo ) == CURLE_OK
+       && tlsInfo && tlsInfo->backend == CURLSSLBACKEND_OPENSSL && tlsInfo->internals ) {
+    req->_shareInfo._tlsResumed = ( SSL_session_reused( reinterpret_cast<SSL *>( tlsInfo->internals ) ) == 1 );
+  }
+#if CURLVERSION_AT_LEAST(7,80,0)
+  return CURL_PREREQFUNC_OK;
+#else
+  return 0;
+#endif
+}
+
+void CurlShare::attach( NetworkRequestPrivate &req )
+{
+  req._shareInfo = NetworkRequestPrivate::ShareInfo();
+  if ( !_share )
+    return;
+
+  curl_easy_setopt( req._easyHandle, CURLOPT_SHARE, _share );
+#if CURLVERSION_AT_LEAST(7,59,0)
+  curl_easy_setopt( req._easyHandle, CURLOPT_RESOLVER_START_FUNCTION, &CurlShare::resolverStart );
+  curl_easy_setopt( req._easyHandle, CURLOPT_RESOLVER_START_DATA, reinterpret_cast<void *>( &req ) );
+#endif
+#if CURLVERSION_AT_LEAST(7,80,0)
+  curl_easy_setopt( req._easyHandle, CURLOPT_PREREQFUNCTION, &CurlShare::prereq );
+  curl_easy_setopt( req._easyHandle, CURLOPT_PREREQDATA, reinterpret_cast<void *>( &req ) );
+#endif
+}
+
+void CurlShare::detach( void *easy )
+{
+  if ( !_share )
+    return;
+
+  curl_easy_setopt( easy, CURLOPT_SHARE, nullptr );
+#if CURLVERSION_AT_LEAST(7,59,0)
+  curl_easy_setopt( easy, CURLOPT_RESOLVER_START_FUNCTION, nullptr );
+  curl_easy_setopt( easy, CURLOPT_RESOLVER_START_DATA, nullptr );
+#endif
+#if CURLVERSION_AT_LEAST(7,80,0)
+  curl_easy_setopt( easy, CURLOPT_PREREQFUNCTION, nullptr );
+  curl_easy_setopt( easy, CURLOPT_PREREQDATA, nullptr );
+#endif
+}
+
+void CurlShare::transferDone( NetworkRequestPrivate &req )
+{
+  long newConnections = 0;
+  if ( curl_easy_getinfo( req._easyHandle, CURLINFO_NUM_CONNECTS, &newConnections ) != CURLE_OK )
+    return;
+
+  if ( newConnections > 0 ) {
+    _connectionMisses += newConnections;
+    // a new connection whose host name was not resolved took it from the DNS cache
+    const auto resolves = static_cast<long>( req._shareInfo._resolves );
+    _dnsMisses += std::min( resolves, newConnections );
+    _dnsHits   += std::max( newConnections - resolves, 0L );
+    if ( req._shareInfo._tlsResumed )
+      ++( *req._shareInfo._tlsResumed ? _tlsSessionHits : _tlsSessionMisses );
+  } else {
+    ++_connectionHits;
+  }
+  req._shareInfo = NetworkRequestPrivate::ShareInfo();
+}
+
+NetworkRequestDispatcher::ShareStatistics CurlShare::statistics()
+{
+  NetworkRequestDispatcher::ShareStatistics stats;
+  stats.connectionHits   = _connectionHits;
+  stats.connectionMisses = _connectionMisses;
+  stats.dnsHits          = _dnsHits;
+  stats.dnsMisses        = _dnsMisses;
+  stats.tlsSessionHits   = _tlsSessionHits;
+  stats.tlsSessionMisses = _tlsSessionMisses;
+  return stats;
+}
+
 NetworkRequestDispatcherPrivate::NetworkRequestDispatcherPrivate(  NetworkRequestDispatcher &p  )
     : BasePrivate( p )
     , _timer( Timer::create() )
+    , _share( CurlShare::instance() )
     , _multi ( curl_multi_init() )
     , _userAgent( defaultAgentString() )
 {
@@ -57,9 +205,8 @@ NetworkRequestDispatcherPrivate::NetworkRequestDispatcherPrivate(  NetworkReques
   curl_multi_setopt( _multi, CURLMOPT_SOCKETFUNCTION, NetworkRequestDispatcherPrivate::static_socket_callback );
   curl_multi_setopt( _multi, CURLMOPT_SOCKETDATA, reinterpret_cast<void *>( this ) );
 
-  // disabled explicit pipelining since it breaks our tests on releases < 15.2
-  // we could consider enabling it starting with a specific CURL version
-  // curl_multi_setopt( _multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX|CURLPIPE_HTTP1 );
+  // explicit pipelining is disabled by default since it breaks our tests on releases < 15.2,
+  // HTTP/2 multiplexing can be enabled via NetworkRequestDispatcher::setMultiplexingEnabled
 
   _timer->setSingleShot( true );
   _timer->connect( &Timer::sigExpired, *this, &NetworkRequestDispatcherPrivate::multiTimerTimout );
@@ -226,6 +373,8 @@ void NetworkRequestDispatcherPrivate::handleMultiSocketAction(curl_socket_t nati
       NetworkRequestPrivate *request = reinterpret_cast<NetworkRequestPrivate *>( privatePtr );
       request->dequeueNotify();
 
+      CurlShare::transferDone( *request );
+
       if ( request->hasMoreWork() && ( res == CURLE_OK || request->canRecover() ) ) {
         std::string errBuf = "Broken easy handle in request";
         if ( !request->_easyHandle ) {
@@ -304,12 +453,18 @@ void NetworkRequestDispatcherPrivate::setFinished( NetworkRequest &req, NetworkR
   }
 
   auto rLocked = delReq( _runningDownloads, req );
-  if ( !rLocked )
+  if ( rLocked ) {
+    if ( auto i = _runningStreams.find( hostKey( req ) ); i != _runningStreams.end() && --(i->second) <= 0 )
+      _runningStreams.erase( i );
+  } else {
     rLocked = delReq( _pendingDownloads, req );
+  }
 
   void *easyHandle = req.d_func()->_easyHandle;
-  if ( easyHandle )
+  if ( easyHandle ) {
     curl_multi_remove_handle( _multi, easyHandle );
+    _share->detach( easyHandle );
+  }
 
   req.d_func()->_dispatcher = nullptr;
 
@@ -324,6 +479,14 @@ void NetworkRequestDispatcherPrivate::setFinished( NetworkRequest &req, NetworkR
 
 bool NetworkRequestDispatcherPrivate::addRequestToMultiHandle(NetworkRequest &req)
 {
+  // with multiplexing enabled rather wait for a connection that can be shared
+  // than opening a new one, curl falls back to a new connection if the server
+  // turns out not to support multiplexing
+  curl_easy_setopt( req.d_func()->_easyHandle, CURLOPT_PIPEWAIT, _multiplexing ? 1L : 0L );
+
+  // use the shared DNS cache and TLS sessions
+  _share->attach( *req.d_func() );
+
   CURLMcode rc = curl_multi_add_handle( _multi, req.d_func()->_easyHandle );
   if ( rc != 0 ) {
     setFinished( req, NetworkRequestErrorPrivate::fromCurlMError( rc ) );
@@ -340,22 +503,38 @@ void NetworkRequestDispatcherPrivate::dequeuePending()
   if ( !_isRunning || _locked )
     return;
 
-  while ( _maxConnections == -1 || ( (std::size_t)_maxConnections > _runningDownloads.size() ) ) {
-    if ( !_pendingDownloads.size() )
+  // in multiplexing mode requests to a host that has all its streams in use are skipped,
+  // so requests to other hosts can start
+  std::size_t idx = 0;
+  while ( _maxConnections == -1 || maxRunningRequests() > _runningDownloads.size() ) {
+    if ( idx >= _pendingDownloads.size() )
       break;
 
-    std::shared_ptr<NetworkRequest> req = std::move( _pendingDownloads.front() );
-    _pendingDownloads.pop_front();
+    if ( !canStartRequest( *_pendingDownloads[idx] ) ) {
+      idx++;
+      continue;
+    }
+
+    std::shared_ptr<NetworkRequest> req = std::move( _pendingDownloads[idx] );
+    _pendingDownloads.erase( _pendingDownloads.begin() + idx );
 
     std::string errBuf = "Failed to initialize easy handle";
     if ( !req->d_func()->initialize( errBuf ) ) {
       //@TODO store the CURL error in the errors extra info
       setFinished( *req, NetworkRequestErrorPrivate::customError( NetworkRequestError::InternalError, std::move(errBuf) ) );
+      // setFinished dequeues on its own, the queue might have changed
+      idx = 0;
       continue;
     }
 
-    if ( !addRequestToMultiHandle( *req ) )
+    if ( !addRequestToMultiHandle( *req ) ) {
+      idx = 0;
       continue;
+    }
+
+    const int streams = ++_runningStreams[ hostKey( *req ) ];
+    if ( _multiplexing && streams == _maxStreamsPerHost )
+      DBG << "Host " << hostKey( *req ) << " reached the maximum of " << streams << " streams" << std::endl;
 
     req->d_func()->aboutToStart();
     _sigDownloadStarted.emit( *z_func(), *req );
@@ -371,6 +550,46 @@ void NetworkRequestDispatcherPrivate::dequeuePending()
   }
 }
 
+bool NetworkRequestDispatcherPrivate::canStartRequest( const NetworkRequest &req ) const
+{
+  if ( !_multiplexing || _maxStreamsPerHost == -1 )
+    return true;
+
+  const auto i = _runningStreams.find( hostKey( req ) );
+  return ( i == _runningStreams.end() || i->second < _maxStreamsPerHost );
+}
+
+std::size_t NetworkRequestDispatcherPrivate::maxRunningRequests() const
+{
+  // in multiplexing mode each of the connections may carry all the streams of its host
+  if ( _multiplexing )
+    return (std::size_t)_maxConnections * ( _maxStreamsPerHost == -1 ? 100 : _maxStreamsPerHost );
+  return _maxConnections;
+}
+
+std::string NetworkRequestDispatcherPrivate::hostKey( const NetworkRequest &req )
+{
+  // Streams are multiplexed per connection, and curl only shares connections
+  // to the same scheme, host and port. The default port is filled in so that
+  // http://host and http://host:80 are counted together.
+  const Url &url = req.url();
+  const std::string &scheme = url.getScheme();
+  std::string port = url.getPort();
+  if ( port.empty() ) {
+    if ( scheme == "https" )
+      port = "443";
+    else if ( scheme == "http" )
+      port = "80";
+    else if ( scheme == "ftp" )
+      port = "21";
+    else if ( scheme == "ftps" )
+      port = "990";
+  }
+  if ( port.empty() )
+    return scheme + "://" + url.getHost();
+  return scheme + "://" + url.getHost() + ":" + port;
+}
+
 ZYPP_IMPL_PRIVATE(NetworkRequestDispatcher)
 
 NetworkRequestDispatcher::NetworkRequestDispatcher( )
@@ -400,7 +619,10 @@ bool NetworkRequestDispatcher::supportsProtocol( const Url &url )
 
 void NetworkRequestDispatcher::setMaximumConcurrentConnections( const int maxConn )
 {
-  d_func()->_maxConnections = maxConn;
+  Z_D();
+  d->_maxConnections = maxConn;
+  if ( d->_multiplexing )
+    setMultiplexingEnabled( true );
 }
 
 int NetworkRequestDispatcher::maximumConcurrentConnections () const
@@ -408,6 +630,59 @@ int NetworkRequestDispatcher::maximumConcurrentConnections () const
   return d_func()->_maxConnections;
 }
 
+void NetworkRequestDispatcher::setMultiplexingEnabled( bool enable )
+{
+  Z_D();
+  d->_multiplexing = enable;
+  if ( enable ) {
+    curl_multi_setopt( d->_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX );
+    // hosts without multiplexing support get at most _maxConnections connections,
+    // curl queues additional requests internally until a connection is available
+    curl_multi_setopt( d->_multi, CURLMOPT_MAX_HOST_CONNECTIONS, d->_maxConnections == -1 ? 0L : static_cast<long>( d->_maxConnections ) );
+    // and all hosts together get at most _maxConnections connections
+    curl_multi_setopt( d->_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, d->_maxConnections == -1 ? 0L : static_cast<long>( d->_maxConnections ) );
+#if CURLVERSION_AT_LEAST(7,67,0)
+    curl_multi_setopt( d->_multi, CURLMOPT_MAX_CONCURRENT_STREAMS, d->_maxStreamsPerHost == -1 ? 100L : static_cast<long>( d->_maxStreamsPerHost ) );
+#endif
+  } else {
+    curl_multi_setopt( d->_multi, CURLMOPT_PIPELINING, CURLPIPE_NOTHING );
+    curl_multi_setopt( d->_multi, CURLMOPT_MAX_HOST_CONNECTIONS, 0L );
+    curl_multi_setopt( d->_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, 0L );
+  }
+  MIL << "HTTP/2 multiplexing " << ( enable ? "enabled" : "disabled" ) << std::endl;
+
+  // the limits changed, we might be able to start more requests
+  d->dequeuePending();
+}
+
+bool NetworkRequestDispatcher::multiplexingEnabled() const
+{
+  return d_func()->_multiplexing;
+}
+
+void NetworkRequestDispatcher::setMaximumStreamsPerHost( const int maxStreams )
+{
+  Z_D();
+  d->_maxStreamsPerHost = maxStreams;
+  if ( d->_multiplexing )
+    setMultiplexingEnabled( true );
+}
+
+int NetworkRequestDispatcher::maximumStreamsPerHost() const
+{
+  return d_func()->_maxStreamsPerHost;
+}
+
+const NetworkRequestDispatcher::HostStreamMap &NetworkRequestDispatcher::runningStreamsPerHost() const
+{
+  return d_func()->_runningStreams;
+}
+
+NetworkRequestDispatcher::ShareStatistics NetworkRequestDispatcher::shareStatistics()
+{
+  return CurlShare::statistics();
+}
+
 void NetworkRequestDispatcher::enqueue(const std::shared_ptr<NetworkRequest> &req )
 {
   if ( !req )
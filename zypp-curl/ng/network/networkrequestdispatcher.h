@@ -5,6 +5,7 @@
 #include <zypp-core/zyppng/base/Base>
 #include <zypp-core/zyppng/base/signals.h>
 #include <zypp-core/zyppng/core/Url>
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 
@@ -24,6 +25,10 @@ namespace zyppng {
    * right away. Its possible to change the maximum number of concurrent connections to control
    * the load on the network.
    *
+   * With multiplexing enabled ( \ref setMultiplexingEnabled ) requests to the same host share
+   * one HTTP/2 connection where the server supports it, and the number of concurrently started
+   * requests is limited per host ( \ref setMaximumStreamsPerHost ) as well as globally.
+   *
    * \code
    * zyppng::EventLoop::Ptr loop = zyppng::EventLoop::create();
    * zyppng::NetworkRequestDispatcher downloader;
@@ -101,6 +106,68 @@ namespace zyppng {
        */
       int maximumConcurrentConnections () const;
 
+      /*!
+       * Enables or disables HTTP/2 multiplexing, disabled by default.
+       * When enabled, requests to the same host wait for and share an existing connection
+       * if the server supports multiplexing, each request becomes a stream on that connection.
+       * The dispatcher then limits the running requests per host to \ref maximumStreamsPerHost,
+       * and all running requests to \ref maximumConcurrentConnections times \ref maximumStreamsPerHost.
+       * \ref maximumConcurrentConnections still limits the number of connections opened, to a single
+       * host that does not support multiplexing and to all hosts together.
+       */
+      void setMultiplexingEnabled ( bool enable );
+
+      /*!
+       * Returns true if HTTP/2 multiplexing is enabled.
+       */
+      bool multiplexingEnabled () const;
+
+      /*!
+       * Change the number of concurrently running requests per host if multiplexing is
+       * enabled, the default is 100. Setting this to -1 means there is no limit.
+       */
+      void setMaximumStreamsPerHost ( const int maxStreams );
+
+      /*!
+       * Returns the maximum number of running requests per host if multiplexing is enabled.
+       */
+      int maximumStreamsPerHost () const;
+
+      using HostStreamMap = std::unordered_map< std::string, int >;
+
+      /*!
+       * Returns the number of currently running requests ( streams ) per host.
+       * Hosts are identified by <tt>scheme://hostname:port</tt>, the scheme's default port
+       * is used if the Url does not specify one.
+       */
+      const HostStreamMap &runningStreamsPerHost () const;
+
+      /*!
+       * Process wide statistics of the requests of all dispatchers.
+       * The dispatchers alive share the DNS cache and the TLS sessions, connections
+       * are reused within a dispatcher only.
+       *
+       * - A connection hit is a finished transfer that reused an already open
+       *   connection, a miss a new connection.
+       * - A DNS hit is a new connection whose host name was found in the DNS cache,
+       *   a miss one that had to be resolved (needs curl >= 7.59).
+       * - A TLS session hit is a new TLS connection that resumed a session, a miss
+       *   one that did a full handshake (needs curl >= 7.80 using OpenSSL).
+       */
+      struct ShareStatistics {
+        uint64_t connectionHits   = 0;
+        uint64_t connectionMisses = 0;
+        uint64_t dnsHits          = 0;
+        uint64_t dnsMisses        = 0;
+        uint64_t tlsSessionHits   = 0;
+        uint64_t tlsSessionMisses = 0;
+      };
+
+      /*!
+       * Returns the connection, DNS and TLS session reuse statistics.
+       */
+      static ShareStatistics shareStatistics ();
+
       /*!
        * Enqueues a new \a request and puts it into the waiting queue. If the dispatcher
        * is already running and has free capacatly the request might be started right away
@@ -17,7 +17,11 @@
 #include <zypp-curl/ng/network/networkrequestdispatcher.h>
 #include <zypp-core/zyppng/base/private/base_p.h>
 #include <curl/curl.h>
+#include <array>
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -25,6 +29,68 @@ namespace zyppng {
 
 class Timer;
 class SocketNotifier;
+class NetworkRequestPrivate;
+
+/*!
+ * \internal
+ * The curl share handle of all \ref NetworkRequestDispatcher instances alive in the process.
+ * It holds the DNS cache and the TLS sessions, both are safe to use from any thread.
+ * Connections are not shared, they stay in the pool of the dispatcher's multi handle
+ * and thus in the dispatcher's thread.
+ *
+ * Each dispatcher holds a reference, the share handle is released together with the
+ * last dispatcher (e.g. when the provider owning the downloader goes away). Requests are
+ * detached from the share when they leave the dispatcher.
+ *
+ * The statistics are collected process wide, they survive the share handle.
+ */
+class CurlShare
+{
+public:
+  /*!
+   * Returns the share used by the dispatchers alive, or a new one if there is none.
+   */
+  static std::shared_ptr<CurlShare> instance ();
+
+  CurlShare ( const CurlShare & ) = delete;
+  CurlShare &operator= ( const CurlShare & ) = delete;
+  ~CurlShare ();
+
+  /*!
+   * Attaches the easy handle of \a req to the share, before it is added to a multi handle.
+   */
+  void attach ( NetworkRequestPrivate &req );
+
+  /*!
+   * Detaches \a easy from the share, after it was removed from the multi handle.
+   */
+  void detach ( void *easy );
+
+  /*!
+   * Updates the statistics from the finished transfer of \a req.
+   */
+  static void transferDone ( NetworkRequestPrivate &req );
+
+  static NetworkRequestDispatcher::ShareStatistics statistics ();
+
+private:
+  CurlShare ();
+
+  static void lock ( CURL *, curl_lock_data data, curl_lock_access, void *userp );
+  static void unlock ( CURL *, curl_lock_data data, void *userp );
+  static int resolverStart ( void *, void *, void *clientp );
+  static int prereq ( void *clientp, char *, char *, int, int );
+
+  CURLSH *_share = nullptr;
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> _locks;
+
+  static std::atomic<uint64_t> _connectionHits;
+  static std::atomic<uint64_t> _connectionMisses;
+  static std::atomic<uint64_t> _dnsHits;
+  static std::atomic<uint64_t> _dnsMisses;
+  static std::atomic<uint64_t> _tlsSessionHits;
+  static std::atomic<uint64_t> _tlsSessionMisses;
+};
 
 class NetworkRequestDispatcherPrivate : public BasePrivate
 {
@@ -34,15 +100,19 @@ public:
   ~NetworkRequestDispatcherPrivate() override;
 
   int _maxConnections = 10;
+  int _maxStreamsPerHost = 100;
+  bool _multiplexing = false;
 
   std::deque< std::shared_ptr<NetworkRequest> > _pendingDownloads;
   std::vector< std::shared_ptr<NetworkRequest> > _runningDownloads;
+  NetworkRequestDispatcher::HostStreamMap _runningStreams; //< running requests per host
 
   std::shared_ptr<Timer> _timer;
   std::map< curl_socket_t, std::shared_ptr<SocketNotifier> > _socketHandler;
 
   bool  _isRunning = false;
   bool  _locked = false; //if set to true, no new requests will be dequeued
+  std::shared_ptr<CurlShare> _share;
   CURLM *_multi = nullptr;
 
   NetworkRequestError _lastError;
@@ -71,6 +141,10 @@ private:
 
   void handleMultiSocketAction ( curl_socket_t nativeSocket, int evBitmask );
   void dequeuePending ();
+  bool canStartRequest ( const NetworkRequest &req ) const;
+  std::size_t maxRunningRequests () const;
+
+  static std::string hostKey ( const NetworkRequest &req );
 };
 }
 
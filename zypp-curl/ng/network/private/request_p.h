@@ -23,6 +23,7 @@
 #include <curl/curl.h>
 #include <array>
 #include <memory>
+#include <optional>
 #include <zypp-core/Digest.h>
 #include <zypp-core/AutoDispose.h>
 
@@ -125,6 +126,12 @@ namespace zyppng {
     void *_easyHandle = nullptr; // the easy handle that controlling this request
     NetworkRequestDispatcher *_dispatcher = nullptr; // the parent downloader owning this request
 
+    // what the current transfer made of the \ref CurlShare, for its statistics
+    struct ShareInfo {
+      unsigned _resolves = 0;          // host name resolves started
+      std::optional<bool> _tlsResumed; // whether a new TLS connection resumed a session
+    } _shareInfo;
+
     //signals
     Signal< void ( NetworkRequest &req )> _sigStarted;
     Signal< void ( NetworkRequest &req, zypp::ByteCount count )> _sigBytesDownloaded;
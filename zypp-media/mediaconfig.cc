@@ -26,6 +26,7 @@ namespace zypp {
       , download_max_silent_tries	( 5 )
       , download_transfer_timeout	( 180 )
       , download_connect_timeout        ( 60 )
+      , download_http2_multiplexing     ( false )
     { }
 
     Pathname credentials_global_dir_path;
@@ -37,6 +38,7 @@ namespace zypp {
     int download_max_silent_tries;
     int download_transfer_timeout;
     int download_connect_timeout;
+    bool download_http2_multiplexing;
 
   };
 
@@ -87,6 +89,10 @@ namespace zypp {
         if ( d->download_transfer_timeout < 0 )		d->download_transfer_timeout = 0;
         else if ( d->download_transfer_timeout > 3600 )	d->download_transfer_timeout = 3600;
         return true;
+
+      } else if ( entry == "download.http2_multiplexing" ) {
+        d->download_http2_multiplexing = str::strToBool( value, false );
+        return true;
       }
     }
     return false;
@@ -124,6 +130,9 @@ namespace zypp {
   long MediaConfig::download_connect_timeout() const
   { return d_func()->download_connect_timeout; }
 
+  bool MediaConfig::download_http2_multiplexing() const
+  { return d_func()->download_http2_multiplexing; }
+
   ZYPP_IMPL_PRIVATE(MediaConfig)
 }
 
@@ -90,6 +90,12 @@ namespace zypp {
      */
     long download_connect_timeout() const;
 
+    /*!
+     * Whether HTTP/2 multiplexing is used by the download workers.
+     * Concurrency is then limited per host instead of globally.
+     */
+    bool download_http2_multiplexing() const;
+
   private:
     MediaConfig();
     std::unique_ptr<MediaConfigPrivate> d_ptr;
@@ -140,6 +140,7 @@ namespace zyppng {
     std::unordered_map< std::string, FileCacheItem > _fileCache;
 
     zypp::Pathname _workerPath;
+    zypp::Pathname _mirrorStatsPath;
     zypp::media::CredManagerOptions _credManagerOptions;
 
     ProvideStatusRef _log;
@@ -18,6 +18,8 @@ namespace zyppng {
   constexpr std::string_view ANON_ID_CONF("zconfig://media/AnonymousId");
   constexpr std::string_view ATTACH_POINT("zconfig://media/AttachPoint");
   constexpr std::string_view PROVIDER_ROOT("zconfig://media/ProviderRoot");
+  constexpr std::string_view MIRROR_STATS_PATH("zconfig://media/MirrorStatsPath");
+  constexpr std::string_view HTTP2_MULTIPLEXING_CONF("zconfig://main/download.http2_multiplexing"); //< \ref zypp::MediaConfig::download_http2_multiplexing
 
 
   // request related settings:
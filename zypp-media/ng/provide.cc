@@ -1177,6 +1177,16 @@ namespace zyppng {
     d_func()->_workerPath = path;
   }
 
+  void Provide::setMirrorStatisticsPath( const zypp::filesystem::Pathname &path )
+  {
+    d_func()->_mirrorStatsPath = path;
+  }
+
+  const zypp::Pathname &Provide::mirrorStatisticsPath() const
+  {
+    return d_func()->_mirrorStatsPath;
+  }
+
   bool Provide::ejectDevice(const std::string &queueRef, const std::string &device)
   {
     if ( !queueRef.empty() ) {
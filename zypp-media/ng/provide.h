@@ -153,6 +153,13 @@ namespace zyppng {
 
     void start();
     void setWorkerPath( const zypp::Pathname &path );
+
+    /*!
+     * Directory where the network workers keep the mirror health statistics between runs,
+     * empty by default which disables the statistics. \sa zypp::media::MirrorStatistics
+     */
+    void setMirrorStatisticsPath( const zypp::Pathname &path );
+    const zypp::Pathname &mirrorStatisticsPath () const;
     bool isRunning() const;
     bool ejectDevice ( const std::string &queueRef, const std::string &device );
 
@@ -17,6 +17,7 @@
 #include <zypp-core/base/StringV.h>
 #include <zypp-media/ng/provide-configvars.h>
 #include <zypp-media/MediaException>
+#include <zypp-media/MediaConfig>
 #include <zypp-media/auth/CredentialManager>
 
 #include <zypp-core/Globals.h>
@@ -340,6 +341,10 @@ namespace zyppng {
     conf.insert ( { AGENT_STRING_CONF.data (), "ZYpp " LIBZYPP_VERSION_STRING } );
     conf.insert ( { ATTACH_POINT.data (), _workerProc->workingDirectory().asString() } );
     conf.insert ( { PROVIDER_ROOT.data (), _parent.z_func()->providerWorkdir().asString() } );
+    if ( const auto &statsPath = _parent.z_func()->mirrorStatisticsPath(); !statsPath.empty() )
+      conf.insert ( { MIRROR_STATS_PATH.data (), statsPath.asString() } );
+    if ( zypp::MediaConfig::instance().download_http2_multiplexing() )
+      conf.insert ( { HTTP2_MULTIPLEXING_CONF.data (), "true" } );
 
     const auto &cleanupOnErr = [&](){
       readAllStderr();
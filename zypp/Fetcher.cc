@@ -243,9 +243,6 @@ namespace zypp
 
   void Fetcher::Impl::enqueueDigested( const OnMediaLocation &resource, const FileChecker & )
   {
-    if ( _mediaSetAccess )
-      _mediaSetAccess->precacheFiles( {resource} );
-
     FetcherJob_Ptr job;
     job.reset(new FetcherJob(resource));
     job->flags |= FetcherJob:: AlwaysVerifyChecksum;
@@ -297,9 +294,6 @@ namespace zypp
 
   void Fetcher::Impl::enqueue( const OnMediaLocation &resource, const FileChecker &checker )
   {
-    if ( _mediaSetAccess )
-      _mediaSetAccess->precacheFiles( {resource} );
-
     FetcherJob_Ptr job;
     job.reset(new FetcherJob(resource));
     if ( checker )
@@ -9,6 +9,7 @@
 /** \file	zypp/PoolItem.cc
  *
 */
+#include <atomic>
 #include <iostream>
 #include <zypp/base/Logger.h>
 #include <utility>
@@ -16,6 +17,7 @@
 
 #include <zypp/PoolItem.h>
 #include <zypp/ResPool.h>
+#include <zypp/pool/ChangeJournal.h>
 #include <zypp/Package.h>
 #include <zypp/VendorAttr.h>
 
@@ -30,6 +32,10 @@ namespace zypp
   //	CLASS NAME : PoolItem::Impl
   //
   /** PoolItem implementation.
+   * The kind specific \ref ResObject is created on demand, so a
+   * (re)build of the ResPool store performs just one allocation
+   * per \ref sat::Solvable.
+   *
    * \c _buddy handling:
    * \li \c ==0 no buddy
    * \li \c >0 this uses \c _buddy status
@@ -40,15 +46,18 @@ namespace zypp
     public:
       Impl() {}
 
-      Impl( ResObject::constPtr &&res_r,
+      Impl( const sat::Solvable & solvable_r,
             ResStatus &&status_r )
       : _status( std::move(status_r) )
-      , _resolvable( std::move(res_r) )
+      , _solvable( solvable_r )
       {}
 
       ResStatus & status() const
       { return _buddy > 0 ? PoolItem(buddy()).status() : _status; }
 
+      const ResStatus & ownStatus() const
+      { return _status; }
+
       sat::Solvable buddy() const
       {
         if ( !_buddy )
@@ -60,8 +69,36 @@ namespace zypp
 
       void setBuddy( const sat::Solvable & solv_r );
 
+      sat::Solvable satSolvable() const
+      { return _solvable; }
+
+      ~Impl()
+      {
+        if ( const ResObject * res = _resolvable.load( std::memory_order_acquire ) )
+          intrusive_ptr_release( res );
+      }
+
+      /** Concurrent callers may each create a ResObject, but only the first
+       * one is published and returned to all of them.
+       */
       ResObject::constPtr resolvable() const
-      { return _resolvable; }
+      {
+        const ResObject * ret = _resolvable.load( std::memory_order_acquire );
+        if ( ! ret && _solvable )
+        {
+          ResObject::constPtr made { makeResObject( _solvable ) };
+          if ( made )
+          {
+            if ( _resolvable.compare_exchange_strong( ret, made.get(), std::memory_order_acq_rel, std::memory_order_acquire ) )
+            {
+              ret = made.get();
+              intrusive_ptr_add_ref( ret );	// the reference held by _resolvable
+            }
+            // else: ret is the one published by another thread
+          }
+        }
+        return ResObject::constPtr( ret );
+      }
 
       ResStatus & statusReset() const
       {
@@ -110,7 +147,8 @@ namespace zypp
 
     private:
       mutable ResStatus     _status;
-      ResObject::constPtr   _resolvable;
+      sat::Solvable         _solvable;
+      mutable std::atomic<const ResObject *> _resolvable { nullptr };	///< lazy created by resolvable(), holds a reference
       DefaultIntegral<sat::detail::IdType,sat::detail::noId> _buddy;
 
     /** \name Poor man's save/restore state.
@@ -121,7 +159,13 @@ namespace zypp
       void saveState() const
       { _savedStatus = status(); }
       void restoreState() const
-      { status() = _savedStatus; }
+      {
+        // plain assignment does not report to the journal
+        if ( status().getTransactValue() != _savedStatus.getTransactValue()
+             || status().getTransactByValue() != _savedStatus.getTransactByValue() )
+          pool::ChangeJournal::instance().record( &status() );
+        status() = _savedStatus;
+      }
       bool sameState() const
       {
         if ( status() == _savedStatus )
@@ -171,7 +215,7 @@ namespace zypp
         ERR <<  *this << " would be buddy2 in " << myBuddy << endl;
         return;
       }
-      myBuddy._pimpl->_buddy = -resolvable()->satSolvable().id();
+      myBuddy._pimpl->_buddy = -_solvable.id();
       _buddy = myBuddy.satSolvable().id();
       DBG << *this << " has buddy " << myBuddy << endl;
     }
@@ -197,9 +241,14 @@ namespace zypp
   : _pimpl( implptr_r )
   {}
 
+  PoolItem::PoolItem( shared_ptr<Impl> && implptr_r )
+  : _pimpl( std::move(implptr_r) )
+  {}
+
   PoolItem PoolItem::makePoolItem( const sat::Solvable & solvable_r )
   {
-    return PoolItem( new Impl( makeResObject( solvable_r ), solvable_r.isSystem() ) );
+    // make_shared: Impl and refcount share a single allocation
+    return PoolItem( std::make_shared<Impl>( solvable_r, solvable_r.isSystem() ) );
   }
 
   PoolItem::~PoolItem()
@@ -208,12 +257,16 @@ namespace zypp
   ResPool PoolItem::pool() const
   { return ResPool::instance(); }
 
+  PoolItem::operator sat::Solvable() const
+  { return _pimpl->satSolvable(); }
+
 
   ResStatus & PoolItem::status() const			{ return _pimpl->status(); }
   ResStatus & PoolItem::statusReset() const		{ return _pimpl->statusReset(); }
   ResStatus & PoolItem::statusReinit() const		{ return _pimpl->statusReinit(); }
   sat::Solvable PoolItem::buddy() const			{ return _pimpl->buddy(); }
   void PoolItem::setBuddy( const sat::Solvable & solv_r )	{ _pimpl->setBuddy( solv_r ); }
+  const ResStatus & PoolItem::ownStatus() const		{ return _pimpl->ownStatus(); }
   bool PoolItem::isUndetermined() const			{ return _pimpl->isUndetermined(); }
   bool PoolItem::isRelevant() const			{ return _pimpl->isRelevant(); }
   bool PoolItem::isSatisfied() const			{ return _pimpl->isSatisfied(); }
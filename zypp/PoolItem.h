@@ -117,9 +117,10 @@ namespace zypp
       /** Return the \ref ResPool the item belongs to. */
       ResPool pool() const;
 
-      /** This is a \ref sat::SolvableType. */
-      explicit operator sat::Solvable() const
-      { return resolvable() ? resolvable()->satSolvable() : sat::Solvable::noSolvable; }
+      /** This is a \ref sat::SolvableType.
+       * \note Does not require the \ref ResObject to be created.
+       */
+      explicit operator sat::Solvable() const;
 
       /** Return the buddy we share our status object with.
        * A \ref Product e.g. may share its status with an associated reference \ref Package.
@@ -128,6 +129,7 @@ namespace zypp
 
     public:
       /** Returns the ResObject::constPtr.
+       * The kind specific \ref ResObject is created on first access.
        * \see \ref operator->
        */
       ResObject::constPtr resolvable() const;
@@ -148,11 +150,14 @@ namespace zypp
       static PoolItem makePoolItem( const sat::Solvable & solvable_r );
       /** Buddies are set by \ref pool::PoolImpl.*/
       void setBuddy( const sat::Solvable & solv_r );
+      /** The status object owned by this item, even if a buddy's status is used. */
+      const ResStatus & ownStatus() const;
       /** internal ctor */
     public:
       struct Impl;	///< Expose type only
     private:
       explicit PoolItem( Impl * implptr_r );
+      explicit PoolItem( shared_ptr<Impl> && implptr_r );
       /** Pointer to implementation */
       RW_pointer<Impl> _pimpl;
 
@@ -171,9 +176,12 @@ namespace zypp
   /** \relates PoolItem Stream output */
   std::ostream & operator<<( std::ostream & str, const PoolItem & obj ) ZYPP_API;
 
-  /** \relates PoolItem Required to disambiguate vs. (PoolItem,ResObject::constPtr) due to implicit PoolItem::operator ResObject::constPtr  */
+  /** \relates PoolItem Required to disambiguate vs. (PoolItem,ResObject::constPtr) due to implicit PoolItem::operator ResObject::constPtr
+   * \note The ResPool holds exactly one PoolItem per \ref sat::Solvable, so comparing
+   * the solvables is sufficient and does not force the \ref ResObject to be created.
+   */
   inline bool operator==( const PoolItem & lhs, const PoolItem & rhs )
-  { return lhs.resolvable() == rhs.resolvable(); }
+  { return lhs.satSolvable() == rhs.satSolvable(); }
 
   /** \relates PoolItem Convenience compare */
   inline bool operator==( const PoolItem & lhs, const ResObject::constPtr & rhs )
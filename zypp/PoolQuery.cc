@@ -11,6 +11,9 @@
 */
 #include <iostream>
 #include <sstream>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
 
 #include <zypp/base/Gettext.h>
@@ -20,9 +23,12 @@
 #include <zypp/repo/RepoException.h>
 #include <zypp/RelCompare.h>
 
+#include <zypp/sat/detail/PoolImpl.h>
 #include <zypp/sat/Pool.h>
 #include <zypp/sat/Solvable.h>
+#include <zypp/sat/TrigramIndex.h>
 #include <zypp/base/StrMatcher.h>
+#include <zypp-core/zyppng/thread/ThreadPool>
 
 #include <zypp/PoolQuery.h>
 
@@ -62,6 +68,49 @@ namespace zypp
       return false;
     }
 
+    /** Whether looking up \a attr_r just reads the pool and may be done
+     * on worker threads. Dependencies and filelists are stringified
+     * in the pools tmpspace, \c allAttr includes them.
+     */
+    bool isParallelAttribute( const sat::SolvAttr& attr_r )
+    {
+      static sat::SolvAttr attrs[] = {
+        SolvAttr::name,
+        SolvAttr::summary,
+        SolvAttr::description,
+        SolvAttr::keywords,
+        SolvAttr::group,
+        SolvAttr::vendor,
+        SolvAttr::license,
+        SolvAttr::url,
+        SolvAttr::eula,
+      };
+      for_( it, arrayBegin(attrs), arrayEnd(attrs) )
+        if ( *it == attr_r )
+          return true;
+      return false;
+    }
+
+    /** Whether \a attr_r is read on demand in \a repo_r: stored paged or in a
+     * not yet loaded stub repodata. Loading must not be done on worker threads.
+     */
+    bool isPagedAttribute( const Repository & repo_r, const sat::SolvAttr & attr_r )
+    {
+      sat::detail::CRepo * repo = repo_r.get();
+      int rdid = 0;
+      ::Repodata * data = nullptr;
+      FOR_REPODATAS( repo, rdid, data )
+      {
+        for ( int k = 1; k < data->nkeys; ++k )
+        {
+          if ( data->keys[k].name == attr_r.id()
+               && ( data->state == REPODATA_STUB || data->keys[k].storage == KEY_STORAGE_VERTICAL_OFFSET ) )
+            return true;
+        }
+      }
+      return false;
+    }
+
     /** Whether the current capabilities edition range ovelaps and/or its solvables arch matches.
      * Query asserts \a iter_r points to a capability and we
      * have to check the range only.
@@ -420,6 +469,7 @@ namespace zypp
       : _flags( Match::SUBSTRING | Match::NOCASE | Match::SKIP_KIND )
       , _match_word(false)
       , _status_flags(ALL)
+      , _parallel(false)
     {}
 
     Impl(const Impl &) = default;
@@ -462,6 +512,9 @@ namespace zypp
 
     /** Optional comment string for serialization. */
     mutable std::string _comment;
+
+    /** Search repos on worker threads (not part of the query). */
+    bool _parallel;
     //@}
 
   public:
@@ -979,6 +1032,9 @@ namespace zypp
   void PoolQuery::setStatusFilterFlags( PoolQuery::StatusFilter flags )
   { _pimpl->_status_flags = flags; }
 
+  void PoolQuery::setParallel( bool yesno_r )
+  { _pimpl->_parallel = yesno_r; }
+
 
   const PoolQuery::StrContainer &
   PoolQuery::strings() const
@@ -1033,6 +1089,9 @@ namespace zypp
   PoolQuery::StatusFilter PoolQuery::statusFilterFlags() const
   { return _pimpl->_status_flags; }
 
+  bool PoolQuery::parallel() const
+  { return _pimpl->_parallel; }
+
   bool PoolQuery::empty() const
   {
     try { return begin() == end(); }
@@ -1527,12 +1586,25 @@ namespace zypp
      *
      * \note The original implementation treated an empty search string as
      * <it>"match always"</it>. We stay compatible.
+     *
+     * In \ref PoolQuery::setParallel mode the ctor already collects all matching
+     * solvables, running the base query of each repo on a worker thread. Repos having
+     * a \ref sat::TrigramIndex covering all attributes are not scanned, but just the
+     * candidate solvables the index returns are checked. \ref advance then just
+     * positions \c base_r on the next of the collected solvables.
      */
     class PoolQueryMatcher
     {
       public:
         using base_iterator = sat::LookupAttr::iterator;
 
+        /** The matching solvables in query order (parallel or indexed mode). */
+        struct Matching
+        {
+          std::vector<sat::Solvable> _solvables;
+          std::unordered_map<sat::detail::SolvableIdType,size_t> _index;
+        };
+
       public:
         const base_iterator & end() const
         {
@@ -1542,6 +1614,9 @@ namespace zypp
 
         bool advance( base_iterator & base_r ) const
         {
+          if ( _matching )
+            return advanceMatching( base_r );
+
           if ( base_r == end() )
             base_r = startNewQyery(); // first candidate
           else
@@ -1648,14 +1723,228 @@ namespace zypp
           _status_flags = query_r->_status_flags;
           // StrMatcher
           _attrMatchList = query_r->_attrMatchList;
+
+          collectMatching( query_r->_parallel );
         }
 
         ~PoolQueryMatcher()
         {}
 
       private:
-        /** Initialize a new base query. */
-        base_iterator startNewQyery() const
+        /** Repos to search in pool order, i.e. the order of the sequential search. */
+        std::vector<Repository> candidateRepos() const
+        {
+          std::vector<Repository> ret;
+          for ( const Repository & repo : sat::Pool::instance().repos() )
+          {
+            if ( _status_flags
+               && ( (_status_flags == PoolQuery::INSTALLED_ONLY) != repo.isSystemRepo() ) )
+              continue;
+            if ( ! _repos.empty() && _repos.find( repo ) == _repos.end() )
+              continue;
+            ret.push_back( repo );
+          }
+          return ret;
+        }
+
+        /** Whether the base query may run on worker threads in \a repos_r.
+         * Repos storing a searched attribute paged are loaded into memory
+         * here, on the main thread, so the workers never read a page.
+         */
+        bool parallelizable( const std::vector<Repository> & repos_r ) const
+        {
+          for ( const AttrMatchData & matchData : _attrMatchList )
+          {
+            // Predicates and Solvable::kind may create new Ids in the pool.
+            if ( ! isParallelAttribute( matchData.attr ) || matchData.predicate || matchData.kindPredicate )
+            {
+              DBG << "Sequential search: not all attributes are thread safe." << endl;
+              return false;
+            }
+          }
+          for ( const Repository & repo : repos_r )
+          {
+            for ( const AttrMatchData & matchData : _attrMatchList )
+            {
+              if ( isPagedAttribute( repo, matchData.attr ) )
+              {
+                DBG << "Load " << matchData.attr << " pages of " << repo << endl;
+                ::repo_disable_paging( repo.get() );
+                break;
+              }
+            }
+          }
+          return true;
+        }
+
+        /** Collect the matching solvables of all repos, using the repos
+         * \ref sat::TrigramIndex or (if \a parallel_r) worker threads.
+         * Leaves \ref _matching unset if the plain sequential search is
+         * as good.
+         */
+        void collectMatching( bool parallel_r )
+        {
+          if ( _neverMatchRepo )
+            return;
+
+          std::vector<Repository> repos { candidateRepos() };
+          bool indexed = ! _attrMatchList.empty();
+          for ( const AttrMatchData & matchData : _attrMatchList )
+          {
+            if ( ! sat::TrigramIndex::indexes( matchData.attr ) )
+            {
+              indexed = false;
+              break;
+            }
+          }
+          bool parallel = parallel_r && repos.size() > 1 && parallelizable( repos );
+          if ( ! ( indexed || parallel ) )
+            return;	// nothing to gain
+
+          std::vector<std::vector<sat::Solvable>> found( repos.size() );
+          std::vector<size_t> scan;	// repos to scan
+          for ( size_t i = 0; i < repos.size(); ++i )
+          {
+            if ( ! ( indexed && matchIndexed( repos[i], found[i] ) ) )
+              scan.push_back( i );
+          }
+          if ( scan.size() == repos.size() && ! parallel )
+            return;	// nothing to gain
+
+          if ( parallel && scan.size() > 1 )
+          {
+            // Each dataiterator compiles its own matcher, but assert the shared
+            // StrMatchers are compiled before the threads use them.
+            for ( const AttrMatchData & matchData : _attrMatchList )
+              matchData.strMatcher.compile();
+
+            // The jobs must not throw; matchInRepo only reads the pool.
+            std::mutex mutex;
+            std::condition_variable done;
+            size_t pending = scan.size();
+            for ( size_t i : scan )
+            {
+              zyppng::ThreadPool::cpuPool().submit( [this,&repos,&found,&mutex,&done,&pending,i]() {
+                matchInRepo( repos[i], found[i] );
+                std::lock_guard<std::mutex> guard( mutex );
+                if ( --pending == 0 )
+                  done.notify_one();
+              } );
+            }
+            std::unique_lock<std::mutex> guard( mutex );
+            done.wait( guard, [&pending]() { return pending == 0; } );
+          }
+          else
+          {
+            for ( size_t i : scan )
+              matchInRepo( repos[i], found[i] );
+          }
+
+          shared_ptr<Matching> matching { new Matching };
+          for ( const std::vector<sat::Solvable> & solvables : found )
+          {
+            for ( const sat::Solvable & solv : solvables )
+            {
+              matching->_index[solv.id()] = matching->_solvables.size();
+              matching->_solvables.push_back( solv );
+            }
+          }
+          DBG << "Search in " << repos.size() << " repos (" << repos.size()-scan.size() << " indexed"
+              << ( parallel ? ", parallel" : "" ) << "): " << matching->_solvables.size() << " matches." << endl;
+          _matching = matching;
+        }
+
+        /** Append the matching solvables of \a repo_r to \a found_r, running the base query. */
+        void matchInRepo( const Repository & repo_r, std::vector<sat::Solvable> & found_r ) const
+        {
+          base_iterator base { startNewQyery( repo_r ) };
+          while ( base != end() )
+          {
+            if ( isAMatch( base ) )
+            {
+              found_r.push_back( base.inSolvable() );
+              base.nextSkipSolvable(); // like advance
+            }
+            ++base;
+          }
+        }
+
+        /** Append the matching solvables of \a repo_r to \a found_r, checking
+         * just the candidates returned by the repos \ref sat::TrigramIndex.
+         * \return \c false if the index can't be used.
+         */
+        bool matchIndexed( const Repository & repo_r, std::vector<sat::Solvable> & found_r ) const
+        {
+          shared_ptr<const sat::TrigramIndex> index { sat::TrigramIndex::forRepo( repo_r ) };
+          if ( ! index )
+            return false;
+
+          std::vector<sat::detail::SolvableIdType> ids;
+          for ( const AttrMatchData & matchData : _attrMatchList )
+          {
+            if ( ! index->candidates( matchData.strMatcher, ids ) )
+              return false;
+          }
+          if ( _attrMatchList.size() > 1 )
+          {
+            std::sort( ids.begin(), ids.end() );
+            ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+          }
+
+          sat::Pool::size_type capacity { sat::Pool::instance().capacity() };
+          for ( sat::detail::SolvableIdType id : ids )
+          {
+            if ( id >= capacity )
+              break;
+            sat::Solvable solv( id );
+            if ( solv.repository() != repo_r )
+              continue;	// dropped on load
+            base_iterator base { startInSolvable( solv ) };
+            if ( base != end() && isAMatch( base ) )
+              found_r.push_back( solv );
+          }
+          return true;
+        }
+
+        /** \ref advance in parallel or indexed mode: move \c base_r to the next matching solvable. */
+        bool advanceMatching( base_iterator & base_r ) const
+        {
+          size_t pos = 0;
+          if ( base_r != end() )
+            pos = _matching->_index.at( base_r.inSolvable().id() ) + 1;
+
+          for ( ; pos < _matching->_solvables.size(); ++pos )
+          {
+            base_r = startInSolvable( _matching->_solvables[pos] );
+            if ( base_r != end() )
+              return true;
+          }
+          base_r = end();
+          return false;
+        }
+
+        /** Position a base query on the 1st match in \a solv_r (as \ref matchDetail expects it). */
+        base_iterator startInSolvable( sat::Solvable solv_r ) const
+        {
+          if ( _attrMatchList.size() == 1 )
+          {
+            const AttrMatchData & matchData( _attrMatchList.front() );
+            sat::LookupAttr q( matchData.attr, solv_r );
+            if ( matchData.strMatcher ) // empty searchstring matches always
+              q.setStrMatcher( matchData.strMatcher );
+            for_( it, q.begin(), q.end() )
+            {
+              if ( ! matchData.predicate || matchData.predicate( it ) )
+                return it;
+            }
+            return end();
+          }
+          // more than 1 attr: matchDetail just needs the solvable
+          return sat::LookupAttr( sat::SolvAttr::allAttr, solv_r ).begin();
+        }
+
+        /** Initialize a new base query (optionally restricted to \a repo_r). */
+        base_iterator startNewQyery( Repository repo_r = Repository::noRepository ) const
         {
           sat::LookupAttr q;
 
@@ -1663,7 +1952,9 @@ namespace zypp
             return q.end();
 
           // Repo restriction:
-          if ( _repos.size() == 1 )
+          if ( repo_r )
+            q.setRepo( repo_r );
+          else if ( _repos.size() == 1 )
             q.setRepo( *_repos.begin() );
           // else: handled in isAMatch.
 
@@ -1802,6 +2093,8 @@ namespace zypp
         int _status_flags;
         /** StrMatcher per attribtue. */
         AttrMatchList _attrMatchList;
+        /** Parallel or indexed mode: the matching solvables. */
+        shared_ptr<const Matching> _matching;
     };
     ///////////////////////////////////////////////////////////////////
 
@@ -186,6 +186,23 @@ namespace zypp
 
     //@}
 
+    /** Search the repositories on worker threads, one per repo.
+     *
+     * Results are merged and returned in the same order as in the
+     * sequential search. This is an execution option, not part of
+     * the query: it is neither serialized nor compared.
+     *
+     * \note Only queries on string attributes (name, summary, description,
+     * vendor, ...) spanning more than one repo are parallelized. Searching
+     * dependencies or filelists stringifies data in the pool, which must not
+     * be done concurrently. Those queries silently run sequential.
+     *
+     * \note Attributes a repo stores paged (e.g. descriptions in a solv file)
+     * are read on demand. Before searching them in parallel, the repos pages
+     * are loaded into memory (on the calling thread) and stay there.
+     */
+    void setParallel( bool yesno_r = true );
+
     /**
      * Add a global query string. The string added via this method is applied
      * to all query attributes as if addAttribute(..., \value) was called
@@ -426,6 +443,9 @@ namespace zypp
     { return flags().mode(); }
 
     StatusFilter statusFilterFlags() const;
+
+    /** Whether the repositories are searched on worker threads. \see \ref setParallel */
+    bool parallel() const;
     //@}
 
     /**
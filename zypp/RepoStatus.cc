@@ -69,7 +69,7 @@ namespace zypp
     void assignFromCtor( std::string && checksum_r, Date && timestamp_r )
     {
       if ( !checksum_r.empty() ) {
-        static const std::string magic( "43" );
+        static const std::string magic( "44" );
         checksum_r += magic;
         _checksums.insert( std::move(checksum_r) );
       }
@@ -9,8 +9,13 @@
 /** \file	zypp/sat/Repository.cc
  *
 */
+extern "C"
+{
+#include <fcntl.h>
+}
 #include <climits>
 #include <iostream>
+#include <memory>
 #include <utility>
 
 #include <zypp/base/Logger.h>
@@ -26,6 +31,8 @@
 #include <zypp/ResPool.h>
 #include <zypp/Product.h>
 #include <zypp/sat/Pool.h>
+#include <zypp/sat/TrigramIndex.h>
+#include <zypp/ZConfig.h>
 
 using std::endl;
 
@@ -322,18 +329,39 @@ namespace zypp
     {
       NO_REPOSITORY_THROW( Exception( "Can't add solvables to norepo." ) );
 
+      // The buffer must outlive the FILE.
+      static constexpr size_t readBufferSize = 256*1024;
+      std::unique_ptr<char[]> buffer( new char[readBufferSize] );
+
       AutoDispose<FILE*> file( ::fopen( file_r.c_str(), "re" ), ::fclose );
       if ( file == NULL )
       {
         file.resetDispose();
         ZYPP_THROW( Exception( "Can't open solv-file: "+file_r.asString() ) );
       }
+      // libsolv parses the file front to back and reads the paged (vertical)
+      // data later on demand from a dup'ed fd. Let the kernel read ahead the
+      // whole file while we parse and use a large buffer to save syscalls.
+      ::posix_fadvise( ::fileno( file ), 0, 0, POSIX_FADV_SEQUENTIAL );
+      ::posix_fadvise( ::fileno( file ), 0, 0, POSIX_FADV_WILLNEED );
+      ::setvbuf( file, buffer.get(), _IOFBF, readBufferSize );
+
+      // A solv file loaded into an empty repo gets a block of new ids.
+      const bool wasEmpty = solvablesEmpty();
+      const sat::detail::SolvableIdType first = myPool().getPool()->nsolvables;
 
       if ( myPool()._addSolv( _repo, file ) != 0 )
       {
         ZYPP_THROW( Exception( "Error reading solv-file: "+file_r.asString() ) );
       }
 
+      if ( wasEmpty && ZConfig::instance().repoSearchIndex() )
+      {
+        shared_ptr<const sat::TrigramIndex> index { sat::TrigramIndex::read( file_r, first ) };
+        if ( index && unsigned(_repo->end) <= first + index->size() )
+          myPool().setSearchIndex( _repo, index );
+      }
+
       MIL << *this << " after adding " << file_r << endl;
     }
 
@@ -111,9 +111,12 @@ namespace zypp
   const pool::PoolTraits::ItemContainerT & ResPool::store() const
   { return _pimpl->store(); }
 
-  const pool::PoolTraits::Id2ItemT & ResPool::id2item() const
+  const pool::PoolTraits::Id2ItemT & ResPool::identIndex() const
   { return _pimpl->id2item(); }
 
+  const pool::PoolTraits::Id2ItemCompatT & ResPool::id2item() const
+  { return _pimpl->id2itemCompat(); }
+
   ///////////////////////////////////////////////////////////////////
   //
   // Forward to sat::Pool:
@@ -166,7 +166,7 @@ namespace zypp
 
       byIdent_iterator byIdentBegin( const ByIdent & ident_r ) const
       {
-        return make_transform_iterator( id2item().equal_range( ident_r.get() ).first,
+        return make_transform_iterator( identIndex().equal_range( ident_r.get() ).first,
                                         pool::PoolTraits::Id2ItemValueSelector() );
       }
 
@@ -197,7 +197,7 @@ namespace zypp
 
       byIdent_iterator byIdentEnd( const ByIdent & ident_r ) const
       {
-        return make_transform_iterator( id2item().equal_range( ident_r.get() ).second,
+        return make_transform_iterator( identIndex().equal_range( ident_r.get() ).second,
                                         pool::PoolTraits::Id2ItemValueSelector() );
       }
 
@@ -461,7 +461,13 @@ namespace zypp
 
     private:
       const pool::PoolTraits::ItemContainerT & store() const;
-      const pool::PoolTraits::Id2ItemT & id2item() const;
+      /** The ident index (for \ref byIdent). */
+      const pool::PoolTraits::Id2ItemT & identIndex() const;
+      /** The former \c unordered_multimap ident index, built on demand.
+       * Kept for binaries built against older headers, their inlined
+       * \ref byIdent calls use it.
+       */
+      const pool::PoolTraits::Id2ItemCompatT & id2item() const;
 
     private:
       /** Ctor */
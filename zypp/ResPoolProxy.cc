@@ -71,14 +71,12 @@ namespace zypp
 
   namespace
   {
-    ui::Selectable::Ptr makeSelectablePtr( pool::PoolImpl::Id2ItemT::const_iterator begin_r,
-                                           pool::PoolImpl::Id2ItemT::const_iterator end_r )
+    ui::Selectable::Ptr makeSelectablePtr( pool::PoolTraits::byIdent_iterator begin_r,
+                                           pool::PoolTraits::byIdent_iterator end_r )
     {
-      pool::PoolTraits::byIdent_iterator begin( begin_r, pool::PoolTraits::Id2ItemValueSelector() );
-      pool::PoolTraits::byIdent_iterator end( end_r, pool::PoolTraits::Id2ItemValueSelector() );
-      sat::Solvable solv( begin->satSolvable() );
+      sat::Solvable solv( begin_r->satSolvable() );
 
-      return new ui::Selectable( ui::Selectable::Impl_Ptr( new ui::Selectable::Impl( solv.kind(), solv.name(), begin, end ) ) );
+      return new ui::Selectable( ui::Selectable::Impl_Ptr( new ui::Selectable::Impl( solv.kind(), solv.name(), begin_r, end_r ) ) );
     }
   } // namespace
 
@@ -106,27 +104,13 @@ namespace zypp
     : _pool( std::move(pool_r) )
     {
       const pool::PoolImpl::Id2ItemT & id2item( poolImpl_r.id2item() );
-      if ( ! id2item.empty() )
+      _selIndex.reserve( id2item.identsSize() );
+      for ( pool::PoolImpl::Id2ItemT::size_type idx = 0; idx < id2item.identsSize(); ++idx )
       {
-        // set startpoint
-        pool::PoolImpl::Id2ItemT::const_iterator cbegin = id2item.begin();
-
-        for_( it, id2item.begin(), id2item.end() )
-        {
-          if ( it->first != cbegin->first )
-          {
-            // starting a new Selectable, create the previous one
-            ui::Selectable::Ptr p( makeSelectablePtr( cbegin, it ) );
-            _selPool.insert( SelectablePool::value_type( p->kind(), p ) );
-            _selIndex[cbegin->first] = p;
-            // remember new startpoint
-            cbegin = it;
-          }
-        }
-        // create the final one
-        ui::Selectable::Ptr p( makeSelectablePtr( cbegin, id2item.end() ) );
+        ui::Selectable::Ptr p( makeSelectablePtr( make_transform_iterator( id2item.identBegin( idx ), pool::PoolTraits::Id2ItemValueSelector() ),
+                                                  make_transform_iterator( id2item.identEnd( idx ), pool::PoolTraits::Id2ItemValueSelector() ) ) );
         _selPool.insert( SelectablePool::value_type( p->kind(), p ) );
-        _selIndex[cbegin->first] = p;
+        _selIndex[id2item.ident( idx )] = p;
       }
     }
 
@@ -13,6 +13,7 @@
 //#include <zypp/base/Logger.h>
 
 #include <zypp/ResStatus.h>
+#include <zypp/pool/ChangeJournal.h>
 
 using std::endl;
 
@@ -50,6 +51,9 @@ namespace zypp
   ResStatus::~ResStatus()
   {}
 
+  void ResStatus::journalChange() const
+  { pool::ChangeJournal::instance().record( this ); }
+
 
   ResStatus::ResStatus (enum StateValue s, enum ValidateValue v, enum TransactValue t, enum InstallDetailValue i, enum RemoveDetailValue r)
     : _bitfield (s)
@@ -14,6 +14,7 @@
 
 #include <inttypes.h>
 #include <iosfwd>
+#include <type_traits>
 #include <zypp/Bit.h>
 #include <zypp/Globals.h>
 
@@ -379,10 +380,8 @@ namespace zypp
 
     bool maySetTransactValue( TransactValue newVal_r, TransactByValue causer_r )
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setTransactValue( newVal_r, causer_r );
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setTransactValue( newVal_r, causer_r );
     }
 
     /** Apply a lock (prevent transaction).
@@ -424,10 +423,8 @@ namespace zypp
 
     bool maySetLock( bool to_r, TransactByValue causer_r )
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setLock( to_r, causer_r );
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setLock( to_r, causer_r );
     }
 
     /** Toggle between TRANSACT and KEEP_STATE.
@@ -468,10 +465,8 @@ namespace zypp
 
     bool maySetTransact( bool val_r, TransactByValue causer )
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setTransact (val_r, causer);
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setTransact( val_r, causer );
     }
 
     /** */
@@ -524,10 +519,8 @@ namespace zypp
     bool maySetSoftTransact( bool val_r, TransactByValue causer,
                              TransactByValue causerLimit_r )
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setSoftTransact( val_r, causer, causerLimit_r );
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setSoftTransact( val_r, causer, causerLimit_r );
     }
 
     bool maySetSoftTransact( bool val_r, TransactByValue causer )
@@ -541,10 +534,8 @@ namespace zypp
 
     bool maySetToBeInstalled (TransactByValue causer)
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setToBeInstalled (causer);
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setToBeInstalled( causer );
     }
 
     bool setToBeUninstalled (TransactByValue causer)
@@ -555,10 +546,8 @@ namespace zypp
 
     bool maySetToBeUninstalled (TransactByValue causer)
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setToBeUninstalled (causer);
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setToBeUninstalled( causer );
     }
 
     //------------------------------------------------------------------------
@@ -600,10 +589,8 @@ namespace zypp
 
     bool maySetToBeUninstalledSoft ()
     {
-        bit::BitField<FieldType> savBitfield = _bitfield;
-        bool ret = setToBeUninstalledSoft ();
-        _bitfield = savBitfield;
-        return ret;
+        ResStatus trial( *this );	// a copy is not a pool status, so it does not report
+        return trial.setToBeUninstalledSoft();
     }
 
     bool isSoftInstall () {
@@ -658,7 +645,7 @@ namespace zypp
         return false;
 
       // Ok, we take it all..
-      _bitfield = newStatus_r._bitfield;
+      assignBitfield( newStatus_r._bitfield );
       return true;
     }
 
@@ -688,7 +675,26 @@ namespace zypp
     */
     template<class TField>
       void fieldValueAssign( FieldType val_r )
-    { _bitfield.assign<TField>( val_r ); }
+    {
+      if constexpr ( std::is_same_v<TField,TransactField> || std::is_same_v<TField,TransactByField> )
+      {
+        if ( ! _bitfield.isEqual<TField>( val_r ) )
+          journalChange();
+      }
+      _bitfield.assign<TField>( val_r );
+    }
+
+    /** Set all fields, reporting a change of the transact or lock state. */
+    void assignBitfield( const BitFieldType & val_r )
+    {
+      if ( _bitfield.value<TransactField>() != val_r.value<TransactField>()
+           || _bitfield.value<TransactByField>() != val_r.value<TransactByField>() )
+        journalChange();
+      _bitfield = val_r;
+    }
+
+    /** Report a change to the \ref pool::ChangeJournal (ignored unless this is a \ref PoolItem status). */
+    void journalChange() const;
 
     /** compare two values.
     */
@@ -740,7 +746,7 @@ namespace zypp
         {}
 
         void replay()
-        { if ( _status ) _status->_bitfield = _bitfield; }
+        { if ( _status ) _status->assignBitfield( _bitfield ); }
 
       private:
         ResStatus *             _status;
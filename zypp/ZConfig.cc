@@ -495,6 +495,8 @@ namespace zypp
         , repo_add_probe          	( false )
         , repo_refresh_delay      	( 10 )
         , repoLabelIsAlias              ( false )
+        , repoSearchIndex               ( false )
+        , solverFetchFilelists          ( false )
         , download_use_deltarpm   	( true )
         , download_use_deltarpm_always  ( false )
         , download_media_prefer_download( true )
@@ -583,6 +585,10 @@ namespace zypp
                 {
                   str::strtonum(value, repo_refresh_delay);
                 }
+                else if ( entry == "repo.searchindex" )
+                {
+                  repoSearchIndex = str::strToBool( value, repoSearchIndex );
+                }
                 else if ( entry == "repo.refresh.locales" )
                 {
                   std::vector<std::string> tmp;
@@ -649,6 +655,10 @@ namespace zypp
                 {
                   solver_checkSystemFileDir = Pathname(value);
                 }
+                else if ( entry == "solver.fetchFilelists" )
+                {
+                  solverFetchFilelists = str::strToBool( value, solverFetchFilelists );
+                }
                 else if ( entry == "multiversion" )
                 {
                   MultiversionSpec & defSpec( _multiversionMap.getDefaultSpec() );
@@ -782,6 +792,7 @@ namespace zypp
     unsigned	repo_refresh_delay;
     LocaleSet	repoRefreshLocales;
     bool	repoLabelIsAlias;
+    bool	repoSearchIndex;
 
     bool download_use_deltarpm;
     bool download_use_deltarpm_always;
@@ -796,6 +807,7 @@ namespace zypp
 
     Pathname solver_checkSystemFile;
     Pathname solver_checkSystemFileDir;
+    bool     solverFetchFilelists;
 
     MultiversionSpec &		multiversion()		{ return getMultiversion(); }
     const MultiversionSpec &	multiversion() const	{ return getMultiversion(); }
@@ -1135,6 +1147,9 @@ namespace zypp
   Pathname ZConfig::geoipCachePath() const
   { return builtinRepoCachePath()/"geoip.d"; }
 
+  Pathname ZConfig::mirrorStatsCachePath() const
+  { return builtinRepoCachePath()/"mirrorstats.d"; }
+
   const std::vector<std::string> ZConfig::geoipHostnames () const
   { return _pimpl->geoipHosts; }
 
@@ -1173,6 +1188,12 @@ namespace zypp
   void ZConfig::repoLabelIsAlias( bool yesno_r )
   { _pimpl->repoLabelIsAlias = yesno_r; }
 
+  bool ZConfig::repoSearchIndex() const
+  { return _pimpl->repoSearchIndex; }
+
+  void ZConfig::repoSearchIndex( bool yesno_r )
+  { _pimpl->repoSearchIndex = yesno_r; }
+
   bool ZConfig::download_use_deltarpm() const
   { return _pimpl->download_use_deltarpm; }
 
@@ -1247,6 +1268,12 @@ namespace zypp
   { return ( _pimpl->solver_checkSystemFileDir.empty()
       ? (configPath()/"systemCheck.d") : _pimpl->solver_checkSystemFileDir ); }
 
+  bool ZConfig::solverFetchFilelists() const
+  { return _pimpl->solverFetchFilelists; }
+
+  void ZConfig::solverFetchFilelists( bool yesno_r )
+  { _pimpl->solverFetchFilelists = yesno_r; }
+
 
   namespace
   {
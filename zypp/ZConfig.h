@@ -243,6 +243,12 @@ namespace zypp
        */
       Pathname geoipCachePath() const;
 
+      /**
+       * Path where the mirror health statistics are kept between runs (/var/cache/zypp/mirrorstats.d)
+       * \see \ref media::MirrorStatistics
+       */
+      Pathname mirrorStatsCachePath() const;
+
       /**
        * All hostnames we want to rewrite using the geoip feature. The \ref RepoManager
        * will try to query each hostname via: https://hostname/geoip to receive a redirection
@@ -290,6 +296,17 @@ namespace zypp
        */
       void repoLabelIsAlias( bool yesno_r );
 
+      /**
+       * Whether a trigram search index is built along with the repo
+       * caches and used by \ref PoolQuery (\ref sat::TrigramIndex).
+       * / config option
+       * repo.searchindex
+       */
+      bool repoSearchIndex() const;
+
+      /** Set \ref repoSearchIndex. Affects repo caches built and loaded afterwards. */
+      void repoSearchIndex( bool yesno_r );
+
       /**
        * Maximum number of concurrent connections for a single transfer
        */
@@ -415,6 +432,19 @@ namespace zypp
        */
       Pathname solver_checkSystemFileDir() const;
 
+      /**
+       * Whether the resolver may download the file lists of repos whose
+       * packages could satisfy a file dependency the loaded metadata can
+       * not resolve (\ref sat::Pool::provideNeededFilelists).
+       * / config option
+       * solver.fetchFilelists
+       * Default: false
+       */
+      bool solverFetchFilelists() const;
+
+      /** Set \ref solverFetchFilelists. */
+      void solverFetchFilelists( bool yesno_r );
+
       /**
        * Whether vendor check is by default enabled.
        */
@@ -178,6 +178,7 @@ namespace zypp
        * \param "Localpath"	Pathname to downloaded package on disk
        * \param "CheckPackageResult"	RpmDb::CheckPackageResult of signature check
        * \param "CheckPackageDetail"	RpmDb::CheckPackageDetail logmessages of rpm signature check
+       * \param "VerifyPackageResult"	target::rpm::VerifyPackageResult structured result of the signature and digest check
        *
        *  Userdata accepted:
        * \param "Action"	DownloadResolvableReport::Action user advice how to behave on error (ABORT).
@@ -403,6 +404,27 @@ namespace zypp
         ) {}
     };
 
+    /**
+     * Passes the data of a file download on as it is written, in file order.
+     *
+     * A receiver may process the file while it arrives (e.g. let rpm check a
+     * package's signature) instead of reading it again once it is complete.
+     * The data passed is void, if the download is restarted (\ref start) or
+     * if the remaining data can't be passed in order (\ref unavailable).
+     * Whether a download completed is told by the \ref DownloadProgressReport.
+     */
+    struct ZYPP_API DownloadDataReport : public callback::ReportBase
+    {
+      /** Writing \a localfile starts at its beginning. */
+      virtual void start( const Url &/*file*/, const Pathname &/*localfile*/ ) {}
+
+      /** The next \a len bytes written to the file. */
+      virtual void data( const char */*data*/, size_t /*len*/ ) {}
+
+      /** The file is not written in order, e.g. in blocks from several mirrors. */
+      virtual void unavailable( const Url &/*file*/ ) {}
+    };
+
     // authentication issues report
     struct ZYPP_API AuthenticationReport : public callback::ReportBase
     {
@@ -13,6 +13,14 @@
 #include <iostream>
 #include <chrono>
 #include <list>
+#include <algorithm>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <condition_variable>
 
 #include <zypp/base/Logger.h>
 #include <zypp/ExternalProgram.h>
@@ -30,6 +38,7 @@
 #include <zypp-media/auth/CredentialManager>
 #include <zypp-curl/CurlConfig>
 #include <zypp-curl/private/curlhelper_p.h>
+#include <zypp-curl/parser/metadatahelper.h>
 #include <zypp/Target.h>
 #include <zypp/ZYppFactory.h>
 #include <zypp/ZConfig.h>
@@ -261,6 +270,23 @@ namespace internal {
     return 0;
   }
 
+  /// CURLOPT_WRITEFUNCTION writing to the file (like curl's default) and
+  /// passing the data on to a \ref zypp::media::DownloadDataReport.
+  struct WriteData
+  {
+    static size_t write( char *ptr, size_t size, size_t nmemb, void *userdata )
+    {
+      WriteData *self = reinterpret_cast<WriteData *>( userdata );
+      size_t ret = ::fwrite( ptr, size, nmemb, self->_file );
+      if ( ret )
+        (*self->_report)->data( ptr, ret * size );
+      return ret;
+    }
+
+    FILE * _file;
+    zypp::callback::SendReport<zypp::media::DownloadDataReport> *_report;
+  };
+
   const char * anonymousIdHeader()
   {
     // we need to add the release and identifier to the
@@ -330,6 +356,385 @@ namespace zypp {
 
 Pathname MediaCurl::_cookieFile = "/var/lib/YaST2/cookies";
 
+///////////////////////////////////////////////////////////////////
+/// \class MediaCurlPrecacher
+/// \brief Background downloader for \ref MediaCurl::precacheFiles.
+///
+/// Files are downloaded concurrently via a curl multi handle in a
+/// separate thread, using duplicates of the media's configured easy
+/// handle. At most \c maxConnections_r transfers run at the same time.
+/// A download lands in a temp file next to its target. \ref claim
+/// hands it over to \ref MediaCurl::getFileCopy, which forwards the
+/// download progress to the report and does the usual checks before
+/// moving it into place.
+///
+/// The requests carry the \c headers_r passed by the media (i.e. the
+/// \c Accept: metalink header of \ref MediaMultiCurl). A download answered
+/// with metalink or zsync data is dropped, so the file takes the media's
+/// regular (multi mirror) download path. As the server will answer the
+/// same way for the remaining files, the pending downloads are dropped too
+/// and no new ones are accepted.
+///
+/// Failed precache downloads are silently dropped and their temp files
+/// removed; the caller then downloads the file the usual way (incl.
+/// authentication, retry and error reporting). A transfer broken after
+/// receiving data leaves a \ref Claimed::_partial file, which the caller
+/// may pass as block source (\ref OnMediaLocation::deltafile) to a media
+/// able to reuse it.
+///////////////////////////////////////////////////////////////////
+class MediaCurlPrecacher
+{
+  using AutoCURL = AutoDispose<CURL*>;
+
+public:
+  /** Progress of a claimed download (bytes received, bytes total or 0), returning whether to continue. */
+  using ProgressCb = std::function<bool( curl_off_t, curl_off_t )>;
+
+  /** Result of \ref claim. */
+  struct Claimed
+  {
+    ManagedFile _file;		///< the temp file (removed unless moved into place and the dispose function is reset)
+    bool _partial = false;	///< \c _file holds just the beginning of a broken download
+  };
+
+  MediaCurlPrecacher( CURL * template_r, const curl_slist * headers_r, unsigned maxConnections_r )
+  : _template { curl_easy_duphandle( template_r ), curl_easy_cleanup }
+  , _headers { nullptr, curl_slist_free_all }
+  , _maxConnections { maxConnections_r ? maxConnections_r : 1 }
+  {
+    if ( _template )
+    {
+      // Own copy of the headers, the media may free its list while we are running
+      curl_slist * headers = nullptr;
+      for ( const curl_slist * sl = headers_r; sl; sl = sl->next )
+        headers = curl_slist_append( headers, sl->data );
+      _headers = AutoDispose<curl_slist*>( headers, curl_slist_free_all );
+      curl_easy_setopt( _template, CURLOPT_HTTPHEADER, headers );
+      // The template must not report into the MediaCurl object
+      curl_easy_setopt( _template, CURLOPT_ERRORBUFFER, (char*)nullptr );
+      curl_easy_setopt( _template, CURLOPT_WRITEFUNCTION, (void*)nullptr );	// fwrite to CURLOPT_WRITEDATA
+      curl_easy_setopt( _template, CURLOPT_HEADERFUNCTION, (void*)nullptr );
+      curl_easy_setopt( _template, CURLOPT_HEADERDATA, (void*)nullptr );
+      curl_easy_setopt( _template, CURLOPT_XFERINFOFUNCTION, &Job::progressCallback );
+      curl_easy_setopt( _template, CURLOPT_XFERINFODATA, (void*)nullptr );
+      curl_easy_setopt( _template, CURLOPT_NOPROGRESS, 0L );
+      curl_easy_setopt( _template, CURLOPT_TIMECONDITION, CURL_TIMECOND_NONE );
+      curl_easy_setopt( _template, CURLOPT_TIMEVALUE, 0L );
+      _thread = std::thread( [this]() { run(); } );
+    }
+    else
+      WAR << "Precache disabled: curl_easy_duphandle failed" << endl;
+  }
+
+  MediaCurlPrecacher( const MediaCurlPrecacher & ) = delete;
+  MediaCurlPrecacher & operator=( const MediaCurlPrecacher & ) = delete;
+
+  ~MediaCurlPrecacher()
+  {
+    {
+      std::lock_guard<std::mutex> guard( _mutex );
+      _stop = true;
+    }
+    _cond.notify_all();
+    if ( _thread.joinable() )
+      _thread.join();
+    // ~Job: unclaimed temp files are removed
+  }
+
+  /** Schedule downloading \a url_r for \a target_r (expecting at most \a size_r bytes if not 0). */
+  void add( const Url & url_r, const Pathname & target_r, const ByteCount & size_r )
+  {
+    if ( ! _template )
+      return;
+    {
+      std::lock_guard<std::mutex> guard( _mutex );
+      if ( _metadataOffered || _jobs.count( target_r ) )
+        return;
+      Job & job { _jobs[target_r] };
+      job._url = url_r.asString();
+      job._size = size_r;
+      _queue.push_back( target_r );
+    }
+    _cond.notify_all();
+  }
+
+  /** The temp file \a target_r was successfully precached to (or an empty \ref ManagedFile).
+   * A download not yet started or failed is dropped, so the caller may immediately
+   * go for it. For a running or finished download \a progress_r is called at least once and
+   * then periodically while waiting for it to finish. If \a progress_r returns
+   * \c false, the download is aborted.
+   * The returned temp file is removed unless the caller moves it into place
+   * and resets the dispose function.
+   */
+  Claimed claim( const Pathname & target_r, const ProgressCb & progress_r )
+  {
+    std::unique_lock<std::mutex> lock( _mutex );
+    auto it { _jobs.find( target_r ) };
+    if ( it == _jobs.end() )
+      return Claimed();
+
+    if ( it->second._state == Job::Pending || it->second._state == Job::Failed || it->second._state == Job::Partial )
+    {
+      Claimed ret;
+      if ( it->second._state == Job::Pending )
+        _queue.erase( std::find( _queue.begin(), _queue.end(), target_r ) );
+      else
+      {
+        DBG << "Precache failed for " << target_r << ": " << it->second._error << endl;
+        ret._file = it->second._tmp;
+        ret._partial = ( it->second._state == Job::Partial );
+      }
+      _jobs.erase( it );
+      return ret;
+    }
+
+    bool goOn = true;
+    do
+    {
+      curl_off_t dlnow = it->second._dlnow;
+      curl_off_t dltotal = it->second._dltotal;
+      if ( it->second._state == Job::Done )
+        dlnow = dltotal = PathInfo( it->second._tmp ).size();
+      lock.unlock();
+      goOn = progress_r( dlnow, dltotal );
+      lock.lock();
+      it = _jobs.find( target_r );
+      if ( it == _jobs.end() )
+        return Claimed();
+      if ( ! goOn )
+      {
+        it->second._abort = true;
+        _cond.wait( lock, [&]() { return it->second._state != Job::Running; } );
+        break;
+      }
+    } while ( ! _cond.wait_for( lock, std::chrono::milliseconds( 200 ), [&]() { return it->second._state != Job::Running; } ) );
+
+    Job::State state { it->second._state };
+    Claimed ret { it->second._tmp, state == Job::Partial };
+    std::string error { it->second._error };
+    _jobs.erase( it );
+    lock.unlock();
+
+    if ( goOn && state == Job::Done )
+      return ret;
+    DBG << "Precache failed for " << target_r << ": " << ( goOn ? error : "aborted" ) << endl;
+    if ( goOn && state == Job::Partial )
+      return ret;
+    return Claimed();
+  }
+
+private:
+  struct Job
+  {
+    enum State { Pending, Running, Done, Partial, Failed };
+    State       _state = Pending;
+    std::string _url;
+    ByteCount   _size;
+    ManagedFile _tmp;	///< unlinked unless claimed; released as soon as the download failed (unless Partial)
+    AutoFILE    _file;
+    AutoCURL    _easy;
+    std::string _error;
+    std::atomic<curl_off_t> _dlnow { 0 };	///< written by the download thread
+    std::atomic<curl_off_t> _dltotal { 0 };
+    std::atomic<bool>       _abort { false };	///< set by claim
+
+    static int progressCallback( void * clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t )
+    {
+      Job * job = reinterpret_cast<Job *>( clientp );
+      if ( ! job )
+        return 0;
+      job->_dltotal = dltotal;
+      job->_dlnow = dlnow;
+      return job->_abort ? 1 : 0;
+    }
+  };
+
+  /** Start the download of \a target_r. Called with \ref _mutex locked.
+   * On error the \ref Job's resources are released by its dtor.
+   */
+  bool startJob( CURLM * multi_r, const Pathname & target_r, Job & job_r )
+  {
+    job_r._state = Job::Failed;
+    if ( filesystem::assert_dir( target_r.dirname() ) != 0 )
+    {
+      job_r._error = "Can not create " + target_r.dirname().asString();
+      return false;
+    }
+    AutoFREE<char> buf { ::strdup( target_r.extend( ".precache.zypp.XXXXXX" ).c_str() ) };
+    AutoFD fd { buf ? ::mkostemp( buf, O_CLOEXEC ) : -1 };
+    if ( fd == -1 )
+    {
+      job_r._error = "Can not create temp file for " + target_r.asString();
+      return false;
+    }
+    job_r._tmp = ManagedFile( Pathname( *buf ), filesystem::unlink );
+    job_r._file = ::fdopen( fd, "we" );
+    if ( ! job_r._file )
+    {
+      job_r._error = "fdopen failed";
+      return false;
+    }
+    fd.resetDispose();	// ::fdopen moved ownership to file
+
+    job_r._easy = AutoCURL( curl_easy_duphandle( _template ), curl_easy_cleanup );
+    if ( ! job_r._easy )
+    {
+      job_r._error = "curl_easy_duphandle failed";
+      return false;
+    }
+    curl_easy_setopt( job_r._easy, CURLOPT_URL, job_r._url.c_str() );
+    curl_easy_setopt( job_r._easy, CURLOPT_WRITEDATA, job_r._file.value() );
+    curl_easy_setopt( job_r._easy, CURLOPT_PRIVATE, &job_r );
+    curl_easy_setopt( job_r._easy, CURLOPT_XFERINFODATA, &job_r );
+    if ( job_r._size )
+      curl_easy_setopt( job_r._easy, CURLOPT_MAXFILESIZE_LARGE, curl_off_t(job_r._size) );
+    if ( curl_multi_add_handle( multi_r, job_r._easy ) != CURLM_OK )
+    {
+      job_r._error = "curl_multi_add_handle failed";
+      return false;
+    }
+    job_r._state = Job::Running;
+    return true;
+  }
+
+  /** Evaluate a finished download. Called with \ref _mutex locked. */
+  void finishJob( CURLM * multi_r, Job & job_r, CURLcode result_r )
+  {
+    long httpReturnCode = 0;
+    curl_easy_getinfo( job_r._easy, CURLINFO_RESPONSE_CODE, &httpReturnCode );
+    char * contentType = nullptr;
+    curl_easy_getinfo( job_r._easy, CURLINFO_CONTENT_TYPE, &contentType );
+    bool metadata = contentType && ( str::startsWith( contentType, "application/x-zsync" )
+                                     || str::startsWith( contentType, "application/metalink+xml" )
+                                     || str::startsWith( contentType, "application/metalink4+xml" ) );
+    curl_multi_remove_handle( multi_r, job_r._easy );
+    job_r._easy.reset();
+
+    bool ok = ( result_r == CURLE_OK && ( httpReturnCode == 0 || httpReturnCode / 100 == 2 ) );
+    if ( ::fchmod( ::fileno( job_r._file ), filesystem::applyUmaskTo( 0644 ) ) )
+      WAR << "Failed to chmod file " << job_r._tmp << endl;
+    job_r._file.resetDispose();	// we're going to close it manually here
+    if ( ::fclose( job_r._file ) )
+      ok = false;
+    job_r._file.reset();
+
+    // bnc#649925: servers may not tell the content type of metalink data
+    if ( ok && ( metadata || looks_like_meta_file( *job_r._tmp ) != MetaDataType::None ) )
+    {
+      job_r._state = Job::Failed;
+      job_r._error = "metalink or zsync data offered";
+      if ( ! _metadataOffered )
+      {
+        // The remaining files take the multi mirror path as well; don't waste requests on them.
+        MIL << "Precache stopped: the server offers metalink or zsync data" << endl;
+        _metadataOffered = true;
+        for ( const Pathname & target : _queue )
+          _jobs.erase( target );
+        _queue.clear();
+      }
+    }
+    else if ( ok )
+      job_r._state = Job::Done;
+    else
+    {
+      // Data received from a broken transfer may serve as block source
+      bool partial = ( httpReturnCode == 0 || httpReturnCode / 100 == 2 ) && ! metadata && result_r != CURLE_FILESIZE_EXCEEDED
+                     && PathInfo( *job_r._tmp ).size() > 0;
+      job_r._state = partial ? Job::Partial : Job::Failed;
+      job_r._error = str::Str() << "curl error " << result_r << " (" << curl_easy_strerror( result_r ) << "), response code " << httpReturnCode;
+    }
+    if ( job_r._state == Job::Failed )
+      job_r._tmp.reset();	// don't leave it in the attach point until claimed
+  }
+
+  /** The download thread. */
+  void run()
+  {
+    CURLM * multi = curl_multi_init();
+    if ( ! multi )
+    {
+      ERR << "Precache disabled: curl_multi_init failed" << endl;
+      std::lock_guard<std::mutex> guard( _mutex );
+      for ( auto & [target, job] : _jobs )
+        job._state = Job::Failed;
+      _queue.clear();
+      _cond.notify_all();
+      return;
+    }
+    MIL << "Precache thread started (" << _maxConnections << " connections)" << endl;
+
+    unsigned running = 0;
+    while ( true )
+    {
+      {
+        std::unique_lock<std::mutex> lock( _mutex );
+        if ( ! running )
+          _cond.wait( lock, [this]() { return _stop || ! _queue.empty(); } );
+        if ( _stop )
+          break;
+        while ( running < _maxConnections && ! _queue.empty() )
+        {
+          Pathname target { _queue.front() };
+          _queue.pop_front();
+          if ( startJob( multi, target, _jobs[target] ) )
+            ++running;
+          else
+            _cond.notify_all();
+        }
+      }
+
+      int stillRunning = 0;
+      curl_multi_perform( multi, &stillRunning );
+
+      int msgsLeft = 0;
+      while ( CURLMsg * msg = curl_multi_info_read( multi, &msgsLeft ) )
+      {
+        if ( msg->msg != CURLMSG_DONE )
+          continue;
+        Job * job = nullptr;
+        curl_easy_getinfo( msg->easy_handle, CURLINFO_PRIVATE, &job );
+        CURLcode result = msg->data.result;
+        {
+          std::lock_guard<std::mutex> guard( _mutex );
+          finishJob( multi, *job, result );
+          --running;
+        }
+        _cond.notify_all();
+      }
+
+      if ( running )
+        curl_multi_wait( multi, nullptr, 0, 100, nullptr );
+    }
+
+    // stopped: abort all running transfers
+    {
+      std::lock_guard<std::mutex> guard( _mutex );
+      for ( auto & [target, job] : _jobs )
+      {
+        if ( job._state == Job::Running )
+          finishJob( multi, job, CURLE_ABORTED_BY_CALLBACK );
+      }
+    }
+    curl_multi_cleanup( multi );
+    MIL << "Precache thread stopped" << endl;
+  }
+
+private:
+  AutoCURL                  _template;
+  AutoDispose<curl_slist*>  _headers;	///< used by _template and the jobs
+  unsigned                  _maxConnections;
+  std::mutex                _mutex;
+  std::condition_variable   _cond;
+  std::map<Pathname,Job>    _jobs;
+  std::deque<Pathname>      _queue;
+  bool                      _metadataOffered = false;	///< the server answers with metalink or zsync data
+  bool                      _stop = false;
+  std::thread               _thread;
+};
+
+///////////////////////////////////////////////////////////////////
+
+
 // we use this define to unbloat code as this C setting option
 // and catching exception is done frequently.
 /** \todo deprecate SET_OPTION and use the typed versions below. */
@@ -379,6 +784,9 @@ MediaCurl::MediaCurl( const Url &      url_r,
   }
 }
 
+MediaCurl::~MediaCurl()
+{ try { release(); } catch(...) {} }
+
 Url MediaCurl::clearQueryString(const Url &url) const
 {
   return internal::clearQueryString(url);
@@ -713,6 +1121,8 @@ MediaCurl::checkAttachPoint(const Pathname &apoint) const
 
 void MediaCurl::disconnectFrom()
 {
+  _precacher.reset();
+
   if ( _customHeaders )
   {
     curl_slist_free_all(_customHeaders);
@@ -765,7 +1175,8 @@ void MediaCurl::getFileCopy( const OnMediaLocation & srcFile , const Pathname &
   {
     try
     {
-      doGetFileCopy( srcFile, target, report );
+      if ( ! doGetPrecachedFile( srcFile, target, report ) )
+        doGetFileCopy( srcFile, target, report );
       break;  // success!
     }
     // retry with proper authentication data
@@ -808,6 +1219,24 @@ void MediaCurl::getFileCopy( const OnMediaLocation & srcFile , const Pathname &
 
 ///////////////////////////////////////////////////////////////////
 
+void MediaCurl::precacheFiles( const std::vector<OnMediaLocation> & files )
+{
+  if ( files.empty() || ! _curl )
+    return;
+
+  if ( ! _precacher )
+    _precacher.reset( new MediaCurlPrecacher( _curl, precacheHeaders(), _settings.maxConcurrentConnections() ) );
+
+  for ( const auto & file : files )
+  {
+    // Same url and destination as used by getFile
+    _precacher->add( clearQueryString( getFileUrl( file.filename() ) ), localPath( file.filename() ).absolutename(), file.downloadSize() );
+  }
+  DBG << "Precaching " << files.size() << " files" << endl;
+}
+
+///////////////////////////////////////////////////////////////////
+
 bool MediaCurl::getDoesFileExist( const Pathname & filename ) const
 {
   bool retry = false;
@@ -1199,6 +1628,61 @@ void MediaCurl::doGetFileCopy( const OnMediaLocation &srcFile , const Pathname &
 
 ///////////////////////////////////////////////////////////////////
 
+bool MediaCurl::doGetPrecachedFile( const OnMediaLocation & srcFile, const Pathname & target, callback::SendReport<DownloadProgressReport> & report ) const
+{
+  if ( ! _precacher )
+    return false;
+
+  // Same reporting and checks as for a regular download, once the file turns out to be precached
+  Pathname dest = target.absolutename();
+  Url url( getFileUrl( srcFile.filename() ) );
+  internal::ProgressData progressData( nullptr, 0, url, srcFile.downloadSize(), &report );
+  bool started = false;
+  bool aborted = false;
+  MediaCurlPrecacher::Claimed claimed { _precacher->claim( dest, [&]( curl_off_t dlnow, curl_off_t dltotal ) {
+    if ( ! started )
+    {
+      report->start( url, dest );
+      started = true;
+    }
+    progressData.updateStats( dltotal, dlnow );
+    aborted = progressData.reportProgress() != 0;
+    return ! aborted;
+  } ) };
+
+  if ( progressData.fileSizeExceeded() )
+    ZYPP_THROW( MediaFileSizeExceededException( url, progressData.expectedFileSize() ) );
+  if ( aborted )
+    evaluateCurlCode( srcFile.filename(), CURLE_ABORTED_BY_CALLBACK, false );	// throws
+  if ( claimed._partial )
+  {
+    // Not precached after all, but MediaMultiCurl may reuse the data received as block source
+    OnMediaLocation src { srcFile };
+    if ( src.deltafile().empty() )
+      src.setDeltafile( claimed._file );
+    doGetFileCopy( src, target, report, started ? OPTION_NO_REPORT_START : OPTION_NONE );
+    return true;	// ~claimed removes the partial file
+  }
+  if ( claimed._file->empty() )
+  {
+    if ( started )
+      doGetFileCopy( srcFile, target, report, OPTION_NO_REPORT_START );	// not precached after all
+    return started;
+  }
+
+  ManagedFile & tmp { claimed._file };
+
+  if ( rename( tmp, dest ) != 0 ) {
+    ERR << "Rename failed" << endl;
+    ZYPP_THROW( MediaWriteException( dest ) );
+  }
+  tmp.resetDispose();	// no more need to unlink it
+  DBG << "Precached " << dest << " (" << PathInfo( dest ).size() << ")" << endl;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////
+
 void MediaCurl::doGetFileCopyFile( const OnMediaLocation & srcFile, const Pathname & dest, FILE *file, callback::SendReport<DownloadProgressReport> & report, RequestOptions options ) const
 {
     DBG << srcFile.filename().asString() << endl;
@@ -1234,15 +1718,23 @@ void MediaCurl::doGetFileCopyFile( const OnMediaLocation & srcFile, const Pathna
       ZYPP_THROW(MediaCurlSetOptException(url, _curlError));
     }
 
-    ret = curl_easy_setopt( _curl, CURLOPT_WRITEDATA, file );
-    if ( ret != 0 ) {
+    // pass the data on as it is written (e.g. to check a package meanwhile)
+    callback::SendReport<DownloadDataReport> dataReport;
+    internal::WriteData writeData { file, &dataReport };
+    if ( curl_easy_setopt( _curl, CURLOPT_WRITEFUNCTION, &internal::WriteData::write ) != 0
+         || curl_easy_setopt( _curl, CURLOPT_WRITEDATA, &writeData ) != 0 ) {
       ZYPP_THROW(MediaCurlSetOptException(url, _curlError));
     }
+    OnScopeExit resetWriteData( [this, file](){
+      curl_easy_setopt( _curl, CURLOPT_WRITEFUNCTION, (void*)nullptr );
+      curl_easy_setopt( _curl, CURLOPT_WRITEDATA, file );
+    });
 
     // Set callback and perform.
     internal::ProgressData progressData(_curl, _settings.timeout(), url, srcFile.downloadSize(), &report);
     if (!(options & OPTION_NO_REPORT_START))
       report->start(url, dest);
+    dataReport->start( url, dest );
     if ( curl_easy_setopt( _curl, CURLOPT_PROGRESSDATA, &progressData ) != 0 ) {
       WAR << "Can't set CURLOPT_PROGRESSDATA: " << _curlError << endl;;
     }
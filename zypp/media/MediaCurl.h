@@ -18,9 +18,13 @@
 
 #include <curl/curl.h>
 
+#include <memory>
+
 namespace zypp {
   namespace media {
 
+class MediaCurlPrecacher;
+
 ///////////////////////////////////////////////////////////////////
 //
 //	CLASS NAME : MediaCurl
@@ -93,12 +97,20 @@ class MediaCurl : public MediaNetworkCommonHandler
 
     bool checkAttachPoint(const Pathname &apoint) const override;
 
+    /**
+     * Start downloading \a files concurrently in the background (bounded by
+     * \ref TransferSettings::maxConcurrentConnections). A later \ref getFile
+     * for one of these files waits for and uses the precached download.
+     * \see MediaHandler::precacheFiles
+     */
+    void precacheFiles( const std::vector<OnMediaLocation> & files ) override;
+
   public:
 
     MediaCurl( const Url &      url_r,
                const Pathname & attach_point_hint_r );
 
-    ~MediaCurl() override { try { release(); } catch(...) {} }
+    ~MediaCurl() override;
 
     static void setCookieFile( const Pathname & );
 
@@ -143,6 +155,20 @@ class MediaCurl : public MediaNetworkCommonHandler
 
     void doGetFileCopyFile( const OnMediaLocation & srcFile, const Pathname & dest, FILE *file, callback::SendReport<DownloadProgressReport> & report, RequestOptions options = OPTION_NONE ) const;
 
+    /** Move a file downloaded by \ref precacheFiles into place, reporting and
+     * checking it like a regular download. The progress of a download still
+     * running is forwarded to \a report while waiting for it. If a started
+     * download fails, the file is downloaded the regular way right here, passing
+     * the data received so far as \ref OnMediaLocation::deltafile.
+     * \return \c false if the file was not precached (nothing was reported).
+     * \throws MediaException
+     */
+    bool doGetPrecachedFile( const OnMediaLocation & srcFile, const Pathname & target, callback::SendReport<DownloadProgressReport> & report ) const;
+
+    /** The HTTP headers sent by \ref precacheFiles downloads. */
+    virtual const curl_slist * precacheHeaders() const
+    { return _customHeaders; }
+
     static void resetExpectedFileSize ( void *clientp, const ByteCount &expectedFileSize );
 
   private:
@@ -166,6 +192,8 @@ class MediaCurl : public MediaNetworkCommonHandler
 
     mutable std::string _lastRedirect;	///< to log/report redirections
 
+    std::unique_ptr<MediaCurlPrecacher> _precacher;	///< background downloads started by precacheFiles
+
   protected:
     CURL *_curl;
     curl_slist *_customHeaders;
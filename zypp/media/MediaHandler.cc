@@ -300,6 +300,23 @@ MediaHandler::setAttachPrefix(const Pathname &attach_prefix)
   return false;
 }
 
+///////////////////////////////////////////////////////////////////
+//
+//
+//	METHOD NAME : MediaHandler::defaultAttachRoot
+//	METHOD TYPE : Pathname
+//
+Pathname
+MediaHandler::defaultAttachRoot()
+{
+  if ( ! MediaHandler::_attachPrefix.empty() )
+    return MediaHandler::_attachPrefix;
+  Pathname aroot { ZConfig::instance().download_mediaMountdir() };
+  if ( ! aroot.empty() )
+    return aroot;
+  return filesystem::TmpPath::defaultLocation();
+}
+
 ///////////////////////////////////////////////////////////////////
 //
 //
@@ -57,6 +57,13 @@ class MediaHandler {
 
         static bool setAttachPrefix(const Pathname &attach_prefix);
 
+        /**
+         * The directory a default attach point is preferably created in
+         * (the attach prefix, the configured media mountdir or the temp space).
+         * Downloading handlers store the files they provide there.
+         */
+        static Pathname defaultAttachRoot();
+
         static std::string getRealPath(const std::string &path);
         static Pathname    getRealPath(const Pathname    &path);
 
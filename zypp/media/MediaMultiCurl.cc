@@ -22,6 +22,8 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <optional>
 
 
 #include <zypp/ManagedFile.h>
@@ -99,13 +101,19 @@ namespace zypp {
  * go over the list of currently running workers and try to figure out the best candidate for stealing. This is based on the performance of the
  * worker and how many workers already compete on a stripe.
  *
- * - If the worker finds a best candidate it will start competition on the stripe and
- *    will request all ranges not marked as "FINALIZED" from the server as well. The worker finishing a block first wins, the one loosing will
- *    stop downloading and report back to get a next job if there is one.
+ * - If a worker still owns blocks nobody started to fetch yet, the stealer splits off the upper half of them and fetches it. The owner
+ *    keeps the lower half. As owners fetch their blocks in ascending order, both meet at the split point and the one reaching a block
+ *    that was already finalized stops and asks for a next job. The worker whose remaining blocks would take the longest (based on its
+ *    average speed) is split first, so a slow or stalled mirror can't hold back the whole file with its stripe.
+ * - If there is nothing left to split, the worker will look for the best candidate to race with. If it finds one it will start competition
+ *    on the stripe and will request all ranges not marked as "FINALIZED" from the server as well. The worker finishing a block first wins,
+ *    the one loosing will stop downloading and report back to get a next job if there is one.
  * - If the worker can not find a best candidate , it will set itself to "WORKER_DONE" and stop stealing stripes
  *
  *
  * Once a worker is done it needs to check if all blocks from its current stripe are marked as FINALIZED, otherwise they need to be refetched.
+ * A competing worker only refetches the blocks no other running worker on the stripe is going to fetch (e.g. blocks that failed to verify
+ * or that belonged to a broken worker), the rest is left to their owners.
  */
 
 
@@ -158,9 +166,36 @@ public:
 
   /*!
    * Fetches all jobs from the currently claimed stripe or calls nextjob()
-   * if the current stripe has all blocks marked as FINALIZED
+   * if the current stripe has all blocks marked as FINALIZED.
+   * Only the stripe blocks in [ \a firstBlock, \a endBlock ) are fetched,
+   * \a endBlock defaults to the end of the stripe.
    */
-  void runjob();
+  void runjob( off_t firstBlock = 0, std::optional<off_t> endBlock = {} );
+
+  /*!
+   * Fetches only the given stripe blocks of the current stripe,
+   * \a stripeBlocks must be sorted ascending.
+   */
+  void runjob( const std::vector<off_t> &stripeBlocks );
+
+  /*!
+   * The nr of bytes of the current job that are not yet finalized,
+   * by us or by any other worker.
+   */
+  size_t remainingBytes() const;
+
+  /*!
+   * The stripe block index where a stealer may split off the upper half of the blocks
+   * this worker owns but did not start to fetch yet. Returns no value if there is
+   * nothing to split.
+   */
+  std::optional<off_t> splitPoint() const;
+
+  /*!
+   * The not yet finalized blocks of the current stripe no running worker is going to fetch,
+   * e.g. because their data failed to verify or because they belonged to a broken worker.
+   */
+  std::vector<off_t> strandedBlocks() const;
 
   /*!
    * Continues a running job, only called by the dispatcher
@@ -199,6 +234,7 @@ public:
   std::unique_ptr<MultiByteHandler>    _multiByteHandler;
 
   off_t  _stripe   = 0; //< The current stripe we are downloading
+  off_t  _stripeEnd = 0; //< End of the stripe blocks this worker owns (exclusive), lowered if others split off work. Owned are the blocks in _rangeToStripeBlock below it.
   size_t _datasize = 0; //< The nr of bytes we need to download overall
 
   double _starttime    = 0; //< When was the current job started
@@ -754,8 +790,56 @@ void multifetchworker::stealjob()
       _request->_stealing = true;
     }
 
-  multifetchworker *best = 0; // best choice for the worker we want to compete with
   double now = 0;
+  const auto &updateAvgSpeed = [&now]( multifetchworker *worker ) {
+    if (!worker->_avgspeed && worker->_datareceived)
+      {
+        // calculate avg speed for the worker if that was not done yet
+        if (!now)
+          now = currentTime();
+        if (now > worker->_starttime)
+          worker->_avgspeed = worker->_datareceived / (now - worker->_starttime);
+      }
+  };
+
+  // first try to split off work nobody started yet, choosing the worker
+  // that would need the most time to finish what it owns
+  multifetchworker *victim = nullptr;
+  off_t victimSplit = 0;
+  double victimTime = -1;
+  for (auto workeriter = _request->_workers.begin(); workeriter != _request->_workers.end(); ++workeriter)
+    {
+      multifetchworker *worker = workeriter->get();
+      if (worker == this || worker->_pass == -1)
+        continue;
+      if (worker->_state == WORKER_DISCARD || worker->_state == WORKER_DONE || worker->_state == WORKER_SLEEP || !worker->_datasize)
+        continue;
+      const auto split = worker->splitPoint();
+      if (!split)
+        continue;
+      updateAvgSpeed( worker );
+      // a worker without speed information did not receive anything yet, it is stalled as far as we know
+      double remainingTime = worker->_avgspeed ? worker->remainingBytes() / worker->_avgspeed : std::numeric_limits<double>::max();
+      if (!victim || remainingTime > victimTime)
+        {
+          victim = worker;
+          victimSplit = *split;
+          victimTime = remainingTime;
+        }
+    }
+  if (victim)
+    {
+      XXX << "#" << _workerno << ": splitting stripe " << victim->_stripe << " of #" << victim->_workerno << " at block " << victimSplit << endl;
+      _competing = true;
+      victim->_competing = true;
+      _stripe = victim->_stripe;
+      const off_t endBlock = victim->_stripeEnd;
+      victim->_stripeEnd = victimSplit;
+      runjob( victimSplit, endBlock );
+      return;
+    }
+
+  multifetchworker *best = 0; // best choice for the worker we want to compete with
 
   // look through all currently running workers to find the best candidate we
   // could steal from
@@ -768,16 +852,9 @@ void multifetchworker::stealjob()
         continue;	// do not steal!
       if (worker->_state == WORKER_DISCARD || worker->_state == WORKER_DONE || worker->_state == WORKER_SLEEP || !worker->_datasize)
         continue;	// do not steal finished jobs
-      if (!worker->_avgspeed && worker->_datareceived)
-        {
-          // calculate avg speed for the worker if that was not done yet
-          if (!now)
-            now = currentTime();
-          if (now > worker->_starttime)
-            worker->_avgspeed = worker->_datareceived / (now - worker->_starttime);
-        }
+      updateAvgSpeed( worker );
       // only consider worker who still have work
-      if ( worker->_datasize - worker->_datareceived <= 0 )
+      if ( worker->remainingBytes() == 0 )
         continue;
       if (!best || best->_pass > worker->_pass)
         {
@@ -791,12 +868,12 @@ void multifetchworker::stealjob()
       // Otherwise the worst.
       if (worker->_stripe == best->_stripe)
         {
-        if ((worker->_datasize - worker->_datareceived) * best->_avgspeed < (best->_datasize - best->_datareceived) * worker->_avgspeed)
+        if (worker->remainingBytes() * best->_avgspeed < best->remainingBytes() * worker->_avgspeed)
             best = worker;
         }
       else
         {
-        if ((worker->_datasize - worker->_datareceived) * best->_avgspeed > (best->_datasize - best->_datareceived) * worker->_avgspeed)
+        if (worker->remainingBytes() * best->_avgspeed > best->remainingBytes() * worker->_avgspeed)
             best = worker;
         }
     }
@@ -810,17 +887,11 @@ void multifetchworker::stealjob()
   // do not sleep twice
   if (_state != WORKER_SLEEP)
     {
-    if (!_avgspeed && _datareceived)
-        {
-          if (!now)
-            now = currentTime();
-          if (now > _starttime)
-            _avgspeed = _datareceived / (now - _starttime);
-        }
+      updateAvgSpeed( this );
 
       // lets see if we should sleep a bit
       XXX << "me #" << _workerno << ": " << _avgspeed << ", size " << best->_datasize << endl;
-      XXX << "best #" << best->_workerno << ": " << best->_avgspeed << ", size " << (best->_datasize - best->_datareceived) << endl;
+      XXX << "best #" << best->_workerno << ": " << best->_avgspeed << ", size " << best->remainingBytes() << endl;
 
       // check if we could download the full data from best faster than best could download its remaining data
       if ( _avgspeed && best->_avgspeed                     // we and best have average speed information
@@ -828,7 +899,7 @@ void multifetchworker::stealjob()
         {
           if (!now)
             now = currentTime();
-          double sl = (best->_datasize - best->_datareceived) / best->_avgspeed * 2;
+          double sl = best->remainingBytes() / best->_avgspeed * 2;
           if (sl > 1)
             sl = 1;
           XXX << "#" << _workerno << ": going to sleep for " << sl * 1000 << " ms" << endl;
@@ -866,6 +937,65 @@ multifetchworker::disableCompetition()
     }
 }
 
+size_t multifetchworker::remainingBytes() const
+{
+  if ( _blocks.empty() )
+    return 0;
+  const auto &stripeDesc = _request->_requiredStripes[_stripe];
+  size_t remaining = 0;
+  for ( uint i = 0; i < _blocks.size(); i++ ) {
+    if ( stripeDesc.blockStates[ _rangeToStripeBlock[i] ] != Stripe::FINALIZED )
+      remaining += _blocks[i].len;
+  }
+  return remaining;
+}
+
+std::optional<off_t> multifetchworker::splitPoint() const
+{
+  if ( _blocks.empty() )
+    return {};
+
+  // blocks we own that nobody started to fetch yet
+  const auto &stripeDesc = _request->_requiredStripes[_stripe];
+  std::vector<off_t> untouched;
+  for ( off_t i : _rangeToStripeBlock ) {
+    if ( i >= _stripeEnd )
+      break;
+    if ( stripeDesc.blockStates[i] == Stripe::PENDING || stripeDesc.blockStates[i] == Stripe::REFETCH )
+      untouched.push_back( i );
+  }
+
+  // a worker that is not fetching (e.g. broken) will never get to its blocks, take all of them
+  if ( _state != WORKER_FETCH )
+    return untouched.empty() ? std::optional<off_t>() : untouched.front();
+
+  // leave at least one block to the owner, the one it is about to start
+  if ( untouched.size() < 2 )
+    return {};
+  return untouched[ untouched.size() / 2 ];
+}
+
+std::vector<off_t> multifetchworker::strandedBlocks() const
+{
+  const auto &stripeDesc = _request->_requiredStripes[_stripe];
+  std::vector<bool> covered( stripeDesc.blocks.size(), false );
+  for ( const auto &worker : _request->_workers ) {
+    if ( worker.get() == this || worker->_stripe != _stripe || worker->_state != WORKER_FETCH )
+      continue;
+    for ( off_t blk : worker->_rangeToStripeBlock ) {
+      if ( blk < worker->_stripeEnd )
+        covered[blk] = true;
+    }
+  }
+
+  std::vector<off_t> stranded;
+  for ( off_t i = 0; i < static_cast<off_t>( stripeDesc.blocks.size() ); i++ ) {
+    if ( stripeDesc.blockStates[i] != Stripe::FINALIZED && !covered[i] )
+      stranded.push_back( i );
+  }
+  return stranded;
+}
+
 void multifetchworker::nextjob()
 {
   _datasize  = 0;
@@ -881,14 +1011,24 @@ void multifetchworker::nextjob()
    runjob();
 }
 
-void multifetchworker::runjob()
+void multifetchworker::runjob( off_t firstBlock, std::optional<off_t> endBlock )
+{
+  const off_t end = endBlock ? *endBlock : static_cast<off_t>( _request->_requiredStripes[_stripe].blocks.size() );
+  std::vector<off_t> stripeBlocks;
+  for ( off_t i = firstBlock; i < end; i++ )
+    stripeBlocks.push_back( i );
+  runjob( stripeBlocks );
+}
+
+void multifetchworker::runjob( const std::vector<off_t> &stripeBlocks )
 {
   _datasize = 0;
   _blocks.clear ();
   _rangeToStripeBlock.clear ();
 
   auto &stripeDesc = _request->_requiredStripes[_stripe];
-  for ( uint i = 0; i < stripeDesc.blocks.size(); i++ ) {
+  _stripeEnd = stripeBlocks.empty() ? 0 : stripeBlocks.back() + 1;
+  for ( off_t i : stripeBlocks ) {
     // ignore verified and finalized ranges
     if( stripeDesc.blockStates[i] == Stripe::FINALIZED ) {
       continue;
@@ -1240,6 +1380,7 @@ multifetchrequest::run(std::vector<Url> &urllist)
               continue;
             } else {
               WAR << "#" << worker->_workerno << ": failed, but was set to discard, reusing for new requests" << endl;
+              worker->nextjob();
             }
           } else {
 
@@ -1254,14 +1395,28 @@ multifetchrequest::run(std::vector<Url> &urllist)
             // now lets see if the stripe was finished too
             // stripe blocks can now be only in FINALIZED or ERROR states
             if (worker->_state == WORKER_FETCH ) {
-              if ( worker->_competing ) {
-                worker->disableCompetition ();
-              }
               auto &wrkerStripe = _requiredStripes[worker->_stripe];
-              bool done = std::all_of( wrkerStripe.blockStates.begin(), wrkerStripe.blockStates.begin(), []( const Stripe::RState s ) { return s == Stripe::FINALIZED; } );
-              if ( !done ) {
+              bool done = std::all_of( wrkerStripe.blockStates.begin(), wrkerStripe.blockStates.end(), []( const Stripe::RState s ) { return s == Stripe::FINALIZED; } );
+              if ( worker->_competing ) {
+                // the stripe may have been split, others may still be working on their part of it
+                if ( done ) {
+                  worker->disableCompetition ();
+                } else {
+                  // but blocks nobody is working on anymore need to be refetched by us
+                  const auto &stranded = worker->strandedBlocks();
+                  if ( !stranded.empty() ) {
+                    XXX << "#" << worker->_workerno << ": requeueing " << stranded.size() << " stranded blocks of stripe " << worker->_stripe << endl;
+                    for ( off_t blk : stranded )
+                      wrkerStripe.blockStates[blk] = Stripe::PENDING;
+
+                    _finished = false; //reset finished flag
+                    worker->runjob( stranded );
+                    continue;
+                  }
+                }
+              } else if ( !done ) {
                 // all ranges that are not finalized are in a bogus state, refetch them
-                std::for_each( wrkerStripe.blockStates.begin(), wrkerStripe.blockStates.begin(), []( Stripe::RState &s ) {
+                std::for_each( wrkerStripe.blockStates.begin(), wrkerStripe.blockStates.end(), []( Stripe::RState &s ) {
                   if ( s != Stripe::FINALIZED)
                     s = Stripe::PENDING;
                 });
@@ -1581,6 +1736,8 @@ void MediaMultiCurl::doGetFileCopy( const OnMediaLocation &srcFile , const Pathn
 
   if ( ismetalink != MetaDataType::None )
     {
+      // the blocks are written out of order (a fallback download starts over)
+      callback::SendReport<DownloadDataReport>()->unavailable( getFileUrl(srcFile.filename()) );
       bool userabort = false;
       Pathname failedFile = ZConfig::instance().repoCachePath() / "MultiCurl.failed";
       file = nullptr;	// explicitly close destNew before the parser reads it.
@@ -65,6 +65,9 @@ protected:
   void toEasyPool(const std::string &host, CURL *easy) const;
 
   void setupEasy() override;
+  /** Precache downloads ask for metalink too, files offering it take the \ref doGetFileCopy path. */
+  const curl_slist * precacheHeaders() const override
+  { return _customHeadersMetalink; }
   void checkFileDigest(Url &url, FILE *fp, MediaBlockList &blklist) const;
   static int progressCallback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow );
 
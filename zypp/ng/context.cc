@@ -8,6 +8,7 @@
 \---------------------------------------------------------------------*/
 #include "private/context_p.h"
 #include <zypp/ZYppFactory.h>
+#include <zypp/ZConfig.h>
 #include <zypp-core/zyppng/base/private/threaddata_p.h>
 #include <zypp-core/zyppng/base/EventLoop>
 #include <zypp-media/ng/Provide>
@@ -24,6 +25,7 @@ namespace zyppng {
     d->_eventDispatcher = ThreadData::current().ensureDispatcher();
 
     d->_provider = Provide::create( d->_providerDir );
+    d->_provider->setMirrorStatisticsPath( zypp::ZConfig::instance().mirrorStatsCachePath() );
 
     // @TODO should start be implicit as soon as something is enqueued?
     d->_provider->start();
@@ -11,16 +11,19 @@
 #include "zypp/parser/xml/Reader.h"
 
 #include <zypp-core/ManagedFile.h>
-#include <zypp-core/zyppng/io/Process>
+#include <zypp-core/zyppng/base/SocketNotifier>
 #include <zypp-core/zyppng/pipelines/MTry>
 #include <zypp-core/zyppng/pipelines/Algorithm>
+#include <zypp-core/zyppng/thread/ThreadPool>
+#include <zypp-core/zyppng/thread/Wakeup>
 #include <zypp-media/MediaException>
 #include <zypp-media/ng/Provide>
 #include <zypp-media/ng/ProvideSpec>
 
-#include <zypp/ExternalProgram.h>
 #include <zypp/HistoryLog.h>
 #include <zypp/base/Algorithm.h>
+#include <zypp/repo/SolvfileBuilder.h>
+#include <zypp/sat/TrigramIndex.h>
 #include <zypp/ng/Context>
 #include <zypp/ng/workflows/logichelpers.h>
 #include <zypp/ng/workflows/contextfacade.h>
@@ -29,6 +32,8 @@
 
 #include <utility>
 #include <fstream>
+#include <mutex>
+#include <condition_variable>
 
 #undef  ZYPP_BASE_LOGGER_LOGGROUP
 #define ZYPP_BASE_LOGGER_LOGGROUP "zypp::repomanager"
@@ -554,78 +559,98 @@ namespace zyppng::RepoManagerWorkflow {
 
   namespace {
 
-    template <typename ZyppCtxRef> struct Repo2SolvOp;
+    template <typename ZyppCtxRef> struct BuildSolvFileOp;
 
+    /*!
+     * Builds the solv file in the CPU worker pool, so the event loop keeps running
+     * while libsolv parses the metadata. Concurrent refreshes of many repos
+     * can thus download while other caches are built, but never run more builders
+     * than there are cores. The worker wakes up the event loop when done.
+     */
     template <>
-    struct Repo2SolvOp<ContextRef> : public AsyncOp<expected<void>>
+    struct BuildSolvFileOp<ContextRef> : public AsyncOp<expected<void>>
     {
-      Repo2SolvOp() { }
-
-      static AsyncOpRef<expected<void>> run( zypp::RepoInfo repo, zypp::ExternalProgram::Arguments args ) {
-        MIL << "Starting repo2solv for repo " << repo.alias () << std::endl;
-        auto me = std::make_shared<Repo2SolvOp<ContextRef>>();
-        me->_repo = std::move(repo);
-        me->_proc = Process::create();
-        me->_proc->connect( &Process::sigFinished, *me, &Repo2SolvOp<ContextRef>::procFinished );
-        me->_proc->connect( &Process::sigReadyRead, *me, &Repo2SolvOp<ContextRef>::readyRead );
-
-        std::vector<const char *> argsIn;
-        argsIn.reserve ( args.size() );
-        std::for_each( args.begin (), args.end(), [&]( const std::string &s ) { argsIn.push_back(s.data()); });
-        argsIn.push_back (nullptr);
-        me->_proc->setOutputChannelMode ( Process::Merged );
-        if (!me->_proc->start( argsIn.data() )) {
-          return makeReadyResult( expected<void>::error(ZYPP_EXCPT_PTR(zypp::repo::RepoException ( me->_repo, _("Failed to cache repo ( unable to start repo2solv ).") ))) );
-        }
-        return me;
-      }
+      /// Shared with the job, which may still be queued when the op is destroyed.
+      struct Job
+      {
+        zyppng::Wakeup _wakeup;
+        std::mutex _lock;
+        std::condition_variable _cond;
+        bool _cancelled = false;
+        bool _running = false;
+        std::exception_ptr _error;  //< written by the worker before it notifies
+      };
 
-      void readyRead (){
-        const ByteArray &data = _proc->readLine();
-        const std::string &line = data.asString();
-        WAR << "  " << line;
-        _errdetail += line;
+      BuildSolvFileOp() : _job( std::make_shared<Job>() ) { }
+
+      ~BuildSolvFileOp() override {
+        // a queued build is dropped, a running one can not be cancelled, wait for it
+        std::unique_lock lk( _job->_lock );
+        _job->_cancelled = true;
+        _job->_cond.wait( lk, [this]{ return !_job->_running; } );
       }
 
-      void procFinished( int ret ) {
+      static AsyncOpRef<expected<void>> run( zypp::RepoInfo repo, zypp::repo::RepoType repokind, zypp::Pathname metadatapath, zypp::Pathname solvfile, bool searchIndex ) {
+        MIL << "Queueing solv file build for repo " << repo.alias () << std::endl;
+        auto me = std::make_shared<BuildSolvFileOp<ContextRef>>();
+        me->_notifier = me->_job->_wakeup.makeNotifier();
+        me->_notifier->connect( &SocketNotifier::sigActivated, *me, &BuildSolvFileOp<ContextRef>::builderFinished );
+
+        ThreadPool::cpuPool().submit( [ job = me->_job, repo = std::move(repo), repokind, metadatapath = std::move(metadatapath), solvfile = std::move(solvfile), searchIndex ]() {
+          {
+            std::lock_guard lk( job->_lock );
+            if ( job->_cancelled )
+              return;
+            job->_running = true;
+          }
+          try {
+            zypp::repo::buildSolvFile( repo, repokind, metadatapath, solvfile, searchIndex );
+          } catch ( ... ) {
+            job->_error = std::current_exception();
+          }
+          {
+            std::lock_guard lk( job->_lock );
+            job->_running = false;
+          }
+          job->_cond.notify_all();
+          job->_wakeup.notify();
+        });
+        return me;
+      }
 
-        while ( _proc->canReadLine() )
-          readyRead();
+      void builderFinished( const SocketNotifier &, int ) {
+        _job->_wakeup.ack();
+        _notifier->setEnabled( false );
 
-        if ( ret != 0 ) {
-          zypp::repo::RepoException ex( _repo, zypp::str::form( _("Failed to cache repo (%d)."), ret ));
-          ex.addHistory( zypp::str::Str() << _proc->executedCommand() << std::endl << _errdetail << _proc->execError() ); // errdetail lines are NL-terminaled!
-          setReady( expected<void>::error(ZYPP_EXCPT_PTR(ex)) );
+        if ( _job->_error ) {
+          setReady( expected<void>::error( _job->_error ) );
           return;
         }
         setReady( expected<void>::success() );
       }
 
     private:
-      ProcessRef  _proc;
-      zypp::RepoInfo _repo;
-      std::string _errdetail;
+      std::shared_ptr<Job> _job;
+      SocketNotifier::Ptr _notifier;
     };
 
+    /*!
+     * Builds the solv file inline, or queues it in the CPU worker pool if
+     * \ref RepoManagerWorkflow::DeferredSolvFileBuilds are active.
+     */
     template <>
-    struct Repo2SolvOp<SyncContextRef>
+    struct BuildSolvFileOp<SyncContextRef>
     {
-      static expected<void> run( zypp::RepoInfo repo, zypp::ExternalProgram::Arguments args ) {
-        zypp::ExternalProgram prog( args, zypp::ExternalProgram::Stderr_To_Stdout );
-        std::string errdetail;
-
-        for ( std::string output( prog.receiveLine() ); output.length(); output = prog.receiveLine() ) {
-          WAR << "  " << output;
-          errdetail += output;
-        }
-
-        int ret = prog.close();
-        if ( ret != 0 )
-        {
-          zypp::repo::RepoException ex(repo, zypp::str::form( _("Failed to cache repo (%d)."), ret ));
-          ex.addHistory( zypp::str::Str() << prog.command() << std::endl << errdetail << prog.execError() ); // errdetail lines are NL-terminaled!
-          return expected<void>::error(ZYPP_EXCPT_PTR(ex));
-        }
+      static expected<void> run( zypp::RepoInfo repo, zypp::repo::RepoType repokind, zypp::Pathname metadatapath, zypp::Pathname solvfile, bool searchIndex ) {
+        RepoManagerWorkflow::DeferredSolvFileBuilds * deferred = RepoManagerWorkflow::DeferredSolvFileBuilds::current();
+        if ( ! deferred || repokind == zypp::repo::RepoType::RPMPLAINDIR )
+          return mtry( zypp::repo::buildSolvFile, repo, repokind, metadatapath, solvfile, searchIndex );
+
+        MIL << "Queueing solv file build for repo " << repo.alias () << std::endl;
+        std::string alias { repo.alias() };
+        deferred->submit( std::move(alias), [ repo = std::move(repo), repokind, metadatapath = std::move(metadatapath), solvfile = std::move(solvfile), searchIndex ]() {
+          zypp::repo::buildSolvFile( repo, repokind, metadatapath, solvfile, searchIndex );
+        });
         return expected<void>::success();
       }
     };
@@ -713,6 +738,9 @@ namespace zyppng::RepoManagerWorkflow {
                 return makeReadyResult(
                   solv_path_for_repoinfo( _refCtx->repoManagerOptions(), info)
                   | and_then([this]( zypp::Pathname base ){
+                    // On the fly add a missing search index too.
+                    if ( _refCtx->zyppContext()->config().repoSearchIndex() && ! zypp::sat::TrigramIndex::upToDate( base/"solv" ) )
+                      zypp::sat::TrigramIndex::write( base/"solv" );
                     if ( ! zypp::PathInfo(base/"solv.idx").isExist() )
                       return mtry( zypp::sat::updateSolvFileIndex, base/"solv" );
                     return expected<void>::success ();
@@ -786,38 +814,25 @@ namespace zyppng::RepoManagerWorkflow {
                 // Take care we unlink the solvfile on error
                 zypp::ManagedFile guard( solvfile, zypp::filesystem::unlink );
 
-                zypp::ExternalProgram::Arguments cmd;
-#ifdef ZYPP_REPO2SOLV_PATH
-                cmd.push_back( ZYPP_REPO2SOLV_PATH );
-#else
-                cmd.push_back( zypp::PathInfo( "/usr/bin/repo2solv" ).isFile() ? "repo2solv" : "repo2solv.sh" );
-#endif
-                // repo2solv expects -o as 1st arg!
-                cmd.push_back( "-o" );
-                cmd.push_back( solvfile.asString() );
-                cmd.push_back( "-X" );	// autogenerate pattern from pattern-package
-                // bsc#1104415: no more application support // cmd.push_back( "-A" );	// autogenerate application pseudo packages
-
+                zypp::Pathname metadatapath;
                 if ( repokind == zypp::repo::RepoType::RPMPLAINDIR )
                 {
-                  // recusive for plaindir as 2nd arg!
-                  cmd.push_back( "-R" );
-
                   std::optional<zypp::Pathname> localPath = forPlainDirs.has_value() ? forPlainDirs->localPath() : zypp::Pathname();
                   if ( !localPath )
                     return makeReadyResult( expected<void>::error( ZYPP_EXCPT_PTR( zypp::repo::RepoException( zypp::str::Format(_("Failed to cache repo %1%")) % _refCtx->repoInfo() ))) );
 
                   // FIXME this does only work for dir: URLs
-                  cmd.push_back( (*localPath / info.path().absolutename()).c_str() );
+                  metadatapath = *localPath / info.path().absolutename();
                 }
                 else
-                  cmd.push_back( _productdatapath.asString() );
+                  metadatapath = _productdatapath;
 
-                return Repo2SolvOp<ZyppContextRefType>::run( info, std::move(cmd) )
-                | and_then( [this, guard = std::move(guard), solvfile = std::move(solvfile) ]() mutable {
+                // the builder writes the solv.idx too
+                return BuildSolvFileOp<ZyppContextRefType>::run( info, repokind, std::move(metadatapath), solvfile, _refCtx->zyppContext()->config().repoSearchIndex() )
+                | and_then( [ guard = std::move(guard), forPlainDirs = std::move(forPlainDirs) ]() mutable {
                   // We keep it.
                   guard.resetDispose();
-                  return mtry( zypp::sat::updateSolvFileIndex, solvfile ); // content digest for zypper bash completion
+                  return expected<void>::success();
                 });
               }
               break;
@@ -827,7 +842,12 @@ namespace zyppng::RepoManagerWorkflow {
             }
           })
           | and_then([this, raw_metadata_status](){
-            // update timestamp and checksum
+            // update timestamp and checksum, for a deferred build once it succeeded
+            RepoManagerWorkflow::DeferredSolvFileBuilds * deferred = RepoManagerWorkflow::DeferredSolvFileBuilds::current();
+            if ( deferred && deferred->whenBuilt( _refCtx->repoInfo().alias(), [ mgr = _refCtx->repoManager(), info = _refCtx->repoInfo(), raw_metadata_status ]() {
+                  mgr->setCacheStatus( info, raw_metadata_status ).unwrap();
+                } ) )
+              return expected<void>::success();
             return _refCtx->repoManager()->setCacheStatus( _refCtx->repoInfo(), raw_metadata_status );
           });
         })
@@ -864,6 +884,101 @@ namespace zyppng::RepoManagerWorkflow {
     };
   }
 
+  namespace
+  {
+    thread_local DeferredSolvFileBuilds * _currentDeferredBuilds = nullptr;
+  }
+
+  struct DeferredSolvFileBuilds::State
+  {
+    std::mutex _lock;
+    std::condition_variable _cond;
+    size_t _pending = 0;
+    bool _cancelled = false;
+    std::map<std::string, std::exception_ptr> _errors;
+  };
+
+  DeferredSolvFileBuilds::DeferredSolvFileBuilds()
+    : _prev( _currentDeferredBuilds )
+    , _state( std::make_shared<State>() )
+  { _currentDeferredBuilds = this; }
+
+  DeferredSolvFileBuilds::~DeferredSolvFileBuilds()
+  {
+    {
+      std::lock_guard lk( _state->_lock );
+      _state->_cancelled = true;
+    }
+    _currentDeferredBuilds = _prev;
+  }
+
+  DeferredSolvFileBuilds * DeferredSolvFileBuilds::current()
+  { return _currentDeferredBuilds; }
+
+  void DeferredSolvFileBuilds::submit( std::string alias_r, std::function<void()> build_r )
+  {
+    _queued[alias_r] = nullptr;
+    {
+      std::lock_guard lk( _state->_lock );
+      ++_state->_pending;
+    }
+    ThreadPool::cpuPool().submit( [ state = _state, alias = std::move(alias_r), build = std::move(build_r) ]() {
+      bool cancelled = false;
+      {
+        std::lock_guard lk( state->_lock );
+        cancelled = state->_cancelled;
+      }
+      std::exception_ptr error;
+      if ( ! cancelled ) {
+        try {
+          build();
+        } catch ( ... ) {
+          error = std::current_exception();
+        }
+      }
+      {
+        std::lock_guard lk( state->_lock );
+        if ( error )
+          state->_errors[alias] = error;
+        --state->_pending;
+      }
+      state->_cond.notify_all();
+    });
+  }
+
+  bool DeferredSolvFileBuilds::whenBuilt( const std::string & alias_r, std::function<void()> action_r )
+  {
+    auto it = _queued.find( alias_r );
+    if ( it == _queued.end() )
+      return false;
+    it->second = std::move(action_r);
+    return true;
+  }
+
+  std::map<std::string, std::exception_ptr> DeferredSolvFileBuilds::join()
+  {
+    std::map<std::string, std::exception_ptr> ret;
+    {
+      std::unique_lock lk( _state->_lock );
+      _state->_cond.wait( lk, [this]{ return _state->_pending == 0; } );
+      ret.swap( _state->_errors );
+    }
+
+    std::map<std::string, std::function<void()>> queued;
+    queued.swap( _queued );
+    for ( auto & [alias, action] : queued )
+    {
+      if ( ret.count( alias ) || ! action )
+        continue;
+      try {
+        action();
+      } catch ( ... ) {
+        ret[alias] = std::current_exception();
+      }
+    }
+    return ret;
+  }
+
   AsyncOpRef<expected<repo::AsyncRefreshContextRef> > buildCache(repo::AsyncRefreshContextRef refCtx, zypp::RepoManagerFlags::CacheBuildPolicy policy, ProgressObserverRef progressObserver)
   {
     return SimpleExecutor<BuildCacheLogic, AsyncOp<expected<repo::AsyncRefreshContextRef>>>::run( std::move(refCtx), policy, std::move(progressObserver));
@@ -20,6 +20,11 @@
 //@ TODO move required types into their own files... e.g. CheckStatus
 #include <zypp/ng/repo/Refresh>
 
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+
 
 namespace zyppng {
 
@@ -56,6 +61,55 @@ namespace zyppng {
     AsyncOpRef<expected<repo::AsyncRefreshContextRef> > buildCache( repo::AsyncRefreshContextRef refCtx, zypp::RepoManagerFlags::CacheBuildPolicy policy, ProgressObserverRef progressObserver = nullptr );
     expected<repo::SyncRefreshContextRef> buildCache( repo::SyncRefreshContextRef refCtx, zypp::RepoManagerFlags::CacheBuildPolicy policy, ProgressObserverRef progressObserver = nullptr );
 
+    /*!
+     * While alive, the sync \ref buildCache workflows run in this thread queue their
+     * solv file build in \ref ThreadPool::cpuPool instead of building it inline, so
+     * the caches of many repos are built concurrently. \ref join waits for them.
+     *
+     * A workflow returns before its build is done. The repos cache cookie is written
+     * by \ref join, once the build succeeded. A failed build leaves no solv file, the
+     * caller must clean the repos cache. Plaindir repos are still built inline, as
+     * they need the attached media. Builds not started when the instance is destroyed
+     * are dropped, running ones are not waited for.
+     */
+    class DeferredSolvFileBuilds
+    {
+    public:
+      DeferredSolvFileBuilds();
+      ~DeferredSolvFileBuilds();
+
+      DeferredSolvFileBuilds( const DeferredSolvFileBuilds & ) = delete;
+      DeferredSolvFileBuilds & operator=( const DeferredSolvFileBuilds & ) = delete;
+
+      /*!
+       * Wait for the queued builds, run the \ref whenBuilt actions of the successful
+       * ones and return the failed ones by repo alias.
+       */
+      std::map<std::string, std::exception_ptr> join();
+
+      /*!
+       * The instance active in this thread or \c nullptr.
+       */
+      static DeferredSolvFileBuilds * current();
+
+      /*!
+       * Queue \a build_r of repo \a alias_r.
+       */
+      void submit( std::string alias_r, std::function<void()> build_r );
+
+      /*!
+       * Let \ref join run \a action_r if the build queued for repo \a alias_r succeeds.
+       * Returns \c false if no build is queued for \a alias_r.
+       */
+      bool whenBuilt( const std::string & alias_r, std::function<void()> action_r );
+
+    private:
+      struct State;
+      DeferredSolvFileBuilds * _prev = nullptr;
+      std::shared_ptr<State> _state;	//< shared with the queued builds
+      std::map<std::string, std::function<void()>> _queued;	//< the queued builds and their whenBuilt action
+    };
+
     AsyncOpRef<expected<RepoInfo>> addRepository( AsyncRepoManagerRef mgr, RepoInfo info, ProgressObserverRef myProgress = nullptr );
     expected<RepoInfo> addRepository( SyncRepoManagerRef mgr, const RepoInfo &info, ProgressObserverRef myProgress = nullptr );
 
@@ -26,9 +26,11 @@
 #include <zypp/parser/RepoFileReader.h>
 #include <zypp/parser/ServiceFileReader.h>
 #include <zypp/sat/Pool.h>
+#include <zypp/sat/PoolSnapshot.h>
 #include <zypp/zypp_detail/urlcredentialextractor_p.h>
 #include <zypp/repo/ServiceType.h>
 #include <zypp/repo/PluginServices.h>
+#include <zypp/repo/yum/LazyFilelists.h>
 
 #include <zypp/ng/reporthelper.h>
 #include <zypp/ng/repo/refresh.h>
@@ -37,6 +39,8 @@
 #include <zypp/ng/workflows/contextfacade.h>
 
 #include <fstream>
+#include <map>
+#include <optional>
 #include <utility>
 
 #undef ZYPP_BASE_LOGGER_LOGGROUP
@@ -534,6 +538,20 @@ namespace zyppng
 
       ProgressObserver::increase ( myProgress );
 
+      // Take the repo from the pool snapshot, if it holds an up to date copy.
+      const zypp::Pathname snapshot( _options.repoSolvCachePath / zypp::sat::PoolSnapshot::defaultFile );
+      const zypp::sat::PoolSnapshot::Entry entry( solvfile, info );
+      if ( ! isTmpRepo( info ) )
+      {
+        zypp::Repository repo = zypp::sat::PoolSnapshot::loadRepo( snapshot, entry );
+        if ( repo )
+        {
+          ProgressObserver::increase ( myProgress );
+          zypp::repo::yum::registerLazyFilelists( repo, info, rawproductdata_path_for_repoinfo( _options, info ).unwrap() );
+          return;
+        }
+      }
+
       zypp::Repository repo = _zyppContext->satPool().addRepoSolv( solvfile, info );
 
       ProgressObserver::increase ( myProgress );
@@ -545,6 +563,9 @@ namespace zyppng
         repo.eraseFromPool();
         ZYPP_THROW(zypp::Exception(zypp::str::Str() << "Solv-file was created by '"<<toolversion<<"'-parser (want "<<LIBSOLV_TOOLVERSION<<")."));
       }
+      if ( ! isTmpRepo( info ) )
+        zypp::sat::PoolSnapshot::remember( snapshot, entry );
+      zypp::repo::yum::registerLazyFilelists( repo, info, rawproductdata_path_for_repoinfo( _options, info ).unwrap() );
     })
     | or_else( [this, info, myProgress]( std::exception_ptr exp ) {
       ZYPP_CAUGHT( exp );
@@ -554,7 +575,11 @@ namespace zyppng
           return buildCache ( info, zypp::RepoManagerFlags::BuildIfNeeded, ProgressObserver::makeSubTask( myProgress ) );
         })
         | and_then( mtry([this, info = info]{
-          _zyppContext->satPool().addRepoSolv( solv_path_for_repoinfo(_options, info).unwrap() / "solv", info );
+          const zypp::Pathname solvfile( solv_path_for_repoinfo(_options, info).unwrap() / "solv" );
+          zypp::Repository repo = _zyppContext->satPool().addRepoSolv( solvfile, info );
+          if ( ! isTmpRepo( info ) )
+            zypp::sat::PoolSnapshot::remember( _options.repoSolvCachePath / zypp::sat::PoolSnapshot::defaultFile, zypp::sat::PoolSnapshot::Entry( solvfile, info ) );
+          zypp::repo::yum::registerLazyFilelists( repo, info, rawproductdata_path_for_repoinfo( _options, info ).unwrap() );
         }));
     })
     | and_then([myProgress]{
@@ -886,6 +911,14 @@ namespace zyppng
 
     ProgressObserver::setup( myProgress, "Refreshing repositories" , 1 );
 
+    // In async mode all repos are refreshed at once: the downloads are scheduled by the
+    // Provide queue, the solv file builds by ThreadPool::cpuPool() (at most one per core).
+    // In sync mode the repos are downloaded one after the other, but their solv file
+    // builds are queued in ThreadPool::cpuPool() and joined at the end.
+    std::optional<RepoManagerWorkflow::DeferredSolvFileBuilds> deferredBuilds;
+    if constexpr ( !std::is_same_v<ZyppContextRefType, ContextRef> )
+      deferredBuilds.emplace();
+
     auto r = std::move(infos)
         | transform( [this, policy, myProgress]( const RepoInfo &info ) {
 
@@ -946,7 +979,20 @@ namespace zyppng
       }
     );
 
-    return joinPipeline( _zyppContext, r );
+    std::vector<std::pair<RepoInfo, expected<void>>> res = joinPipeline( _zyppContext, r );
+    if ( deferredBuilds )
+    {
+      std::map<std::string, std::exception_ptr> failed = deferredBuilds->join();
+      for ( auto & [info, result] : res )
+      {
+        auto it = failed.find( info.alias() );
+        if ( it == failed.end() || ! result )
+          continue;
+        cleanCache( info );
+        result = expected<void>::error( it->second );
+      }
+    }
+    return res;
   }
 
   /** Probe the metadata type of a repository located at \c url.
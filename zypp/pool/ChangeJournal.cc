@@ -0,0 +1,137 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/pool/ChangeJournal.cc
+ *
+*/
+#include <algorithm>
+
+#include <zypp/base/Logger.h>
+#include <zypp/ResPool.h>
+
+#include <zypp/pool/ChangeJournal.h>
+
+using std::endl;
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{ /////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+  namespace pool
+  { /////////////////////////////////////////////////////////////////
+
+    namespace
+    {
+      /** Beyond this the journal is reset, readers then scan the pool once. */
+      constexpr size_t maxLogSize = 1 << 20;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // ChangeJournal
+    ///////////////////////////////////////////////////////////////////
+
+    ChangeJournal::ChangeJournal()
+    {}
+
+    ChangeJournal & ChangeJournal::instance()
+    {
+      static ChangeJournal _instance;
+      return _instance;
+    }
+
+    void ChangeJournal::watch( const StatusIds * statusIds_r )
+    { _statusIds = statusIds_r; }
+
+    void ChangeJournal::record( const ResStatus * status_r )
+    {
+      if ( ! _statusIds )
+        return;
+      StatusIds::const_iterator it { _statusIds->find( status_r ) };
+      if ( it == _statusIds->end() )
+        return;	// not a PoolItem status
+      IdType id { it->second };
+      if ( ! _log.empty() && _log.back() == id )
+        return;	// a status change usually touches more than one field
+      if ( _log.size() >= maxLogSize )
+      {
+        DBG << "Journal overflow" << endl;
+        reset();
+      }
+      _log.push_back( id );
+    }
+
+    bool ChangeJournal::changedSince( Cursor & cursor_r, std::vector<IdType> & changed_r ) const
+    {
+      bool ret = ( cursor_r._epoch == _epoch && cursor_r._pos <= _log.size() );
+      if ( ret )
+      {
+        size_t oldsize = changed_r.size();
+        changed_r.insert( changed_r.end(), _log.begin() + cursor_r._pos, _log.end() );
+        std::sort( changed_r.begin() + oldsize, changed_r.end() );
+        changed_r.erase( std::unique( changed_r.begin() + oldsize, changed_r.end() ), changed_r.end() );
+      }
+      cursor_r._epoch = _epoch;
+      cursor_r._pos = _log.size();
+      return ret;
+    }
+
+    void ChangeJournal::reset()
+    {
+      _log.clear();
+      ++_epoch;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // ChangeJournal::Selection
+    ///////////////////////////////////////////////////////////////////
+
+    ChangeJournal::Selection::Selection( Predicate pred_r )
+    : _pred( std::move(pred_r) )
+    {}
+
+    const std::set<ChangeJournal::IdType> & ChangeJournal::Selection::ids()
+    {
+      ResPool pool( ResPool::instance() );
+      pool.size();	// update the store (may reset the journal) before reading it
+
+      std::vector<IdType> changed;
+      if ( ! ChangeJournal::instance().changedSince( _cursor, changed ) )
+      {
+        _ids.clear();
+        for ( const PoolItem & pi : pool )
+        {
+          if ( _pred( pi.status() ) )
+            _ids.insert( pi.id() );
+        }
+        return _ids;
+      }
+
+      const auto update = [this]( const PoolItem & pi_r ) {
+        if ( ! pi_r )
+          return;
+        if ( _pred( pi_r.status() ) )
+          _ids.insert( pi_r.id() );
+        else
+          _ids.erase( pi_r.id() );
+      };
+      for ( IdType id : changed )
+      {
+        PoolItem pi { pool.find( sat::Solvable(id) ) };
+        update( pi );
+        if ( pi && pi.buddy() )
+          update( pool.find( pi.buddy() ) );	// shares the status
+      }
+      return _ids;
+    }
+
+    /////////////////////////////////////////////////////////////////
+  } // namespace pool
+  ///////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
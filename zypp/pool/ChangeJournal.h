@@ -0,0 +1,131 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/pool/ChangeJournal.h
+ *
+*/
+#ifndef ZYPP_POOL_CHANGEJOURNAL_H
+#define ZYPP_POOL_CHANGEJOURNAL_H
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include <zypp-core/Globals.h>
+#include <zypp/ResStatus.h>
+#include <zypp/sat/detail/PoolMember.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{ /////////////////////////////////////////////////////////////////
+
+  ///////////////////////////////////////////////////////////////////
+  namespace pool
+  { /////////////////////////////////////////////////////////////////
+
+    ///////////////////////////////////////////////////////////////////
+    /// \class ChangeJournal
+    /// \brief Journal of the PoolItems whose transact or lock state changed.
+    ///
+    /// A \ref ResStatus reports whenever its \ref ResStatus::TransactField or
+    /// \ref ResStatus::TransactByField changes. If it is the status of a
+    /// \ref PoolItem, the items solvable id is looked up in the \ref StatusIds
+    /// side table maintained by \ref pool::PoolImpl and recorded. Other statuses
+    /// (e.g. copies) are ignored. Readers keep a \ref Cursor and ask for the
+    /// items changed since they last looked, instead of scanning the whole pool.
+    ///
+    /// The journal is reset whenever the \ref ResPool content changes and
+    /// if it grows too large. Readers must then inspect the whole pool once.
+    /// \ref Selection does this for the common case of maintaining the set of
+    /// items whose status meets some predicate.
+    ///
+    /// \note Like the \ref ResPool, the journal is not thread-safe. Statuses
+    /// must be changed and the journal be read from the main thread only.
+    ///////////////////////////////////////////////////////////////////
+    class ZYPP_API ChangeJournal
+    {
+    public:
+      using IdType = sat::detail::SolvableIdType;
+      /** The solvable id of each \ref PoolItem status. */
+      using StatusIds = std::unordered_map<const ResStatus *, IdType>;
+
+      /** A readers position in the journal.
+       * A default constructed Cursor can't be served, so the 1st
+       * \ref changedSince tells to inspect the whole pool.
+       */
+      class Cursor
+      {
+        friend class ChangeJournal;
+        size_t   _pos = 0;
+        unsigned _epoch = 0;
+      };
+
+      class Selection;
+
+    public:
+      /** The global journal. */
+      static ChangeJournal & instance();
+
+      /** The side table to look up the reporting statuses in (or \c nullptr).
+       * Set by \ref pool::PoolImpl, which maintains it along with its store.
+       */
+      void watch( const StatusIds * statusIds_r );
+
+      /** Remember the item owning \a status_r changed (if any). */
+      void record( const ResStatus * status_r );
+
+      /** Append the ids changed since \a cursor_r to \a changed_r (sorted, unique) and
+       * move the cursor to the end of the journal.
+       * \return \c false if the journal can't tell, because the cursor is new or the
+       * journal was reset in between. The caller must inspect the whole pool then.
+       */
+      bool changedSince( Cursor & cursor_r, std::vector<IdType> & changed_r ) const;
+
+      /** Forget all records. Cursors can't be served until they are moved again. */
+      void reset();
+
+    private:
+      ChangeJournal();
+
+      const StatusIds * _statusIds = nullptr;
+      std::vector<IdType> _log;
+      unsigned _epoch = 1;
+    };
+
+    ///////////////////////////////////////////////////////////////////
+    /// \class ChangeJournal::Selection
+    /// \brief The ids of the PoolItems whose \ref ResStatus meets a predicate.
+    ///
+    /// \ref ids updates the selection from the \ref ChangeJournal, and scans
+    /// the whole pool only if the journal can't tell. Buddies sharing a status
+    /// are updated together.
+    ///////////////////////////////////////////////////////////////////
+    class ZYPP_API ChangeJournal::Selection
+    {
+    public:
+      using Predicate = std::function<bool(const ResStatus &)>;
+
+      explicit Selection( Predicate pred_r );
+
+      /** The ids (in pool order) of the items whose status meets the predicate. */
+      const std::set<IdType> & ids();
+
+    private:
+      Predicate        _pred;
+      Cursor           _cursor;
+      std::set<IdType> _ids;
+    };
+
+    /////////////////////////////////////////////////////////////////
+  } // namespace pool
+  ///////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_POOL_CHANGEJOURNAL_H
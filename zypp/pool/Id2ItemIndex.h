@@ -0,0 +1,167 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/pool/Id2ItemIndex.h
+ *
+*/
+#ifndef ZYPP_POOL_ID2ITEMINDEX_H
+#define ZYPP_POOL_ID2ITEMINDEX_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <boost/iterator/iterator_adaptor.hpp>
+
+#include <zypp/PoolItem.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{ /////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+  namespace pool
+  { /////////////////////////////////////////////////////////////////
+
+    ///////////////////////////////////////////////////////////////////
+    /// \class Id2ItemIndex
+    /// \brief Flat ident index of the PoolItems (\ref ResPool::byIdent).
+    ///
+    /// The sorted ident ids (\ref ByIdent::get, negative for \c srcpackage)
+    /// are stored together with offsets into a single contiguous vector
+    /// of PoolItems grouped by ident (CSR layout). Each ident is stored once.
+    /// Lookup is a binary search over the idents, iterating an ident's items
+    /// is linear in memory.
+    ///
+    /// Like the former \c unordered_multimap the index provides forward
+    /// iterators, so \ref PoolTraits::byIdent_iterator keeps its category.
+    ///////////////////////////////////////////////////////////////////
+    class Id2ItemIndex
+    {
+    public:
+      using IdType = sat::detail::IdType;
+      /** Ident and PoolItem; input for \ref assign. */
+      using Entry = std::pair<IdType,PoolItem>;
+      using Entries = std::vector<Entry>;
+
+      using value_type = PoolItem;
+      using Items = std::vector<PoolItem>;
+      using size_type = Items::size_type;
+
+      /** Forward iterator over the PoolItems. */
+      class const_iterator : public boost::iterator_adaptor<const_iterator, Items::const_iterator, boost::use_default, boost::forward_traversal_tag>
+      {
+      public:
+        const_iterator()
+        {}
+        explicit const_iterator( Items::const_iterator it_r )
+        : const_iterator::iterator_adaptor_( it_r )
+        {}
+      private:
+        friend class boost::iterator_core_access;
+      };
+
+    public:
+      /** Whether the index is empty. */
+      bool empty() const
+      { return _items.empty(); }
+
+      /** Number of indexed PoolItems. */
+      size_type size() const
+      { return _items.size(); }
+
+      /** All PoolItems, grouped by ident. */
+      const_iterator begin() const
+      { return const_iterator( _items.begin() ); }
+
+      const_iterator end() const
+      { return const_iterator( _items.end() ); }
+
+      /** Clear the index. */
+      void clear()
+      { _idents.clear(); _offsets.clear(); _items.clear(); }
+
+    public:
+      /** Number of distinct idents. */
+      size_type identsSize() const
+      { return _idents.size(); }
+
+      /** The \a idx_r-th ident (<tt>idx_r < identsSize()</tt>). */
+      IdType ident( size_type idx_r ) const
+      { return _idents[idx_r]; }
+
+      /** Begin of the \a idx_r-th idents items. */
+      const_iterator identBegin( size_type idx_r ) const
+      { return const_iterator( _items.begin() + _offsets[idx_r] ); }
+
+      /** End of the \a idx_r-th idents items. */
+      const_iterator identEnd( size_type idx_r ) const
+      { return const_iterator( _items.begin() + _offsets[idx_r+1] ); }
+
+      /** The PoolItems of ident \a id_r. */
+      std::pair<const_iterator,const_iterator> equal_range( IdType id_r ) const
+      {
+        std::vector<IdType>::const_iterator it( std::lower_bound( _idents.begin(), _idents.end(), id_r ) );
+        if ( it == _idents.end() || *it != id_r )
+          return std::make_pair( end(), end() );
+        size_type idx = it - _idents.begin();
+        return std::make_pair( identBegin( idx ), identEnd( idx ) );
+      }
+
+    public:
+      /** Order of \ref Entries expected by \ref assign (ident, solvable id). */
+      static bool entryLess( const Entry & lhs, const Entry & rhs )
+      { return lhs.first < rhs.first || ( lhs.first == rhs.first && lhs.second.id() < rhs.second.id() ); }
+
+      /** Rebuild the index in one pass from \a entries_r sorted by \ref entryLess. */
+      void assign( const Entries & entries_r )
+      {
+        clear();
+        _items.reserve( entries_r.size() );
+        for ( const Entry & entry : entries_r )
+        {
+          if ( _idents.empty() || _idents.back() != entry.first )
+          {
+            _idents.push_back( entry.first );
+            _offsets.push_back( _items.size() );
+          }
+          _items.push_back( entry.second );
+        }
+        _offsets.push_back( _items.size() );
+        _idents.shrink_to_fit();
+        _offsets.shrink_to_fit();
+      }
+
+      /** Append the entries of all idents to \a entries_r, omitting the PoolItems
+       * matching \a skip_r. The \ref entryLess order is preserved.
+       */
+      template <class TSkip>
+      void dumpEntries( Entries & entries_r, TSkip && skip_r ) const
+      {
+        for ( size_type idx = 0; idx < identsSize(); ++idx )
+        {
+          for ( const_iterator it = identBegin( idx ); it != identEnd( idx ); ++it )
+          {
+            if ( ! skip_r( *it ) )
+              entries_r.push_back( Entry( _idents[idx], *it ) );
+          }
+        }
+      }
+
+    private:
+      std::vector<IdType>    _idents;	///< sorted idents
+      std::vector<size_type> _offsets;	///< _items offset per ident (plus end)
+      Items                  _items;	///< PoolItems grouped by ident
+    };
+
+    /////////////////////////////////////////////////////////////////
+  } // namespace pool
+  ///////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_POOL_ID2ITEMINDEX_H
@@ -10,9 +10,11 @@
  *
 */
 #include <iostream>
+#include <algorithm>
 #include <zypp/base/LogTools.h>
 
 #include <zypp/pool/PoolImpl.h>
+#include <solv/repo.h>
 
 using std::endl;
 
@@ -42,7 +44,7 @@ namespace zypp
     //	METHOD TYPE : Ctor
     //
     PoolImpl::PoolImpl()
-    {}
+    { ChangeJournal::instance().watch( &_statusIds ); }
 
     ///////////////////////////////////////////////////////////////////
     //
@@ -50,7 +52,212 @@ namespace zypp
     //	METHOD TYPE : Dtor
     //
     PoolImpl::~PoolImpl()
-    {}
+    { ChangeJournal::instance().watch( nullptr ); }
+
+    void PoolImpl::normalize( IdRanges & ranges_r )
+    {
+      if ( ranges_r.size() < 2 )
+        return;
+      std::sort( ranges_r.begin(), ranges_r.end() );
+      IdRanges::iterator last = ranges_r.begin();
+      for ( IdRanges::iterator it = last+1; it != ranges_r.end(); ++it )
+      {
+        if ( it->first <= last->second )
+          last->second = std::max( last->second, it->second );
+        else
+          *(++last) = *it;
+      }
+      ranges_r.erase( last+1, ranges_r.end() );
+    }
+
+    bool PoolImpl::contains( const IdRanges & ranges_r, SolvableIdType id_r )
+    {
+      IdRanges::const_iterator it = std::upper_bound( ranges_r.begin(), ranges_r.end(), id_r,
+                                                      []( SolvableIdType id, const IdRange & range ) { return id < range.first; } );
+      return( it != ranges_r.begin() && id_r < (--it)->second );
+    }
+
+    const PoolImpl::ContainerT & PoolImpl::store() const
+    {
+      checkSerial();
+      if ( _storeDirty )
+      {
+        sat::Pool pool( satpool() );
+        bool reusedIDs = _watcherIDs.remember( pool.serialIDs() );
+        std::vector<PoolItem> addedItems;
+        std::list<PoolItem> addedProducts;
+
+        // Remember the repos solvable id ranges and compare them to the
+        // last ones. Unless IDs were reused, only the ranges of added,
+        // removed or modified repos need to be processed.
+        RepoRanges repoRanges;
+        for_( it, pool.reposBegin(), pool.reposEnd() )
+        {
+          const sat::detail::CRepo * repo( it->get() );
+          repoRanges[it->id()] = RepoRange{ SolvableIdType(repo->start), SolvableIdType(repo->end), size_type(repo->nsolvables) };
+        }
+
+        bool fullScan = reusedIDs || _repoRanges.empty();
+        IdRanges changed;
+        if ( fullScan )
+        {
+          changed.push_back( IdRange( 1, pool.capacity() ) );
+        }
+        else
+        {
+          for ( const auto & [repo, range] : repoRanges )
+          {
+            RepoRanges::const_iterator old( _repoRanges.find( repo ) );
+            if ( old == _repoRanges.end() )
+              changed.push_back( IdRange( range._start, range._end ) );
+            else if ( old->second != range )
+            {
+              changed.push_back( IdRange( old->second._start, old->second._end ) );
+              changed.push_back( IdRange( range._start, range._end ) );
+            }
+          }
+          for ( const auto & [repo, range] : _repoRanges )
+          {
+            if ( repoRanges.find( repo ) == repoRanges.end() )
+              changed.push_back( IdRange( range._start, range._end ) );	// removed repo
+          }
+          normalize( changed );
+        }
+        _repoRanges.swap( repoRanges );
+
+        for ( SolvableIdType i = pool.capacity(); i < _store.size(); ++i )
+        {
+          if ( _store[i] )
+            _statusIds.erase( &_store[i].ownStatus() );
+        }
+        _store.resize( pool.capacity() );
+
+        for ( const IdRange & range : changed )
+        {
+          for ( SolvableIdType i = range.first; i < range.second && i < _store.size(); ++i )
+          {
+            sat::Solvable s( i );
+            PoolItem & pi( _store[i] );
+            if ( ! s &&  pi )
+            {
+              // the PoolItem got invalidated (e.g unloaded repo)
+              _statusIds.erase( &pi.ownStatus() );
+              pi = PoolItem();
+            }
+            else if ( reusedIDs || (s && ! pi) )
+            {
+              // new PoolItem to add
+              if ( pi )
+                _statusIds.erase( &pi.ownStatus() );
+              pi = PoolItem::makePoolItem( s ); // the only way to create a new one!
+              _statusIds[&pi.ownStatus()] = i;
+              // remember products for buddy processing (requires clean store)
+              if ( s.isKind( ResKind::product ) )
+                addedProducts.push_back( pi );
+              addedItems.push_back( pi );
+            }
+          }
+        }
+        _storeDirty = false;
+        DBG << "Store update: " << (fullScan?"full":"partial") << " scan of " << changed.size() << " id ranges, " << addedItems.size() << " new items" << endl;
+
+        // Remember the changes for the ident index
+        if ( fullScan )
+        {
+          _id2item.clear();
+          _id2itemChanged.clear();
+        }
+        else if ( ! changed.empty() )
+        {
+          _id2itemChanged.insert( _id2itemChanged.end(), changed.begin(), changed.end() );
+          normalize( _id2itemChanged );
+        }
+
+        // Now, as the pool is adjusted, ....
+
+        // .... we check for product buddies.
+        if ( ! addedProducts.empty() )
+        {
+          for_( it, addedProducts.begin(), addedProducts.end() )
+          {
+            it->setBuddy( asKind<Product>(*it)->referencePackage() );
+          }
+        }
+
+        // .... we must reapply those query based hard locks.
+        reapplyHardLocks( addedItems );
+
+        // Compute the initial status of Patches etc.
+        if ( !_establishedStates )
+          _establishedStates.reset( new EstablishedStatesImpl );
+      }
+      return _store;
+    }
+
+    const PoolImpl::Id2ItemT & PoolImpl::id2item () const
+    {
+      checkSerial();
+      if ( _id2itemDirty )
+      {
+        store();
+        auto makeEntry = []( const PoolItem & pi ) {
+          const sat::Solvable &s = pi.satSolvable();
+          sat::detail::IdType id = s.ident().id();
+          if ( s.isKind( ResKind::srcpackage ) )
+            id = -id;
+          return Id2ItemT::Entry( id, pi );
+        };
+
+        Id2ItemT::Entries entries;
+        entries.reserve( size() );
+        if ( _id2item.empty() )
+        {
+          for_( it, begin(), end() )
+            entries.push_back( makeEntry( *it ) );
+          std::sort( entries.begin(), entries.end(), &Id2ItemT::entryLess );
+          _id2item.assign( entries );
+        }
+        else if ( ! _id2itemChanged.empty() )
+        {
+          // keep the (sorted) entries outside the changed ranges and merge in the
+          // current items of the changed ranges.
+          _id2item.dumpEntries( entries, [this]( const PoolItem & pi ) { return contains( _id2itemChanged, pi.id() ); } );
+          Id2ItemT::Entries::size_type kept = entries.size();
+          for ( const IdRange & range : _id2itemChanged )
+          {
+            for ( SolvableIdType i = range.first; i < range.second && i < _store.size(); ++i )
+            {
+              if ( _store[i] )
+                entries.push_back( makeEntry( _store[i] ) );
+            }
+          }
+          std::sort( entries.begin()+kept, entries.end(), &Id2ItemT::entryLess );
+          std::inplace_merge( entries.begin(), entries.begin()+kept, entries.end(), &Id2ItemT::entryLess );
+          _id2item.assign( entries );
+        }
+        _id2itemChanged.clear();
+        _id2itemDirty = false;
+        _id2itemCompatDirty = true;
+      }
+      return _id2item;
+    }
+
+    const PoolTraits::Id2ItemCompatT & PoolImpl::id2itemCompat() const
+    {
+      const Id2ItemT & index( id2item() );
+      if ( _id2itemCompatDirty )
+      {
+        _id2itemCompat.clear();
+        _id2itemCompat.reserve( index.size() );
+        for ( Id2ItemT::size_type idx = 0; idx < index.identsSize(); ++idx )
+        {
+          for ( Id2ItemT::const_iterator it = index.identBegin( idx ); it != index.identEnd( idx ); ++it )
+            _id2itemCompat.insert( PoolTraits::Id2ItemCompatT::value_type( index.ident( idx ), *it ) );
+        }
+        _id2itemCompatDirty = false;
+      }
+      return _id2itemCompat;
+    }
 
     /////////////////////////////////////////////////////////////////
   } // namespace pool
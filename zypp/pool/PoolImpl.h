@@ -13,7 +13,9 @@
 #define ZYPP_POOL_POOLIMPL_H
 
 #include <iosfwd>
+#include <map>
 #include <utility>
+#include <vector>
 
 #include <zypp/base/Easy.h>
 #include <zypp/base/LogTools.h>
@@ -21,6 +23,7 @@
 #include <zypp-core/Globals.h>
 
 #include <zypp/pool/PoolTraits.h>
+#include <zypp/pool/ChangeJournal.h>
 #include <zypp/ResPoolProxy.h>
 #include <zypp/PoolQueryResult.h>
 
@@ -284,24 +287,28 @@ namespace zypp
         const HardLockQueries & hardLockQueries() const
         { return _hardLockQueries; }
 
-        void reapplyHardLocks() const
+        /** Reapply the hard locks to the \a addedItems_r only. */
+        template <class TContainer>
+        void reapplyHardLocks( const TContainer & addedItems_r ) const
         {
           // It is assumed that reapplyHardLocks is called after new
           // items were added to the pool, but the _hardLockQueries
           // did not change since. Action is to be performed only on
           // those items that gained the bit in the UserLockQueryField.
-          MIL << "Re-apply " << _hardLockQueries.size() << " HardLockQueries" << endl;
+          if ( _hardLockQueries.empty() || addedItems_r.empty() )
+            return;
+          MIL << "Re-apply " << _hardLockQueries.size() << " HardLockQueries to " << addedItems_r.size() << " new items" << endl;
           PoolQueryResult locked;
           for_( it, _hardLockQueries.begin(), _hardLockQueries.end() )
           {
             locked += *it;
           }
           MIL << "HardLockQueries match " << locked.size() << " Solvables." << endl;
-          for_( it, begin(), end() )
+          for ( const PoolItem & pi : addedItems_r )
           {
             // NOTE bsc#1225267: While reapplyLock sets but never unsets a lock,
             // we don't need to care about buddies like in setHardLockQueries.
-            resstatus::UserLockQueryManip::reapplyLock( it->status(), locked.contains( *it ) );
+            resstatus::UserLockQueryManip::reapplyLock( pi.status(), locked.contains( pi ) );
           }
         }
 
@@ -367,87 +374,22 @@ namespace zypp
        }
 
       public:
-        const ContainerT & store() const
-        {
-          checkSerial();
-          if ( _storeDirty )
-          {
-            sat::Pool pool( satpool() );
-            bool addedItems = false;
-            bool reusedIDs = _watcherIDs.remember( pool.serialIDs() );
-            std::list<PoolItem> addedProducts;
-
-            _store.resize( pool.capacity() );
-
-            if ( pool.capacity() )
-            {
-              for ( sat::detail::SolvableIdType i = pool.capacity()-1; i != 0; --i )
-              {
-                sat::Solvable s( i );
-                PoolItem & pi( _store[i] );
-                if ( ! s &&  pi )
-                {
-                  // the PoolItem got invalidated (e.g unloaded repo)
-                  pi = PoolItem();
-                }
-                else if ( reusedIDs || (s && ! pi) )
-                {
-                  // new PoolItem to add
-                  pi = PoolItem::makePoolItem( s ); // the only way to create a new one!
-                  // remember products for buddy processing (requires clean store)
-                  if ( s.isKind( ResKind::product ) )
-                    addedProducts.push_back( pi );
-                  if ( !addedItems )
-                    addedItems = true;
-                }
-              }
-            }
-            _storeDirty = false;
-
-            // Now, as the pool is adjusted, ....
-
-            // .... we check for product buddies.
-            if ( ! addedProducts.empty() )
-            {
-              for_( it, addedProducts.begin(), addedProducts.end() )
-              {
-                it->setBuddy( asKind<Product>(*it)->referencePackage() );
-              }
-            }
-
-            // .... we must reapply those query based hard locks.
-            if ( addedItems )
-            {
-              reapplyHardLocks();
-            }
+        /** The PoolItem store indexed by \ref sat::Solvable id.
+         * On changes of the \ref sat::Pool content, only the solvable
+         * id ranges of added, removed or modified repos are updated.
+         */
+        const ContainerT & store() const;
 
-            // Compute the initial status of Patches etc.
-            if ( !_establishedStates )
-              _establishedStates.reset( new EstablishedStatesImpl );
-          }
-          return _store;
-        }
+        /** The ident index (for \ref ResPool::byIdent).
+         * Updated incrementally for the solvable id ranges changed
+         * by the last \ref store updates.
+         */
+        const Id2ItemT & id2item () const;
 
-        const Id2ItemT & id2item () const
-        {
-          checkSerial();
-          if ( _id2itemDirty )
-          {
-            store();
-            _id2item = Id2ItemT( size() );
-            for_( it, begin(), end() )
-            {
-              const sat::Solvable &s = (*it)->satSolvable();
-              sat::detail::IdType id = s.ident().id();
-              if ( s.isKind( ResKind::srcpackage ) )
-                id = -id;
-              _id2item.insert( std::make_pair( id, *it ) );
-            }
-            //INT << _id2item << endl;
-            _id2itemDirty = false;
-          }
-          return _id2item;
-        }
+        /** The ident index as \c unordered_multimap (for \ref ResPool::id2item).
+         * Built on demand from \ref id2item.
+         */
+        const PoolTraits::Id2ItemCompatT & id2itemCompat() const;
 
         ///////////////////////////////////////////////////////////////////
         //
@@ -462,13 +404,39 @@ namespace zypp
 
         void invalidate() const
         {
+          ChangeJournal::instance().reset();	// items come and go
           _storeDirty = true;
-          _id2itemDirty = true;
-          _id2item.clear();
+          _id2itemDirty = true;	// updated according to _id2itemChanged
           _poolProxy.reset();
           _establishedStates.reset();
         }
 
+      private:
+        /** A half open range <tt>[first,second)</tt> of solvable ids. */
+        using IdRange = std::pair<SolvableIdType,SolvableIdType>;
+        /** Sorted, non overlapping \ref IdRange. */
+        using IdRanges = std::vector<IdRange>;
+
+        /** A repos solvable id range and size as seen by the last \ref store update. */
+        struct RepoRange
+        {
+          SolvableIdType _start = 0;
+          SolvableIdType _end = 0;
+          size_type      _size = 0;
+
+          bool operator==( const RepoRange & rhs ) const
+          { return _start == rhs._start && _end == rhs._end && _size == rhs._size; }
+          bool operator!=( const RepoRange & rhs ) const
+          { return ! ( *this == rhs ); }
+        };
+        using RepoRanges = std::map<sat::detail::RepoIdType, RepoRange>;
+
+        /** Sort and merge overlapping ranges. */
+        static void normalize( IdRanges & ranges_r );
+
+        /** Whether \a id_r is in one of the (normalized) \a ranges_r. */
+        static bool contains( const IdRanges & ranges_r, SolvableIdType id_r );
+
       private:
         /** Watch sat pools serial number. */
         SerialNumberWatcher                   _watcher;
@@ -478,6 +446,14 @@ namespace zypp
         mutable DefaultIntegral<bool,true>    _storeDirty;
         mutable Id2ItemT		      _id2item;
         mutable DefaultIntegral<bool,true>    _id2itemDirty;
+        mutable PoolTraits::Id2ItemCompatT    _id2itemCompat;
+        mutable DefaultIntegral<bool,true>    _id2itemCompatDirty;
+        /** Repo solvable id ranges the \ref _store was last built for. */
+        mutable RepoRanges                    _repoRanges;
+        /** Solvable id ranges changed in \ref _store but not yet in \ref _id2item. */
+        mutable IdRanges                      _id2itemChanged;
+        /** Side table of the \ref _store items statuses for the \ref ChangeJournal. */
+        mutable ChangeJournal::StatusIds      _statusIds;
 
       private:
         mutable shared_ptr<ResPoolProxy>      _poolProxy;
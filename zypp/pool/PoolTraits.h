@@ -22,6 +22,7 @@
 
 #include <zypp/PoolItem.h>
 #include <zypp/pool/ByIdent.h>
+#include <zypp/pool/Id2ItemIndex.h>
 #include <zypp/sat/Pool.h>
 
 ///////////////////////////////////////////////////////////////////
@@ -57,6 +58,16 @@ namespace zypp
       { return __x.second; }
     };
 
+    /** Select the value itself (\ref Id2ItemIndex iterates the PoolItems).
+     */
+    template<typename TVal>
+    struct P_SelectValue
+    {
+      const TVal &
+      operator()(const TVal & __x) const
+      { return __x; }
+    };
+
     ///////////////////////////////////////////////////////////////////
     //
     //	CLASS NAME : PoolTraits
@@ -74,9 +85,11 @@ namespace zypp
       using size_type = ItemContainerT::size_type;
 
       /** ident index */
-      using Id2ItemT = std::unordered_multimap<sat::detail::IdType, PoolItem>;
-      using Id2ItemValueSelector = P_Select2nd<Id2ItemT::value_type>;
+      using Id2ItemT = Id2ItemIndex;
+      using Id2ItemValueSelector = P_SelectValue<Id2ItemT::value_type>;
       using byIdent_iterator = transform_iterator<Id2ItemValueSelector, Id2ItemT::const_iterator>;
+      /** The former ident index (\see \ref ResPool::id2item). */
+      using Id2ItemCompatT = std::unordered_multimap<sat::detail::IdType, PoolItem>;
 
       /** list of known Repositories */
       using repository_iterator = sat::Pool::RepositoryIterator;
@@ -18,6 +18,7 @@
 #include <zypp/base/Gettext.h>
 #include <utility>
 #include <zypp-core/base/UserRequestException>
+#include <zypp-core/base/DtorReset>
 #include <zypp/base/NonCopyable.h>
 #include <zypp/repo/PackageProvider.h>
 #include <zypp/repo/Applydeltarpm.h>
@@ -34,6 +35,7 @@
 #include <zypp/target/rpm/RpmDb.h>
 #include <zypp/FileChecker.h>
 #include <zypp/target/rpm/RpmHeader.h>
+#include <zypp/target/rpm/RpmPackageVerifyPool.h>
 #include <zypp/ng/workflows/keyringwf.h>
 
 using std::endl;
@@ -64,6 +66,83 @@ namespace zypp
       repo::DownloadResolvableReport::Action _action;
     };
 
+    ///////////////////////////////////////////////////////////////////
+    /// \class RpmSigStream
+    /// \brief Feed a package download to rpm's signature check as it arrives.
+    ///
+    /// While connected, the data written by a download are passed to a
+    /// \ref target::rpm::RpmPackageVerifyPool::Stream. If the provided file
+    /// is the one streamed, the stream's check is queued for it and the file
+    /// is not read again. Otherwise (data not written in order, a precached
+    /// or locally built package,...) the file is checked as usual.
+    ///////////////////////////////////////////////////////////////////
+    struct RpmSigStream : public callback::ReceiveReport<media::DownloadDataReport>
+    {
+      RpmSigStream( shared_ptr<target::rpm::RpmPackageVerifyPool> pool_r )
+      : _oldRec( Distributor::instance().getReceiver() )
+      , _pool( std::move(pool_r) )
+      { connect(); }
+
+      RpmSigStream(const RpmSigStream &) = delete;
+      RpmSigStream(RpmSigStream &&) = delete;
+      RpmSigStream &operator=(const RpmSigStream &) = delete;
+      RpmSigStream &operator=(RpmSigStream &&) = delete;
+
+      ~RpmSigStream() override
+      { if ( _oldRec ) Distributor::instance().setReceiver( *_oldRec ); else Distributor::instance().noReceiver(); }
+
+      void start( const Url & file_r, const Pathname & localfile_r ) override
+      {
+        if ( _oldRec )
+          _oldRec->start( file_r, localfile_r );
+        _localfile = localfile_r;
+        _bound = PathInfo();
+        _stream = _pool->stream();
+      }
+
+      void data( const char * data_r, size_t len_r ) override
+      {
+        if ( _oldRec )
+          _oldRec->data( data_r, len_r );
+        if ( _stream && ! _stream->write( data_r, len_r ) )
+          _stream.reset();
+      }
+
+      void unavailable( const Url & file_r ) override
+      {
+        if ( _oldRec )
+          _oldRec->unavailable( file_r );
+        _stream.reset();
+      }
+
+      /** Remember the provided \a file_r if it is the one streamed. */
+      void bind( const Pathname & file_r )
+      {
+        if ( _stream && file_r == _localfile )
+          _bound = PathInfo( file_r );
+        else
+          _stream.reset();
+      }
+
+      /** Queue the streamed check for \a file_r, the bound file (or a hardlink of it). */
+      bool submit( const Pathname & file_r )
+      {
+        shared_ptr<target::rpm::RpmPackageVerifyPool::Stream> stream;
+        stream.swap( _stream );
+        if ( ! ( stream && _bound.isFile() ) )
+          return false;
+        PathInfo pi( file_r );
+        return pi.dev() == _bound.dev() && pi.ino() == _bound.ino() && _pool->submit( *stream, file_r );
+      }
+
+    private:
+      Receiver * _oldRec;
+      shared_ptr<target::rpm::RpmPackageVerifyPool> _pool;
+      shared_ptr<target::rpm::RpmPackageVerifyPool::Stream> _stream;
+      Pathname _localfile;	///< the file streamed
+      PathInfo _bound;		///< the file provided as _localfile
+    };
+
 
     ///////////////////////////////////////////////////////////////////
     //	class PackageProviderPolicy
@@ -102,6 +181,12 @@ namespace zypp
 
       /** Whether the package is cached. */
       virtual bool isCached() const = 0;
+
+      /** Complete a queued signature check. */
+      virtual ManagedFile verifyPackage( const ManagedFile & file_r ) const = 0;
+
+      /** The pool queueing the signature checks (or \c nullptr if checked immediately). */
+      shared_ptr<target::rpm::RpmPackageVerifyPool> _verifyPool;
     };
 
     ///////////////////////////////////////////////////////////////////
@@ -150,6 +235,9 @@ namespace zypp
       bool isCached() const override
       { return ! doProvidePackageFromCache()->empty(); }
 
+      /** Complete a queued signature check. */
+      ManagedFile verifyPackage( const ManagedFile & file_r ) const override;
+
     protected:
       using Base = PackageProviderImpl<TPackage>;
       using Report = callback::SendReport<repo::DownloadResolvableReport>;
@@ -218,6 +306,21 @@ namespace zypp
         RepoInfo info = _package->repoInfo();
         if ( info.pkgGpgCheck() )
         {
+          if ( _sigStream && ! _verifying )
+          {
+            _sigStream->bind( file_r );
+            if ( ! _verifyPool )
+              _sigStream->submit( file_r );	// the check below takes it
+          }
+
+          if ( _verifyPool && ! _verifying )
+          {
+            // The file may still be copied into the cache, so the check
+            // is queued for the final file by queueSigCheck.
+            _deferredSigCheck = true;
+            return;
+          }
+
           UserData userData( "pkgGpgCheck" );
           ResObject::constPtr roptr( _package );	// gcc6 needs it more explcit. Has problem deducing
           userData.set( "ResObject", roptr );		// a type for '_package->asKind<ResObject>()'...
@@ -236,15 +339,8 @@ namespace zypp
               // we try to resolv it with gpgkey urls from the
               // repository, if available
 
-              target::rpm::RpmHeader::constPtr hr = target::rpm::RpmHeader::readPackage( file_r );
-              if ( !hr ) {
-                // we did not find any information about the key in the header
-                // this should never happen
-                WAR << "Unable to read package header from " << hr << endl;
-                break;
-              }
-
-              std::string keyID = hr->signatureKeyID();
+              // the key ID was already read from the header by the signature check
+              std::string keyID = userData.get<target::rpm::VerifyPackageResult>( "VerifyPackageResult", target::rpm::VerifyPackageResult() ).keyID;
               if ( keyID.length() > 0 ) {
                 if ( !zyppng::KeyRingWorkflow::provideAndImportKeyFromRepository ( zyppng::SyncContext::defaultContext(), keyID, info ) )
                   break;
@@ -291,6 +387,24 @@ namespace zypp
         }
       }
 
+      /** Queue the check deferred by \ref rpmSigFileChecker for the provided \a file_r.
+       * If it can't be queued, it is checked immediately.
+       */
+      void queueSigCheck( const Pathname & file_r ) const
+      {
+        if ( ! _deferredSigCheck )
+          return;
+        _deferredSigCheck = false;
+        if ( _sigStream && _sigStream->submit( file_r ) )
+          return;	// checked while downloading, completed by verifyPackage
+        if ( _verifyPool->submit( file_r ) )
+          return;	// completed by verifyPackage
+
+        DtorReset guardVerifying( _verifying, false );
+        _verifying = true;
+        rpmSigFileChecker( file_r );
+      }
+
       using RpmDb = target::rpm::RpmDb;
 
       /** Actual rpm package signature check. */
@@ -299,22 +413,31 @@ namespace zypp
         if ( !_target )
           _target = getZYpp()->getTarget();
 
-        RpmDb::CheckPackageResult ret = RpmDb::CHK_ERROR;
+        target::rpm::VerifyPackageResult res;
         RpmDb::CheckPackageDetail detail;
         if ( _target )
         {
-          ret = _target->rpmDb().checkPackageSignature( path_r, detail );
-          if ( ret == RpmDb::CHK_NOSIG && !isMandatory_r )
+          if ( _verifyPool )
+            res = _target->rpmDb().verifyPackageSignature( path_r, true, *_verifyPool );
+          else if ( _streamPool )
+            res = _target->rpmDb().verifyPackageSignature( path_r, true, *_streamPool );
+          else
+            res = _target->rpmDb().verifyPackageSignature( path_r );
+          MIL << _package->asUserString() << ": signature check took " << res.verifyTime.count() << "us" << endl;
+          detail = res.detail;
+          if ( res.result == RpmDb::CHK_NOSIG && !isMandatory_r )
           {
             WAR << "Relax CHK_NOSIG: Config says unsigned packages are OK" << endl;
-            ret = RpmDb::CHK_OK;
+            res.result = RpmDb::CHK_OK;
           }
         }
         else
-          detail.push_back( RpmDb::CheckPackageDetail::value_type( ret, "OOps. Target is not initialized!" ) );
+          detail.push_back( RpmDb::CheckPackageDetail::value_type( res.result, "OOps. Target is not initialized!" ) );
 
+        RpmDb::CheckPackageResult ret = res.result;
         userData.set( "CheckPackageResult", ret );
         userData.set( "CheckPackageDetail", std::move(detail) );
+        userData.set( "VerifyPackageResult", std::move(res) );
         return ret;
       }
 
@@ -366,9 +489,27 @@ namespace zypp
                                             std::ref(_report) ) );
       }
 
+      /** Stream the package download to the signature check (or \c nullptr if not checked). */
+      shared_ptr<RpmSigStream> newSigStream() const
+      {
+        if ( ! _package->repoInfo().pkgGpgCheck() )
+          return nullptr;
+        if ( !_target )
+          _target = getZYpp()->getTarget();
+        if ( !_target )
+          return nullptr;
+        if ( ! ( _verifyPool || _streamPool ) )
+          _streamPool.reset( new target::rpm::RpmPackageVerifyPool( _target->root(), 1 ) );
+        return make_shared<RpmSigStream>( _verifyPool ? _verifyPool : _streamPool );
+      }
+
       mutable bool               _retry;
+      mutable bool               _verifying = false;	///< completing a check queued in the verifyPool
+      mutable bool               _deferredSigCheck = false;	///< rpmSigFileChecker left the check to queueSigCheck
       mutable shared_ptr<Report> _report;
       mutable Target_Ptr         _target;
+      mutable shared_ptr<RpmSigStream> _sigStream;	///< feeding the download to the signature check
+      mutable shared_ptr<target::rpm::RpmPackageVerifyPool> _streamPool;	///< checking streams if there is no _verifyPool
     };
     ///////////////////////////////////////////////////////////////////
 
@@ -432,9 +573,13 @@ namespace zypp
           ret.reset();
         }
         report()->start( _package, url );
+        _deferredSigCheck = false;
         try
           {
+            DtorReset guardSigStream( _sigStream );
+            _sigStream = newSigStream();
             ret = doProvidePackage();
+            queueSigCheck( ret );
           }
         catch ( const UserRequestException & excpt )
           {
@@ -526,6 +671,46 @@ namespace zypp
       return ret;
     }
 
+    template <class TPackage>
+    ManagedFile PackageProviderImpl<TPackage>::verifyPackage( const ManagedFile & file_r ) const
+    {
+      if ( ! ( _verifyPool && _verifyPool->queued( file_r ) ) )
+        return file_r;
+
+      {
+        ScopedGuard guardReport( newReport() );
+        try
+        {
+          DtorReset guardVerifying( _verifying, false );
+          _verifying = true;
+          rpmSigFileChecker( file_r );
+          return file_r;
+        }
+        catch ( const RpmSigCheckException & excpt )
+        {
+          ERR << "Failed to verify Package " << _package << endl;
+          // bsc#1045735: Be sure no invalid files stay in the cache!
+          filesystem::unlink( file_r );
+          // Signature verification error was already reported by the
+          // rpmSigFileChecker. Just handle the users action decision:
+          switch ( excpt.action() )
+          {
+            case repo::DownloadResolvableReport::RETRY:
+              break;
+            case repo::DownloadResolvableReport::IGNORE:
+              ZYPP_THROW(SkipRequestException("User requested skip of corrupted file"));
+              break;
+            default:
+            case repo::DownloadResolvableReport::ABORT:
+              ZYPP_THROW(AbortRequestException("User requested to abort"));
+              break;
+          }
+        }
+      }
+      // RETRY: download again, the new file is queued again
+      return verifyPackage( providePackage() );
+    }
+
 
     ///////////////////////////////////////////////////////////////////
     /// \class RpmPackageProvider
@@ -714,6 +899,12 @@ namespace zypp
     bool PackageProvider::isCached() const
     { return _pimpl->isCached(); }
 
+    void PackageProvider::verifyPool( shared_ptr<target::rpm::RpmPackageVerifyPool> verifyPool_r )
+    { _pimpl->_verifyPool = std::move(verifyPool_r); }
+
+    ManagedFile PackageProvider::verifyPackage( const ManagedFile & file_r ) const
+    { return _pimpl->verifyPackage( file_r ); }
+
   } // namespace repo
   ///////////////////////////////////////////////////////////////////
 } // namespace zypp
@@ -23,6 +23,14 @@
 ///////////////////////////////////////////////////////////////////
 namespace zypp
 {
+  namespace target
+  {
+    namespace rpm
+    {
+      class RpmPackageVerifyPool;
+    }
+  }
+
   ///////////////////////////////////////////////////////////////////
   namespace repo
   {
@@ -93,6 +101,24 @@ namespace zypp
       /** Whether the package is cached. */
       bool isCached() const;
 
+      /** Queue the signature check of a downloaded package in \a verifyPool_r.
+       * The provided package is then not yet checked. The check must be completed
+       * by \ref verifyPackage, before the package is used. If the package can not
+       * be queued, it is checked immediately as usual.
+       *
+       * \note With or without a pool, a package written in order while it is
+       * downloaded is fed to rpm's check meanwhile, so it is not read again.
+       */
+      void verifyPool( shared_ptr<target::rpm::RpmPackageVerifyPool> verifyPool_r );
+
+      /** Complete the signature check of \a file_r queued in the \ref verifyPool.
+       * The usual callbacks are sent from here. If the user chooses to retry, the
+       * package is downloaded again. Files not queued are returned unchanged.
+       * \returns the checked package.
+       * \throws Exception.
+       */
+      ManagedFile verifyPackage( const ManagedFile & file_r ) const;
+
     public:
       struct Impl;              ///< Implementation class.
     private:
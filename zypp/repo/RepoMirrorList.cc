@@ -16,6 +16,7 @@
 #include <time.h>
 #include <zypp/repo/RepoMirrorList.h>
 #include <zypp-curl/parser/MetaLinkParser>
+#include <zypp-curl/MirrorStatistics>
 #include <zypp/MediaSetAccess.h>
 #include <zypp/base/LogTools.h>
 #include <zypp/ZConfig.h>
@@ -113,11 +114,13 @@ namespace zypp
               murl.setPathName( murl.getPathName().erase(delpos)  );
             }
             ret.push_back( murl );
-
-            if ( ret.size() >= 4 )	// why 4?
-              break;
           }
         }
+
+        // prefer the mirrors that did well in previous runs
+        media::MirrorStatistics( ZConfig::instance().mirrorStatsCachePath() ).sortUrls( ret );
+        if ( ret.size() > 4 )	// why 4?
+          ret.resize( 4 );
         return ret;
       }
 
@@ -342,6 +342,38 @@ namespace zypp
       return ManagedFile(); // not reached
     }
 
+    void RepoMediaAccess::precacheFiles( const RepoInfo & repo_r, const std::vector<OnMediaLocation> & locs_r )
+    {
+      if ( locs_r.empty() || repo_r.baseUrlsEmpty() )
+        return;
+
+      std::vector<OnMediaLocation> locsWithPath;
+      locsWithPath.reserve( locs_r.size() );
+      for ( const OnMediaLocation & loc : locs_r )
+        locsWithPath.push_back( OnMediaLocation(loc).prependPath( repo_r.path() ) );
+
+      // Like provideFile: use the 1st url whose media can be accessed.
+      for ( RepoInfo::urls_const_iterator it = repo_r.baseUrlsBegin(); it != repo_r.baseUrlsEnd(); ++it )
+      {
+        Url url( *it );
+        if ( ! url.schemeIsDownloading() )
+          return;	// provideFile would use it
+
+        try
+        {
+          MIL << "Precache " << locsWithPath.size() << " files of repo '" << repo_r.alias() << "' from " << url << endl;
+          _impl->mediaAccessForUrl( url, repo_r )->precacheFiles( locsWithPath );
+          return;
+        }
+        catch ( const Exception & excpt )
+        {
+          // just a hint; provideFile will report any real error
+          ZYPP_CAUGHT( excpt );
+          WAR << "Trying next url" << endl;
+        }
+      }
+    }
+
     /////////////////////////////////////////////////////////////////
   } // namespace repo
   ///////////////////////////////////////////////////////////////////
@@ -13,6 +13,7 @@
 #define ZYPP_REPO_REPOPROVIDEFILE_H
 
 #include <iosfwd>
+#include <vector>
 
 #include <zypp/base/PtrTypes.h>
 #include <zypp/base/Function.h>
@@ -82,6 +83,16 @@ namespace zypp
       ManagedFile provideFile( RepoInfo repo_r, const OnMediaLocation & loc_r )
       { return provideFile( std::move(repo_r), loc_r, defaultPolicy() ); }
 
+      /** Hint to download the files described by \a locs_r in advance.
+       * Hands all files at once to the media backend of the repos first
+       * accessible base url (like \ref provideFile, falling back to the next
+       * one if a media can't be attached), which may download them
+       * concurrently (\ref MediaSetAccess::precacheFiles).
+       * A later \ref provideFile for one of these files then uses the
+       * precached download. Nothing is done for non-downloading urls.
+       */
+      void precacheFiles( const RepoInfo & repo_r, const std::vector<OnMediaLocation> & locs_r );
+
     public:
       /** Set a new default \ref ProvideFilePolicy. */
       void setDefaultPolicy( const ProvideFilePolicy & policy_r );
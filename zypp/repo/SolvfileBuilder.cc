@@ -0,0 +1,329 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/repo/SolvfileBuilder.cc
+ *
+*/
+extern "C"
+{
+#include <solv/pool.h>
+#include <solv/repo.h>
+#include <solv/repodata.h>
+#include <solv/repo_write.h>
+#include <solv/repo_rpmmd.h>
+#include <solv/repo_repomdxml.h>
+#include <solv/repo_updateinfoxml.h>
+#include <solv/repo_deltainfoxml.h>
+#include <solv/repo_susetags.h>
+#include <solv/repo_content.h>
+#include <solv/repo_rpmdb.h>
+#include <solv/repo_autopattern.h>
+#include <solv/solv_xfopen.h>
+#include <solv/solvversion.h>
+}
+
+#include <iostream>
+#include <functional>
+#include <list>
+#include <map>
+#include <vector>
+
+#include <zypp/base/LogTools.h>
+#include <zypp/base/Gettext.h>
+#include <zypp/base/String.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/OnMediaLocation.h>
+#include <zypp/parser/yum/RepomdFileReader.h>
+#include <zypp/repo/RepoException.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/TrigramIndex.h>
+
+#include <zypp/repo/SolvfileBuilder.h>
+
+#undef  ZYPP_BASE_LOGGER_LOGGROUP
+#define ZYPP_BASE_LOGGER_LOGGROUP "zypp::repo2solv"
+
+using std::endl;
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{ /////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+  namespace repo
+  { /////////////////////////////////////////////////////////////////
+
+    ///////////////////////////////////////////////////////////////////
+    namespace
+    {
+      ///////////////////////////////////////////////////////////////////
+      /// \class SolvfileBuilder
+      /// \brief Private libsolv pool the metadata is read into.
+      ///////////////////////////////////////////////////////////////////
+      class SolvfileBuilder
+      {
+      public:
+        SolvfileBuilder( const RepoInfo & info_r )
+        : _info( info_r )
+        , _pool( ::pool_create(), ::pool_free )
+        , _repo( ::repo_create( _pool, "" ) )
+        {}
+
+        void addRpmmd( const Pathname & dir_r );
+        void addSusetags( const Pathname & dir_r );
+        void addPlaindir( const Pathname & dir_r );
+
+        void write( const Pathname & solvfile_r, bool searchIndex_r );
+
+      private:
+        /** Open a (maybe compressed) metadata file or throw. */
+        AutoDispose<FILE*> open( const Pathname & file_r ) const
+        {
+          FILE * fp = ::solv_xfopen( file_r.c_str(), "r" );
+          if ( ! fp )
+            throwError( str::Format(_("Can't open '%1%'.")) % file_r );
+          return AutoDispose<FILE*>( fp, ::fclose );
+        }
+
+        /** Throw if a libsolv reader returned \a ret_r != 0. */
+        void assertRead( int ret_r, const Pathname & file_r ) const
+        {
+          if ( ret_r != 0 )
+            throwError( str::Format(_("Can't parse '%1%': %2%")) % file_r % ::pool_errstr( _pool ) );
+        }
+
+        [[noreturn]] void throwError( const std::string & msg_r ) const
+        {
+          RepoException ex( _info, str::Format(_("Failed to cache repo %1%")) % _info );
+          ex.addHistory( msg_r );
+          ZYPP_THROW( ex );
+        }
+
+      private:
+        const RepoInfo & _info;
+        AutoDispose<sat::detail::CPool*> _pool;
+        sat::detail::CRepo * _repo;	// owned by _pool
+      };
+
+      /** \c packages.en.gz ==> \c packages.en */
+      std::string stripCompressionExt( const std::string & name_r )
+      {
+        for ( const char * ext : { ".gz", ".xz", ".bz2", ".lzma", ".zst" } )
+        {
+          if ( str::hasSuffix( name_r, ext ) )
+            return str::stripSuffix( name_r, ext );
+        }
+        return name_r;
+      }
+
+      void SolvfileBuilder::addRpmmd( const Pathname & dir_r )
+      {
+        const Pathname repomd( dir_r / "repodata/repomd.xml" );
+        assertRead( ::repo_add_repomdxml( _repo, open( repomd ), REPO_NO_INTERNALIZE ), repomd );
+
+        // Like repo2solv read just the resources present in the raw cache: the
+        // RepomdFileCollector skips unwanted ones (filelists, other, susedata.<lang>)
+        // and prefers the '<type>_zck' variant if zchunk is supported.
+        std::map<std::string,Pathname> resources;	// base type and file
+        parser::yum::RepomdFileReader( repomd, [&]( OnMediaLocation && loc_r, const std::string & type_r ) {
+          if ( str::endsWith( type_r, "_db" ) )
+            return true;	// sqlitedb
+          bool zchk { str::endsWith( type_r, "_zck" ) };
+          const std::string basetype { zchk ? type_r.substr( 0, type_r.size()-4 ) : type_r };
+          const Pathname file( dir_r / loc_r.filename() );
+          if ( ! PathInfo( file ).isFile() )
+            return true;	// not downloaded
+          if ( zchk || ! resources.count( basetype ) )
+            resources[basetype] = file;
+          return true;
+        });
+
+        if ( ! resources.count( "primary" ) )
+          throwError( str::Format(_("No primary metadata in '%1%'.")) % repomd );
+
+        // primary creates the solvables, the other files extend them
+        for ( bool extend : { false, true } )
+        {
+          for ( const auto & res : resources )
+          {
+            const std::string & type( res.first );
+            const Pathname & file( res.second );
+            int ret = 0;
+
+            if ( ! extend )
+            {
+              if ( type == "primary" )
+                ret = ::repo_add_rpmmd( _repo, open( file ), nullptr, REPO_NO_INTERNALIZE );
+              else
+                continue;
+            }
+            else if ( type == "filelists" )
+              ret = ::repo_add_rpmmd( _repo, open( file ), nullptr, REPO_EXTEND_SOLVABLES|REPO_LOCALPOOL|REPO_NO_INTERNALIZE );
+            else if ( type == "susedata" )
+              ret = ::repo_add_rpmmd( _repo, open( file ), nullptr, REPO_EXTEND_SOLVABLES|REPO_NO_INTERNALIZE );
+            else if ( str::hasPrefix( type, "susedata." ) )	// susedata.<lang>
+              ret = ::repo_add_rpmmd( _repo, open( file ), type.c_str() + 9, REPO_EXTEND_SOLVABLES|REPO_NO_INTERNALIZE );
+            else if ( type == "updateinfo" )
+              ret = ::repo_add_updateinfoxml( _repo, open( file ), REPO_NO_INTERNALIZE );
+            else if ( type == "deltainfo" || type == "prestodelta" )
+              ret = ::repo_add_deltainfoxml( _repo, open( file ), REPO_NO_INTERNALIZE );
+            else if ( type == "suseinfo" )
+              ret = ::repo_add_repomdxml( _repo, open( file ), REPO_NO_INTERNALIZE );
+            else
+              continue;	// 'other' (changelogs) is not cached
+            DBG << "Read " << type << " " << file << endl;
+            assertRead( ret, file );
+          }
+        }
+      }
+
+      void SolvfileBuilder::addSusetags( const Pathname & dir_r )
+      {
+        const Pathname content( dir_r / "content" );
+        if ( PathInfo( content ).isFile() )
+          assertRead( ::repo_add_content( _repo, open( content ), REPO_NO_INTERNALIZE|REPO_REUSE_REPODATA ), content );
+
+        const char * descr = ::repo_lookup_str( _repo, SOLVID_META, SUSETAGS_DESCRDIR );
+        const Pathname descrdir( dir_r / ( descr ? descr : "suse/setup/descr" ) );
+        const Id defvendor = ::repo_lookup_id( _repo, SOLVID_META, SUSETAGS_DEFAULTVENDOR );
+
+        std::list<std::string> files;
+        if ( filesystem::readdir( files, descrdir, false ) != 0 )
+          throwError( str::Format(_("Can't read directory '%1%'.")) % descrdir );
+        files.sort();
+
+        // 'packages' creates the solvables, the DU, FL and language files extend them
+        for ( bool extend : { false, true } )
+        {
+          for ( const std::string & name : files )
+          {
+            const std::string stem( stripCompressionExt( name ) );
+            const Pathname file( descrdir / name );
+            int ret = 0;
+
+            if ( ! extend )
+            {
+              if ( stem == "packages" || str::hasSuffix( stem, ".pat" ) )
+                ret = ::repo_add_susetags( _repo, open( file ), defvendor, nullptr, REPO_NO_INTERNALIZE|SUSETAGS_RECORD_SHARES );
+              else
+                continue;
+            }
+            else if ( str::hasPrefix( stem, "packages." ) )
+            {
+              const std::string ext( stem.substr( 9 ) );
+              if ( ext == "DU" || ext == "FL" )
+                ret = ::repo_add_susetags( _repo, open( file ), defvendor, nullptr, REPO_NO_INTERNALIZE|REPO_REUSE_REPODATA|REPO_EXTEND_SOLVABLES );
+              else if ( ext.find( '.' ) == std::string::npos )	// packages.<lang>
+                ret = ::repo_add_susetags( _repo, open( file ), defvendor, ext.c_str(), REPO_NO_INTERNALIZE|REPO_REUSE_REPODATA|REPO_EXTEND_SOLVABLES );
+              else
+                continue;
+            }
+            else
+              continue;
+            DBG << "Read " << file << endl;
+            assertRead( ret, file );
+          }
+        }
+      }
+
+      void SolvfileBuilder::addPlaindir( const Pathname & dir_r )
+      {
+        std::vector<Pathname> rpms;	// relative to dir_r
+        std::function<void(const Pathname &)> collect = [&]( const Pathname & sub_r ) {
+          std::list<std::string> names;
+          filesystem::readdir( names, dir_r / sub_r, false );
+          names.sort();
+          for ( const std::string & name : names )
+          {
+            PathInfo pi( dir_r / sub_r / name );
+            if ( pi.isDir() )
+              collect( sub_r / name );
+            else if ( pi.isFile() && str::hasSuffix( name, ".rpm" ) )
+              rpms.push_back( sub_r / name );
+          }
+        };
+        collect( Pathname() );
+
+        Repodata * data = ::repo_add_repodata( _repo, 0 );
+        for ( const Pathname & rpm : rpms )
+        {
+          const Pathname file( dir_r / rpm );
+          Id solvid = ::repo_add_rpm( _repo, file.c_str(), REPO_REUSE_REPODATA|REPO_NO_INTERNALIZE|RPM_ADD_WITH_PKGID|RPM_ADD_WITH_SHA256SUM );
+          if ( ! solvid )
+          {
+            WAR << "Skip unreadable rpm " << file << ": " << ::pool_errstr( _pool ) << endl;
+            continue;
+          }
+          const std::string dir( rpm.dirname().relativename().asString() );
+          ::repodata_set_location( data, solvid, 0, ( dir == "." ? nullptr : dir.c_str() ), rpm.basename().c_str() );
+        }
+      }
+
+      void SolvfileBuilder::write( const Pathname & solvfile_r, bool searchIndex_r )
+      {
+        ::repo_add_autopattern( _repo, 0 );	// like repo2solv -X
+        ::repo_internalize( _repo );
+
+        // like repo2solv: loadFromCache rebuilds solv files stamped by a different parser version
+        Repodata * info = ::repo_add_repodata( _repo, 0 );
+        ::repodata_set_str( info, SOLVID_META, REPOSITORY_TOOLVERSION, LIBSOLV_TOOLVERSION );
+        ::repodata_internalize( info );
+
+        {
+          // Written aside and renamed, so a failed build leaves no partial solv file.
+          filesystem::TmpFile tmpfile( filesystem::TmpFile::makeSibling( solvfile_r, 0644 ) );
+          AutoDispose<FILE*> fp( ::fopen( tmpfile.path().c_str(), "we" ), ::fclose );
+          if ( ! fp )
+            throwError( str::Format(_("Can't create '%1%'.")) % solvfile_r );
+          if ( ::repo_write( _repo, fp ) != 0 )
+            throwError( str::Format(_("Can't write '%1%': %2%")) % solvfile_r % ::pool_errstr( _pool ) );
+          fp.resetDispose();
+          if ( ::fclose( fp ) != 0 || filesystem::rename( tmpfile.path(), solvfile_r ) != 0 )
+            throwError( str::Format(_("Can't write '%1%'.")) % solvfile_r );
+        }
+
+        sat::updateSolvFileIndex( solvfile_r, _repo );	// content digest for zypper bash completion
+        if ( searchIndex_r )
+          sat::TrigramIndex::write( solvfile_r, _repo );	// PoolQuery preselection
+        else
+          filesystem::unlink( sat::TrigramIndex::indexFile( solvfile_r ) );
+        MIL << "Wrote " << _repo->nsolvables << " solvables to " << solvfile_r << endl;
+      }
+
+    } // namespace
+    ///////////////////////////////////////////////////////////////////
+
+    void buildSolvFile( const RepoInfo & info_r, const RepoType & type_r, const Pathname & metadatapath_r, const Pathname & solvfile_r, bool searchIndex_r )
+    {
+      MIL << "Building " << solvfile_r << " for " << info_r.alias() << " (" << type_r << ") from " << metadatapath_r << endl;
+      SolvfileBuilder builder( info_r );
+      switch ( type_r.toEnum() )
+      {
+        case RepoType::RPMMD_e:
+          builder.addRpmmd( metadatapath_r );
+          break;
+        case RepoType::YAST2_e:
+          builder.addSusetags( metadatapath_r );
+          break;
+        case RepoType::RPMPLAINDIR_e:
+          builder.addPlaindir( metadatapath_r );
+          break;
+        default:
+          ZYPP_THROW( RepoUnknownTypeException( info_r, _("Unhandled repository type") ) );
+          break;
+      }
+      builder.write( solvfile_r, searchIndex_r );
+    }
+
+    /////////////////////////////////////////////////////////////////
+  } // namespace repo
+  ///////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
@@ -0,0 +1,53 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/repo/SolvfileBuilder.h
+ *
+*/
+#ifndef ZYPP_REPO_SOLVFILEBUILDER_H
+#define ZYPP_REPO_SOLVFILEBUILDER_H
+
+#include <zypp/Pathname.h>
+#include <zypp/RepoInfo.h>
+#include <zypp/repo/RepoType.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{ /////////////////////////////////////////////////////////////////
+  ///////////////////////////////////////////////////////////////////
+  namespace repo
+  { /////////////////////////////////////////////////////////////////
+
+    /**
+     * Build the solv file \a solvfile_r (and its \c solv.idx) for the
+     * repository \a info_r in-process, as the \c repo2solv tool would.
+     * If \a searchIndex_r is set, the \ref sat::TrigramIndex is written
+     * too, otherwise a stale one is removed.
+     *
+     * The libsolv readers for \a type_r parse the raw metadata in
+     * \a metadatapath_r into a private pool, which is then written to
+     * the solv file. The \c solv.idx is created from the same pool, so
+     * the solv file is not read back.
+     *
+     * For \ref RepoType::RPMPLAINDIR \a metadatapath_r is the local
+     * directory which is searched recursively for rpm files.
+     *
+     * The builder uses no global state (the caller passes the
+     * \ref ZConfig::repoSearchIndex setting) and may be called from any thread.
+     *
+     * \throws RepoException if the metadata can not be read or the solv file can not be written.
+     */
+    void buildSolvFile( const RepoInfo & info_r, const RepoType & type_r, const Pathname & metadatapath_r, const Pathname & solvfile_r, bool searchIndex_r );
+
+    /////////////////////////////////////////////////////////////////
+  } // namespace repo
+  ///////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_REPO_SOLVFILEBUILDER_H
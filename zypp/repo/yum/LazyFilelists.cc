@@ -0,0 +1,116 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+extern "C"
+{
+#include <fcntl.h>
+#include <unistd.h>
+#include <solv/solv_xfopen.h>
+}
+#include <optional>
+
+#include <zypp/base/Logger.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/repo/RepoProvideFile.h>
+#include <zypp/parser/yum/RepomdFileReader.h>
+#include <zypp/sat/detail/PoolImpl.h>
+
+#include "RepomdFileCollector.h"
+#include "LazyFilelists.h"
+
+using std::endl;
+
+namespace zypp::repo::yum
+{
+  namespace
+  {
+    /** Whether \a file_r matches the checksum in \a loc_r (if any). */
+    bool checksumOk( const Pathname & file_r, const OnMediaLocation & loc_r )
+    {
+      const CheckSum & cs( loc_r.checksum() );
+      return cs.empty() || filesystem::checksum( file_r, cs.type() ) == cs.checksum();
+    }
+
+    /** Fetch the filelists (unless cached) and add them to \a repo_r. */
+    bool provideFilelists( Repository repo_r, const RepoInfo & info_r, const Pathname & productdatapath_r, const OnMediaLocation & loc_r )
+    {
+      Pathname file( productdatapath_r / loc_r.filename() );
+      std::optional<filesystem::TmpFile> tmpcopy;
+
+      if ( ! ( PathInfo( file ).isFile() && checksumOk( file, loc_r ) ) )
+      {
+        MIL << "Fetching filelists of " << info_r.alias() << ": " << loc_r << endl;
+        try
+        {
+          // Like packages: try the repos base urls (and mirrors) in turn, checking the checksum.
+          RepoMediaAccess access;
+          ManagedFile downloaded( access.provideFile( info_r, loc_r ) );
+          // Keep them for later processes unless we lack permission.
+          if ( filesystem::hardlinkCopy( downloaded, file ) != 0 )
+          {
+            tmpcopy.emplace();
+            if ( filesystem::copy( downloaded, tmpcopy->path() ) != 0 )
+              return false;
+            file = tmpcopy->path();
+          }
+        }
+        catch ( const Exception & excpt )
+        {
+          ZYPP_CAUGHT( excpt );
+          WAR << "Can't fetch filelists of " << info_r.alias() << endl;
+          return false;
+        }
+      }
+
+      // solv_xfopen_fd guesses the compression from the original file name.
+      int fd = ::open( file.c_str(), O_RDONLY | O_CLOEXEC );
+      AutoDispose<FILE*> fp( fd == -1 ? nullptr : ::solv_xfopen_fd( loc_r.filename().c_str(), fd, "r" ), ::fclose );
+      if ( ! fp )
+      {
+        fp.resetDispose();
+        if ( fd != -1 )
+          ::close( fd );
+        WAR << "Can't open filelists of " << info_r.alias() << ": " << file << endl;
+        return false;
+      }
+      if ( sat::detail::PoolMember::myPool()._addRpmmdFilelists( repo_r.get(), fp ) != 0 )
+      {
+        WAR << "Can't read filelists of " << info_r.alias() << ": " << file << endl;
+        return false;
+      }
+      MIL << "Added filelists to " << repo_r << endl;
+      return true;
+    }
+  } // namespace
+
+  void registerLazyFilelists( const Repository & repo_r, const RepoInfo & info_r, const Pathname & productdatapath_r )
+  {
+    if ( env::ZYPP_REPOMD_WITH_FILELISTS() )
+      return;	// already in the solv file
+
+    const Pathname repomd( productdatapath_r / "repodata/repomd.xml" );
+    if ( ! PathInfo( repomd ).isFile() )
+      return;	// not rpm-md
+
+    std::optional<OnMediaLocation> loc;
+    parser::yum::RepomdFileReader( repomd, [&loc]( OnMediaLocation && loc_r, const std::string & type_r ) {
+      if ( type_r == "filelists" )
+        loc = std::move(loc_r);
+      return true;
+    });
+    if ( ! loc )
+      return;
+
+    DBG << "Filelists of " << info_r.alias() << " on demand: " << *loc << endl;
+    sat::detail::PoolMember::myPool().setFilelistsProvider( repo_r.get(), [repo_r,info_r,productdatapath_r,loc = *loc]() {
+      return provideFilelists( repo_r, info_r, productdatapath_r, loc );
+    });
+  }
+}
@@ -0,0 +1,35 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+
+#ifndef ZYPP_SOURCE_YUM_LAZYFILELISTS
+#define ZYPP_SOURCE_YUM_LAZYFILELISTS
+
+#include <zypp-core/Pathname.h>
+#include <zypp/Repository.h>
+#include <zypp/RepoInfo.h>
+
+namespace zypp::repo::yum
+{
+  /**
+   * Register the on demand filelists of an rpm-md \a repo_r loaded from cache.
+   *
+   * Unless \c ZYPP_REPOMD_WITH_FILELISTS is set, the refresh skips the filelists
+   * and primary just lists the files in /etc and in *bin/ dirs. If the repomd.xml
+   * in \a productdatapath_r offers filelists, they are fetched when the resolver
+   * needs them for an unresolved file requirement and \ref ZConfig::solverFetchFilelists
+   * is set (\ref sat::Pool::provideNeededFilelists), or when the application asks
+   * for them (\ref sat::Pool::provideFilelists). They are downloaded like the
+   * repos packages. A PoolQuery just searches the filelists already loaded.
+   *
+   * Once downloaded, the filelists are kept in the raw metadata cache next to
+   * repomd.xml, so later processes just need to parse them.
+   */
+  void registerLazyFilelists( const Repository & repo_r, const RepoInfo & info_r, const Pathname & productdatapath_r );
+}
+#endif
@@ -18,6 +18,14 @@
 #include <string>
 #include <functional>
 
+namespace zypp::env
+{
+  /** Whether to download and parse 'other' (changelogs). */
+  bool ZYPP_REPOMD_WITH_OTHER();
+  /** Whether to download and parse 'filelists' on refresh (otherwise they are fetched on demand). */
+  bool ZYPP_REPOMD_WITH_FILELISTS();
+}
+
 namespace zypp::repo::yum
 {
 
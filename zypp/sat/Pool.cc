@@ -61,6 +61,20 @@ namespace zypp
     void Pool::prepare() const
     { return myPool().prepare(); }
 
+    bool Pool::provideFilelists() const
+    { return myPool().provideFilelists(); }
+
+    bool Pool::provideFilelists( const std::set<Repository> & repos_r ) const
+    {
+      std::set<detail::RepoIdType> repos;
+      for ( const Repository & repo : repos_r )
+        repos.insert( repo.id() );
+      return myPool().provideFilelists( repos );
+    }
+
+    bool Pool::provideNeededFilelists() const
+    { return myPool().provideNeededFilelists(); }
+
     Pathname Pool::rootDir() const
     { return myPool().rootDir(); }
 
@@ -293,6 +307,18 @@ namespace zypp
         return;
       }
 
+      detail::CPool * _pool = ::pool_create();
+      detail::CRepo * _repo = ::repo_create( _pool, "" );
+      if ( ::repo_add_solv( _repo, solv, 0 ) == 0 )
+        updateSolvFileIndex( solvfile_r, _repo );
+      else
+        ERR << "Can't read solv-file: " << ::pool_errstr( _pool ) << endl;
+      ::repo_free( _repo, 0 );
+      ::pool_free( _pool );
+    }
+
+    void updateSolvFileIndex( const Pathname & solvfile_r, detail::CRepo * repo_r )
+    {
       std::string solvidxfile( solvfile_r.extend(".idx").asString() );
       if ( ::unlink( solvidxfile.c_str() ) == -1 && errno != ENOENT )
       {
@@ -310,32 +336,21 @@ namespace zypp
       }
       std::ofstream idx( solvidxfile.c_str() );
 
-
-      detail::CPool * _pool = ::pool_create();
-      detail::CRepo * _repo = ::repo_create( _pool, "" );
-      if ( ::repo_add_solv( _repo, solv, 0 ) == 0 )
+      detail::CPool * _pool = repo_r->pool;
+      int _id = 0;
+      detail::CSolvable * _solv = nullptr;
+      FOR_REPO_SOLVABLES( repo_r, _id, _solv )
       {
-        int _id = 0;
-        detail::CSolvable * _solv = nullptr;
-        FOR_REPO_SOLVABLES( _repo, _id, _solv )
+        if ( _solv )
         {
-          if ( _solv )
-          {
 #define SEP '\t'
 #define	idstr(V) pool_id2str( _pool, _solv->V )
-            if ( _solv->arch == ARCH_SRC || _solv->arch == ARCH_NOSRC )
-              idx << "srcpackage:" << idstr(name) << SEP << idstr(evr) << SEP << "noarch" << endl;
-            else
-              idx << idstr(name) << SEP << idstr(evr) << SEP << idstr(arch) << endl;
-          }
+          if ( _solv->arch == ARCH_SRC || _solv->arch == ARCH_NOSRC )
+            idx << "srcpackage:" << idstr(name) << SEP << idstr(evr) << SEP << "noarch" << endl;
+          else
+            idx << idstr(name) << SEP << idstr(evr) << SEP << idstr(arch) << endl;
         }
       }
-      else
-      {
-        ERR << "Can't read solv-file: " << ::pool_errstr( _pool ) << endl;
-      }
-      ::repo_free( _repo, 0 );
-      ::pool_free( _pool );
     }
 
     /////////////////////////////////////////////////////////////////
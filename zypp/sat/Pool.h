@@ -13,6 +13,7 @@
 #define ZYPP_SAT_POOL_H
 
 #include <iosfwd>
+#include <set>
 
 #include <zypp/Pathname.h>
 
@@ -72,6 +73,29 @@ namespace zypp
         /** Update housekeeping data if necessary (e.g. whatprovides). */
         void prepare() const;
 
+        /** Fetch the filelists of rpm-md repos which were refreshed without them.
+         * A \ref PoolQuery searching the filelists just searches the ones loaded,
+         * so the application calls this before, if it wants all files to be found.
+         * Returns whether filelists were added.
+         */
+        bool provideFilelists() const;
+
+        /** \overload Just for the repos in \a repos_r. */
+        bool provideFilelists( const std::set<Repository> & repos_r ) const;
+
+        /** Fetch just the filelists needed to resolve file requirements.
+         * File requirements primary lists anyway (files in /etc and *bin/
+         * dirs) are not considered. Just the repos which may provide a
+         * file are asked: those of the requiring packages first, then
+         * those with packages named like the owners of other files in the
+         * same directory (e.g. installed packages), by priority. Each fetch
+         * is announced via \ref JobReport (\c UserData "filelists/fetch"
+         * with "Repository" and "File"); returning \c false skips the repo.
+         * The resolver calls this if \ref ZConfig::solverFetchFilelists.
+         * Returns whether filelists were added.
+         */
+        bool provideNeededFilelists() const;
+
         /** Get rootdir (for file conflicts check) */
         Pathname rootDir() const;
 
@@ -301,6 +325,9 @@ namespace zypp
     /** Create solv file content digest for zypper bash completion */
     void updateSolvFileIndex( const Pathname & solvfile_r );
 
+    /** \overload Create the digest for \a solvfile_r from the already loaded \a repo_r. */
+    void updateSolvFileIndex( const Pathname & solvfile_r, detail::CRepo * repo_r );
+
     /////////////////////////////////////////////////////////////////
   } // namespace sat
   ///////////////////////////////////////////////////////////////////
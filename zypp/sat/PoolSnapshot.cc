@@ -0,0 +1,430 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/PoolSnapshot.cc
+ */
+extern "C"
+{
+#include <solv/pool.h>
+#include <solv/repo.h>
+#include <solv/repodata.h>
+#include <solv/repo_write.h>
+#include <solv/knownid.h>
+#include <solv/solvversion.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/base/Exception.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/ZConfig.h>
+#include <zypp/Repository.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/detail/PoolImpl.h>
+
+#include <zypp/sat/PoolSnapshot.h>
+
+using std::endl;
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    ///////////////////////////////////////////////////////////////////
+    namespace
+    {
+      // File layout: the repos as written by repo_write, followed by a
+      // text index and a fixed size trailer holding the index offset.
+      const std::string snapshotMagic( "zypp-pool-snapshot 1" );
+      constexpr size_t trailerSize = 17;	// "%016llx\n"
+
+      std::string versionLine()
+      { return str::Str() << "libsolv " << solv_version << " " << LIBSOLV_TOOLVERSION; }
+
+      std::string archLine()
+      { return str::Str() << "arch " << ZConfig::instance().systemArchitecture(); }
+
+      /** What a repo in the snapshot was built from: alias, solv file (path, inode, size, mtime) and cookie.
+       * Empty if the solv file does not exist.
+       */
+      std::string stamp( const PoolSnapshot::Entry & entry_r )
+      {
+        PathInfo solv( entry_r._solvfile );
+        if ( ! solv.isFile() )
+          return std::string();
+
+        std::string cookie( "-" );
+        Pathname cookiefile( entry_r._solvfile.dirname() / "cookie" );
+        if ( PathInfo( cookiefile ).isFile() )
+          cookie = filesystem::sha1sum( cookiefile );
+
+        return str::Str() << entry_r._alias << "\t" << entry_r._solvfile << "\t" << solv.ino() << "\t" << solv.size() << "\t" << solv.mtime() << "\t" << cookie;
+      }
+
+      /** A repo to write and the \ref stamp of the solv file it was loaded from. */
+      using Stamped = std::pair<const PoolSnapshot::Entry *, std::string>;
+
+      /** Write the repo \a entry_r as read from its solv file to \a fp_r, storing the file provides \a added_r.
+       * They are then not searched again after loading. The repo in the pool is not
+       * written, as data may have been added to it after loading (e.g. the lazy filelists).
+       * The solv file is read into a scratch pool and the file provides are added there.
+       */
+      int writeRepo( detail::CPool * pool_r, const PoolSnapshot::Entry & entry_r, const StringQueue & added_r, FILE * fp_r )
+      {
+        AutoDispose<FILE*> solv( ::fopen( entry_r._solvfile.c_str(), "re" ), ::fclose );
+        if ( ! solv )
+        {
+          solv.resetDispose();
+          return -1;
+        }
+        AutoDispose<detail::CPool*> scratch( ::pool_create(), ::pool_free );
+        detail::CRepo * copy = ::repo_create( scratch, entry_r._alias.c_str() );
+        if ( ::repo_add_solv( copy, solv, 0 ) != 0 )
+          return -1;
+        if ( added_r.empty() )
+          return ::repo_write( copy, fp_r );
+
+        // A dummy solvable requiring the files makes libsolv search them in the copy.
+        StringQueue added;
+        detail::CRepo * dummy = ::repo_create( scratch, "" );
+        detail::CSolvable * s = ::pool_id2solvable( scratch, ::repo_add_solvable( dummy ) );
+        for ( detail::IdType id : added_r )
+        {
+          detail::IdType sid = ::pool_str2id( scratch, ::pool_id2str( pool_r, id ), /*create*/true );
+          added.push( sid );
+          s->requires = ::repo_addid_dep( dummy, s->requires, sid, 0 );
+        }
+        ::pool_addfileprovides_queue( scratch, nullptr, nullptr );
+        ::repo_free( dummy, /*resusePoolIDs*/false );
+
+        Repodata * data = ::repo_last_repodata( copy );
+        ::repodata_set_idarray( data, SOLVID_META, REPOSITORY_ADDEDFILEPROVIDES, added );
+        ::repodata_internalize( data );
+        return ::repo_write( copy, fp_r );
+      }
+
+      /** The snapshot index: the offset of each repo by its \ref stamp. */
+      using Index = std::map<std::string,off_t>;
+
+      /** Read and check the snapshot index. Returns \c false if the snapshot is damaged or outdated. */
+      bool readIndex( FILE * fp_r, Index & index_r )
+      {
+        if ( ::fseeko( fp_r, 0, SEEK_END ) != 0 )
+          return false;
+        off_t fsize = ::ftello( fp_r );
+        if ( fsize < off_t(trailerSize) )
+          return false;
+
+        char trailer[trailerSize+1] = { '\0' };
+        if ( ::fseeko( fp_r, fsize - trailerSize, SEEK_SET ) != 0 || ::fread( trailer, 1, trailerSize, fp_r ) != trailerSize )
+          return false;
+        char * end = nullptr;
+        off_t indexoff = ::strtoull( trailer, &end, 16 );
+        if ( end != trailer + trailerSize - 1 || *end != '\n' )
+          return false;
+        if ( indexoff <= 0 || indexoff >= off_t(fsize - trailerSize) )
+          return false;
+
+        std::string index( fsize - trailerSize - indexoff, '\0' );
+        if ( ::fseeko( fp_r, indexoff, SEEK_SET ) != 0 || ::fread( index.data(), 1, index.size(), fp_r ) != index.size() )
+          return false;
+
+        std::istringstream str( index );
+        std::string line;
+        if ( ! std::getline( str, line ) || line != snapshotMagic )
+          return false;
+        if ( ! std::getline( str, line ) || line != versionLine() )
+        {
+          MIL << "Pool snapshot was written by " << line << endl;
+          return false;
+        }
+        if ( ! std::getline( str, line ) || line != archLine() )
+        {
+          MIL << "Pool snapshot was written for " << line << endl;
+          return false;
+        }
+        while ( std::getline( str, line ) )
+        {
+          // repo<TAB>offset<TAB>stamp
+          std::string::size_type sep = line.find( '\t', 5 );
+          if ( ! str::startsWith( line, "repo\t" ) || sep == std::string::npos )
+            return false;
+          off_t offset = str::strtonum<off_t>( line.substr( 5, sep-5 ) );
+          if ( offset < 0 || offset >= indexoff )
+            return false;
+          index_r[line.substr( sep+1 )] = offset;
+        }
+        return true;
+      }
+
+      /** Open \a snapshot_r and read its index. */
+      AutoDispose<FILE*> openSnapshot( const Pathname & snapshot_r, Index & index_r )
+      {
+        AutoDispose<FILE*> fp( ::fopen( snapshot_r.c_str(), "re" ), ::fclose );
+        if ( ! fp )
+        {
+          fp.resetDispose();
+          DBG << "No pool snapshot " << snapshot_r << endl;
+        }
+        else if ( ! readIndex( fp, index_r ) )
+        {
+          MIL << "Not using outdated or damaged pool snapshot " << snapshot_r << endl;
+          fp.reset();
+        }
+        return fp;
+      }
+
+      /** The snapshot last opened by \ref PoolSnapshot::loadRepo.
+       * It is kept open, so loading all repos opens it and reads its index just once.
+       */
+      struct Opened
+      {
+        Pathname _path;
+        std::string _id;	///< inode, size and mtime of the file opened
+        AutoDispose<FILE*> _fp;
+        Index _index;
+      };
+
+      Opened & opened()
+      {
+        static Opened _opened;
+        return _opened;
+      }
+
+      std::string fileId( const struct ::stat & st_r )
+      { return str::Str() << st_r.st_ino << ":" << st_r.st_size << ":" << st_r.st_mtime; }
+
+      /** \a snapshot_r opened and its index read, reusing the \ref opened one if the file is unchanged. */
+      const Opened & openCached( const Pathname & snapshot_r )
+      {
+        Opened & ret( opened() );
+        struct ::stat st;
+        if ( ret._path == snapshot_r && ::stat( snapshot_r.c_str(), &st ) == 0 && ret._id == fileId( st ) )
+          return ret;
+
+        ret = Opened();
+        ret._path = snapshot_r;
+        ret._fp = openSnapshot( snapshot_r, ret._index );
+        if ( ret._fp && ::fstat( ::fileno( ret._fp ), &st ) == 0 )
+          ret._id = fileId( st );
+        return ret;
+      }
+
+      /** Load the repo at \a offset_r in \a fp_r as \a entry_r. */
+      bool addRepo( detail::PoolImpl & pool_r, FILE * fp_r, off_t offset_r, Repository repo_r, const PoolSnapshot::Entry & entry_r )
+      {
+        if ( ::fseeko( fp_r, offset_r, SEEK_SET ) != 0 || pool_r._addSolv( repo_r.get(), fp_r ) != 0 )
+          return false;
+        if ( ! repo_r.isSystemRepo() )
+          repo_r.setInfo( entry_r._info );
+        return true;
+      }
+
+      void writeSnapshot( detail::PoolImpl & pool_r, const Pathname & snapshot_r, const std::vector<Stamped> & repos_r )
+      {
+        StringQueue added;
+        StringQueue addedInst;
+        pool_r.addedFileProvides( added, addedInst );	// prepares the pool
+
+        // Concurrent writers each use their own file, the last rename wins.
+        filesystem::TmpFile tmpfile( filesystem::TmpFile::makeSibling( snapshot_r, 0644 ) );
+        AutoDispose<FILE*> fp( ::fopen( tmpfile.path().c_str(), "we" ), ::fclose );
+        if ( ! fp )
+        {
+          fp.resetDispose();
+          ZYPP_THROW( Exception( "Can't create pool snapshot: "+tmpfile.path().asString() ) );
+        }
+
+        std::ostringstream index;
+        index << snapshotMagic << endl << versionLine() << endl << archLine() << endl;
+        for ( const auto & [entry,st] : repos_r )
+        {
+          Repository repo( Pool::instance().reposFind( entry->_alias ) );
+          if ( ! repo )
+            ZYPP_THROW( Exception( "Repo to snapshot is not in the pool: "+entry->_alias ) );
+          if ( st.empty() || stamp( *entry ) != st )
+            ZYPP_THROW( Exception( "Solv file of repo "+entry->_alias+" is missing or changed since loading: "+entry->_solvfile.asString() ) );
+
+          off_t offset = ::ftello( fp );
+          if ( writeRepo( pool_r.getPool(), *entry, pool_r.isSystemRepo( repo.get() ) ? addedInst : added, fp ) != 0 )
+            ZYPP_THROW( Exception( "Can't write repo "+entry->_alias+" to pool snapshot: "+entry->_solvfile.asString() ) );
+          index << "repo\t" << offset << "\t" << st << endl;
+        }
+
+        off_t indexoff = ::ftello( fp );
+        const std::string & idx( index.str() );
+        ::fwrite( idx.data(), 1, idx.size(), fp );
+        ::fprintf( fp, "%016llx\n", (unsigned long long)indexoff );
+
+        fp.resetDispose();
+        if ( ::ferror( fp ) | ::fclose( fp ) )
+          ZYPP_THROW( Exception( "Can't write pool snapshot: "+tmpfile.path().asString() ) );
+        if ( filesystem::rename( tmpfile.path(), snapshot_r ) != 0 )
+          ZYPP_THROW( Exception( "Can't write pool snapshot: "+snapshot_r.asString() ) );
+
+        MIL << "Wrote " << repos_r.size() << " repos to pool snapshot " << snapshot_r << endl;
+      }
+
+      /** A repo remembered for a snapshot: the entry, the stamp when it was loaded and the repo loaded. */
+      struct Remembered
+      {
+        PoolSnapshot::Entry _entry;
+        std::string _stamp;
+        Repository _repo;
+      };
+
+      /** The remembered repos by snapshot and alias, and the snapshots to rewrite. */
+      struct Remembrance
+      {
+        std::map<Pathname,std::map<std::string,Remembered>> _repos;
+        std::set<Pathname> _outdated;
+      };
+
+      Remembrance & remembrance()
+      {
+        static Remembrance _remembrance;
+        return _remembrance;
+      }
+    } // namespace
+    ///////////////////////////////////////////////////////////////////
+
+    ///////////////////////////////////////////////////////////////////
+    // PoolSnapshot::Entry
+    ///////////////////////////////////////////////////////////////////
+
+    PoolSnapshot::Entry::Entry( Pathname solvfile_r, RepoInfo info_r )
+    : _alias( info_r.alias() )
+    , _solvfile( std::move(solvfile_r) )
+    , _info( std::move(info_r) )
+    {}
+
+    PoolSnapshot::Entry PoolSnapshot::Entry::systemRepo( Pathname solvfile_r )
+    {
+      Entry ret( std::move(solvfile_r), RepoInfo() );
+      ret._alias = Pool::systemRepoAlias();
+      return ret;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // PoolSnapshot
+    ///////////////////////////////////////////////////////////////////
+
+    const std::string PoolSnapshot::defaultFile( ".pool.snapshot" );	// repo aliases can't start with a dot
+
+    void PoolSnapshot::save( const Pathname & snapshot_r, const Entries & entries_r )
+    {
+      std::vector<Stamped> repos;
+      for ( const Entry & entry : entries_r )
+        repos.push_back( { &entry, stamp( entry ) } );
+      writeSnapshot( myPool(), snapshot_r, repos );
+    }
+
+    Repository PoolSnapshot::loadRepo( const Pathname & snapshot_r, const Entry & entry_r )
+    {
+      Pool satpool( Pool::instance() );
+      Repository repo( satpool.reposFind( entry_r._alias ) );
+      if ( repo && ! repo.solvablesEmpty() )
+        return Repository::noRepository;
+
+      const Opened & snapshot( openCached( snapshot_r ) );
+      if ( ! snapshot._fp )
+        return Repository::noRepository;
+
+      const std::string st( stamp( entry_r ) );
+      auto it = snapshot._index.find( st );
+      if ( st.empty() || it == snapshot._index.end() )
+      {
+        MIL << "Pool snapshot lacks an up to date " << entry_r._alias << endl;
+        return Repository::noRepository;
+      }
+
+      bool created = ! repo;
+      if ( created )
+        repo = satpool.reposInsert( entry_r._alias );
+      if ( ! addRepo( myPool(), snapshot._fp, it->second, repo, entry_r ) )
+      {
+        WAR << "Broken pool snapshot " << snapshot_r << " at repo " << entry_r._alias << endl;
+        if ( created )
+          repo.eraseFromPool();
+        return Repository::noRepository;
+      }
+
+      remembrance()._repos[snapshot_r][entry_r._alias] = Remembered{ entry_r, st, repo };
+      MIL << "Loaded " << entry_r._alias << " from pool snapshot " << snapshot_r << endl;
+      return repo;
+    }
+
+    void PoolSnapshot::remember( const Pathname & snapshot_r, const Entry & entry_r )
+    {
+      Repository repo( Pool::instance().reposFind( entry_r._alias ) );
+      if ( ! repo )
+        return;
+      remembrance()._repos[snapshot_r][entry_r._alias] = Remembered{ entry_r, stamp( entry_r ), repo };
+      remembrance()._outdated.insert( snapshot_r );
+    }
+
+    void PoolSnapshot::saveRemembered()
+    {
+      opened() = Opened();	// done loading
+
+      std::set<Pathname> outdated;
+      outdated.swap( remembrance()._outdated );	// saving prepares the pool again
+      for ( const Pathname & snapshot : outdated )
+      {
+        if ( ::access( snapshot.dirname().c_str(), W_OK ) != 0 )
+        {
+          DBG << "Not allowed to write pool snapshot " << snapshot << endl;
+          continue;
+        }
+
+        std::vector<Stamped> repos;
+        auto & remembered( remembrance()._repos[snapshot] );
+        for ( auto it = remembered.begin(); it != remembered.end(); )
+        {
+          // Forget repos erased from the pool or loaded in other ways since.
+          if ( Pool::instance().reposFind( it->first ) != it->second._repo || it->second._stamp.empty() )
+          {
+            it = remembered.erase( it );
+            continue;
+          }
+          repos.push_back( { &it->second._entry, it->second._stamp } );
+          ++it;
+        }
+
+        try
+        {
+          if ( repos.empty() )
+            filesystem::unlink( snapshot );
+          else
+            writeSnapshot( myPool(), snapshot, repos );
+        }
+        catch ( const Exception & excpt )
+        {
+          ZYPP_CAUGHT( excpt );
+          WAR << "Removing outdated pool snapshot " << snapshot << endl;
+          filesystem::unlink( snapshot );
+        }
+      }
+    }
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
@@ -0,0 +1,127 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/PoolSnapshot.h
+ */
+#ifndef ZYPP_SAT_POOLSNAPSHOT_H
+#define ZYPP_SAT_POOLSNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include <zypp-core/Globals.h>
+#include <zypp/Pathname.h>
+#include <zypp/RepoInfo.h>
+#include <zypp/Repository.h>
+#include <zypp/sat/detail/PoolMember.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    ///////////////////////////////////////////////////////////////////
+    /// \class PoolSnapshot
+    /// \brief Combined on-disk snapshot of the prepared pool for a fast startup.
+    ///
+    /// A single file holding all repos of the pool, written after the pool
+    /// was prepared. Each repo carries the file provides libsolv added to it,
+    /// so preparing the pool after loading the snapshot does not need to scan
+    /// the filelists again.
+    ///
+    /// Along with the repos, the snapshot remembers the solv file each repo
+    /// was loaded from and the repo cache cookie next to it. \ref loadRepo
+    /// checks them and the libsolv version and system architecture. On any
+    /// mismatch it leaves the pool untouched, so the caller falls back to
+    /// loading the solv file. The snapshot is opened and its index is read
+    /// once for all repos loaded from it.
+    ///
+    /// \ref RepoManager::loadFromCache and \ref Target::load use \ref loadRepo
+    /// with the \ref defaultFile in the solv cache. Repos loaded from their solv
+    /// file are \ref remember ed. When the ZYpp instance is released, after the
+    /// application is done with its repos and the target, \ref saveRemembered
+    /// rewrites the snapshot with all remembered repos still in the pool:
+    ///
+    /// \code
+    ///   sat::PoolSnapshot::Entry entry( solvCache/info.escaped_alias()/"solv", info );
+    ///   Repository repo( sat::PoolSnapshot::loadRepo( snapshot, entry ) );
+    ///   if ( ! repo )
+    ///   {
+    ///     repo = sat::Pool::instance().addRepoSolv( entry._solvfile, info );
+    ///     sat::PoolSnapshot::remember( snapshot, entry );
+    ///   }
+    ///   ...
+    ///   sat::PoolSnapshot::saveRemembered();
+    /// \endcode
+    ///
+    /// The repos are written as read from their solv file, so data added to
+    /// the repos in the pool after loading (like the lazy filelists) is not
+    /// kept in the snapshot. A snapshot is written to a temporary file which
+    /// is then renamed, so concurrent processes do not damage it.
+    ///
+    /// \note The repos are still parsed when loading, as libsolv is not able
+    /// to map a prepared pool from disk. The snapshot saves the filelist scan
+    /// when preparing the pool.
+    ///////////////////////////////////////////////////////////////////
+    class ZYPP_API PoolSnapshot : protected detail::PoolMember
+    {
+    public:
+      /** A repo in the snapshot and the solv file it is loaded from. */
+      struct ZYPP_API Entry
+      {
+        /** A repo described by \a info_r. */
+        Entry( Pathname solvfile_r, RepoInfo info_r );
+
+        /** The system repo. */
+        static Entry systemRepo( Pathname solvfile_r );
+
+        std::string _alias;
+        Pathname    _solvfile;
+        RepoInfo    _info;	///< empty for the system repo
+      };
+      using Entries = std::vector<Entry>;
+
+    public:
+      /** Name of the snapshot file kept in a solv cache directory. */
+      static const std::string defaultFile;
+
+      /** Write the repos \a entries_r of the pool to \a snapshot_r.
+       * The pool is prepared first. The repos must be in the pool. They
+       * are written as read from their solv files, the pool is not changed.
+       * \throws Exception if a repo is missing or the file can't be written.
+       */
+      static void save( const Pathname & snapshot_r, const Entries & entries_r );
+
+      /** Load the repo \a entry_r from \a snapshot_r into the pool.
+       * Returns \ref Repository::noRepository and leaves the pool untouched
+       * if the repo is already in the pool and not empty, or \a snapshot_r is
+       * missing, damaged or does not contain an up to date copy of the repo.
+       * A loaded repo is \ref remember ed.
+       */
+      static Repository loadRepo( const Pathname & snapshot_r, const Entry & entry_r );
+
+      /** Remember the repo \a entry_r just loaded from its solv file to be kept in \a snapshot_r.
+       * The next \ref saveRemembered rewrites \a snapshot_r with all the
+       * repos remembered for it and still in the pool.
+       */
+      static void remember( const Pathname & snapshot_r, const Entry & entry_r );
+
+      /** Rewrite the snapshots having new repos \ref remember ed.
+       * The pool is prepared first. Errors are logged, an outdated snapshot
+       * is removed. Snapshots in directories we may not write are skipped.
+       * Called by the library when the ZYpp instance is released.
+       */
+      static void saveRemembered();
+    };
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_SAT_POOLSNAPSHOT_H
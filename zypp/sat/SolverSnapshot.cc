@@ -0,0 +1,792 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/SolverSnapshot.cc
+ */
+extern "C"
+{
+#include <solv/pool.h>
+#include <solv/poolarch.h>
+#include <solv/repo.h>
+#include <solv/repo_solv.h>
+#include <solv/repo_write.h>
+#include <solv/solver.h>
+#include <solv/transaction.h>
+#include <solv/testcase.h>
+}
+#include <fnmatch.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <unordered_map>
+
+#define ZYPP_USE_RESOLVER_INTERNALS
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/String.h>
+#include <zypp/base/Exception.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/VendorAttr.h>
+#include <zypp/ZConfig.h>
+#include <zypp/ResPool.h>
+#include <zypp/Resolver.h>
+#include <zypp/SrcPackage.h>
+#include <zypp/ui/Selectable.h>
+#include <zypp/pool/ChangeJournal.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/Map.h>
+#include <zypp/sat/WhatProvides.h>
+#include <zypp/sat/detail/PoolImpl.h>
+#include <zypp/misc/LoadTestcase.h>
+#include <zypp/target/modalias/Modalias.h>
+#include <zypp/solver/detail/SATResolver.h>
+#include <zypp/solver/detail/SystemCheck.h>
+#include <zypp-core/zyppng/thread/ThreadPool>
+
+#include <zypp/sat/SolverSnapshot.h>
+
+using std::endl;
+
+#undef ZYPP_BASE_LOGGER_LOGGROUP
+#define ZYPP_BASE_LOGGER_LOGGROUP "zypp::solver"
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    namespace
+    {
+      /** A libsolv job with a solvable, dependency, repo or all solvables as selection. */
+      struct Job
+      {
+        enum What { SOLVABLE, DEP, REPO, ALL };
+
+        int            _how  = 0;
+        What           _what = ALL;
+        detail::IdType _id   = 0;	///< local solvable id or repo index
+        std::string    _dep;		///< testcase notation
+      };
+
+      /** A \ref SolverSnapshot::Request translated to the snapshot (built by the pool owning thread). */
+      struct PreparedRequest
+      {
+        std::vector<Job>                 _jobs;
+        solver::detail::SolverFlags      _flags;
+        std::optional<std::vector<bool>> _repos;	///< repos to consider (by index)
+        bool                             _relaxedVendor = false;
+        std::string                      _error;	///< can't be solved
+      };
+
+      /** Keep just the solvable data the solver looks at (the dependencies are
+       * complete as file provides were already added to the global pool).
+       */
+      int solverKeys( detail::CRepo * repo_r, ::Repokey * key_r, void * kfdata_r )
+      {
+        switch ( key_r->name )
+        {
+          case SOLVABLE_NAME:
+          case SOLVABLE_ARCH:
+          case SOLVABLE_EVR:
+          case SOLVABLE_VENDOR:
+          case SOLVABLE_PROVIDES:
+          case SOLVABLE_OBSOLETES:
+          case SOLVABLE_CONFLICTS:
+          case SOLVABLE_REQUIRES:
+          case SOLVABLE_RECOMMENDS:
+          case SOLVABLE_SUGGESTS:
+          case SOLVABLE_SUPPLEMENTS:
+          case SOLVABLE_ENHANCES:
+          case SOLVABLE_BUILDTIME:
+            return ::repo_write_stdkeyfilter( repo_r, key_r, kfdata_r );
+        }
+        return KEY_STORAGE_DROPPED;
+      }
+
+      /** Write \a repo_r to a memory buffer. */
+      std::string writeRepo( detail::CRepo * repo_r )
+      {
+        char * buf = nullptr;
+        size_t len = 0;
+        FILE * fp = ::open_memstream( &buf, &len );
+        if ( ! fp )
+          ZYPP_THROW( Exception( "Can't create solver snapshot buffer" ) );
+        int res = ::repo_write_filtered( repo_r, fp, &solverKeys, nullptr, nullptr );
+        if ( ::fclose( fp ) != 0 )	// flushes to buf
+          res = -1;
+        AutoDispose<char*> cleanup( buf, ::free );
+        if ( res != 0 )
+          ZYPP_THROW( Exception( "Can't write repo "+std::string(repo_r->name)+" to solver snapshot: "+std::string( ::pool_errstr( repo_r->pool ) ) ) );
+        return std::string( buf, len );
+      }
+    } // namespace
+
+    ///////////////////////////////////////////////////////////////////
+    /// \class SolverSnapshot::Impl
+    /// \brief The repos and solver settings copied from the global pool.
+    ///
+    /// The snapshot is immutable once taken. Each \ref Worker loads it into a
+    /// private pool. Solvables are loaded in the order they are written, so their
+    /// ids in a worker pool are the same in all workers and map to the global ids
+    /// via \ref _toGlobal and \ref _toLocal.
+    ///////////////////////////////////////////////////////////////////
+    class SolverSnapshot::Impl : protected detail::PoolMember
+    {
+    public:
+      struct RepoData
+      {
+        std::string    _alias;
+        int            _priority = 0;
+        int            _subpriority = 0;
+        bool           _system = false;
+        std::string    _solv;
+        detail::IdType _start = 0;	///< 1st local solvable id
+        detail::IdType _end = 0;	///< behind the last local solvable id
+      };
+
+    public:
+      Impl()
+      : _poolSerial( myPool().serial() )
+      {
+        myPool().prepare();
+        detail::CPool * pool { myPool().getPool() };
+
+        _arch = ZConfig::instance().systemArchitecture().asString();
+        _toGlobal.assign( 2, 0 );	// 0 and SYSTEMSOLVABLE are not in repos
+
+        int repoid = 0;
+        detail::CRepo * repo = nullptr;
+        FOR_REPOS( repoid, repo )
+        {
+          RepoData & data { _repos.emplace_back() };
+          data._alias       = repo->name;
+          data._priority    = repo->priority;
+          data._subpriority = repo->subpriority;
+          data._system      = ( repo == pool->installed );
+          data._solv        = writeRepo( repo );
+          data._start       = _toGlobal.size();
+          // repo_write_filtered writes the solvables of the repo in id order.
+          for ( detail::SolvableIdType id = repo->start; id < detail::SolvableIdType(repo->end); ++id )
+          {
+            if ( pool->solvables[id].repo == repo )
+            {
+              _toLocal[id] = _toGlobal.size();
+              _toGlobal.push_back( id );
+            }
+          }
+          data._end = _toGlobal.size();
+        }
+
+        for ( const Solvable & solv : myPool().multiversionList() )
+          _multiversion.push_back( _toLocal[solv.id()] );
+
+        for ( detail::IdType name : myPool().autoInstalled() )
+          _autoInstalled.push_back( ::pool_id2str( pool, name ) );
+
+        // The input of the namespace callback (see PoolImpl::nsCallback), so the
+        // workers can evaluate any namespace dependency, even ones created later.
+        for ( IdString locale : myPool().trackedLocaleIds().current() )
+          _languages.insert( locale.asString() );
+        for ( IdString locale : myPool().trackedLocaleIds().added() )
+          _addedLanguages.push_back( locale.asString() );
+        for ( IdString locale : myPool().trackedLocaleIds().removed() )
+          _removedLanguages.push_back( locale.asString() );
+        _modaliases = target::Modalias::instance().modaliasList();
+        _filesystems = myPool().requiredFilesystems();
+
+        // bsc#1203248: see SATResolver::solverInit
+        for ( const Solvable & solv : AllPTFs() )
+        {
+          if ( solv.isSystem() )
+            _installedPTFs.push_back( _toLocal[solv.id()] );
+        }
+
+        // Vendor equivalence as classes of vendor strings.
+        std::set<IdString> vendors;
+        for ( const Solvable & solv : Pool::instance().solvables() )
+          vendors.insert( solv.vendor() );
+        const VendorAttr & vendorAttr { VendorAttr::instance() };
+        vendorClasses( vendors, _vendorClass, [&vendorAttr]( IdString l, IdString r ) { return vendorAttr.equivalent( l, r ); } );
+        vendorClasses( vendors, _relaxedVendorClass, [&vendorAttr]( IdString l, IdString r ) { return vendorAttr.relaxedEquivalent( l, r ); } );
+        for ( const Solvable & solv : WhatProvides( Capability("dup-vendor-relax(suse)") ) )
+        {
+          if ( ! solv.isSystem() )
+          {
+            _dupVendorRelax = true;
+            break;
+          }
+        }
+
+        MIL << "Solver snapshot of " << _repos.size() << " repos, " << size() << " solvables" << endl;
+      }
+
+    public:
+      bool valid() const
+      { return _poolSerial.isClean( myPool().serial() ); }
+
+      size_t size() const
+      { return _toGlobal.size() - 2; }
+
+      /** Translate \a request_r to the snapshot. Must be called by the pool owning thread. */
+      PreparedRequest prepare( const Request & request_r ) const
+      {
+        PreparedRequest ret;
+        detail::CPool * pool { myPool().getPool() };
+
+        auto solvableJob = [&]( int how_r, const Solvable & solv_r ) {
+          auto it = _toLocal.find( solv_r.id() );
+          if ( it == _toLocal.end() || ! valid() )
+          {
+            ret._error = str::Str() << "Not in the solver snapshot: " << solv_r;
+            return;
+          }
+          ret._jobs.push_back( { how_r, Job::SOLVABLE, detail::IdType(it->second), std::string() } );
+        };
+        auto depJob = [&]( int how_r, const Capability & cap_r ) {
+          ret._jobs.push_back( { how_r, Job::DEP, 0, ::testcase_dep2str( pool, cap_r.id() ) } );
+        };
+        auto repoIndex = [this]( const std::string & alias_r ) {
+          for ( unsigned i = 0; i < _repos.size(); ++i )
+            if ( _repos[i]._alias == alias_r )
+              return int(i);
+          return -1;
+        };
+
+        const int maybeCleandeps = request_r._cleandepsOnRemove ? SOLVER_CLEANDEPS : 0;
+
+        // Jobs the SATResolver adds besides the ones derived from the request:
+        // see SATResolver::solverInit.
+        depJob( SOLVER_BLACKLIST|SOLVER_SOLVABLE_PROVIDES, Capability( Solvable::retractedToken.id() ) );
+        depJob( SOLVER_BLACKLIST|SOLVER_SOLVABLE_PROVIDES, Capability( Solvable::ptfMasterToken.id() ) );
+        for ( const std::string & locale : _addedLanguages )
+          depJob( SOLVER_INSTALL|SOLVER_SOLVABLE_PROVIDES, Capability( ResolverNamespace::language, IdString(locale) ) );
+        for ( const std::string & locale : _removedLanguages )
+          depJob( SOLVER_ERASE|SOLVER_SOLVABLE_PROVIDES|SOLVER_CLEANDEPS, Capability( ResolverNamespace::language, IdString(locale) ) );
+
+        if ( request_r._poolLocks && valid() )
+        {
+          // Items locked or kept by the user, as collected by SATCollectTransact.
+          static pool::ChangeJournal::Selection userStatus( []( const ResStatus & status_r ) {
+            return ! ( status_r.isBySolver() || status_r.isByApplLow() || status_r.transacts() );
+          } );
+          ResPool respool { ResPool::instance() };
+          const bool solveSrcPackages { respool.resolver().solveSrcPackages() };
+          std::set<IdString> unifiedByName;
+          for ( detail::SolvableIdType id : userStatus.ids() )
+          {
+            PoolItem pi { respool.find( Solvable(id) ) };
+            if ( ! pi || ( ! solveSrcPackages && pi.isKind<SrcPackage>() ) )
+              continue;
+            if ( pi.status().isLocked() )
+            {
+              auto it = _toLocal.find( id );
+              if ( it != _toLocal.end() )
+                ret._jobs.push_back( { pi.status().isInstalled() ? SOLVER_INSTALL|SOLVER_SOLVABLE : SOLVER_ERASE|SOLVER_SOLVABLE|maybeCleandeps,
+                                       Job::SOLVABLE, detail::IdType(it->second), std::string() } );
+            }
+            else if ( unifiedByName.insert( pi.ident() ).second && ! ui::Selectable::get( pi )->hasInstalledObj() )
+              ret._jobs.push_back( { SOLVER_ERASE|SOLVER_SOLVABLE_NAME|SOLVER_WEAK|maybeCleandeps, Job::DEP, 0, pi.ident().asString() } );
+          }
+        }
+
+        for ( const Solvable & solv : request_r._install )
+          solvableJob( SOLVER_INSTALL|SOLVER_SOLVABLE, solv );
+        for ( const Solvable & solv : request_r._remove )
+          solvableJob( SOLVER_ERASE|SOLVER_SOLVABLE|maybeCleandeps, solv );
+        for ( const Solvable & solv : request_r._lock )
+          solvableJob( SOLVER_LOCK|SOLVER_SOLVABLE, solv );
+        for ( const Capability & cap : request_r._addRequires )
+          depJob( SOLVER_INSTALL|SOLVER_SOLVABLE_PROVIDES, cap );
+        for ( const Capability & cap : request_r._addConflicts )
+          depJob( SOLVER_ERASE|SOLVER_SOLVABLE_PROVIDES, cap );
+        for ( const std::string & alias : request_r._upgradeRepos )
+        {
+          int idx = repoIndex( alias );
+          if ( idx < 0 )
+            ret._error = "Repo to upgrade from is not in the solver snapshot: "+alias;
+          else
+            ret._jobs.push_back( { SOLVER_DISTUPGRADE|SOLVER_SOLVABLE_REPO, Job::REPO, idx, std::string() } );
+        }
+        if ( request_r._distupgrade )
+        {
+          ret._jobs.push_back( { SOLVER_DISTUPGRADE|SOLVER_SOLVABLE_ALL, Job::ALL, 0, std::string() } );
+          // Lock the architecture of the running systems rpm package.
+          if ( ZConfig::instance().systemRoot() == "/" )
+          {
+            for ( const Solvable & solv : WhatProvides( Capability( "rpm" ) ) )
+            {
+              if ( solv.isSystem() && solv.ident() == IdString( "rpm" ) )
+                depJob( SOLVER_INSTALL|SOLVER_SOLVABLE_NAME|SOLVER_ESSENTIAL, Capability( solv.arch(), "rpm", Capability::PARSED ) );
+            }
+          }
+        }
+        if ( request_r._update )
+          ret._jobs.push_back( { SOLVER_UPDATE|SOLVER_SOLVABLE_ALL, Job::ALL, 0, std::string() } );
+        if ( request_r._verify )
+          ret._jobs.push_back( { SOLVER_VERIFY|SOLVER_SOLVABLE_ALL, Job::ALL, 0, std::string() } );
+
+        unsigned consideredRepos = _repos.size();
+        if ( request_r._repos )
+        {
+          ret._repos.emplace( _repos.size(), false );
+          consideredRepos = 0;
+          for ( unsigned i = 0; i < _repos.size(); ++i )
+          {
+            (*ret._repos)[i] = _repos[i]._system || request_r._repos->count( _repos[i]._alias );
+            if ( (*ret._repos)[i] )
+              ++consideredRepos;
+          }
+        }
+
+        // bsc#1203248: protect PTF removal if just the installed repo is present.
+        if ( consideredRepos == 1 )
+        {
+          for ( detail::SolvableIdType id : _installedPTFs )
+            ret._jobs.push_back( { SOLVER_INSTALL|SOLVER_SOLVABLE, Job::SOLVABLE, detail::IdType(id), std::string() } );
+        }
+
+        solver::detail::SolverFlags & flags { ret._flags };
+        flags.focus			= request_r._focus;
+        flags.ignorealreadyrecommended	= request_r._ignoreAlreadyRecommended;
+        flags.onlyRequires		= request_r._onlyRequires;
+        flags.allowuninstall		= request_r._forceResolve;
+        flags.allowdowngrade		= request_r._allowDowngrade;
+        flags.allownamechange		= request_r._allowNameChange;
+        flags.allowarchchange		= request_r._allowArchChange;
+        flags.allowvendorchange		= request_r._allowVendorChange;
+        flags.dup_allowdowngrade	= request_r._dupAllowDowngrade;
+        flags.dup_allownamechange	= request_r._dupAllowNameChange;
+        flags.dup_allowarchchange	= request_r._dupAllowArchChange;
+        flags.dup_allowvendorchange	= request_r._dupAllowVendorChange;
+        // bsc#1182629: see SATResolver::solverInit
+        ret._relaxedVendor = _dupVendorRelax && ( request_r._distupgrade || ! request_r._upgradeRepos.empty() );
+        return ret;
+      }
+
+    public:
+      std::string                      _arch;
+      std::vector<RepoData>            _repos;
+      std::vector<detail::SolvableIdType> _toGlobal;	///< local id -> global id
+      std::unordered_map<detail::SolvableIdType,detail::SolvableIdType> _toLocal;	///< global id -> local id
+      std::vector<detail::SolvableIdType> _multiversion;	///< local ids
+      std::vector<detail::SolvableIdType> _installedPTFs;	///< local ids
+      std::vector<std::string>         _autoInstalled;	///< names
+      std::set<std::string>            _languages;	///< requested locales incl. fallbacks
+      std::vector<std::string>         _addedLanguages;
+      std::vector<std::string>         _removedLanguages;
+      target::Modalias::ModaliasList   _modaliases;
+      std::set<std::string>            _filesystems;
+      std::unordered_map<std::string,unsigned> _vendorClass;
+      std::unordered_map<std::string,unsigned> _relaxedVendorClass;
+      bool                             _dupVendorRelax = false;
+      SerialNumberWatcher              _poolSerial;
+
+    private:
+      template <class TEquivalent>
+      static void vendorClasses( const std::set<IdString> & vendors_r, std::unordered_map<std::string,unsigned> & classes_r, TEquivalent equivalent_r )
+      {
+        std::vector<IdString> representatives;
+        for ( IdString vendor : vendors_r )
+        {
+          unsigned cls = 0;
+          while ( cls < representatives.size() && ! equivalent_r( vendor, representatives[cls] ) )
+            ++cls;
+          if ( cls == representatives.size() )
+            representatives.push_back( vendor );
+          classes_r[vendor.asString()] = cls;
+        }
+      }
+    };
+
+    namespace
+    {
+      ///////////////////////////////////////////////////////////////////
+      /// \class Worker
+      /// \brief A private libsolv pool loaded from a \ref SolverSnapshot::Impl.
+      ///
+      /// Must not use the global pool or anything depending on it, as it
+      /// runs in worker threads. Only the snapshot data are read.
+      ///////////////////////////////////////////////////////////////////
+      class Worker
+      {
+      public:
+        Worker( const SolverSnapshot::Impl & snapshot_r )
+        : _snapshot( snapshot_r )
+        , _pool( ::pool_create() )
+        {
+          ::pool_setdisttype( _pool, DISTTYPE_RPM );
+          ::pool_setdebugmask( _pool, 0 );
+          ::pool_setarch( _pool, _snapshot._arch.c_str() );
+          _pool->appdata = this;
+          _pool->nscallback = &nsCallback;
+          _pool->nscallbackdata = this;
+          ::pool_set_custom_vendorcheck( _pool, &vendorCheck );
+          try {
+            load();
+          }
+          catch ( ... ) {
+            ::pool_free( _pool );
+            throw;
+          }
+        }
+
+        Worker( const Worker & ) = delete;
+        Worker & operator=( const Worker & ) = delete;
+
+        ~Worker()
+        {
+          _pool->considered = nullptr;	// owned by _considered
+          ::pool_free( _pool );
+        }
+
+        void solve( const PreparedRequest & request_r, SolverSnapshot::Result & result_r )
+        {
+          if ( ! request_r._error.empty() )
+          {
+            result_r._problems.push_back( request_r._error );
+            return;
+          }
+
+          consider( request_r._repos );
+          _relaxedVendor = request_r._relaxedVendor;
+
+          Queue jobs;
+          for ( detail::SolvableIdType id : _snapshot._multiversion )
+          {
+            jobs.push( SOLVER_NOOBSOLETES|SOLVER_SOLVABLE );
+            jobs.push( id );
+          }
+          if ( ! _snapshot._autoInstalled.empty() )
+          {
+            Queue autoInstalled;
+            for ( const std::string & name : _snapshot._autoInstalled )
+              autoInstalled.push( ::pool_str2id( _pool, name.c_str(), 1 ) );
+            ::pool_add_userinstalled_jobs( _pool, autoInstalled, jobs, GET_USERINSTALLED_NAMES|GET_USERINSTALLED_INVERTED );
+          }
+          for ( const Job & job : request_r._jobs )
+          {
+            jobs.push( job._how );
+            switch ( job._what )
+            {
+              case Job::SOLVABLE: jobs.push( job._id ); break;
+              case Job::DEP:      jobs.push( ::testcase_str2dep( _pool, job._dep.c_str() ) ); break;
+              case Job::REPO:     jobs.push( _repos[job._id]->repoid ); break;
+              case Job::ALL:      jobs.push( 0 ); break;
+            }
+          }
+
+          AutoDispose<detail::CSolver*> solver( ::solver_create( _pool ), ::solver_free );
+          request_r._flags.apply( *solver.value() );
+
+          if ( int problems = ::solver_solve( solver, jobs ) )
+          {
+            for ( int problem = 1; problem <= problems; ++problem )
+              result_r._problems.push_back( ::solver_problem2str( solver, problem ) );
+            return;
+          }
+
+          AutoDispose<detail::CTransaction*> trans( ::solver_create_transaction( solver ), ::transaction_free );
+          const ::Queue & steps { trans.value()->steps };
+          for ( int i = 0; i < steps.count; ++i )
+          {
+            detail::SolvableIdType id = steps.elements[i];
+            detail::IdType global = _snapshot._toGlobal[id];
+            result_r._decisions.push( _pool->solvables[id].repo == _pool->installed ? -global : global );
+          }
+        }
+
+      private:
+        /** Load the repos of the snapshot. */
+        void load()
+        {
+          for ( const SolverSnapshot::Impl::RepoData & data : _snapshot._repos )
+          {
+            detail::CRepo * repo = ::repo_create( _pool, data._alias.c_str() );
+            repo->priority    = data._priority;
+            repo->subpriority = data._subpriority;
+            _repos.push_back( repo );
+
+            AutoDispose<FILE*> fp( ::fmemopen( const_cast<char*>( data._solv.data() ), data._solv.size(), "r" ), ::fclose );
+            if ( ! fp )
+            {
+              fp.resetDispose();
+              ZYPP_THROW( Exception( "Can't read solver snapshot of repo "+data._alias ) );
+            }
+            if ( ::repo_add_solv( repo, fp, 0 ) != 0 )
+              ZYPP_THROW( Exception( "Can't load solver snapshot of repo "+data._alias+": "+std::string( ::pool_errstr( _pool ) ) ) );
+            if ( repo->nsolvables && ( repo->start != data._start || repo->end != data._end ) )
+              ZYPP_THROW( Exception( "Unexpected solvable ids in solver snapshot of repo "+data._alias ) );
+            if ( data._system )
+              ::pool_set_installed( _pool, repo );
+          }
+        }
+
+        /** Adjust the considered map and (re)create the whatprovides index. */
+        void consider( const std::optional<std::vector<bool>> & repos_r )
+        {
+          if ( repos_r != _consideredRepos || ! _pool->whatprovides )
+          {
+            _consideredRepos = repos_r;
+            if ( repos_r )
+            {
+              _considered.grow( _pool->nsolvables );
+              _considered.clearAll();
+              for ( unsigned i = 0; i < _repos.size(); ++i )
+              {
+                if ( (*repos_r)[i] )
+                  for ( detail::IdType id = _repos[i]->start; id < _repos[i]->end; ++id )
+                    _considered.set( id );
+              }
+              _pool->considered = _considered;
+            }
+            else
+              _pool->considered = nullptr;
+            ::pool_createwhatprovides( _pool );
+          }
+        }
+
+        /** Like PoolImpl::nsCallback, but using the snapshot data. */
+        static detail::IdType nsCallback( detail::CPool * pool_r, void * data_r, detail::IdType lhs_r, detail::IdType rhs_r )
+        {
+          const SolverSnapshot::Impl & snapshot { reinterpret_cast<Worker*>( data_r )->_snapshot };
+          switch ( lhs_r )
+          {
+            case NAMESPACE_LANGUAGE:
+              return snapshot._languages.count( ::pool_id2str( pool_r, rhs_r ) ) ? 1 : 0;
+
+            case NAMESPACE_MODALIAS:
+            {
+              const std::string & modalias { str::hexdecode( ::pool_id2str( pool_r, rhs_r ) ) };
+              for ( const std::string & sysmodalias : snapshot._modaliases )
+              {
+                if ( ::fnmatch( modalias.c_str(), sysmodalias.c_str(), 0 ) == 0 )
+                  return 1;
+              }
+              return 0;
+            }
+
+            case NAMESPACE_FILESYSTEM:
+              return snapshot._filesystems.count( ::pool_id2str( pool_r, rhs_r ) ) ? 1 : 0;
+          }
+          return 0;
+        }
+
+        static int vendorCheck( detail::CPool * pool_r, detail::CSolvable * lhs_r, detail::CSolvable * rhs_r )
+        {
+          const Worker & self { *reinterpret_cast<Worker*>( pool_r->appdata ) };
+          const auto & classes { self._relaxedVendor ? self._snapshot._relaxedVendorClass : self._snapshot._vendorClass };
+          const std::string lhs { ::pool_id2str( pool_r, lhs_r->vendor ) };
+          const std::string rhs { ::pool_id2str( pool_r, rhs_r->vendor ) };
+          auto l = classes.find( lhs );
+          auto r = classes.find( rhs );
+          if ( l == classes.end() || r == classes.end() )
+            return lhs == rhs ? 0 : 1;
+          return l->second == r->second ? 0 : 1;
+        }
+
+      private:
+        const SolverSnapshot::Impl &     _snapshot;
+        detail::CPool *                  _pool;
+        std::vector<detail::CRepo*>      _repos;
+        Map                              _considered;
+        std::optional<std::vector<bool>> _consideredRepos;
+        bool                             _relaxedVendor = false;
+      };
+    } // namespace
+
+    ///////////////////////////////////////////////////////////////////
+    // SolverSnapshot::Request
+    ///////////////////////////////////////////////////////////////////
+
+    SolverSnapshot::Request::Request()
+    {
+      const Resolver & resolver { ResPool::instance().resolver() };
+      _focus			= resolver.focus();
+      _ignoreAlreadyRecommended	= resolver.ignoreAlreadyRecommended();
+      _onlyRequires		= resolver.onlyRequires();
+      _forceResolve		= resolver.forceResolve();
+      _cleandepsOnRemove	= resolver.cleandepsOnRemove();
+      _allowDowngrade		= resolver.allowDowngrade();
+      _allowNameChange		= resolver.allowNameChange();
+      _allowArchChange		= resolver.allowArchChange();
+      _allowVendorChange	= resolver.allowVendorChange();
+      _dupAllowDowngrade	= resolver.dupAllowDowngrade();
+      _dupAllowNameChange	= resolver.dupAllowNameChange();
+      _dupAllowArchChange	= resolver.dupAllowArchChange();
+      _dupAllowVendorChange	= resolver.dupAllowVendorChange();
+    }
+
+    SolverSnapshot::Request & SolverSnapshot::Request::addSystemCheck()
+    {
+      const SystemCheck & systemCheck { SystemCheck::instance() };
+      _addRequires.insert( systemCheck.requiredSystemCap().begin(), systemCheck.requiredSystemCap().end() );
+      _addConflicts.insert( systemCheck.conflictSystemCap().begin(), systemCheck.conflictSystemCap().end() );
+      return *this;
+    }
+
+    SolverSnapshot::Request SolverSnapshot::Request::fromTestcase( const misc::testcase::TestcaseTrial & trial_r, std::string name_r )
+    {
+      Request ret;
+      ret._name = std::move(name_r);
+
+      // The solvables matching the node properties (as written by the Testcase).
+      auto matching = []( const misc::testcase::TestcaseTrial::Node & node_r ) {
+        std::vector<Solvable> ret;
+        const IdString ident { Solvable::SplitIdent( ResKind( node_r.getProp( "kind", "package" ) ), node_r.getProp( "name" ) ).ident() };
+        const std::string & channel { node_r.getProp( "channel" ) };
+        const std::string & arch    { node_r.getProp( "arch" ) };
+        const std::string & version { node_r.getProp( "version" ) };
+        const std::string & release { node_r.getProp( "release" ) };
+        for ( const Solvable & solv : Pool::instance().solvables() )
+        {
+          if ( solv.ident() != ident )
+            continue;
+          if ( ! channel.empty() && solv.repository().alias() != channel )
+            continue;
+          if ( ! arch.empty() && solv.arch().asString() != arch )
+            continue;
+          if ( ! version.empty() && solv.edition().version() != version )
+            continue;
+          if ( ! release.empty() && solv.edition().release() != release )
+            continue;
+          ret.push_back( solv );
+        }
+        if ( ret.empty() )
+          ZYPP_THROW( Exception( "Testcase job "+node_r.name()+" "+ident.asString()+" is not in the pool" ) );
+        return ret;
+      };
+
+      for ( const misc::testcase::TestcaseTrial::Node & node : trial_r.nodes() )
+      {
+        const std::string & job { node.name() };
+        if ( job == "install" )
+        {
+          ret._install.push_back( matching( node ).front() );
+        }
+        else if ( job == "uninstall" )
+        {
+          for ( const Solvable & solv : matching( node ) )
+            if ( solv.isSystem() )
+              ret._remove.push_back( solv );
+        }
+        else if ( job == "lock" )
+        {
+          for ( const Solvable & solv : matching( node ) )
+            ret._lock.push_back( solv );
+        }
+        else if ( job == "addRequire" )
+          ret._addRequires.insert( Capability( node.getProp( "name" ) ) );
+        else if ( job == "addConflict" )
+          ret._addConflicts.insert( Capability( node.getProp( "name" ) ) );
+        else if ( job == "upgradeRepo" )
+          ret._upgradeRepos.push_back( node.getProp( "name" ) );
+        else if ( job == "distupgrade" )
+          ret._distupgrade = true;
+        else if ( job == "update" )
+          ret._update = true;
+        else if ( job == "verify" )
+          ret._verify = true;
+        else
+          DBG << "Ignore testcase job " << job << endl;
+      }
+      return ret;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // SolverSnapshot::Result
+    ///////////////////////////////////////////////////////////////////
+
+    Transaction SolverSnapshot::Result::transaction() const
+    {
+      if ( ! ok() || ! _poolSerial.isClean( Pool::instance().serial() ) )
+        return Transaction();
+      return Transaction( _decisions );
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // SolverSnapshot
+    ///////////////////////////////////////////////////////////////////
+
+    SolverSnapshot::SolverSnapshot()
+    : _pimpl( new Impl )
+    {}
+
+    SolverSnapshot::~SolverSnapshot()
+    {}
+
+    bool SolverSnapshot::valid() const
+    { return _pimpl->valid(); }
+
+    size_t SolverSnapshot::size() const
+    { return _pimpl->size(); }
+
+    std::vector<SolverSnapshot::Result> SolverSnapshot::solve( const std::vector<Request> & requests_r, size_t maxThreads_r ) const
+    {
+      std::vector<PreparedRequest> prepared;
+      std::vector<Result> results( requests_r.size() );
+      for ( size_t i = 0; i < requests_r.size(); ++i )
+      {
+        prepared.push_back( _pimpl->prepare( requests_r[i] ) );
+        results[i]._name = requests_r[i]._name;
+        results[i]._poolSerial = _pimpl->_poolSerial;
+      }
+      if ( requests_r.empty() )
+        return results;
+
+      MIL << "Solving " << requests_r.size() << " requests..." << endl;
+      {
+        zyppng::ThreadPool threads( maxThreads_r );
+        std::atomic<size_t> next { 0 };
+        const size_t workers = std::min( threads.maxThreads(), requests_r.size() );
+        for ( size_t w = 0; w < workers; ++w )
+        {
+          threads.submit( [this,&prepared,&results,&next]() {
+            std::optional<Worker> worker;
+            std::string error;
+            try {
+              worker.emplace( *_pimpl );
+            }
+            catch ( const Exception & excpt ) {
+              error = excpt.asUserString();
+            }
+            for ( size_t i = next++; i < prepared.size(); i = next++ )
+            {
+              if ( ! worker )
+              {
+                results[i]._problems.push_back( error );
+                continue;
+              }
+              try {
+                worker->solve( prepared[i], results[i] );
+              }
+              catch ( const std::exception & excpt ) {
+                results[i]._problems.push_back( excpt.what() );
+              }
+            }
+          } );
+        }
+      } // ~ThreadPool joins the workers
+      MIL << "Solved " << requests_r.size() << " requests." << endl;
+      return results;
+    }
+
+    SolverSnapshot::Result SolverSnapshot::solve( const Request & request_r ) const
+    {
+      Result result;
+      result._name = request_r._name;
+      result._poolSerial = _pimpl->_poolSerial;
+      Worker( *_pimpl ).solve( _pimpl->prepare( request_r ), result );
+      return result;
+    }
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
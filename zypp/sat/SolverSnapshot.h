@@ -0,0 +1,182 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/SolverSnapshot.h
+ */
+#ifndef ZYPP_SAT_SOLVERSNAPSHOT_H
+#define ZYPP_SAT_SOLVERSNAPSHOT_H
+
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <zypp-core/Globals.h>
+#include <zypp/base/PtrTypes.h>
+#include <zypp/base/SerialNumber.h>
+#include <zypp/Capability.h>
+#include <zypp/ResolverFocus.h>
+#include <zypp/sat/Solvable.h>
+#include <zypp/sat/Queue.h>
+#include <zypp/sat/Transaction.h>
+#include <zypp/sat/detail/PoolMember.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  namespace misc::testcase
+  {
+    struct TestcaseTrial;
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    ///////////////////////////////////////////////////////////////////
+    /// \class SolverSnapshot
+    /// \brief Read-only copy of the prepared pool to run what-if resolutions concurrently.
+    ///
+    /// The ctor takes a copy of all repos of the prepared \ref Pool (just the
+    /// data the solver needs) along with the settings the solver depends on:
+    /// system architecture, installed repo, multiversion and auto installed
+    /// packages, vendor equivalence, installed PTFs, the requested locales and
+    /// the modaliases and filesystems the namespace dependencies are evaluated with.
+    ///
+    /// Each request is solved like \ref Resolver::resolvePool would: with the same
+    /// solver flags, blacklisted retracted packages and PTFs and (unless disabled
+    /// in the \ref Request) the locks of the \ref PoolItem.
+    ///
+    /// \ref solve runs a batch of \ref Request on worker threads. Each thread
+    /// loads the snapshot into a private libsolv pool, so neither the global
+    /// \ref Pool nor any \ref ResStatus is touched while solving. The results refer
+    /// to the solvables of the global pool and a \ref Result::transaction can be
+    /// built as long as the pool content did not change.
+    ///
+    /// \code
+    ///   sat::SolverSnapshot snapshot;
+    ///   std::vector<sat::SolverSnapshot::Request> requests;
+    ///   for ( const PoolItem & patch : patches )
+    ///   {
+    ///     sat::SolverSnapshot::Request & req { requests.emplace_back() };
+    ///     req._name = patch.name();
+    ///     req._install.push_back( patch.satSolvable() );
+    ///   }
+    ///   for ( const sat::SolverSnapshot::Result & res : snapshot.solve( requests ) )
+    ///     MIL << res._name << ": " << ( res.ok() ? "installable" : res._problems.front() ) << endl;
+    /// \endcode
+    ///
+    /// \note Taking the snapshot and \ref solve must be called from the thread owning
+    /// the pool, like any other pool operation. The worker threads just use the copy.
+    ///////////////////////////////////////////////////////////////////
+    class ZYPP_API SolverSnapshot : protected detail::PoolMember
+    {
+    public:
+      /** A what-if job for the solver.
+       * Solvables refer to the global pool the snapshot was taken from.
+       */
+      struct ZYPP_API Request
+      {
+        Request();
+
+        std::string              _name;		///< Returned in the \ref Result
+        std::vector<Solvable>    _install;
+        std::vector<Solvable>    _remove;
+        std::vector<Solvable>    _lock;
+        CapabilitySet            _addRequires;
+        CapabilitySet            _addConflicts;
+        std::vector<std::string> _upgradeRepos;	///< Aliases of repos to dup from
+        bool                     _distupgrade = false;
+        bool                     _update = false;
+        bool                     _verify = false;
+        /** Consider just the repos with these aliases (besides the installed ones). */
+        std::optional<std::set<std::string>> _repos;
+
+        /** Also obey the locks of the \ref PoolItem (like the \ref Resolver). */
+        bool _poolLocks = true;
+
+        /** \name Solver settings.
+         * Defaults are the current settings of the pools \ref Resolver.
+         */
+        //@{
+        ResolverFocus _focus;
+        bool _ignoreAlreadyRecommended;
+        bool _onlyRequires;
+        bool _forceResolve;
+        bool _cleandepsOnRemove;
+        bool _allowDowngrade;
+        bool _allowNameChange;
+        bool _allowArchChange;
+        bool _allowVendorChange;
+        bool _dupAllowDowngrade;
+        bool _dupAllowNameChange;
+        bool _dupAllowArchChange;
+        bool _dupAllowVendorChange;
+        //@}
+
+        /** Add the system requirements and conflicts of the \c SystemCheck. */
+        Request & addSystemCheck();
+
+        /** The jobs of a testcase trial.
+         * Supported are \c install, \c uninstall and \c lock (matched against the pool
+         * by kind, name, channel, arch, version and release if given), \c addRequire,
+         * \c addConflict, \c upgradeRepo, \c distupgrade, \c update and \c verify.
+         * \throws Exception if an item is not in the pool.
+         */
+        static Request fromTestcase( const misc::testcase::TestcaseTrial & trial_r, std::string name_r = std::string() );
+      };
+
+      /** The solver outcome of a \ref Request. */
+      struct ZYPP_API Result
+      {
+        /** Whether the request is solvable. */
+        bool ok() const
+        { return _problems.empty(); }
+
+        /** The transaction in the global pool (empty if the pool content changed). */
+        Transaction transaction() const;
+
+        std::string              _name;		///< The \ref Request::_name
+        std::vector<std::string> _problems;	///< The solver problems
+        Queue                    _decisions;	///< Solvables to install, negated for the installed ones to delete
+        SerialNumberWatcher      _poolSerial;	///< The pool content the ids refer to
+      };
+
+    public:
+      /** Take a snapshot of the global pool. The pool is prepared first. */
+      SolverSnapshot();
+
+      ~SolverSnapshot();
+
+      /** Whether the pool content is still the one the snapshot was taken from.
+       * Solving is still possible if not, but the \ref Request must not
+       * refer to new solvables and results can't be turned into a \ref Transaction.
+       */
+      bool valid() const;
+
+      /** The number of solvables in the snapshot. */
+      size_t size() const;
+
+      /** Solve \a requests_r using up to \a maxThreads_r threads (0: one per core).
+       * \return the results in order of the requests.
+       */
+      std::vector<Result> solve( const std::vector<Request> & requests_r, size_t maxThreads_r = 0 ) const;
+
+      /** Solve a single \a request_r in the calling thread. */
+      Result solve( const Request & request_r ) const;
+
+    public:
+      class Impl;
+    private:
+      RW_pointer<Impl> _pimpl;
+    };
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_SAT_SOLVERSNAPSHOT_H
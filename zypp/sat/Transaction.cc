@@ -26,6 +26,7 @@ extern "C"
 #include <zypp/sat/Queue.h>
 #include <zypp/sat/Map.h>
 #include <zypp/ResPool.h>
+#include <zypp/pool/ChangeJournal.h>
 
 using std::endl;
 
@@ -81,14 +82,10 @@ namespace zypp
         Impl &operator=(const Impl &) = delete;
         Impl &operator=(Impl &&) = delete;
 
-        Impl(LoadFromPoolType) : _watcher(myPool().serial()), _trans(nullptr) {
-          Queue decisionq;
-          for ( const PoolItem & pi : ResPool::instance() )
-          {
-            if ( ! pi.status().transacts() )
-              continue;
-            decisionq.push( pi.isSystem() ? -pi.id() : pi.id() );
-          }
+        Impl(LoadFromPoolType) : Impl( transactingItems() )
+        {}
+
+        Impl( const Queue & decisionq ) : _watcher(myPool().serial()), _trans(nullptr) {
           Queue noobsq;
           for ( const Solvable & solv : myPool().multiversionList() )
           {
@@ -131,6 +128,23 @@ namespace zypp
         ~Impl()
         { ::transaction_free( _trans ); }
 
+      private:
+        /** The decisions of all transacting items in the pool (negated for @System). */
+        static Queue transactingItems()
+        {
+          // Just the items touched since the last transaction are inspected, not the whole pool.
+          static pool::ChangeJournal::Selection transacting( []( const ResStatus & status_r ) {
+            return status_r.transacts();
+          } );
+          Queue decisionq;
+          for ( detail::SolvableIdType id : transacting.ids() )
+          {
+            sat::Solvable solv( id );
+            decisionq.push( solv.isSystem() ? -solv.id() : solv.id() );
+          }
+          return decisionq;
+        }
+
       public:
         bool valid() const
         { return _watcher.isClean( myPool().serial() ); }
@@ -321,6 +335,10 @@ namespace zypp
       : _pimpl( new Impl( loadFromPool ) )
     {}
 
+    Transaction::Transaction( const Queue & decisions_r )
+      : _pimpl( new Impl( decisions_r ) )
+    {}
+
     Transaction::~Transaction()
     {}
 
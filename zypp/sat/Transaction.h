@@ -88,6 +88,12 @@ namespace zypp
         /** Ctor loading the default pools transaction. */
         Transaction( LoadFromPoolType );
 
+        /** Ctor building the transaction from solver decisions: the ids of the
+         * solvables to install, negated for the installed ones to delete.
+         * \see \ref SolverSnapshot::Result
+         */
+        explicit Transaction( const Queue & decisions_r );
+
         /** Dtor */
         ~Transaction();
 
@@ -0,0 +1,554 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/TrigramIndex.cc
+ */
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include <zypp/base/LogTools.h>
+#include <zypp/base/StrMatcher.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/PathInfo.h>
+#include <zypp/TmpPath.h>
+#include <zypp/Repository.h>
+
+#include <zypp/sat/detail/PoolImpl.h>
+#include <zypp/sat/TrigramIndex.h>
+
+#undef ZYPP_BASE_LOGGER_LOGGROUP
+#define ZYPP_BASE_LOGGER_LOGGROUP "trigrams"
+
+using std::endl;
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    namespace
+    {
+      constexpr char magic[8] = { 'Z', 'Y', 'P', 'P', 'T', 'R', 'I', '1' };
+
+      /** The file header. Host byte order, it's a local cache. */
+      struct Header
+      {
+        char     _magic[8];
+        uint64_t _solvSize;	///< of the solv file the index was built from
+        int64_t  _solvMtime;	///< of the solv file the index was built from
+        uint32_t _size;		///< number of solvables in the solv file
+        uint32_t _npostings;
+        uint64_t _datasize;
+      };
+
+      /** Header data of the current \a solvfile_r. */
+      Header solvHeader( const Pathname & solvfile_r )
+      {
+        PathInfo pi( solvfile_r );
+        Header ret;
+        ::memcpy( ret._magic, magic, sizeof(magic) );
+        ret._solvSize  = pi.size();
+        ret._solvMtime = pi.mtime();
+        ret._size      = 0;
+        ret._npostings = 0;
+        ret._datasize  = 0;
+        return ret;
+      }
+
+      /** Whether \a header_r was written for the current \a solvfile_r. */
+      bool headerMatches( const Header & header_r, const Pathname & solvfile_r )
+      {
+        Header solv { solvHeader( solvfile_r ) };
+        return ::memcmp( header_r._magic, magic, sizeof(magic) ) == 0
+            && header_r._solvSize  == solv._solvSize
+            && header_r._solvMtime == solv._solvMtime;
+      }
+
+      inline uint32_t fold( char ch_r )
+      {
+        unsigned char ch = ch_r;
+        return ( 'A' <= ch && ch <= 'Z' ) ? ch + ( 'a' - 'A' ) : ch;
+      }
+
+      inline uint32_t trigram( const char * p_r )
+      { return fold( p_r[0] ) << 16 | fold( p_r[1] ) << 8 | fold( p_r[2] ); }
+
+      /** Append the trigrams of \a str_r to \a trigrams_r. */
+      void addTrigrams( const char * str_r, std::vector<uint32_t> & trigrams_r )
+      {
+        if ( ! str_r )
+          return;
+        size_t len = ::strlen( str_r );
+        for ( size_t i = 0; i + 3 <= len; ++i )
+          trigrams_r.push_back( trigram( str_r + i ) );
+      }
+
+      inline void putVarint( std::string & data_r, uint32_t val_r )
+      {
+        while ( val_r >= 0x80 )
+        {
+          data_r.push_back( char( val_r | 0x80 ) );
+          val_r >>= 7;
+        }
+        data_r.push_back( char( val_r ) );
+      }
+
+      /** Whether the \a count_r ordinals at \a offset_r decode within \a data_r
+       * to ascending ordinals below \a size_r.
+       */
+      bool validOrdinals( uint64_t offset_r, uint32_t count_r, const std::string & data_r, uint32_t size_r )
+      {
+        if ( offset_r > data_r.size() || count_r > data_r.size() - offset_r )
+          return false;	// each ordinal takes at least one byte
+        std::string::size_type pos = offset_r;
+        uint64_t ord = 0;
+        for ( uint32_t i = 0; i < count_r; ++i )
+        {
+          uint64_t delta = 0;
+          for ( unsigned shift = 0; ; shift += 7 )
+          {
+            if ( pos == data_r.size() || shift > 28 )
+              return false;
+            unsigned char ch = data_r[pos++];
+            delta |= uint64_t( ch & 0x7f ) << shift;
+            if ( ! ( ch & 0x80 ) )
+              break;
+          }
+          if ( i && ! delta )
+            return false;
+          ord += delta;
+          if ( ord >= size_r )
+            return false;
+        }
+        return true;
+      }
+
+      inline uint32_t getVarint( const char *& p_r )
+      {
+        uint32_t ret = 0;
+        for ( unsigned shift = 0; ; shift += 7 )
+        {
+          unsigned char ch = *p_r++;
+          ret |= uint32_t( ch & 0x7f ) << shift;
+          if ( ! ( ch & 0x80 ) )
+            break;
+        }
+        return ret;
+      }
+
+      /** Position of the ']' closing the bracket expression starting at \a pos_r.
+       * \c npos if it's not closed or contains a '[' (POSIX classes like
+       * <tt>[[:alpha:]]</tt> or collating elements, which are not parsed).
+       * A leading ']' (after an optional \a negate_r char) is literal.
+       */
+      std::string::size_type bracketEnd( const std::string & str_r, std::string::size_type pos_r, const char * negate_r )
+      {
+        std::string::size_type i = pos_r + 1;
+        if ( i < str_r.size() && ::strchr( negate_r, str_r[i] ) )
+          ++i;
+        if ( i < str_r.size() && str_r[i] == ']' )
+          ++i;
+        for ( ; i < str_r.size(); ++i )
+        {
+          if ( str_r[i] == ']' )
+            return i;
+          if ( str_r[i] == '[' )
+            return std::string::npos;
+        }
+        return std::string::npos;
+      }
+
+      /** Literals of a glob; \c false if it contains escapes. */
+      bool globLiterals( const std::string & glob_r, std::vector<std::string> & literals_r )
+      {
+        std::string run;
+        for ( std::string::size_type i = 0; i < glob_r.size(); ++i )
+        {
+          char ch = glob_r[i];
+          switch ( ch )
+          {
+            case '\\':
+              return false;
+
+            case '[':
+              i = bracketEnd( glob_r, i, "!^" );
+              if ( i == std::string::npos )
+                return false;
+              // fall through
+            case '*':
+            case '?':
+              literals_r.push_back( std::move(run) );
+              run.clear();
+              break;
+
+            default:
+              run += ch;
+              break;
+          }
+        }
+        literals_r.push_back( std::move(run) );
+        return true;
+      }
+
+      /** Literals of an extended regex; \c false if it's not a plain sequence
+       * of literals, bracket expressions and quantified atoms.
+       */
+      bool regexLiterals( const std::string & regex_r, std::vector<std::string> & literals_r )
+      {
+        std::string run;
+        for ( std::string::size_type i = 0; i < regex_r.size(); ++i )
+        {
+          char ch = regex_r[i];
+          switch ( ch )
+          {
+            case '\\':
+            case '|':
+            case '(':
+            case ')':
+            case '{':
+            case '}':
+              return false;
+
+            case '?':
+            case '*':
+              // the preceding atom is optional; if it's a multibyte char, stop
+              // the literal before its first byte
+              if ( ! run.empty() && ( run.back() & 0x80 ) )
+              {
+                while ( ! run.empty() && ( run.back() & 0x80 ) )
+                  run.pop_back();
+              }
+              else if ( ! run.empty() )
+                run.pop_back();
+              literals_r.push_back( std::move(run) );
+              run.clear();
+              break;
+
+            case '[':
+              i = bracketEnd( regex_r, i, "^" );
+              if ( i == std::string::npos )
+                return false;
+              // fall through
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+              literals_r.push_back( std::move(run) );
+              run.clear();
+              break;
+
+            default:
+              run += ch;
+              break;
+          }
+        }
+        literals_r.push_back( std::move(run) );
+        return true;
+      }
+    } // namespace
+
+    ///////////////////////////////////////////////////////////////////
+    // TrigramIndex
+    ///////////////////////////////////////////////////////////////////
+
+    bool TrigramIndex::indexes( const SolvAttr & attr_r )
+    {
+      return attr_r == SolvAttr::summary
+          || attr_r == SolvAttr::description
+          || attr_r == SolvAttr::dep_provides;
+    }
+
+    bool TrigramIndex::requiredLiterals( const StrMatcher & matcher_r, std::vector<std::string> & literals_r )
+    {
+      const std::string & search( matcher_r.searchstring() );
+      if ( search.empty() )
+        return false;	// matches always
+
+      std::vector<std::string> literals;
+      switch ( matcher_r.flags().mode() )
+      {
+        case Match::STRING:
+        case Match::STRINGSTART:
+        case Match::STRINGEND:
+        case Match::SUBSTRING:
+          literals.push_back( search );
+          break;
+
+        case Match::GLOB:
+          if ( ! globLiterals( search, literals ) )
+            return false;
+          break;
+
+        case Match::REGEX:
+          if ( ! regexLiterals( search, literals ) )
+            return false;
+          break;
+
+        default:
+          return false;
+      }
+
+      for ( std::string & literal : literals )
+      {
+        if ( ! literal.empty() )
+          literals_r.push_back( std::move(literal) );
+      }
+      return true;
+    }
+
+    bool TrigramIndex::upToDate( const Pathname & solvfile_r )
+    {
+      std::ifstream file( indexFile( solvfile_r ).c_str(), std::ios::binary );
+      Header header;
+      return file.read( reinterpret_cast<char*>(&header), sizeof(header) ) && headerMatches( header, solvfile_r );
+    }
+
+    void TrigramIndex::write( const Pathname & solvfile_r, detail::CRepo * repo_r )
+    {
+      detail::CPool * pool = repo_r->pool;
+
+      // The ordinal of a solvable is its position in the solv file.
+      std::vector<int> ordinal( repo_r->end - repo_r->start, -1 );
+      unsigned size = 0;
+      {
+        int id = 0;
+        detail::CSolvable * solv = nullptr;
+        FOR_REPO_SOLVABLES( repo_r, id, solv )
+          ordinal[id - repo_r->start] = size++;
+      }
+
+      std::vector<std::vector<uint32_t>> trigrams( size );
+      for ( detail::IdType key : { SOLVABLE_SUMMARY, SOLVABLE_DESCRIPTION, SOLVABLE_PROVIDES, SOLVABLE_FILELIST } )
+      {
+        ::Dataiterator di;
+        ::dataiterator_init( &di, pool, repo_r, 0, key, 0, 0 );
+        while ( ::dataiterator_step( &di ) )
+        {
+          if ( di.solvid < repo_r->start || di.solvid >= repo_r->end || ordinal[di.solvid - repo_r->start] < 0 )
+            continue;
+          std::vector<uint32_t> & solvtrigrams( trigrams[ordinal[di.solvid - repo_r->start]] );
+          switch ( key )
+          {
+            case SOLVABLE_PROVIDES:
+              addTrigrams( ::pool_dep2str( pool, di.kv.id ), solvtrigrams );
+              break;
+            case SOLVABLE_FILELIST:
+              addTrigrams( ::repodata_dir2str( di.data, di.kv.id, di.kv.str ), solvtrigrams );
+              break;
+            default:
+              addTrigrams( di.kv.str, solvtrigrams );
+              break;
+          }
+        }
+        ::dataiterator_free( &di );
+      }
+
+      std::map<uint32_t,std::vector<uint32_t>> postings;
+      for ( uint32_t ord = 0; ord < size; ++ord )
+      {
+        std::vector<uint32_t> & solvtrigrams( trigrams[ord] );
+        std::sort( solvtrigrams.begin(), solvtrigrams.end() );
+        solvtrigrams.erase( std::unique( solvtrigrams.begin(), solvtrigrams.end() ), solvtrigrams.end() );
+        for ( uint32_t tri : solvtrigrams )
+          postings[tri].push_back( ord );
+        std::vector<uint32_t>().swap( solvtrigrams );
+      }
+
+      std::vector<Posting> table;
+      table.reserve( postings.size() );
+      std::string data;
+      for ( const auto & el : postings )
+      {
+        table.push_back( Posting{ el.first, uint32_t(el.second.size()), data.size() } );
+        uint32_t last = 0;
+        for ( uint32_t ord : el.second )
+        {
+          putVarint( data, ord - last );
+          last = ord;
+        }
+      }
+
+      Header header { solvHeader( solvfile_r ) };
+      header._size      = size;
+      header._npostings = table.size();
+      header._datasize  = data.size();
+
+      // Write to a temp file first, so readers never see a partial index.
+      // Concurrent writers each use their own file, the last rename wins.
+      filesystem::TmpFile tmpfile( filesystem::TmpFile::makeSibling( indexFile( solvfile_r ), 0644 ) );
+      if ( tmpfile.path().empty() )
+      {
+        ERR << "Can't create a temp file for " << indexFile( solvfile_r ) << endl;
+        return;
+      }
+      {
+        std::ofstream file( tmpfile.path().c_str(), std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast<const char*>(&header), sizeof(header) );
+        file.write( reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Posting) );
+        file.write( data.data(), data.size() );
+        if ( ! file.flush() )
+        {
+          ERR << "Can't write " << tmpfile.path() << endl;
+          return;
+        }
+      }
+      if ( filesystem::rename( tmpfile.path(), indexFile( solvfile_r ) ) != 0 )
+      {
+        ERR << "Can't create " << indexFile( solvfile_r ) << endl;
+        return;
+      }
+      MIL << "Indexed " << size << " solvables: " << table.size() << " trigrams, " << data.size() << " bytes" << endl;
+    }
+
+    void TrigramIndex::write( const Pathname & solvfile_r )
+    {
+      AutoDispose<FILE*> solv( ::fopen( solvfile_r.c_str(), "re" ), ::fclose );
+      if ( solv == NULL )
+      {
+        solv.resetDispose();
+        ERR << "Can't open solv-file: " << solvfile_r << endl;
+        return;
+      }
+
+      detail::CPool * pool = ::pool_create();
+      detail::CRepo * repo = ::repo_create( pool, "" );
+      if ( ::repo_add_solv( repo, solv, 0 ) == 0 )
+        write( solvfile_r, repo );
+      else
+        ERR << "Can't read solv-file: " << ::pool_errstr( pool ) << endl;
+      ::repo_free( repo, 0 );
+      ::pool_free( pool );
+    }
+
+    shared_ptr<const TrigramIndex> TrigramIndex::read( const Pathname & solvfile_r, detail::SolvableIdType first_r )
+    {
+      std::ifstream file( indexFile( solvfile_r ).c_str(), std::ios::binary );
+      if ( ! file )
+        return nullptr;
+
+      Header header;
+      if ( ! file.read( reinterpret_cast<char*>(&header), sizeof(header) ) || ! headerMatches( header, solvfile_r ) )
+      {
+        WAR << "Ignore outdated " << indexFile( solvfile_r ) << endl;
+        return nullptr;
+      }
+
+      // Don't trust the sizes in the header before checking them against the file.
+      uint64_t filesize = PathInfo( indexFile( solvfile_r ) ).size();
+      if ( header._datasize > filesize
+           || sizeof(header) + uint64_t(header._npostings) * sizeof(Posting) + header._datasize != filesize )
+      {
+        WAR << "Ignore corrupt " << indexFile( solvfile_r ) << ": bad size" << endl;
+        return nullptr;
+      }
+
+      shared_ptr<TrigramIndex> ret { new TrigramIndex };
+      ret->_first = first_r;
+      ret->_size  = header._size;
+      ret->_postings.resize( header._npostings );
+      ret->_data.resize( header._datasize );
+      file.read( reinterpret_cast<char*>(ret->_postings.data()), ret->_postings.size() * sizeof(Posting) );
+      file.read( ret->_data.data(), ret->_data.size() );
+      if ( ! file )
+      {
+        WAR << "Can't read " << indexFile( solvfile_r ) << endl;
+        return nullptr;
+      }
+      for ( uint32_t i = 0; i < header._npostings; ++i )
+      {
+        const Posting & posting { ret->_postings[i] };
+        if ( ( i && posting._trigram <= ret->_postings[i-1]._trigram ) || ! validOrdinals( posting._offset, posting._count, ret->_data, ret->_size ) )
+        {
+          WAR << "Ignore corrupt " << indexFile( solvfile_r ) << ": bad posting " << i << endl;
+          return nullptr;
+        }
+      }
+      DBG << "Read " << indexFile( solvfile_r ) << ": " << ret->_size << " solvables" << endl;
+      return ret;
+    }
+
+    shared_ptr<const TrigramIndex> TrigramIndex::forRepo( const Repository & repo_r )
+    { return repo_r ? detail::PoolMember::myPool().searchIndex( repo_r.id() ) : nullptr; }
+
+    void TrigramIndex::ordinals( const Posting & posting_r, std::vector<uint32_t> & ordinals_r ) const
+    {
+      ordinals_r.clear();
+      ordinals_r.reserve( posting_r._count );
+      const char * p = _data.data() + posting_r._offset;
+      uint32_t ord = 0;
+      for ( uint32_t i = 0; i < posting_r._count; ++i )
+      {
+        ord += getVarint( p );
+        ordinals_r.push_back( ord );
+      }
+    }
+
+    bool TrigramIndex::candidates( const StrMatcher & matcher_r, std::vector<detail::SolvableIdType> & ids_r ) const
+    {
+      std::vector<std::string> literals;
+      if ( ! requiredLiterals( matcher_r, literals ) )
+        return false;
+
+      // Case insensitive matching may fold non-ASCII chars in some locales,
+      // we index them as they are. So look at the pure ASCII trigrams only.
+      const bool nocase = matcher_r.flags().test( Match::NOCASE );
+      std::vector<uint32_t> trigrams;
+      for ( const std::string & literal : literals )
+      {
+        for ( std::string::size_type i = 0; i + 3 <= literal.size(); ++i )
+        {
+          if ( nocase && ( ( literal[i] | literal[i+1] | literal[i+2] ) & 0x80 ) )
+            continue;
+          trigrams.push_back( trigram( literal.c_str() + i ) );
+        }
+      }
+      if ( trigrams.empty() )
+        return false;
+      std::sort( trigrams.begin(), trigrams.end() );
+      trigrams.erase( std::unique( trigrams.begin(), trigrams.end() ), trigrams.end() );
+
+      // Intersect the postings, shortest first.
+      std::vector<const Posting *> postings;
+      for ( uint32_t tri : trigrams )
+      {
+        auto it = std::lower_bound( _postings.begin(), _postings.end(), tri,
+                                    []( const Posting & lhs, uint32_t rhs ) { return lhs._trigram < rhs; } );
+        if ( it == _postings.end() || it->_trigram != tri )
+          return true;	// no solvable contains it
+        postings.push_back( &*it );
+      }
+      std::sort( postings.begin(), postings.end(),
+                 []( const Posting * lhs, const Posting * rhs ) { return lhs->_count < rhs->_count; } );
+
+      std::vector<uint32_t> result;
+      ordinals( *postings.front(), result );
+      std::vector<uint32_t> next;
+      std::vector<uint32_t> tmp;
+      for ( auto it = std::next( postings.begin() ); it != postings.end() && ! result.empty(); ++it )
+      {
+        ordinals( **it, next );
+        tmp.clear();
+        std::set_intersection( result.begin(), result.end(), next.begin(), next.end(), std::back_inserter( tmp ) );
+        result.swap( tmp );
+      }
+
+      ids_r.reserve( ids_r.size() + result.size() );
+      for ( uint32_t ord : result )
+        ids_r.push_back( _first + ord );
+      return true;
+    }
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
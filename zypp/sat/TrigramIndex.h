@@ -0,0 +1,123 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file	zypp/sat/TrigramIndex.h
+ */
+#ifndef ZYPP_SAT_TRIGRAMINDEX_H
+#define ZYPP_SAT_TRIGRAMINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <zypp-core/Globals.h>
+#include <zypp/base/PtrTypes.h>
+#include <zypp/Pathname.h>
+#include <zypp/sat/detail/PoolMember.h>
+#include <zypp/sat/SolvAttr.h>
+
+///////////////////////////////////////////////////////////////////
+namespace zypp
+{
+  class StrMatcher;
+  class Repository;
+
+  ///////////////////////////////////////////////////////////////////
+  namespace sat
+  {
+    ///////////////////////////////////////////////////////////////////
+    /// \class TrigramIndex
+    /// \brief Persistent trigram index of the searchable strings in a solv file.
+    ///
+    /// If \ref ZConfig::repoSearchIndex is enabled, the index is written next to
+    /// the repos solv file when the cache is built, and attached to the \ref Repository
+    /// when the solv file is loaded. \ref PoolQuery then uses it to preselect the
+    /// solvables which may match, before running the real matcher on them.
+    ///
+    /// The index maps each trigram (3 bytes, ASCII letters folded to lowercase) found
+    /// in the summary, description, provides or filelist of a solvable to the solvables
+    /// containing it. The filelist is indexed because \c pool_addfileprovides turns
+    /// files into provides. A string can only be matched by a \ref StrMatcher if it
+    /// contains all trigrams of the \ref requiredLiterals, so the candidates are a
+    /// superset of the matches.
+    ///
+    /// The index is dropped if the repo content changes after loading (e.g. if the
+    /// lazy filelists are added). A stale index file (solv file changed) is ignored.
+    ///////////////////////////////////////////////////////////////////
+    class ZYPP_API TrigramIndex
+    {
+    public:
+      /** Whether \a attr_r is covered by the index. */
+      static bool indexes( const SolvAttr & attr_r );
+
+      /** The literal strings a value must contain to be matched by \a matcher_r.
+       * Supported are the string, substring and glob modes and regular expressions
+       * without alternations, groups, intervals and escapes.
+       * \return \c false if the matcher can't be reduced to literals.
+       */
+      static bool requiredLiterals( const StrMatcher & matcher_r, std::vector<std::string> & literals_r );
+
+      /** The file the index of \a solvfile_r is stored in. */
+      static Pathname indexFile( const Pathname & solvfile_r )
+      { return solvfile_r.extend( ".trigrams" ); }
+
+      /** Whether the index of \a solvfile_r exists and was built from this solv file. */
+      static bool upToDate( const Pathname & solvfile_r );
+
+      /** Write the index of \a repo_r which was just written to \a solvfile_r. */
+      static void write( const Pathname & solvfile_r, detail::CRepo * repo_r );
+
+      /** \overload Loading \a solvfile_r into a temporary pool (e.g. to add a missing index). */
+      static void write( const Pathname & solvfile_r );
+
+      /** Read the index of \a solvfile_r whose solvables were loaded starting at id \a first_r.
+       * \return \c nullptr if there is no up to date index or it is corrupt.
+       */
+      static shared_ptr<const TrigramIndex> read( const Pathname & solvfile_r, detail::SolvableIdType first_r );
+
+      /** The index attached to \a repo_r (or \c nullptr). */
+      static shared_ptr<const TrigramIndex> forRepo( const Repository & repo_r );
+
+    public:
+      /** The number of solvables in the solv file. */
+      unsigned size() const
+      { return _size; }
+
+      /** Append the ids of the solvables which may contain a value matched by
+       * \a matcher_r to \a ids_r (ascending). Solvables dropped on load (e.g.
+       * due to an incompatible arch) may be included.
+       * \return \c false if the index can't tell (e.g. search strings shorter than 3
+       * bytes). All solvables are candidates then.
+       */
+      bool candidates( const StrMatcher & matcher_r, std::vector<detail::SolvableIdType> & ids_r ) const;
+
+    private:
+      TrigramIndex() = default;
+
+      /** The ordinals of the solvables containing a trigram. */
+      struct Posting
+      {
+        uint32_t _trigram;
+        uint32_t _count;	///< number of ordinals
+        uint64_t _offset;	///< in \ref _data
+      };
+
+      /** Decode the ordinals of \a posting_r. */
+      void ordinals( const Posting & posting_r, std::vector<uint32_t> & ordinals_r ) const;
+
+      detail::SolvableIdType _first = 0;	///< id of the 1st solvable in the solv file
+      unsigned             _size = 0;
+      std::vector<Posting> _postings;	///< sorted by trigram
+      std::string          _data;		///< delta/varint encoded ordinals
+    };
+
+  } // namespace sat
+  ///////////////////////////////////////////////////////////////////
+} // namespace zypp
+///////////////////////////////////////////////////////////////////
+#endif // ZYPP_SAT_TRIGRAMINDEX_H
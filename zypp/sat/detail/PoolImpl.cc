@@ -11,6 +11,7 @@
 */
 #include <iostream>
 #include <fstream>
+#include <cstring>
 #include <boost/mpl/int.hpp>
 
 #include <zypp/base/Easy.h>
@@ -23,6 +24,8 @@
 #include <zypp/base/IOStream.h>
 
 #include <zypp/ZConfig.h>
+#include <zypp/ZYppCallbacks.h>
+#include <zypp/Repository.h>
 
 #include <zypp/sat/detail/PoolImpl.h>
 #include <zypp/sat/SolvableSet.h>
@@ -40,8 +43,10 @@ extern "C"
 // directory. (the -devel package does, but the git repo doesn't).
 // #include <solv/repo_helix.h>
 // #include <solv/testcase.h>
+// #include <solv/repo_rpmmd.h>
 int repo_add_helix( ::Repo *repo, FILE *fp, int flags );
 int testcase_add_testtags(Repo *repo, FILE *fp, int flags);
+int repo_add_rpmmd( ::Repo *repo, FILE *fp, const char *language, int flags );
 }
 
 using std::endl;
@@ -313,7 +318,7 @@ namespace zypp
         {
           MIL << "pool_createwhatprovides..." << endl;
 
-          ::pool_addfileprovides( _pool );
+          ::pool_addfileprovides_queue( _pool, _addedFileProvides, _addedFileProvidesInst );
           ::pool_createwhatprovides( _pool );
         }
         if ( ! _pool->languages )
@@ -340,6 +345,8 @@ namespace zypp
         if ( isSystemRepo( repo_r ) )
           _autoinstalled.clear();
         eraseRepoInfo( repo_r );
+        _filelistsProviders.erase( repo_r );
+        _searchIndexes.erase( repo_r );
         ::repo_free( repo_r, /*resusePoolIDs*/false );
         // If the last repo is removed clear the pool to actually reuse all IDs.
         // NOTE: the explicit ::repo_free above asserts all solvables are memset(0)!
@@ -353,6 +360,7 @@ namespace zypp
       int PoolImpl::_addSolv( CRepo * repo_r, FILE * file_r )
       {
         setDirty(__FUNCTION__, repo_r->name );
+        _searchIndexes.erase( repo_r );
         int ret = ::repo_add_solv( repo_r, file_r, 0 );
         if ( ret == 0 )
           _postRepoAdd( repo_r );
@@ -362,6 +370,7 @@ namespace zypp
       int PoolImpl::_addHelix( CRepo * repo_r, FILE * file_r )
       {
         setDirty(__FUNCTION__, repo_r->name );
+        _searchIndexes.erase( repo_r );
         int ret = ::repo_add_helix( repo_r, file_r, 0 );
         if ( ret == 0 )
           _postRepoAdd( repo_r );
@@ -371,12 +380,196 @@ namespace zypp
       int PoolImpl::_addTesttags(CRepo *repo_r, FILE *file_r)
       {
         setDirty(__FUNCTION__, repo_r->name );
+        _searchIndexes.erase( repo_r );
         int ret = ::testcase_add_testtags( repo_r, file_r, 0 );
         if ( ret == 0 )
           _postRepoAdd( repo_r );
         return 0;
       }
 
+      int PoolImpl::_addRpmmdFilelists( CRepo * repo_r, FILE * file_r )
+      {
+        setDirty(__FUNCTION__, repo_r->name );
+        _searchIndexes.erase( repo_r );	// files may become provides
+        return ::repo_add_rpmmd( repo_r, file_r, 0, REPO_EXTEND_SOLVABLES );
+      }
+
+      namespace
+      {
+        /** Whether rpm-md primary lists \a path_r anyway, as createrepo does
+         * for files in /etc and *bin/ dirs. The filelists can't add these.
+         */
+        inline bool listedInPrimary( const char * path_r )
+        { return ::strncmp( path_r, "/etc/", 5 ) == 0 || ::strstr( path_r, "bin/" ) || ::strcmp( path_r, "/usr/lib/sendmail" ) == 0; }
+      } // namespace
+
+      bool PoolImpl::provideFilelists()
+      {
+        std::map<RepoIdType,FilelistsProvider> providers;
+        providers.swap( _filelistsProviders );
+        bool ret = false;
+        for ( auto & el : providers )
+        {
+          if ( el.second() )
+            ret = true;
+        }
+        if ( ret )
+          prepare();
+        return ret;
+      }
+
+      bool PoolImpl::provideFilelists( const std::set<RepoIdType> & repos_r )
+      {
+        bool ret = false;
+        for ( RepoIdType repo : repos_r )
+        {
+          auto it = _filelistsProviders.find( repo );
+          if ( it == _filelistsProviders.end() )
+            continue;
+          FilelistsProvider provider( std::move(it->second) );
+          _filelistsProviders.erase( it );
+          if ( provider() )
+            ret = true;
+        }
+        if ( ret )
+          prepare();
+        return ret;
+      }
+
+      std::map<IdType,std::set<RepoIdType>> PoolImpl::unresolvedFileRequires() const
+      {
+        prepare();
+        std::map<IdType,std::set<RepoIdType>> ret;
+        for ( detail::SolvableIdType id = 2; id < detail::SolvableIdType(_pool->nsolvables); ++id )
+        {
+          CSolvable * s( _pool->solvables + id );
+          if ( ! s->repo || ! s->requires )
+            continue;
+          for ( detail::IdType * dp = s->repo->idarraydata + s->requires; *dp; ++dp )
+          {
+            if ( ISRELDEP(*dp) || *dp == SOLVABLE_PREREQMARKER )
+              continue;
+            const char * path = ::pool_id2str( _pool, *dp );
+            if ( *path != '/' || listedInPrimary( path ) || _pool->whatprovidesdata[::pool_whatprovides( _pool, *dp )] )
+              continue;
+            ret[*dp].insert( s->repo );
+          }
+        }
+        return ret;
+      }
+
+      std::set<RepoIdType> PoolImpl::filelistsCandidates( IdType path_r, const std::set<RepoIdType> & requirers_r ) const
+      {
+        std::set<RepoIdType> ret;
+        for ( RepoIdType repo : requirers_r )
+        {
+          if ( _filelistsProviders.count( repo ) )
+            ret.insert( repo );
+        }
+
+        // Packages owning files in the same directory, e.g. the installed ones,
+        // are likely to own the file in the repos without filelists, too.
+        std::string dir( ::pool_id2str( _pool, path_r ) );
+        dir.erase( dir.rfind( '/' ) + 1 );
+        std::set<IdType> owners;
+        ::Dataiterator di;
+        ::dataiterator_init( &di, _pool, 0, 0, SOLVABLE_FILELIST, dir.c_str(), SEARCH_STRINGSTART|SEARCH_FILES );
+        while ( ::dataiterator_step( &di ) )
+        {
+          owners.insert( _pool->solvables[di.solvid].name );
+          ::dataiterator_skip_solvable( &di );
+        }
+        ::dataiterator_free( &di );
+
+        for ( IdType owner : owners )
+        {
+          for ( detail::IdType * pp = _pool->whatprovidesdata + ::pool_whatprovides( _pool, owner ); *pp; ++pp )
+          {
+            CSolvable * s( _pool->solvables + *pp );
+            if ( s->name == owner && _filelistsProviders.count( s->repo ) )
+              ret.insert( s->repo );
+          }
+        }
+        return ret;
+      }
+
+      bool PoolImpl::provideNeededFilelists()
+      {
+        if ( _filelistsProviders.empty() )
+          return false;
+
+        std::map<IdType,std::set<RepoIdType>> unresolved( unresolvedFileRequires() );
+        if ( unresolved.empty() )
+          return false;
+        MIL << unresolved.size() << " unresolved file requirements may need the filelists, e.g. " << IdString( unresolved.begin()->first ) << endl;
+
+        // Just the repos which may provide a file; those of the requiring
+        // packages first, then by priority.
+        std::set<RepoIdType> requirers;
+        std::map<IdType,std::set<RepoIdType>> candidates;
+        for ( const auto & el : unresolved )
+        {
+          requirers.insert( el.second.begin(), el.second.end() );
+          std::set<RepoIdType> repos( filelistsCandidates( el.first, el.second ) );
+          if ( repos.empty() )
+            MIL << "No repo may provide " << IdString( el.first ) << endl;
+          else
+            candidates[el.first] = std::move(repos);
+        }
+        std::set<RepoIdType> reposet;
+        for ( const auto & el : candidates )
+          reposet.insert( el.second.begin(), el.second.end() );
+        std::vector<RepoIdType> repos( reposet.begin(), reposet.end() );
+        std::stable_sort( repos.begin(), repos.end(), [&requirers]( RepoIdType lhs, RepoIdType rhs ) {
+          bool lreq = requirers.count( lhs );
+          bool rreq = requirers.count( rhs );
+          if ( lreq != rreq )
+            return lreq;
+          if ( lhs->priority != rhs->priority )
+            return lhs->priority > rhs->priority;
+          return lhs->subpriority > rhs->subpriority;
+        });
+
+        bool ret = false;
+        for ( RepoIdType repo : repos )
+        {
+          // still needed for one of the files?
+          auto needed = std::find_if( candidates.begin(), candidates.end(), [repo]( const auto & el ) {
+            return el.second.count( repo );
+          });
+          if ( needed == candidates.end() )
+            continue;
+
+          UserDataJobReport report { "filelists", "fetch" };
+          report.set( "Repository", Repository( repo ) );
+          report.set( "File", IdString( needed->first ) );
+          if ( ! report.info( str::Format(_("Fetching the file lists of repository '%1%' to resolve '%2%'."))
+                              % repoInfo( repo ).label() % IdString( needed->first ) ) )
+          {
+            MIL << "Fetching the filelists of " << repo->name << " declined" << endl;
+            continue;
+          }
+
+          if ( ! provideFilelists( { repo } ) )
+            continue;
+          ret = true;
+          // prepared, so the files just added are provided
+          for ( auto it = candidates.begin(); it != candidates.end(); )
+          {
+            if ( _pool->whatprovidesdata[::pool_whatprovides( _pool, it->first )] )
+              it = candidates.erase( it );
+            else
+              ++it;
+          }
+          if ( candidates.empty() )
+          {
+            MIL << "File requirements resolved, " << _filelistsProviders.size() << " repos still without filelists" << endl;
+            break;
+          }
+        }
+        return ret;
+      }
+
       void PoolImpl::_postRepoAdd( CRepo * repo_r )
       {
         if ( ! isSystemRepo( repo_r ) )
@@ -424,6 +617,7 @@ namespace zypp
       detail::SolvableIdType PoolImpl::_addSolvables( CRepo * repo_r, unsigned count_r )
       {
         setDirty(__FUNCTION__, repo_r->name );
+        _searchIndexes.erase( repo_r );
         return ::repo_add_solvable_block( repo_r, count_r );
       }
 
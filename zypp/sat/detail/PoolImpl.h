@@ -21,6 +21,8 @@ extern "C"
 #include <solv/pool_parserpmrichdep.h>
 }
 #include <iosfwd>
+#include <functional>
+#include <map>
 
 #include <zypp/base/Hash.h>
 #include <zypp/base/NonCopyable.h>
@@ -41,6 +43,7 @@ namespace zypp
   namespace sat
   { /////////////////////////////////////////////////////////////////
     class SolvableSet;
+    class TrigramIndex;
     ///////////////////////////////////////////////////////////////////
     namespace detail
     { /////////////////////////////////////////////////////////////////
@@ -77,6 +80,16 @@ namespace zypp
            */
           void prepare() const;
 
+          /** The file provides added to the repos by the last \ref prepare
+           * (for the system repo in \a inst_r), as needed by \ref PoolSnapshot.
+           */
+          void addedFileProvides( StringQueue & added_r, StringQueue & inst_r ) const
+          {
+            prepare();
+            added_r = _addedFileProvides;
+            inst_r = _addedFileProvidesInst;
+          }
+
         private:
           /** Invalidate housekeeping data (e.g. whatprovides) if the
            *  pools content changed.
@@ -150,6 +163,9 @@ namespace zypp
           */
           int _addTesttags( CRepo * repo_r, FILE * file_r );
 
+          /** Adding rpm-md filelists to the solvables of a repo (matched by checksum). */
+          int _addRpmmdFilelists( CRepo * repo_r, FILE * file_r );
+
           /** Adding Solvables to a repo. */
           detail::SolvableIdType _addSolvables( CRepo * repo_r, unsigned count_r );
           //@}
@@ -157,6 +173,58 @@ namespace zypp
           /** Helper postprocessing the repo after adding solv or helix files. */
           void _postRepoAdd( CRepo * repo_r );
 
+        public:
+          /** \name Lazy filelists.
+           * rpm-md repos are refreshed without the filelists, primary just lists the
+           * files in /etc and in *bin/ dirs. The filelists are fetched on demand.
+           */
+          //@{
+          /** Fetches and adds the filelists of a repo; returns whether they were added. */
+          using FilelistsProvider = std::function<bool()>;
+
+          /** Remember how to fetch the filelists of repo \a id_r. */
+          void setFilelistsProvider( RepoIdType id_r, FilelistsProvider provider_r )
+          { _filelistsProviders[id_r] = std::move(provider_r); }
+
+          /** Run (and forget) the pending filelists providers. */
+          bool provideFilelists();
+
+          /** Run (and forget) the pending filelists providers of \a repos_r. */
+          bool provideFilelists( const std::set<RepoIdType> & repos_r );
+
+          /** Run the filelists providers needed for unresolved file requirements (\ref sat::Pool::provideNeededFilelists). */
+          bool provideNeededFilelists();
+
+        private:
+          /** The unresolved file requirements the filelists may provide,
+           * mapped to the repos of the requiring solvables.
+           */
+          std::map<IdType,std::set<RepoIdType>> unresolvedFileRequires() const;
+
+          /** The repos without filelists which may provide \a path_r: those in
+           * \a requirers_r and those with packages named like the owners of
+           * other files in the directory of \a path_r.
+           */
+          std::set<RepoIdType> filelistsCandidates( IdType path_r, const std::set<RepoIdType> & requirers_r ) const;
+        public:
+          //@}
+
+        public:
+          /** \name Trigram search index.
+           * Attached to repos loaded from a solv file with an up to date
+           * \ref TrigramIndex. Dropped when the repo content changes.
+           */
+          //@{
+          void setSearchIndex( RepoIdType id_r, shared_ptr<const TrigramIndex> index_r )
+          { _searchIndexes[id_r] = std::move(index_r); }
+
+          shared_ptr<const TrigramIndex> searchIndex( RepoIdType id_r ) const
+          {
+            auto it = _searchIndexes.find( id_r );
+            return it == _searchIndexes.end() ? nullptr : it->second;
+          }
+          //@}
+
         public:
           /** a \c valid \ref Solvable has a non NULL repo pointer. */
           bool validSolvable( const CSolvable & slv_r ) const
@@ -384,6 +452,16 @@ namespace zypp
           sat::SolvableSpec _ptfMasterSpec;
           sat::SolvableSpec _ptfPackageSpec;
 
+          /** Pending lazy filelists. */
+          std::map<RepoIdType,FilelistsProvider> _filelistsProviders;
+
+          /** Search indexes of repos loaded from solv files. */
+          std::map<RepoIdType,shared_ptr<const TrigramIndex>> _searchIndexes;
+
+          /** File provides added by the last pool_addfileprovides (system repo in Inst). */
+          mutable sat::StringQueue _addedFileProvides;
+          mutable sat::StringQueue _addedFileProvidesInst;
+
           /** filesystems mentioned in /etc/sysconfig/storage */
           mutable scoped_ptr<std::set<std::string> > _requiredFilesystemsPtr;
       };
@@ -35,6 +35,7 @@
 
 #include <zypp/ZConfig.h>
 #include <zypp/sat/Transaction.h>
+#include <zypp/sat/Pool.h>
 
 #define MAXSOLVERRUNS 5
 
@@ -299,6 +300,12 @@ void Resolver::undo()
     return;
 }
 
+void Resolver::solverPrepare()
+{
+  if ( ZConfig::instance().solverFetchFilelists() )
+    sat::Pool::instance().provideNeededFilelists();
+}
+
 void Resolver::solverInit()
 {
     // Solving with libsolv
@@ -356,6 +363,7 @@ bool Resolver::doUpgrade()
 
 bool Resolver::resolvePool()
 {
+  solverPrepare();
   solverInit();
   return _satResolver->resolvePool(_extra_requires, _extra_conflicts, _addWeak, _upgradeRepos );
 }
@@ -363,12 +371,14 @@ bool Resolver::resolvePool()
 void Resolver::doUpdate()
 {
   _updateMode = true;
+  solverPrepare();
   solverInit();
   return _satResolver->doUpdate();
 }
 
 bool Resolver::resolveQueue( solver::detail::SolverQueueItemList & queue )
 {
+    solverPrepare();
     solverInit();
 
     // add/remove additional SolverQueueItems
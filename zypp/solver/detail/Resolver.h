@@ -123,6 +123,10 @@ class ZYPP_API_DEPTESTOMATIC Resolver : private base::NonCopyable
     // returns true if solving was successful
     bool checkUnmaintainedItems ();
 
+    // Prepare the pool for solving: if ZConfig::solverFetchFilelists, fetch the
+    // filelists needed to resolve file requirements (see sat::Pool::provideNeededFilelists).
+    void solverPrepare();
+
     void solverInit();
 
   public:
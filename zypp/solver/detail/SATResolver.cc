@@ -74,35 +74,20 @@ namespace zypp
       ///////////////////////////////////////////////////////////////////////
       namespace
       {
-        inline void solverSetFocus( sat::detail::CSolver & satSolver_r, const ResolverFocus & focus_r )
-        {
-          switch ( focus_r )
-          {
-            case ResolverFocus::Default:	// fallthrough to Job
-            case ResolverFocus::Job:
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_INSTALLED, 0 );
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_BEST,      0 );
-              break;
-            case ResolverFocus::Installed:
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_INSTALLED, 1 );
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_BEST,      0 );
-              break;
-            case ResolverFocus::Update:
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_INSTALLED, 0 );
-              solver_set_flag( &satSolver_r, SOLVER_FLAG_FOCUS_BEST,      1 );
-              break;
-          }
-        }
-
         /** Helper collecting pseudo installed items from the pool.
-         * \todo: pseudoItems are cachable as long as pool content does not change
+         * They are cached as long as the pool content does not change.
          */
         inline sat::Queue collectPseudoInstalled( const ResPool & pool_r )
         {
-          sat::Queue ret;
-          for ( const PoolItem & pi : pool_r )
-            if ( traits::isPseudoInstalled( pi.kind() ) ) ret.push( pi.id() );
-          return ret;
+          static SerialNumberWatcher _watcher;
+          static sat::Queue _cache;
+          if ( _watcher.remember( pool_r.serial() ) )
+          {
+            _cache.clear();
+            for ( const PoolItem & pi : pool_r )
+              if ( traits::isPseudoInstalled( pi.kind() ) ) _cache.push( pi.id() );
+          }
+          return _cache;
         }
 
         /** Copy back new \ref WeakValue to \ref PoolItem after solving.
@@ -291,6 +276,10 @@ SATResolver::SATResolver (ResPool  pool, sat::detail::CPool *satPool)
     : _pool(std::move(pool))
     , _satPool(satPool)
     , _satSolver(NULL)
+    , _transactCandidates( []( const ResStatus & status_r ) {
+      // Untouched items are KEEP_STATE by SOLVER, SATCollectTransact ignores them.
+      return status_r.getTransactValue() != ResStatus::KEEP_STATE || status_r.getTransactByValue() != ResStatus::SOLVER;
+    } )
     , _focus			( ZConfig::instance().solver_focus() )
     , _fixsystem(false)
     , _allowdowngrade		( false )
@@ -474,9 +463,16 @@ SATResolver::solverInit(const PoolItemList & weakItems)
 
     // Collect PoolItem's tasks and cleanup Pool for solving.
     // Todos are kept in _items_to_install, _items_to_remove, _items_to_lock, _items_to_keep
+    // Just the items touched since the last run are inspected, not the whole pool.
     {
       SATCollectTransact collector( _items_to_install, _items_to_remove, _items_to_lock, _items_to_keep, solveSrcPackages() );
-      invokeOnEach ( _pool.begin(), _pool.end(), std::ref( collector ) );
+      const std::set<sat::detail::SolvableIdType> & ids( _transactCandidates.ids() );
+      const std::vector<sat::detail::SolvableIdType> candidates( ids.begin(), ids.end() );	// collector changes them
+      for ( sat::detail::SolvableIdType id : candidates )
+      {
+        if ( PoolItem pi { _pool.find( sat::Solvable(id) ) } )
+          collector( pi );
+      }
     }
 
     // Add rules for previous ProblemSolutions "break %s by ignoring some of its dependencies"
@@ -656,21 +652,62 @@ void SATResolver::solverInitSetModeJobsAndFlags()
         } );
     }
 
-    solverSetFocus( *_satSolver, _focus );
-    solver_set_flag(_satSolver, SOLVER_FLAG_ADD_ALREADY_RECOMMENDED, !_ignorealreadyrecommended);
-    solver_set_flag(_satSolver, SOLVER_FLAG_ALLOW_DOWNGRADE,		_allowdowngrade);
-    solver_set_flag(_satSolver, SOLVER_FLAG_ALLOW_NAMECHANGE,		_allownamechange);
-    solver_set_flag(_satSolver, SOLVER_FLAG_ALLOW_ARCHCHANGE,		_allowarchchange);
-    solver_set_flag(_satSolver, SOLVER_FLAG_ALLOW_VENDORCHANGE,		_allowvendorchange);
-    solver_set_flag(_satSolver, SOLVER_FLAG_ALLOW_UNINSTALL,		_allowuninstall);
-    solver_set_flag(_satSolver, SOLVER_FLAG_NO_UPDATEPROVIDE,		_noupdateprovide);
-    solver_set_flag(_satSolver, SOLVER_FLAG_SPLITPROVIDES,		_dosplitprovides);
-    solver_set_flag(_satSolver, SOLVER_FLAG_IGNORE_RECOMMENDED, 	false);		// resolve recommended namespaces
-    solver_set_flag(_satSolver, SOLVER_FLAG_ONLY_NAMESPACE_RECOMMENDED,	_onlyRequires);	//
-    solver_set_flag(_satSolver, SOLVER_FLAG_DUP_ALLOW_DOWNGRADE,	_dup_allowdowngrade );
-    solver_set_flag(_satSolver, SOLVER_FLAG_DUP_ALLOW_NAMECHANGE,	_dup_allownamechange );
-    solver_set_flag(_satSolver, SOLVER_FLAG_DUP_ALLOW_ARCHCHANGE,	_dup_allowarchchange );
-    solver_set_flag(_satSolver, SOLVER_FLAG_DUP_ALLOW_VENDORCHANGE,	_dup_allowvendorchange );
+    solverFlags().apply( *_satSolver );
+}
+
+SolverFlags SATResolver::solverFlags() const
+{
+    SolverFlags ret;
+    ret.focus			= _focus;
+    ret.ignorealreadyrecommended	= _ignorealreadyrecommended;
+    ret.allowdowngrade		= _allowdowngrade;
+    ret.allownamechange		= _allownamechange;
+    ret.allowarchchange		= _allowarchchange;
+    ret.allowvendorchange	= _allowvendorchange;
+    ret.allowuninstall		= _allowuninstall;
+    ret.noupdateprovide		= _noupdateprovide;
+    ret.dosplitprovides		= _dosplitprovides;
+    ret.onlyRequires		= _onlyRequires;
+    ret.dup_allowdowngrade	= _dup_allowdowngrade;
+    ret.dup_allownamechange	= _dup_allownamechange;
+    ret.dup_allowarchchange	= _dup_allowarchchange;
+    ret.dup_allowvendorchange	= _dup_allowvendorchange;
+    return ret;
+}
+
+void SolverFlags::apply( sat::detail::CSolver & satSolver_r ) const
+{
+    sat::detail::CSolver * satSolver = &satSolver_r;
+    switch ( focus )
+    {
+      case ResolverFocus::Default:	// fallthrough to Job
+      case ResolverFocus::Job:
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_INSTALLED, 0 );
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_BEST,      0 );
+        break;
+      case ResolverFocus::Installed:
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_INSTALLED, 1 );
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_BEST,      0 );
+        break;
+      case ResolverFocus::Update:
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_INSTALLED, 0 );
+        solver_set_flag( satSolver, SOLVER_FLAG_FOCUS_BEST,      1 );
+        break;
+    }
+    solver_set_flag(satSolver, SOLVER_FLAG_ADD_ALREADY_RECOMMENDED,	!ignorealreadyrecommended);
+    solver_set_flag(satSolver, SOLVER_FLAG_ALLOW_DOWNGRADE,		allowdowngrade);
+    solver_set_flag(satSolver, SOLVER_FLAG_ALLOW_NAMECHANGE,		allownamechange);
+    solver_set_flag(satSolver, SOLVER_FLAG_ALLOW_ARCHCHANGE,		allowarchchange);
+    solver_set_flag(satSolver, SOLVER_FLAG_ALLOW_VENDORCHANGE,		allowvendorchange);
+    solver_set_flag(satSolver, SOLVER_FLAG_ALLOW_UNINSTALL,		allowuninstall);
+    solver_set_flag(satSolver, SOLVER_FLAG_NO_UPDATEPROVIDE,		noupdateprovide);
+    solver_set_flag(satSolver, SOLVER_FLAG_SPLITPROVIDES,		dosplitprovides);
+    solver_set_flag(satSolver, SOLVER_FLAG_IGNORE_RECOMMENDED, 		false);		// resolve recommended namespaces
+    solver_set_flag(satSolver, SOLVER_FLAG_ONLY_NAMESPACE_RECOMMENDED,	onlyRequires);	//
+    solver_set_flag(satSolver, SOLVER_FLAG_DUP_ALLOW_DOWNGRADE,		dup_allowdowngrade );
+    solver_set_flag(satSolver, SOLVER_FLAG_DUP_ALLOW_NAMECHANGE,	dup_allownamechange );
+    solver_set_flag(satSolver, SOLVER_FLAG_DUP_ALLOW_ARCHCHANGE,	dup_allowarchchange );
+    solver_set_flag(satSolver, SOLVER_FLAG_DUP_ALLOW_VENDORCHANGE,	dup_allowvendorchange );
 }
 
 //----------------------------------------------------------------------------
@@ -36,6 +36,7 @@ extern "C"
 #include <string>
 
 #include <zypp/solver/Types.h>
+#include <zypp/pool/ChangeJournal.h>
 
 /////////////////////////////////////////////////////////////////////////
 namespace zypp
@@ -54,6 +55,34 @@ namespace zypp
     { ///////////////////////////////////////////////////////////////////
 
 
+///////////////////////////////////////////////////////////////////
+/// \class SolverFlags
+/// \brief The libsolv solver flags set by the \ref SATResolver.
+///
+/// Shared with \ref sat::SolverSnapshot, so both set up the solver alike.
+/// Defaults are those of the \ref SATResolver ctor, not considering \ref ZConfig.
+///////////////////////////////////////////////////////////////////
+struct SolverFlags
+{
+  ResolverFocus focus = ResolverFocus::Default;
+  bool ignorealreadyrecommended = true;
+  bool allowdowngrade = false;
+  bool allownamechange = true;		// bsc#1071466
+  bool allowarchchange = false;
+  bool allowvendorchange = false;
+  bool allowuninstall = false;
+  bool noupdateprovide = false;
+  bool dosplitprovides = true;
+  bool onlyRequires = false;
+  bool dup_allowdowngrade = false;
+  bool dup_allownamechange = false;
+  bool dup_allowarchchange = false;
+  bool dup_allowvendorchange = false;
+
+  /** Set the flags in \a satSolver_r. */
+  void apply( sat::detail::CSolver & satSolver_r ) const;
+};
+
 ///////////////////////////////////////////////////////////////////
 //
 //	CLASS NAME : SATResolver
@@ -79,6 +108,8 @@ class SATResolver : public base::ReferenceCounted, private base::NonCopyable, pr
     PoolItemList _items_to_remove;
     PoolItemList _items_to_lock;
     PoolItemList _items_to_keep;
+    // items SATCollectTransact needs to look at (maintained via the ChangeJournal)
+    pool::ChangeJournal::Selection _transactCandidates;
 
     // solve results
     PoolItemList _result_items_to_install;
@@ -117,7 +148,8 @@ class SATResolver : public base::ReferenceCounted, private base::NonCopyable, pr
     std::vector<std::string> SATgetCompleteProblemInfoStrings ( Id problem );
     void resetItemTransaction (PoolItem item);
 
-    // Create a SAT solver and
+    // Create a new SAT solver for each run and feed it the jobs (reusing one would
+    // not save the rules, solver_solve() rebuilds all of them from the job queue).
     void solverInit(const PoolItemList & weakItems);
     void solverInitSetLocks();
     void solverInitSetSystemRequirements();
@@ -213,6 +245,9 @@ class SATResolver : public base::ReferenceCounted, private base::NonCopyable, pr
     bool cleandepsOnRemove() const 		{ return _cleandepsOnRemove; }
     void setCleandepsOnRemove( bool state_r )	{ _cleandepsOnRemove = state_r; }
 
+    /** The solver flags according to the current settings. */
+    SolverFlags solverFlags() const;
+
     PoolItemList problematicUpdateItems( void ) const { return _problem_items; }
     PoolItemList problematicUpdateItems() { return _problem_items; }
 
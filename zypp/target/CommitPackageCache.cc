@@ -10,6 +10,7 @@
  *
 */
 #include <iostream>
+#include <map>
 #include <utility>
 #include <zypp/base/Logger.h>
 #include <zypp/base/Exception.h>
@@ -24,6 +25,8 @@ using std::endl;
 #include <zypp/repo/PackageProvider.h>
 #include <zypp/repo/DeltaCandidates.h>
 #include <zypp/ResPool.h>
+#include <zypp/ZConfig.h>
+#include <zypp/SrcPackage.h>
 
 ///////////////////////////////////////////////////////////////////
 namespace zypp
@@ -71,6 +74,7 @@ namespace zypp
       repo::RepoMediaAccess _access;
       std::list<Repository> _repos;
       repo::PackageProviderPolicy _packageProviderPolicy;
+      shared_ptr<rpm::RpmPackageVerifyPool> _verifyPool;
     };
 
     RepoProvidePackage::RepoProvidePackage()
@@ -96,16 +100,58 @@ namespace zypp
       {
         repo::DeltaCandidates deltas( _impl->_repos, pi_r.name() );
         repo::PackageProvider pkgProvider( _impl->_access, pi_r, deltas, _impl->_packageProviderPolicy );
+        pkgProvider.verifyPool( _impl->_verifyPool );
         return pkgProvider.providePackage();
       }
       else	// SrcPackage or throws
       {
         repo::PackageProvider pkgProvider( _impl->_access, pi_r, _impl->_packageProviderPolicy );
+        pkgProvider.verifyPool( _impl->_verifyPool );
         return pkgProvider.providePackage();
       }
       return ret;
     }
 
+    void RepoProvidePackage::precache( const std::vector<PoolItem> & pis_r )
+    {
+      bool useDeltas = ZConfig::instance().download_use_deltarpm();
+      std::map<Repository::IdType, std::vector<OnMediaLocation>> locsByRepo;
+      for ( const PoolItem & pi : pis_r )
+      {
+        if ( pi.isKind<Package>() )
+        {
+          Package::constPtr pkg( asKind<Package>( pi.resolvable() ) );
+          if ( pkg->isCached() )
+            continue;
+          if ( useDeltas && ! repo::DeltaCandidates( _impl->_repos, pi.name() ).deltaRpms( pkg ).empty() )
+            continue;	// PackageProvider may prefer the delta
+          locsByRepo[pi.repository().id()].push_back( pkg->location() );
+        }
+        else if ( pi.isKind<SrcPackage>() )
+        {
+          SrcPackage::constPtr pkg( asKind<SrcPackage>( pi.resolvable() ) );
+          if ( pkg->isCached() )
+            continue;
+          locsByRepo[pi.repository().id()].push_back( pkg->location() );
+        }
+      }
+
+      for ( const auto & [repoId, locs] : locsByRepo )
+      {
+        _impl->_access.precacheFiles( Repository( repoId ).info(), locs );
+      }
+    }
+
+    void RepoProvidePackage::verifyPool( shared_ptr<rpm::RpmPackageVerifyPool> pool_r )
+    { _impl->_verifyPool = std::move(pool_r); }
+
+    ManagedFile RepoProvidePackage::verify( const PoolItem & pi_r, const ManagedFile & file_r )
+    {
+      repo::PackageProvider pkgProvider( _impl->_access, pi_r, _impl->_packageProviderPolicy );
+      pkgProvider.verifyPool( _impl->_verifyPool );
+      return pkgProvider.verifyPackage( file_r );
+    }
+
     ///////////////////////////////////////////////////////////////////
     //
     //	CLASS NAME : CommitPackageCache
@@ -13,6 +13,7 @@
 #define ZYPP_TARGET_COMMITPACKAGECACHE_H
 
 #include <iosfwd>
+#include <vector>
 
 #include <zypp/base/PtrTypes.h>
 #include <zypp/base/Function.h>
@@ -28,6 +29,11 @@ namespace zypp
   namespace target
   { /////////////////////////////////////////////////////////////////
 
+    namespace rpm
+    {
+      class RpmPackageVerifyPool;
+    }
+
     ///////////////////////////////////////////////////////////////////
     /// \class RepoProvidePackage
     /// \short Default PackageProvider for \ref CommitPackageCache
@@ -44,6 +50,25 @@ namespace zypp
       /** Provide package optionally fron cache only. */
       ManagedFile operator()( const PoolItem & pi, bool fromCache_r );
 
+      /** Hint to download the packages \a pis_r in advance.
+       * All packages of a repo are handed to its media backend at once, which
+       * may download them concurrently. Packages already cached and packages
+       * which may be built from a delta rpm are omitted.
+       * \see \ref repo::RepoMediaAccess::precacheFiles
+       */
+      void precache( const std::vector<PoolItem> & pis_r );
+
+      /** Queue the signature check of downloaded packages in \a pool_r
+       * (or check them immediately again, if \c nullptr).
+       * \see \ref repo::PackageProvider::verifyPool
+       */
+      void verifyPool( shared_ptr<rpm::RpmPackageVerifyPool> pool_r );
+
+      /** Complete the queued signature check of \a file_r provided for \a pi_r.
+       * \see \ref repo::PackageProvider::verifyPackage
+       */
+      ManagedFile verify( const PoolItem & pi_r, const ManagedFile & file_r );
+
     private:
       struct Impl;
       RW_pointer<Impl> _impl;
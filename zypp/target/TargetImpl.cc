@@ -14,6 +14,8 @@
 #include <sstream>
 #include <string>
 #include <list>
+#include <deque>
+#include <map>
 #include <set>
 
 #include <sys/types.h>
@@ -47,12 +49,15 @@
 #include <zypp/target/TargetCallbackReceiver.h>
 #include <zypp/target/rpm/librpmDb.h>
 #include <zypp/target/CommitPackageCache.h>
+#include <zypp/target/rpm/RpmPackageVerifyPool.h>
 #include <zypp/target/RpmPostTransCollector.h>
 
 #include <zypp/parser/ProductFileReader.h>
 #include <zypp/repo/SrcPackageProvider.h>
+#include <zypp/media/MediaHandler.h>
 
 #include <zypp/sat/Pool.h>
+#include <zypp/sat/PoolSnapshot.h>
 #include <zypp/sat/detail/PoolImpl.h>
 #include <zypp/sat/SolvableSpec.h>
 #include <zypp/sat/Transaction.h>
@@ -97,6 +102,9 @@ using std::endl;
 extern "C"
 {
 #include <solv/repo_rpmdb.h>
+#include <solv/repo_products.h>
+#include <solv/repo_autopattern.h>
+#include <solv/repo_write.h>
 #include <solv/chksum.h>
 }
 namespace zypp
@@ -124,6 +132,60 @@ namespace zypp
     inline RepoStatus rpmDbRepoStatus( const Pathname & root_r )
     { return RepoStatus( rpmDbStateHash( root_r ), Date() ); }
 
+    /** Cache the rpmdb below \a root_r in \a solvfile_r, like <tt>rpmdb2solv -X -p /etc/products.d</tt> but in-process.
+     * The solv file is written to \a tmpsolv_r and renamed. The \c solv.idx is created from
+     * the same pool, so the solv file is not read back. Headers which did not change since
+     * \a refsolv_r (if not empty) was written are taken from there, instead of being parsed again.
+     * \throws Exception if the rpmdb can't be read or the solv file can't be written.
+     */
+    inline void buildRpmDbSolvFile( const Pathname & root_r, const Pathname & dbPath_r, const Pathname & refsolv_r,
+                                    const Pathname & tmpsolv_r, const Pathname & solvfile_r )
+    {
+      AutoDispose<sat::detail::CPool*> pool { ::pool_create(), ::pool_free };
+      ::pool_set_rootdir( pool, root_r.c_str() );
+      sat::detail::CRepo * repo = ::repo_create( pool, sat::Pool::systemRepoAlias().c_str() );	// owned by pool
+      Repodata * data = ::repo_add_repodata( repo, 0 );
+
+      const auto failed = [&pool]( const std::string & what_r ) {
+        Exception ex( "Failed to cache rpm database." );
+        ex.remember( what_r+": "+::pool_errstr( pool ) );
+        return ex;
+      };
+
+      {
+        AutoDispose<FILE*> reffp { refsolv_r.empty() ? nullptr : ::fopen( refsolv_r.c_str(), "re" ), []( FILE * fp ) { if ( fp ) ::fclose( fp ); } };
+        OnScopeExit dbpath { rpm::librpmDb::tmpDbPath( dbPath_r ) };
+        if ( ::repo_add_rpmdb_reffp( repo, reffp, REPO_USE_ROOTDIR|REPO_REUSE_REPODATA|REPO_NO_INTERNALIZE ) != 0 )
+          ZYPP_THROW( failed( "Can't read the rpm database "+dbPath_r.asString() ) );
+      }
+      if ( ::repo_add_products( repo, "/etc/products.d", REPO_USE_ROOTDIR|REPO_REUSE_REPODATA|REPO_NO_INTERNALIZE ) != 0 )
+        ZYPP_THROW( failed( "Can't read the installed products" ) );
+      ::repodata_internalize( data );
+      ::repo_add_autopattern( repo, ADD_NO_AUTOPRODUCTS );
+
+      {
+        AutoDispose<FILE*> fp { ::fopen( tmpsolv_r.c_str(), "we" ), ::fclose };
+        if ( ! fp )
+        {
+          fp.resetDispose();
+          ZYPP_THROW( failed( "Can't create "+tmpsolv_r.asString() ) );
+        }
+        if ( ::repo_write( repo, fp ) != 0 )
+          ZYPP_THROW( failed( "Can't write "+tmpsolv_r.asString() ) );
+        fp.resetDispose();
+        if ( ::fclose( fp ) != 0 )
+          ZYPP_THROW( Exception( "Failed to cache rpm database." ) );
+      }
+
+      if ( filesystem::rename( tmpsolv_r, solvfile_r ) != 0 )
+        ZYPP_THROW(Exception("Failed to move cache to final destination"));
+      // if this fails, don't bother throwing exceptions
+      filesystem::chmod( solvfile_r, 0644 );
+
+      sat::updateSolvFileIndex( solvfile_r, repo );	// content digest for zypper bash completion
+      MIL << "Cached " << repo->nsolvables << " installed solvables in " << solvfile_r << endl;
+    }
+
   } // namespace target
 } // namespace
 ///////////////////////////////////////////////////////////////////
@@ -1042,7 +1104,7 @@ namespace zypp
         // if the solvfile dir does not exist yet, we better create it
         filesystem::assert_dir( base );
 
-        Pathname oldSolvFile( solvexisted ? rpmsolv : Pathname() ); // to speedup rpmdb2solv
+        Pathname oldSolvFile( solvexisted ? rpmsolv : Pathname() ); // to reuse unchanged headers
 
         filesystem::TmpFile tmpsolv( filesystem::TmpFile::makeSibling( rpmsolv ) );
         if ( !tmpsolv )
@@ -1085,60 +1147,11 @@ namespace zypp
         // Take care we unlink the solvfile on exception
         ManagedFile guard( base, filesystem::recursive_rmdir );
 
-        ExternalProgram::Arguments cmd;
-#ifdef ZYPP_RPMDB2SOLV_PATH
-        cmd.push_back( ZYPP_RPMDB2SOLV_PATH );
-#else
-        cmd.push_back( "rpmdb2solv" );
-#endif
-        if ( ! _root.empty() ) {
-          cmd.push_back( "-r" );
-          cmd.push_back( _root.asString() );
-        }
-        cmd.push_back( "-D" );
-        cmd.push_back( rpm().dbPath().asString() );
-        cmd.push_back( "-X" );	// autogenerate pattern/product/... from -package
-        // bsc#1104415: no more application support // cmd.push_back( "-A" );	// autogenerate application pseudo packages
-        cmd.push_back( "-p" );
-        cmd.push_back( Pathname::assertprefix( _root, "/etc/products.d" ).asString() );
-
-        if ( ! oldSolvFile.empty() )
-          cmd.push_back( oldSolvFile.asString() );
-
-        cmd.push_back( "-o" );
-        cmd.push_back( tmpsolv.path().asString() );
-
-        ExternalProgram prog( cmd, ExternalProgram::Stderr_To_Stdout );
-        std::string errdetail;
-
-        for ( std::string output( prog.receiveLine() ); output.length(); output = prog.receiveLine() ) {
-          WAR << "  " << output;
-          if ( errdetail.empty() ) {
-            errdetail = prog.command();
-            errdetail += '\n';
-          }
-          errdetail += output;
-        }
-
-        int ret = prog.close();
-        if ( ret != 0 )
-        {
-          Exception ex(str::form("Failed to cache rpm database (%d).", ret));
-          ex.remember( errdetail );
-          ZYPP_THROW(ex);
-        }
-
-        ret = filesystem::rename( tmpsolv, rpmsolv );
-        if ( ret != 0 )
-          ZYPP_THROW(Exception("Failed to move cache to final destination"));
-        // if this fails, don't bother throwing exceptions
-        filesystem::chmod( rpmsolv, 0644 );
-
+        buildRpmDbSolvFile( _root, rpm().dbPath(), oldSolvFile, tmpsolv.path(), rpmsolv );
         rpmstatus.saveToCookieFile(rpmsolvcookie);
 
         // We keep it.
         guard.resetDispose();
-        sat::updateSolvFileIndex( rpmsolv );	// content digest for zypper bash completion
 
         // system-hook: Finally send notification to plugins
         if ( root() == "/" )
@@ -1196,25 +1209,34 @@ namespace zypp
         }
       }
 
-      if ( ! system )
+      // Take the system repo from the pool snapshot next to the repos, if it holds an up to date copy.
+      const Pathname snapshot( solvfilesPathIsTemp() ? Pathname() : solvfilesPath().dirname() / sat::PoolSnapshot::defaultFile );
+      const sat::PoolSnapshot::Entry entry( sat::PoolSnapshot::Entry::systemRepo( rpmsolv ) );
+      if ( snapshot.empty() || ! sat::PoolSnapshot::loadRepo( snapshot, entry ) )
       {
-        system = satpool.systemRepo();
-      }
+        if ( ! system )
+        {
+          system = satpool.systemRepo();
+        }
 
-      try
-      {
-        MIL << "adding " << rpmsolv << " to system" << endl;
-        system.addSolv( rpmsolv );
-      }
-      catch ( const Exception & exp )
-      {
-        ZYPP_CAUGHT( exp );
-        MIL << "Try to handle exception by rebuilding the solv-file" << endl;
-        clearCache();
-        buildCache();
+        try
+        {
+          MIL << "adding " << rpmsolv << " to system" << endl;
+          system.addSolv( rpmsolv );
+        }
+        catch ( const Exception & exp )
+        {
+          ZYPP_CAUGHT( exp );
+          MIL << "Try to handle exception by rebuilding the solv-file" << endl;
+          clearCache();
+          buildCache();
 
-        system.addSolv( rpmsolv );
+          system.addSolv( rpmsolv );
+        }
+        if ( ! snapshot.empty() )
+          sat::PoolSnapshot::remember( snapshot, entry );
       }
+      system = satpool.systemRepo();
       satpool.rootDir( _root );
 
       // (Re)Load the requested locales et al.
@@ -1301,6 +1323,338 @@ namespace zypp
       MIL << "Target loaded: " << system.solvablesSize() << " resolvables" << endl;
     }
 
+    ///////////////////////////////////////////////////////////////////
+    /// \class CommitDownloadHeaps
+    /// \brief Split the ordered commit steps into download heaps (\ref DownloadInHeaps).
+    ///
+    /// A heap is a consecutive range of the ordered transaction steps. All
+    /// packages of a heap are downloaded before its 1st step is committed.
+    /// While a heap is installed, the packages of the next heap are precached
+    /// in the background. The classic commit installs step by step in
+    /// transaction order, so any such range is a self-contained install unit
+    /// as far as the commit is concerned.
+    ///
+    /// Heaps are sized by the free space of the package caches (the repos
+    /// packagesPath, per filesystem): If all packages fit into half of it,
+    /// there is just one heap (like \ref DownloadInAdvance). Otherwise a heap
+    /// may use a quarter of it, so the heap being installed and the one being
+    /// precached fit in. Installed packages are removed from the cache unless
+    /// the repo keeps its packages. Packages of downloading repos are precached
+    /// into the media attach point before they are moved into the cache, so
+    /// they count against the attach point's filesystem as well.
+    ///
+    /// The file conflicts are checked per heap, once it is downloaded and
+    /// before its 1st step is committed. Packages of earlier heaps count as
+    /// installed. If a later heap can't be provided or the user rejects its
+    /// file conflicts, the commit is aborted before any of its steps.
+    ///////////////////////////////////////////////////////////////////
+    class CommitDownloadHeaps
+    {
+    public:
+      using StepList = ZYppCommitResult::TransactionStepList;
+      using size_type = StepList::size_type;
+
+      /** Ctor; one heap unless \a split_r and the packages don't fit into the cache.
+       * Package signatures are checked against the rpm database in \a root_r.
+       */
+      CommitDownloadHeaps( StepList & steps_r, RepoProvidePackage provider_r, bool split_r, const Pathname & root_r )
+      : _steps( steps_r )
+      , _provider( std::move(provider_r) )
+      , _root( root_r )
+      {
+        if ( split_r )
+          split();
+        _heapEnds.push_back( _steps.size() );
+      }
+
+      /** Number of heaps. */
+      unsigned size() const
+      { return _heapEnds.size(); }
+
+      /** Index of the 1st step of heap \a heap_r. */
+      size_type heapBegin( unsigned heap_r ) const
+      { return heap_r ? _heapEnds[heap_r-1] : 0; }
+
+      /** Index behind the last step of heap \a heap_r. */
+      size_type heapEnd( unsigned heap_r ) const
+      { return _heapEnds[heap_r]; }
+
+      /** Hint the media backends to download the packages of heap \a heap_r in the background. */
+      void precache( unsigned heap_r )
+      {
+        if ( heap_r >= size() )
+          return;
+        std::vector<PoolItem> items;
+        for ( size_type idx = heapBegin( heap_r ); idx < heapEnd( heap_r ); ++idx )
+        {
+          PoolItem pi( needsDownload( _steps[idx] ) );
+          if ( pi )
+            items.push_back( pi );
+        }
+        _provider.precache( items );
+      }
+
+      /** Provide all packages of heap \a heap_r in \a packageCache_r.
+       * Steps whose package can't be provided are set to \c STEP_ERROR.
+       *
+       * Downloaded packages are queued in a \ref rpm::RpmPackageVerifyPool,
+       * so rpm checks them while the next ones are provided (or already while
+       * they are downloaded, see \ref repo::PackageProvider::verifyPool). The results
+       * are evaluated in order on this thread, sending the usual callbacks.
+       * Only a few checks are pending at any time. Files still unverified
+       * when leaving, normally or not, are removed from the cache, so they
+       * are not taken as valid cache hits later.
+       *
+       * \returns whether all packages were provided.
+       * \throws TargetAbortedException if aborted by the user.
+       */
+      bool preload( unsigned heap_r, CommitPackageCache & packageCache_r )
+      {
+        bool miss = false;
+        shared_ptr<rpm::RpmPackageVerifyPool> verifyPool( new rpm::RpmPackageVerifyPool( _root ) );
+        std::deque<std::pair<size_type,ManagedFile>> unverified;
+        const size_type maxUnverified = 2 * verifyPool->maxThreads();
+
+        // Complete the check of a package, a file that failed to verify must not stay in the cache.
+        // Throws if aborted, the file stays where it was and is cleaned up on exit.
+        auto verify = [&]( size_type idx, const PoolItem & pi, const Pathname & localfile ) {
+          if ( provideStep( idx, [&]() { return _provider.verify( pi, ManagedFile( localfile ) ); } ) )
+            return true;
+          filesystem::unlink( localfile );
+          return false;
+        };
+        // Complete the check of the 1st unverified package.
+        auto verifyNext = [&]() {
+          size_type idx = unverified.front().first;
+          if ( ! verify( idx, PoolItem( _steps[idx] ), unverified.front().second ) )
+            miss = true;
+          unverified.pop_front();
+        };
+
+        _provider.verifyPool( verifyPool );
+        // bsc#1045735: Be sure no unverified files stay in the cache!
+        // Any file handed to the pool and not yet taken is unverified, including
+        // files of later steps the cache filled in ahead (CommitPackageCacheReadAhead).
+        OnScopeExit dropUnverified( [&]() {
+          for ( const auto & entry : unverified )
+            filesystem::unlink( entry.second );
+          for ( size_type idx = heapBegin( heap_r ); idx < _steps.size(); ++idx )
+          {
+            PoolItem pi( needsDownload( _steps[idx] ) );
+            if ( ! pi )
+              continue;
+            Pathname localfile( cacheLocation( pi ) );
+            if ( verifyPool->queued( localfile ) )
+            {
+              WAR << "Removing unverified " << localfile << endl;
+              filesystem::unlink( localfile );
+            }
+          }
+          _provider.verifyPool( nullptr );
+        } );
+
+        for ( size_type idx = heapBegin( heap_r ); idx < heapEnd( heap_r ); ++idx )
+        {
+          PoolItem pi( needsDownload( _steps[idx] ) );
+          if ( ! pi )
+            continue;
+
+          ManagedFile localfile;
+          if ( ! provideStep( idx, [&]() { return packageCache_r.get( pi ); }, &localfile ) )
+            miss = true;
+          else if ( verifyPool->queued( localfile ) )
+            unverified.push_back( { idx, localfile } );
+
+          while ( ! unverified.empty()
+                  && ( unverified.size() > maxUnverified || verifyPool->ready( unverified.front().second ) ) )
+            verifyNext();
+        }
+        while ( ! unverified.empty() )
+          verifyNext();
+
+        // Packages of later steps the cache filled in ahead
+        // (CommitPackageCacheReadAhead) were queued as well.
+        for ( size_type idx = heapEnd( heap_r ); idx < _steps.size() && verifyPool->size(); ++idx )
+        {
+          PoolItem pi( needsDownload( _steps[idx] ) );
+          if ( ! pi )
+            continue;
+          Pathname localfile( cacheLocation( pi ) );
+          if ( verifyPool->queued( localfile ) )
+            verify( idx, pi, localfile );
+        }
+        return ! miss;
+      }
+
+    private:
+      /** Provide the package for step \a idx_r by \a provide_r and keep it in the cache.
+       * Steps whose package can't be provided are set to \c STEP_ERROR.
+       * \returns whether the package was provided.
+       * \throws TargetAbortedException if aborted by the user.
+       */
+      template <class TProvide>
+      bool provideStep( size_type idx_r, TProvide && provide_r, ManagedFile * localfile_r = nullptr )
+      {
+        sat::Transaction::Step & step { _steps[idx_r] };
+        try
+        {
+          ManagedFile localfile( provide_r() );
+          localfile.resetDispose(); // keep the package file in the cache
+          if ( localfile_r )
+            *localfile_r = localfile;
+          return true;
+        }
+        catch ( const AbortRequestException & exp )
+        {
+          step.stepStage( sat::Transaction::STEP_ERROR );
+          WAR << "commit cache preload aborted by the user" << endl;
+          ZYPP_THROW( TargetAbortedException( ) );
+        }
+        catch ( const SkipRequestException & exp )
+        {
+          ZYPP_CAUGHT( exp );
+          step.stepStage( sat::Transaction::STEP_ERROR );
+          WAR << "Skipping cache preload package " << PoolItem( step )->asKind<Package>() << " in commit" << endl;
+        }
+        catch ( const Exception & exp )
+        {
+          // bnc #395704: missing catch causes abort.
+          // TODO see if packageCache fails to handle errors correctly.
+          ZYPP_CAUGHT( exp );
+          step.stepStage( sat::Transaction::STEP_ERROR );
+          INT << "Unexpected Error: Skipping cache preload package " << PoolItem( step )->asKind<Package>() << " in commit" << endl;
+        }
+        return false;
+      }
+
+      /** The \ref Package or \ref SrcPackage to install in \a step_r (or \c noPoolItem). */
+      static PoolItem needsDownload( const sat::Transaction::Step & step_r )
+      {
+        // only install actions may require download.
+        if ( step_r.stepType() != sat::Transaction::TRANSACTION_INSTALL
+          && step_r.stepType() != sat::Transaction::TRANSACTION_MULTIINSTALL )
+          return PoolItem();
+        PoolItem pi( step_r );
+        if ( pi->isKind<Package>() || pi->isKind<SrcPackage>() )
+          return pi;
+        return PoolItem();
+      }
+
+      /** Where the package of \a pi is stored in the package cache, whether it is there or not. */
+      static Pathname cacheLocation( const PoolItem & pi )
+      {
+        const RepoInfo & info { pi->repoInfo() };
+        const OnMediaLocation & loc { pi->isKind<SrcPackage>() ? pi->asKind<SrcPackage>()->location() : pi->asKind<Package>()->location() };
+        return info.packagesPath() / info.path() / loc.filename();
+      }
+
+      /** Bytes to download for \a pi (\c 0 if cached). */
+      static ByteCount::SizeType downloadSize( const PoolItem & pi )
+      {
+        if ( pi->isKind<Package>() ? pi->asKind<Package>()->isCached() : pi->asKind<SrcPackage>()->isCached() )
+          return 0;
+        return pi.satSolvable().downloadSize();
+      }
+
+      /** \a dir_r or its nearest existing parent (for \ref filesystem::df). */
+      static Pathname existingDir( Pathname dir_r )
+      {
+        while ( ! dir_r.emptyOrRoot() && ! PathInfo( dir_r ).isDir() )
+          dir_r = dir_r.dirname();
+        return dir_r;
+      }
+
+      void split()
+      {
+        // Packages are downloaded into their repos packagesPath, those of
+        // downloading repos via the media attach point. Account each
+        // filesystem on its own.
+        struct Cache
+        {
+          ByteCount::SizeType _avail = 0;
+          ByteCount::SizeType _total = 0;
+          ByteCount::SizeType _current = 0;	///< in the heap being collected
+        };
+        std::map<dev_t,Cache> caches;
+        auto cacheDev = [&caches]( const Pathname & dir_r ) {
+          Pathname dir { existingDir( dir_r ) };
+          dev_t dev = PathInfo( dir ).dev();
+          if ( ! caches.count( dev ) )
+            caches[dev]._avail = filesystem::df( dir );
+          return dev;
+        };
+        std::optional<dev_t> attachDev;	// computed on demand
+        std::map<Repository::IdType,std::vector<dev_t>> repoDevs;
+        std::vector<std::pair<std::vector<dev_t>,ByteCount::SizeType>> sizes( _steps.size() );
+        for ( size_type idx = 0; idx < _steps.size(); ++idx )
+        {
+          PoolItem pi( needsDownload( _steps[idx] ) );
+          if ( ! pi )
+            continue;
+          ByteCount::SizeType size = downloadSize( pi );
+          if ( ! size )
+            continue;
+
+          auto it = repoDevs.find( pi.repository().id() );
+          if ( it == repoDevs.end() )
+          {
+            const RepoInfo & info { pi.repoInfo() };
+            std::vector<dev_t> devs { cacheDev( info.packagesPath() ) };
+            if ( ! info.baseUrlsEmpty() && info.url().schemeIsDownloading() )
+            {
+              if ( ! attachDev )
+                attachDev = cacheDev( media::MediaHandler::defaultAttachRoot() );
+              if ( *attachDev != devs.front() )
+                devs.push_back( *attachDev );
+            }
+            it = repoDevs.insert( { pi.repository().id(), std::move(devs) } ).first;
+          }
+          sizes[idx] = { it->second, size };
+          for ( dev_t dev : it->second )
+            caches[dev]._total += size;
+        }
+
+        bool fits = true;
+        for ( const auto & [dev, cache] : caches )
+        {
+          DBG << "DownloadInHeaps: device " << dev << " download " << ByteCount(cache._total) << ", available " << ByteCount(cache._avail) << endl;
+          if ( cache._avail > 0 && 2 * cache._total > cache._avail )
+            fits = false;
+        }
+        if ( fits )
+        {
+          MIL << "DownloadInHeaps: 1 heap" << endl;
+          return;
+        }
+
+        for ( size_type idx = 0; idx < _steps.size(); ++idx )
+        {
+          if ( ! sizes[idx].second )
+            continue;
+          for ( dev_t dev : sizes[idx].first )
+          {
+            const Cache & cache { caches[dev] };
+            if ( cache._avail > 0 && cache._current && cache._current + sizes[idx].second > cache._avail / 4 )
+            {
+              _heapEnds.push_back( idx );
+              for ( auto & el : caches )
+                el.second._current = 0;
+              break;
+            }
+          }
+          for ( dev_t dev : sizes[idx].first )
+            caches[dev]._current += sizes[idx].second;
+        }
+        MIL << "DownloadInHeaps: " << _heapEnds.size()+1 << " heaps of up to a quarter of the available cache space" << endl;
+      }
+
+    private:
+      StepList & _steps;
+      RepoProvidePackage _provider;
+      Pathname _root;
+      std::vector<size_type> _heapEnds;	///< index behind the last step per heap
+    };
+
     ///////////////////////////////////////////////////////////////////
     //
     // COMMIT
@@ -1458,67 +1812,29 @@ namespace zypp
       if ( ! policy_r.dryRun() || policy_r.downloadMode() == DownloadOnly )
       {
         // Prepare the package cache. Pass all items requiring download.
-        CommitPackageCache packageCache;
+        // (copies of RepoProvidePackage share the media access)
+        RepoProvidePackage repoProvidePackage;
+        CommitPackageCache packageCache( repoProvidePackage );
         packageCache.setCommitList( steps.begin(), steps.end() );
 
+        // DownloadInHeaps may split the transaction into heaps, unless rpm needs
+        // all packages at once (single transaction mode) or nothing is installed.
+        CommitDownloadHeaps heaps( steps, repoProvidePackage,
+                                   policy_r.downloadMode() == DownloadInHeaps && ! policy_r.dryRun() && ! policy_r.singleTransModeEnabled(),
+                                   _rpm.root() );
+
         bool miss = false;
         if ( policy_r.downloadMode() != DownloadAsNeeded  )
         {
-          // Preload the cache. Until now this means pre-loading all packages.
-          // Once DownloadInHeaps is fully implemented, this will change and
-          // we may actually have more than one heap.
-          for_( it, steps.begin(), steps.end() )
-          {
-            switch ( it->stepType() )
-            {
-              case sat::Transaction::TRANSACTION_INSTALL:
-              case sat::Transaction::TRANSACTION_MULTIINSTALL:
-                // proceed: only install actionas may require download.
-                break;
-
-              default:
-                // next: no download for or non-packages and delete actions.
-                continue;
-                break;
-            }
-
-            PoolItem pi( *it );
-            if ( pi->isKind<Package>() || pi->isKind<SrcPackage>() )
-            {
-              ManagedFile localfile;
-              try
-              {
-                localfile = packageCache.get( pi );
-                localfile.resetDispose(); // keep the package file in the cache
-              }
-              catch ( const AbortRequestException & exp )
-              {
-                it->stepStage( sat::Transaction::STEP_ERROR );
-                miss = true;
-                WAR << "commit cache preload aborted by the user" << endl;
-                ZYPP_THROW( TargetAbortedException( ) );
-                break;
-              }
-              catch ( const SkipRequestException & exp )
-              {
-                ZYPP_CAUGHT( exp );
-                it->stepStage( sat::Transaction::STEP_ERROR );
-                miss = true;
-                WAR << "Skipping cache preload package " << pi->asKind<Package>() << " in commit" << endl;
-                continue;
-              }
-              catch ( const Exception & exp )
-              {
-                // bnc #395704: missing catch causes abort.
-                // TODO see if packageCache fails to handle errors correctly.
-                ZYPP_CAUGHT( exp );
-                it->stepStage( sat::Transaction::STEP_ERROR );
-                miss = true;
-                INT << "Unexpected Error: Skipping cache preload package " << pi->asKind<Package>() << " in commit" << endl;
-                continue;
-              }
-            }
-          }
+          // Preload the cache with the 1st heap (i.e. all packages unless
+          // DownloadInHeaps split the transaction; commit() then preloads
+          // the remaining heaps one by one).
+          //
+          // The media backends get the whole heap in advance, so they may
+          // transfer it concurrently. The preload then picks up the (precached)
+          // files in order, verifying them and sending the usual callbacks.
+          heaps.precache( 0 );
+          miss = ! heaps.preload( 0, packageCache );
           packageCache.preloaded( true ); // try to avoid duplicate infoInCache CBs in commit
         }
 
@@ -1534,8 +1850,9 @@ namespace zypp
               commitInSingleTransaction( policy_r, packageCache, result );
             } else {
               // if cache is preloaded, check for file conflicts
-              commitFindFileConflicts( policy_r, result );
-              commit( policy_r, packageCache, result );
+              // (DownloadInHeaps: just the 1st heap, commit() checks the others)
+              commitFindFileConflicts( policy_r, result, 0, heaps.heapEnd( 0 ) );
+              commit( policy_r, packageCache, result, heaps );
             }
           }
           else
@@ -1613,7 +1930,8 @@ namespace zypp
 
     void TargetImpl::commit( const ZYppCommitPolicy & policy_r,
                              CommitPackageCache & packageCache_r,
-                             ZYppCommitResult & result_r )
+                             ZYppCommitResult & result_r,
+                             CommitDownloadHeaps & heaps_r )
     {
       // steps: this is our todo-list
       ZYppCommitResult::TransactionStepList & steps( result_r.rTransactionStepList() );
@@ -1634,8 +1952,46 @@ namespace zypp
       std::vector<sat::Solvable> successfullyInstalledPackages;
       TargetImpl::PoolItemList remaining;
 
+      unsigned heap = 0;	// the heap about to start
       for_( step, steps.begin(), steps.end() )
       {
+        if ( heap < heaps_r.size() && CommitDownloadHeaps::size_type(step - steps.begin()) == heaps_r.heapBegin( heap ) )
+        {
+          // DownloadInHeaps: The 1st heap was preloaded by our caller, the
+          // following ones are completed here (mostly precached meanwhile).
+          // Then start precaching the next heap while installing this one.
+          if ( heap )
+          {
+            MIL << "Preload download heap " << heap << " of " << heaps_r.size() << endl;
+            bool provided = false;
+            bool checked = false;
+            try
+            {
+              provided = heaps_r.preload( heap, packageCache_r );
+              if ( provided )
+              {
+                commitFindFileConflicts( policy_r, result_r, heaps_r.heapBegin( heap ), heaps_r.heapEnd( heap ) );
+                checked = true;
+              }
+            }
+            catch ( const TargetAbortedException & e )
+            {
+              ZYPP_CAUGHT( e );
+            }
+            if ( ! ( provided && checked ) )
+            {
+              // Earlier heaps are already installed, so this is an incomplete
+              // commit. Unprovided packages are STEP_ERROR, all steps
+              // from here on remain STEP_TODO.
+              ERR << "Download heap " << heap << ( provided ? " has rejected file conflicts" : " could not be provided" )
+                  << ". Aborting commit with " << steps.end() - step << " steps remaining." << endl;
+              abort = true;
+              break; // stop
+            }
+          }
+          heaps_r.precache( ++heap );
+        }
+
         PoolItem citem( *step );
         if ( step->stepType() == sat::Transaction::TRANSACTION_IGNORE )
         {
@@ -19,6 +19,7 @@ extern "C"
 #include <solv/pool_fileconflicts.h>
 }
 #include <iostream>
+#include <algorithm>
 #include <unordered_set>
 #include <string>
 
@@ -103,12 +104,30 @@ namespace zypp
               return nullptr;
             Pathname localfile( pkg->cachedLocation() );
             if ( localfile.empty() )
-              return nullptr;
+              return lookupInstalled( solv );	// installed by an earlier download heap?
             AutoDispose<FILE*> fp( ::fopen( localfile.c_str(), "re" ), ::fclose );
             return ::rpm_byfp( _state, fp, localfile.c_str() );
           }
         }
 
+        /** The header of \a solv_r in the rpm database. */
+        void * lookupInstalled( const sat::Solvable & solv_r )
+        {
+          sat::Queue rpmdbids;
+          ::rpm_installedrpmdbids( _state, "Name", solv_r.name().c_str(), rpmdbids );
+          for ( sat::detail::IdType rpmdbid : rpmdbids )
+          {
+            void * ret = ::rpm_byrpmdbid( _state, rpmdbid );
+            if ( ! ret )
+              continue;
+            AutoDispose<char*> evr( ::rpm_query( ret, SOLVABLE_EVR ), ::solv_free );
+            AutoDispose<char*> arch( ::rpm_query( ret, SOLVABLE_ARCH ), ::solv_free );
+            if ( evr && arch && solv_r.edition() == Edition( evr.value() ) && solv_r.arch() == Arch( arch.value() ) )
+              return ret;
+          }
+          return nullptr;
+        }
+
       private:
         ProgressData & _progress;
         AutoDispose<void*> _state;
@@ -119,11 +138,37 @@ namespace zypp
     } // namespace
     ///////////////////////////////////////////////////////////////////
 
-    void TargetImpl::commitFindFileConflicts( const ZYppCommitPolicy & policy_r, ZYppCommitResult & result_r )
+    void TargetImpl::commitFindFileConflicts( const ZYppCommitPolicy & policy_r, ZYppCommitResult & result_r,
+                                              size_t stepsBegin_r, size_t stepsEnd_r )
     {
       sat::Queue todo;
       sat::FileConflicts conflicts;
       int newpkgs = result_r.transaction().installedResult( todo );
+
+      const ZYppCommitResult::TransactionStepList & steps( result_r.transactionStepList() );
+      if ( stepsBegin_r || stepsEnd_r < steps.size() )
+      {
+        // DownloadInHeaps: Check the new packages of the steps in range against
+        // the installed ones, including those of earlier steps.
+        std::unordered_set<sat::detail::IdType> earlier;
+        std::unordered_set<sat::detail::IdType> current;
+        for ( size_t idx = 0; idx < std::min( stepsEnd_r, steps.size() ); ++idx )
+          ( idx < stepsBegin_r ? earlier : current ).insert( steps[idx].satSolvable().id() );
+
+        sat::Queue heap;
+        for ( int i = 0; i < newpkgs; ++i )
+          if ( current.count( todo[i] ) )
+            heap.push( todo[i] );
+        int heappkgs = heap.size();
+        for ( int i = 0; i < newpkgs; ++i )
+          if ( earlier.count( todo[i] ) )
+            heap.push( todo[i] );
+        for ( unsigned i = newpkgs; i < todo.size(); ++i )
+          heap.push( todo[i] );
+
+        todo = heap;
+        newpkgs = heappkgs;
+      }
       MIL << "Checking for file conflicts in " << newpkgs << " new packages..." << endl;
       if ( ! newpkgs )
         return;
@@ -40,6 +40,7 @@ namespace zypp
 
     DEFINE_PTR_TYPE(TargetImpl);
     class CommitPackageCache;
+    class CommitDownloadHeaps;
 
     ///////////////////////////////////////////////////////////////////
     //
@@ -207,7 +208,8 @@ namespace zypp
       /** Commit ordered changes (internal helper) */
       void commit( const ZYppCommitPolicy & policy_r,
                    CommitPackageCache & packageCache_r,
-                   ZYppCommitResult & result_r );
+                   ZYppCommitResult & result_r,
+                   CommitDownloadHeaps & heaps_r );
 
       /** Commit ordered changes (internal helper) */
       void commitInSingleTransaction( const ZYppCommitPolicy & policy_r,
@@ -215,8 +217,13 @@ namespace zypp
         ZYppCommitResult & result_r );
 
 
-      /** Commit helper checking for file conflicts after download. */
-      void commitFindFileConflicts( const ZYppCommitPolicy & policy_r, ZYppCommitResult & result_r );
+      /** Commit helper checking for file conflicts after download.
+       * Just the packages installed by the steps in [\a stepsBegin_r, \a stepsEnd_r)
+       * are checked. Those installed by earlier steps count as installed (\ref DownloadInHeaps),
+       * those of later steps are not yet downloaded and are left out.
+       */
+      void commitFindFileConflicts( const ZYppCommitPolicy & policy_r, ZYppCommitResult & result_r,
+                                    size_t stepsBegin_r = 0, size_t stepsEnd_r = size_t(-1) );
     protected:
       /** Path to the target */
       Pathname _root;
@@ -18,6 +18,7 @@ extern "C"
 #include <cstdlib>
 #include <cstdio>
 #include <ctime>
+#include <chrono>
 
 #include <iostream>
 #include <fstream>
@@ -44,6 +45,7 @@ extern "C"
 #include <zypp-core/ui/ProgressData>
 
 #include <zypp/target/rpm/RpmDb.h>
+#include <zypp/target/rpm/RpmPackageVerifyPool.h>
 #include <zypp/target/rpm/RpmCallbacks.h>
 #include <zypp/target/RpmPostTransCollector.h>
 
@@ -268,7 +270,7 @@ void RpmDb::initDatabase( Pathname root_r, bool doRebuild_r )
   const Pathname & dbPath_r { librpmDb::suggestedDbPath( root_r ) };	// also asserts root_r is absolute
 
   // The rpmdb compat symlink.
-  // Required at least until rpmdb2solv takes a dppath argument.
+  // Required at least until libsolv takes a dppath argument.
   // Otherwise it creates a db at "/var/lib/rpm".
   if ( dbPath_r != "/var/lib/rpm" && ! PathInfo( root_r/"/var/lib/rpm" ).isExist() )
   {
@@ -1113,7 +1115,8 @@ namespace
     int _oldMask = 0;
   };
 
-  std::ostream & operator<<( std::ostream & str, const RpmlogCapture & obj )
+  /** Captured rpm log lines, e.g. \ref RpmlogCapture. */
+  std::ostream & operator<<( std::ostream & str, const std::vector<std::string> & obj )
   {
     char sep = '\0';
     for ( const auto & l : obj ) {
@@ -1124,6 +1127,12 @@ namespace
   }
 
 
+  RpmDb::CheckPackageResult evalCheckPackageSig( const Pathname & path_r,			// rpm file checked
+                                                 int res,					// rpm's return value
+                                                 const std::vector<std::string> & vresult,	// rpm's verbose output
+                                                 bool  requireGPGSig_r,			// whether no gpg signature is to be reported
+                                                 RpmDb::CheckPackageDetail & detail_r );	// detailed result
+
   RpmDb::CheckPackageResult doCheckPackageSig( const Pathname & path_r,			// rpm file to check
                                                const Pathname & root_r,			// target root
                                                bool  requireGPGSig_r,			// whether no gpg signature is to be reported
@@ -1160,6 +1169,12 @@ namespace
     ts = rpmtsFree(ts);
     ::Fclose( fd );
 
+    return evalCheckPackageSig( path_r, res, vresult, requireGPGSig_r, detail_r );
+  }
+
+  /** Check the individual signature/digest results rpm printed. */
+  RpmDb::CheckPackageResult evalCheckPackageSig( const Pathname & path_r, int res, const std::vector<std::string> & vresult, bool requireGPGSig_r, RpmDb::CheckPackageDetail & detail_r )
+  {
     // Check the individual signature/disgest results:
 
     // To.map back known result strings to enum, everything else is CHK_ERROR.
@@ -1317,6 +1332,18 @@ namespace
     return ret;
   }
 
+  /** The ID of the key \a path_r is signed with, if rpm has no key for it. */
+  void addMissingKeyID( VerifyPackageResult & ret_r, const Pathname & path_r )
+  {
+    if ( ret_r.result != RpmDb::CHK_NOKEY )
+      return;
+    RpmHeader::constPtr hr = RpmHeader::readPackage( path_r, RpmHeader::NOVERIFY );
+    if ( hr )
+      ret_r.keyID = hr->signatureKeyID();
+    else
+      WAR << "Unable to read package header from " << path_r << endl;
+  }
+
 } // namespace
 ///////////////////////////////////////////////////////////////////
 //
@@ -1332,6 +1359,31 @@ RpmDb::CheckPackageResult RpmDb::checkPackage( const Pathname & path_r )
 RpmDb::CheckPackageResult RpmDb::checkPackageSignature( const Pathname & path_r, RpmDb::CheckPackageDetail & detail_r )
 { return doCheckPackageSig( path_r, root(), true/*requireGPGSig_r*/, detail_r ); }
 
+VerifyPackageResult RpmDb::verifyPackageSignature( const Pathname & path_r, bool requireGPGSig_r )
+{
+  VerifyPackageResult ret;
+  auto start = std::chrono::steady_clock::now();
+  ret.result = doCheckPackageSig( path_r, root(), requireGPGSig_r, ret.detail );
+  ret.verifyTime = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start );
+  addMissingKeyID( ret, path_r );
+  return ret;
+}
+
+VerifyPackageResult RpmDb::verifyPackageSignature( const Pathname & path_r, bool requireGPGSig_r, RpmPackageVerifyPool & pool_r )
+{
+  std::optional<RpmPackageVerifyPool::Output> pooled;
+  if ( pool_r.root() == root() )
+    pooled = pool_r.take( path_r );
+  if ( ! pooled )
+    return verifyPackageSignature( path_r, requireGPGSig_r );
+
+  VerifyPackageResult ret;
+  ret.result = evalCheckPackageSig( path_r, pooled->exitCode, pooled->lines, requireGPGSig_r, ret.detail );
+  ret.verifyTime = pooled->verifyTime;
+  addMissingKeyID( ret, path_r );
+  return ret;
+}
+
 
 // determine changed files of installed package
 bool
@@ -2231,6 +2283,14 @@ std::ostream & operator<<( std::ostream & str, const RpmDb::CheckPackageDetail &
   return str;
 }
 
+std::ostream & operator<<( std::ostream & str, const VerifyPackageResult & obj )
+{
+  str << "VerifyPackageResult" << obj.result;
+  if ( ! obj.keyID.empty() )
+    str << " key " << obj.keyID;
+  return str << " (" << obj.verifyTime.count() << "us)";
+}
+
 } // namespace rpm
 } // namespace target
 } // namespace zypp
@@ -16,6 +16,7 @@
 #define ZYPP_TARGET_RPM_RPMDB_H
 
 #include <iosfwd>
+#include <chrono>
 #include <list>
 #include <vector>
 #include <string>
@@ -41,6 +42,9 @@ class RpmPostTransCollector;
 namespace rpm
 {
 
+struct VerifyPackageResult;
+class RpmPackageVerifyPool;
+
 ///////////////////////////////////////////////////////////////////
 //
 //	CLASS NAME : RpmDb
@@ -417,6 +421,20 @@ public:
    */
   CheckPackageResult checkPackageSignature( const Pathname & path_r, CheckPackageDetail & detail_r );
 
+  /**
+   * Check signature of rpm file on disk like \ref checkPackageSignature,
+   * returning a structured result.
+   *
+   * @param path_r which file to check
+   * @param requireGPGSig_r whether an unsigned file results in CHK_NOSIG (like \ref checkPackageSignature)
+   */
+  VerifyPackageResult verifyPackageSignature( const Pathname & path_r, bool requireGPGSig_r = true );
+
+  /** \overload Use rpm's output from \a pool_r, if \a path_r was queued there.
+   * The pool must have been set up for this root.
+   */
+  VerifyPackageResult verifyPackageSignature( const Pathname & path_r, bool requireGPGSig_r, RpmPackageVerifyPool & pool_r );
+
   /** install rpm package
    *
    * @param filename file to install
@@ -528,6 +546,24 @@ std::ostream & operator<<( std::ostream & str, RpmDb::CheckPackageResult obj ) Z
 /** \relates RpmDb::checkPackageDetail Stream output */
 std::ostream & operator<<( std::ostream & str, const RpmDb::CheckPackageDetail & obj ) ZYPP_API;
 
+///////////////////////////////////////////////////////////////////
+/// \class VerifyPackageResult
+/// \brief Result of \ref RpmDb::verifyPackageSignature.
+///
+/// The check is done by rpm, \ref result and \ref detail are those
+/// \ref RpmDb::checkPackageSignature would return.
+///////////////////////////////////////////////////////////////////
+struct ZYPP_API VerifyPackageResult
+{
+  RpmDb::CheckPackageResult result = RpmDb::CHK_ERROR;	///< the overall result
+  RpmDb::CheckPackageDetail detail;			///< rpm's log messages
+  std::string keyID;					///< ID of the missing key if result is CHK_NOKEY
+  std::chrono::microseconds verifyTime { 0 };		///< time spent checking (not waiting for) the package
+};
+
+/** \relates VerifyPackageResult Stream output */
+std::ostream & operator<<( std::ostream & str, const VerifyPackageResult & obj ) ZYPP_API;
+
 } // namespace rpm
 } // namespace target
 } // namespace zypp
@@ -0,0 +1,428 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file zypp/target/rpm/RpmPackageVerifyPool.cc
+ *
+*/
+extern "C"
+{
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+}
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <zypp/base/Logger.h>
+#include <zypp/base/Signal.h>
+#include <zypp/base/String.h>
+#include <zypp/AutoDispose.h>
+#include <zypp/ExternalProgram.h>
+#include <zypp/PathInfo.h>
+#include <zypp-core/zyppng/thread/ThreadPool>
+
+#include <zypp/target/rpm/RpmPackageVerifyPool.h>
+
+using std::endl;
+
+namespace zypp
+{
+  namespace target
+  {
+    namespace rpm
+    {
+      ///////////////////////////////////////////////////////////////////
+      // RpmPackageVerifyPool::Stream::Impl
+      ///////////////////////////////////////////////////////////////////
+
+      class RpmPackageVerifyPool::Stream::Impl
+      {
+      public:
+        /** rpm reads the package from a pipe on its stdin. */
+        Impl( const Pathname & root_r )
+        {
+          int fds[2];
+          if ( ::pipe2( fds, O_CLOEXEC ) != 0 )
+          {
+            WAR << "Can't create a pipe: " << str::strerror( errno ) << endl;
+            return;
+          }
+          AutoFD readFd( fds[0] );
+          _fd = AutoFD( fds[1] );
+
+          // ExternalProgram opens the '<' file as the child's stdin before our read end is closed
+          ExternalProgram::Arguments argv { str::Str() << "</proc/" << ::getpid() << "/fd/" << int(readFd),
+                                            "rpmkeys", "--root", root_r.asString(), "--checksig", "-v", "/dev/stdin" };
+          _prog.reset( new ExternalProgram( argv, ExternalProgram::Stderr_To_Stdout, false, -1, true/*default_locale*/ ) );
+        }
+
+        ~Impl()
+        {
+          if ( _prog )
+          {
+            _fd = AutoFD();
+            _prog->kill();
+            _prog->close();
+          }
+        }
+
+        bool write( const char * data_r, size_t len_r )
+        {
+          if ( ! _prog || _fd == -1 )
+            return false;
+
+          // rpm may quit early, writing the pipe must not raise SIGPIPE then
+          SigprocmaskSaver sigsav;
+          sigsav.block( SIGPIPE );
+          while ( len_r )
+          {
+            ssize_t ret = ::write( _fd, data_r, len_r );
+            if ( ret == -1 )
+            {
+              if ( errno == EINTR )
+                continue;
+              WAR << "rpm takes no more data: " << str::strerror( errno ) << endl;
+              if ( errno == EPIPE && sigsav.pending( SIGPIPE ) )
+              {
+                ::sigset_t mask;
+                ::sigemptyset( &mask );
+                ::sigaddset( &mask, SIGPIPE );
+                struct ::timespec nowait { 0, 0 };
+                ::sigtimedwait( &mask, nullptr, &nowait );
+              }
+              _fd = AutoFD();
+              return false;
+            }
+            data_r += ret;
+            len_r -= ret;
+            _size += ret;
+          }
+          return true;
+        }
+
+      public:
+        AutoFD _fd;				///< the pipe rpm reads
+        off_t _size = 0;			///< bytes written
+        std::unique_ptr<ExternalProgram> _prog;	///< until queued
+      };
+
+      ///////////////////////////////////////////////////////////////////
+      // RpmPackageVerifyPool::Impl
+      ///////////////////////////////////////////////////////////////////
+
+      class RpmPackageVerifyPool::Impl
+      {
+      public:
+        /** A file is identified by its inode. */
+        using Key = std::pair<dev_t, ino_t>;
+
+        struct Entry
+        {
+          Entry( int fd_r, const struct ::stat & st_r )
+          : _fd( fd_r )
+          , _size( st_r.st_size )
+          , _mtime( st_r.st_mtime )
+          {}
+
+          AutoFD _fd;
+          off_t _size;
+          time_t _mtime;
+          std::unique_ptr<ExternalProgram> _prog;	///< rpm reading a Stream
+          Output _output;
+          std::atomic<bool> _cancelled { false };
+          bool _done = false;		///< guarded by Impl::_lock
+          bool _runError = false;
+        };
+
+        Impl( const Pathname & root_r, size_t maxThreads_r )
+        : _root( root_r )
+        , _threads( maxThreads_r )
+        {}
+
+        ~Impl()
+        {
+          std::lock_guard lk( _lock );
+          for ( auto & [key, entry] : _entries )
+            entry->_cancelled = true;
+          // ~ThreadPool runs the remaining (cancelled) jobs and joins the threads
+        }
+
+        /** The entry for \a path_r if it is queued. Call with \c _lock held. */
+        std::map<Key, shared_ptr<Entry>>::const_iterator find( const Pathname & path_r ) const
+        {
+          PathInfo pi( path_r );
+          if ( ! pi.isFile() )
+            return _entries.end();
+          return _entries.find( Key( pi.dev(), pi.ino() ) );
+        }
+
+        /** Whether the file queued as \a entry_r was changed after it was queued. */
+        static bool changed( const Pathname & path_r, const Entry & entry_r )
+        {
+          PathInfo pi( path_r );
+          return off_t(pi.size()) != entry_r._size || pi.mtime() != entry_r._mtime;
+        }
+
+        bool submit( const Pathname & path_r )
+        {
+          int fd = ::open( path_r.c_str(), O_RDONLY | O_CLOEXEC );
+          struct ::stat st;
+          if ( fd == -1 || ::fstat( fd, &st ) != 0 )
+          {
+            WAR << "Can't queue " << path_r << ": " << str::strerror( errno ) << endl;
+            if ( fd != -1 )
+              ::close( fd );
+            return false;
+          }
+
+          shared_ptr<Entry> entry( new Entry( fd, st ) );
+          {
+            std::lock_guard lk( _lock );
+            _entries[Key( st.st_dev, st.st_ino )] = entry;
+            _pending.push_back( entry );
+          }
+          _threads.submit( [this](){ run(); } );
+          DBG << "Queued " << path_r << endl;
+          return true;
+        }
+
+        bool submit( Stream::Impl & stream_r, const Pathname & path_r )
+        {
+          if ( ! stream_r._prog || stream_r._fd == -1 )
+            return false;	// rpm did not take all data
+
+          int fd = ::open( path_r.c_str(), O_RDONLY | O_CLOEXEC );
+          struct ::stat st;
+          if ( fd == -1 || ::fstat( fd, &st ) != 0 || st.st_size != stream_r._size )
+          {
+            WAR << "Can't queue the stream for " << path_r << " (" << stream_r._size << " bytes)" << endl;
+            if ( fd != -1 )
+              ::close( fd );
+            return false;
+          }
+
+          stream_r._fd = AutoFD();	// EOF for rpm
+          shared_ptr<Entry> entry( new Entry( fd, st ) );
+          entry->_prog = std::move( stream_r._prog );
+          {
+            std::lock_guard lk( _lock );
+            _entries[Key( st.st_dev, st.st_ino )] = entry;
+          }
+          _threads.submit( [this,entry](){ collect( entry ); } );
+          DBG << "Queued stream " << path_r << endl;
+          return true;
+        }
+
+        /** Worker: read the output of rpm checking a \ref Stream. */
+        void collect( const shared_ptr<Entry> & entry_r )
+        {
+          auto start = std::chrono::steady_clock::now();
+          ExternalProgram & prog( *entry_r->_prog );
+          for ( std::string line = prog.receiveLine(); ! line.empty(); line = prog.receiveLine() )
+          {
+            if ( line.back() == '\n' )
+              line.pop_back();
+            entry_r->_output.lines.push_back( std::move(line) );
+          }
+          int exitCode = prog.close();
+          entry_r->_prog.reset();
+          if ( exitCode != 0 )
+            WAR << "rpmkeys returned " << exitCode << " checking a stream." << endl;
+
+          entry_r->_output.exitCode = exitCode;
+          entry_r->_output.verifyTime = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start );
+          entry_r->_runError = ( exitCode != 0 );
+          {
+            std::lock_guard lk( _lock );
+            entry_r->_done = true;
+          }
+          _cond.notify_all();
+        }
+
+        /** Worker: let rpm check the packages pending so far.
+         * One \c rpmkeys call checks up to \ref _batchSize packages. Its output
+         * is split into the per package sections rpm prints below a \c "file:"
+         * line. If rpm fails on any package of the batch, the output can't be
+         * assigned reliably and all of them are checked again by the caller.
+         */
+        void run()
+        {
+          std::vector<shared_ptr<Entry>> batch;
+          {
+            std::lock_guard lk( _lock );
+            while ( ! _pending.empty() && batch.size() < _batchSize )
+            {
+              batch.push_back( std::move(_pending.front()) );
+              _pending.pop_front();
+            }
+          }
+          if ( batch.empty() )
+            return;	// taken by another worker
+
+          // rpm reads the files we hold open, they may have been moved into the cache meanwhile
+          std::map<std::string, shared_ptr<Entry>> byName;
+          ExternalProgram::Arguments argv { "rpmkeys", "--root", _root.asString(), "--checksig", "-v" };
+          for ( const auto & entry : batch )
+          {
+            if ( entry->_cancelled )
+              continue;
+            std::string name { str::Str() << "/proc/" << ::getpid() << "/fd/" << int(entry->_fd) };
+            argv.push_back( name );
+            byName[name+":"] = entry;
+          }
+
+          if ( ! byName.empty() )
+          {
+            auto start = std::chrono::steady_clock::now();
+            ExternalProgram prog( argv, ExternalProgram::Stderr_To_Stdout, false, -1, true/*default_locale*/ );
+            shared_ptr<Entry> current;
+            for ( std::string line = prog.receiveLine(); ! line.empty(); line = prog.receiveLine() )
+            {
+              if ( line.back() == '\n' )
+                line.pop_back();
+              if ( line[0] != ' ' )
+              {
+                auto it = byName.find( line );
+                if ( it != byName.end() )
+                  current = it->second;
+              }
+              if ( current )
+                current->_output.lines.push_back( std::move(line) );
+            }
+            int exitCode = prog.close();
+            auto verifyTime = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ) / byName.size();
+            if ( exitCode != 0 )
+              WAR << "rpmkeys returned " << exitCode << " checking " << byName.size() << " packages." << endl;
+
+            for ( auto & [name, entry] : byName )
+            {
+              entry->_output.exitCode = exitCode;
+              entry->_output.verifyTime = verifyTime;
+              entry->_runError = ( exitCode != 0 );
+            }
+          }
+
+          {
+            std::lock_guard lk( _lock );
+            for ( const auto & entry : batch )
+              entry->_done = true;
+          }
+          _cond.notify_all();
+        }
+
+        std::optional<Output> take( const Pathname & path_r )
+        {
+          shared_ptr<Entry> entry;
+          {
+            std::unique_lock lk( _lock );
+            auto it = find( path_r );
+            if ( it == _entries.end() )
+              return std::nullopt;
+            entry = it->second;
+            _entries.erase( it );
+            _cond.wait( lk, [&entry]{ return entry->_done; } );
+          }
+
+          if ( changed( path_r, *entry ) )
+          {
+            WAR << path_r << " was changed after it was queued." << endl;
+            return std::nullopt;
+          }
+          if ( entry->_runError || entry->_cancelled )
+          {
+            WAR << "No rpm result for " << path_r << ": " << entry->_output.exitCode << endl;
+            return std::nullopt;
+          }
+          return std::move( entry->_output );
+        }
+
+      public:
+        Pathname _root;
+        mutable std::mutex _lock;
+        std::condition_variable _cond;
+        std::map<Key, shared_ptr<Entry>> _entries;	///< holding the files open until taken, so the inodes are not reused
+        std::deque<shared_ptr<Entry>> _pending;	///< not yet handed to rpm
+        static constexpr size_t _batchSize = 16;	///< max. packages checked per rpm call
+        zyppng::ThreadPool _threads;	///< last: joined before the members the jobs use are gone
+      };
+
+      ///////////////////////////////////////////////////////////////////
+      // RpmPackageVerifyPool
+      ///////////////////////////////////////////////////////////////////
+
+      RpmPackageVerifyPool::RpmPackageVerifyPool( const Pathname & root_r, size_t maxThreads_r )
+      : _pimpl( new Impl( root_r, maxThreads_r ) )
+      {}
+
+      RpmPackageVerifyPool::~RpmPackageVerifyPool()
+      {}
+
+      const Pathname & RpmPackageVerifyPool::root() const
+      { return _pimpl->_root; }
+
+      size_t RpmPackageVerifyPool::maxThreads() const
+      { return _pimpl->_threads.maxThreads(); }
+
+      size_t RpmPackageVerifyPool::size() const
+      {
+        std::lock_guard lk( _pimpl->_lock );
+        return _pimpl->_entries.size();
+      }
+
+      bool RpmPackageVerifyPool::submit( const Pathname & path_r )
+      { return _pimpl->submit( path_r ); }
+
+      shared_ptr<RpmPackageVerifyPool::Stream> RpmPackageVerifyPool::stream() const
+      { return shared_ptr<Stream>( new Stream( _pimpl->_root ) ); }
+
+      bool RpmPackageVerifyPool::submit( Stream & stream_r, const Pathname & path_r )
+      { return _pimpl->submit( *stream_r._pimpl, path_r ); }
+
+      bool RpmPackageVerifyPool::queued( const Pathname & path_r ) const
+      {
+        std::lock_guard lk( _pimpl->_lock );
+        return _pimpl->find( path_r ) != _pimpl->_entries.end();
+      }
+
+      bool RpmPackageVerifyPool::ready( const Pathname & path_r ) const
+      {
+        std::lock_guard lk( _pimpl->_lock );
+        auto it = _pimpl->find( path_r );
+        return it != _pimpl->_entries.end() && it->second->_done;
+      }
+
+      std::optional<RpmPackageVerifyPool::Output> RpmPackageVerifyPool::take( const Pathname & path_r )
+      { return _pimpl->take( path_r ); }
+
+      ///////////////////////////////////////////////////////////////////
+      // RpmPackageVerifyPool::Stream
+      ///////////////////////////////////////////////////////////////////
+
+      RpmPackageVerifyPool::Stream::Stream( const Pathname & root_r )
+      : _pimpl( new Impl( root_r ) )
+      {}
+
+      RpmPackageVerifyPool::Stream::~Stream()
+      {}
+
+      bool RpmPackageVerifyPool::Stream::write( const char * data_r, size_t len_r )
+      { return _pimpl->write( data_r, len_r ); }
+
+      off_t RpmPackageVerifyPool::Stream::size() const
+      { return _pimpl->_size; }
+
+    } // namespace rpm
+  } // namespace target
+} // namespace zypp
@@ -0,0 +1,165 @@
+/*---------------------------------------------------------------------\
+|                          ____ _   __ __ ___                          |
+|                         |__  / \ / / . \ . \                         |
+|                           / / \ V /|  _/  _/                         |
+|                          / /__ | | | | | |                           |
+|                         /_____||_| |_| |_|                           |
+|                                                                      |
+\---------------------------------------------------------------------*/
+/** \file zypp/target/rpm/RpmPackageVerifyPool.h
+ *
+*/
+#ifndef ZYPP_TARGET_RPM_RPMPACKAGEVERIFYPOOL_H
+#define ZYPP_TARGET_RPM_RPMPACKAGEVERIFYPOOL_H
+
+extern "C"
+{
+#include <sys/types.h>
+}
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <zypp/base/PtrTypes.h>
+#include <zypp/base/NonCopyable.h>
+#include <zypp/Pathname.h>
+
+namespace zypp
+{
+  namespace target
+  {
+    namespace rpm
+    {
+      ///////////////////////////////////////////////////////////////////
+      /// \class RpmPackageVerifyPool
+      /// \brief Check rpm packages in a bounded number of worker threads.
+      ///
+      /// The workers let rpm check the package signatures like
+      /// \ref RpmDb::checkPackageSignature does. As librpm's log capturing
+      /// is process wide, the checks run \c rpmkeys in a separate process,
+      /// which checks all packages queued meanwhile at once.
+      /// Its output is evaluated by \ref RpmDb::verifyPackageSignature in the
+      /// calling thread, together with any reporting. So packages may be queued
+      /// as they arrive and are taken in order when they are needed.
+      ///
+      /// A queued file is opened immediately and identified by its inode. It
+      /// is held open until it is taken, so the inode is not reused. It may be
+      /// taken under any hardlinked name. If the file was changed meanwhile,
+      /// it is still queued, but \ref take provides no result for it.
+      ///
+      /// A package may also be checked while it is downloaded: rpm reads
+      /// the data passed to a \ref Stream. Once the file is complete, it is
+      /// queued with the stream and taken like any other file, without rpm
+      /// reading it again.
+      ///
+      /// \code
+      ///   RpmPackageVerifyPool pool( root );
+      ///   for ( const Pathname & file : files )
+      ///     pool.submit( file );
+      ///   for ( const Pathname & file : files )
+      ///     VerifyPackageResult res = rpmDb.verifyPackageSignature( file, true, pool );
+      /// \endcode
+      /// \see \ref RpmDb::verifyPackageSignature
+      ///////////////////////////////////////////////////////////////////
+      class ZYPP_API RpmPackageVerifyPool : private base::NonCopyable
+      {
+      public:
+        /** rpm's output for a queued package. */
+        struct Output
+        {
+          int exitCode = -1;				///< rpm's exit code
+          std::vector<std::string> lines;		///< rpm's verbose output
+          std::chrono::microseconds verifyTime { 0 };	///< time spent checking (not waiting for) the package
+        };
+
+        class Stream;
+
+      public:
+        /** Verify against the keyring of the rpm database in \a root_r,
+         * running at most \a maxThreads_r checks at once (\c 0 means one per CPU core).
+         */
+        RpmPackageVerifyPool( const Pathname & root_r, size_t maxThreads_r = 0 );
+
+        /** Checks not yet started are dropped, running ones are waited for. */
+        ~RpmPackageVerifyPool();
+
+        /** The rpm database root. */
+        const Pathname & root() const;
+
+        /** Max. number of checks running at once. */
+        size_t maxThreads() const;
+
+        /** Number of queued files not yet taken. */
+        size_t size() const;
+
+        /** Queue the check of \a path_r.
+         * \returns \c false if the file can not be opened.
+         */
+        bool submit( const Pathname & path_r );
+
+        /** Start a check rpm is fed by the returned \ref Stream. */
+        shared_ptr<Stream> stream() const;
+
+        /** Queue the check fed by \a stream_r for the complete file \a path_r.
+         * The stream takes no more data then. The time spent checking is the time
+         * rpm needs after the stream is queued.
+         * \returns \c false if rpm did not take all data of \a path_r, it must
+         * then be queued or checked as usual.
+         */
+        bool submit( Stream & stream_r, const Pathname & path_r );
+
+        /** Whether \a path_r is queued and not yet taken. */
+        bool queued( const Pathname & path_r ) const;
+
+        /** Whether the workers are done with \a path_r, so \ref take will not block. */
+        bool ready( const Pathname & path_r ) const;
+
+        /** rpm's output for \a path_r, which is removed from the pool.
+         * Waits for the workers if necessary. Returns no result if \a path_r is not
+         * queued, was changed or rpm failed, it must then be checked as usual.
+         */
+        std::optional<Output> take( const Pathname & path_r );
+
+      public:
+        class Impl;
+      private:
+        RW_pointer<Impl> _pimpl;
+      };
+
+      ///////////////////////////////////////////////////////////////////
+      /// \class RpmPackageVerifyPool::Stream
+      /// \brief A package check rpm is fed with the data as it arrives.
+      ///
+      /// rpm reads the package from a pipe. It verifies the signature header
+      /// once it has arrived and computes the payload digest as the data is
+      /// written. A stream not queued by \ref RpmPackageVerifyPool::submit
+      /// is dropped when it is destroyed.
+      ///////////////////////////////////////////////////////////////////
+      class ZYPP_API RpmPackageVerifyPool::Stream : private base::NonCopyable
+      {
+        friend class RpmPackageVerifyPool;
+      public:
+        ~Stream();
+
+        /** Pass the next \a len_r bytes of the package to rpm.
+         * \returns \c false if rpm takes no more data (the stream is broken).
+         */
+        bool write( const char * data_r, size_t len_r );
+
+        /** Number of bytes passed to rpm. */
+        off_t size() const;
+
+      public:
+        class Impl;
+      private:
+        Stream( const Pathname & root_r );
+        RW_pointer<Impl> _pimpl;
+      };
+
+    } // namespace rpm
+  } // namespace target
+} // namespace zypp
+
+#endif // ZYPP_TARGET_RPM_RPMPACKAGEVERIFYPOOL_H
@@ -113,12 +113,7 @@ public:
     ::rpmtsSetRootDir( _ts, _root.c_str() );
 
     // open database (creates a missing one on the fly)
-    OnScopeExit cleanup;
-    if ( _dbPath != internal::rpmDefaultDbPath() ) {
-      // temp set %{_dbpath} macro for rpmtsOpenDB
-      cleanup.setDispose( &macroResetDbpath );
-      macroSetDbpath( _dbPath );
-    }
+    OnScopeExit cleanup { tmpDbPath( _dbPath ) };	// temp set %{_dbpath} macro for rpmtsOpenDB
     int res = ::rpmtsOpenDB( _ts, (readonly_r ? O_RDONLY : O_RDWR ) );
     if ( res ) {
       ERR << "rpmdbOpen error(" << res << "): " << *this << endl;
@@ -126,12 +121,6 @@ public:
     }
   }
 
-private:
-  static void macroSetDbpath( const Pathname & dppath_r )
-  { ::addMacro( NULL, "_dbpath", NULL, dppath_r.asString().c_str(), RMIL_CMDLINE ); }
-
-  static void macroResetDbpath()
-  { macroSetDbpath( internal::rpmDefaultDbPath() ); }
 };
 
 ///////////////////////////////////////////////////////////////////
@@ -168,6 +157,20 @@ std::string librpmDb::expand( const std::string & macro_r )
   return std::string();
 }
 
+OnScopeExit librpmDb::tmpDbPath( const Pathname & dbPath_r )
+{
+  static const auto macroSetDbpath = []( const Pathname & dppath_r ) {
+    ::addMacro( NULL, "_dbpath", NULL, dppath_r.asString().c_str(), RMIL_CMDLINE );
+  };
+
+  OnScopeExit ret;
+  if ( globalInit() && dbPath_r != internal::rpmDefaultDbPath() ) {
+    ret.setDispose( [](){ macroSetDbpath( internal::rpmDefaultDbPath() ); } );
+    macroSetDbpath( dbPath_r );
+  }
+  return ret;
+}
+
 Pathname librpmDb::suggestedDbPath( const Pathname & root_r )
 {
   if ( ! root_r.absolute() )
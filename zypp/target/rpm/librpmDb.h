@@ -17,6 +17,7 @@
 #include <zypp/base/ReferenceCounted.h>
 #include <zypp/base/NonCopyable.h>
 #include <zypp/base/PtrTypes.h>
+#include <zypp-core/AutoDispose.h>
 #include <zypp/PathInfo.h>
 #include <zypp/target/rpm/RpmHeader.h>
 #include <zypp/target/rpm/RpmException.h>
@@ -84,6 +85,14 @@ public:
    **/
   static std::string expand( const std::string & macro_r );
 
+  /**
+   * Temporarily set librpm's %{_dbpath} macro to \a dbPath_r.
+   * For code opening the rpmdb via librpm on its own (like libsolv's
+   * rpmdb reader). The default is restored when the returned guard
+   * goes out of scope.
+   **/
+  static OnScopeExit tmpDbPath( const Pathname & dbPath_r );
+
   /**
    * \return The preferred location of the rpmdb below \a root_r.
    * It's the location of an already existing db, otherwise the
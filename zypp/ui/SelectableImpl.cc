@@ -10,6 +10,9 @@
  *
 */
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 //#include <zypp/base/Logger.h>
 
 #include <zypp/ui/SelectableImpl.h>
@@ -313,12 +316,119 @@ namespace zypp
     };
     ///////////////////////////////////////////////////////////////////
 
+    namespace
+    {
+      /** Packed \ref SelectableTraits::AVOrder rank of an available item.
+       * Computed once when the Selectable is built, i.e. once per pool serial.
+       * Arch and Edition are ranked within the ident, so sorting needs no
+       * string compare, repo or repodata lookup.
+       *
+       * \c _hi holds (MSB first) 'not blacklisted', the repo priority, the arch
+       * rank and the edition rank; \c _lo the buildtime and the repo subpriority.
+       * Larger is better; the solvable id is the final (ascending) tie-break.
+       *
+       * \note \ref AVOrder ignores the arch if one of the items is \c noarch,
+       * which is not a strict weak order. Here \c noarch is ranked like the ident's
+       * best arch, so noarch and best arch items still compete on the edition.
+       */
+      struct AVKey
+      {
+        uint64_t _hi;
+        uint64_t _lo;
+        sat::detail::IdType _id;
+        PoolItem _pi;
+
+        bool operator<( const AVKey & rhs ) const
+        {
+          if ( _hi != rhs._hi )
+            return _hi > rhs._hi;
+          if ( _lo != rhs._lo )
+            return _lo > rhs._lo;
+          return _id < rhs._id;
+        }
+      };
+
+      /** Map a signed to an unsigned value preserving the order. */
+      inline uint32_t biased( int val_r )
+      { return uint32_t(val_r) ^ 0x80000000U; }
+
+      /** Rank the distinct values (by IdString id) of \a items_r; equal comparing values share a rank. */
+      template <class Tp, class TGetter>
+      std::unordered_map<IdString::IdType,uint32_t> rankWithinIdent( const std::vector<PoolItem> & items_r, TGetter get_r )
+      {
+        std::vector<Tp> values;
+        std::unordered_set<IdString::IdType> seen;
+        for ( const PoolItem & pi : items_r )
+        {
+          Tp val( get_r( pi ) );
+          if ( seen.insert( val.id() ).second )
+            values.push_back( val );
+        }
+        std::sort( values.begin(), values.end(), []( const Tp & lhs, const Tp & rhs ) { return lhs.compare( rhs ) < 0; } );
+
+        std::unordered_map<IdString::IdType,uint32_t> ret;
+        uint32_t rank = 0;
+        for ( size_t i = 0; i < values.size(); ++i )
+        {
+          if ( i && values[i-1].compare( values[i] ) != 0 )
+            ++rank;
+          ret[values[i].id()] = rank;
+        }
+        return ret;
+      }
+    } // namespace
+
     ///////////////////////////////////////////////////////////////////
     //
     //	CLASS NAME : Selectable::Impl
     //
     ///////////////////////////////////////////////////////////////////
 
+    void Selectable::Impl::insertAvailable( std::vector<PoolItem> && items_r )
+    {
+      if ( items_r.size() < 2 )
+      {
+        _availableItems.insert( items_r.begin(), items_r.end() );
+        return;
+      }
+
+      auto archRank( rankWithinIdent<Arch>( items_r, []( const PoolItem & pi ) { return pi.arch(); } ) );
+      auto evrRank( rankWithinIdent<Edition>( items_r, []( const PoolItem & pi ) { return pi.edition(); } ) );
+
+      uint32_t noarchRank = 0;
+      for ( const auto & [id,rank] : archRank )
+      {
+        if ( id != Arch_noarch.id() && rank > noarchRank )
+          noarchRank = rank;
+      }
+      archRank[Arch_noarch.id()] = noarchRank;
+
+      std::vector<AVKey> keys;
+      keys.reserve( items_r.size() );
+      for ( const PoolItem & pi : items_r )
+      {
+        sat::Solvable solv( pi.satSolvable() );
+        Repository repo( solv.repository() );
+        Date::ValueType buildtime = solv.buildtime();
+
+        AVKey key;
+        key._hi = uint64_t(!pi.isBlacklisted()) << 63
+                | uint64_t(biased( repo.satInternalPriority() )) << 31
+                | uint64_t(std::min( archRank[solv.arch().id()], 0x7ffU )) << 20
+                | uint64_t(std::min( evrRank[solv.edition().id()], 0xfffffU ));
+        key._lo = uint64_t(std::clamp<Date::ValueType>( buildtime, 0, 0xffffffff )) << 32
+                | uint64_t(biased( repo.satInternalSubPriority() ));
+        key._id = solv.id();
+        key._pi = pi;
+        keys.push_back( std::move(key) );
+      }
+      std::sort( keys.begin(), keys.end() );
+
+      // Appending in AVOrder needs a single compare per item to confirm the position.
+      for ( const AVKey & key : keys )
+        _availableItems.insert( _availableItems.end(), key._pi );
+    }
+
     Status Selectable::Impl::status() const
     {
       PoolItem cand( candidateObj() );
@@ -66,13 +66,15 @@ namespace zypp
       , _kind( kind_r )
       , _name( name_r )
       {
+        std::vector<PoolItem> available;
         for_( it, begin_r, end_r )
         {
           if ( it->status().isInstalled() )
             _installedItems.insert( *it );
           else
-            _availableItems.insert( *it );
+            available.push_back( *it );
         }
+        insertAvailable( std::move(available) );
       }
 
     public:
@@ -526,6 +528,10 @@ namespace zypp
       }
 
 
+    private:
+      /** Fill \ref _availableItems with \a items_r, presorted by precomputed keys. */
+      void insertAvailable( std::vector<PoolItem> && items_r );
+
     private:
       const IdString         _ident;
       const ResKind          _kind;
@@ -22,6 +22,7 @@
 #include <zypp/DiskUsageCounter.h>
 #include <zypp/ZConfig.h>
 #include <zypp/sat/Pool.h>
+#include <zypp/sat/PoolSnapshot.h>
 #include <zypp/PoolItem.h>
 
 #include <zypp/ZYppCallbacks.h>	// JobReport::instance
@@ -133,7 +134,10 @@ namespace zypp
     //	METHOD TYPE : Destructor
     //
     ZYppImpl::~ZYppImpl()
-    {}
+    {
+      // Target and repos are loaded by now.
+      sat::PoolSnapshot::saveRemembered();
+    }
 
     //------------------------------------------------------------------------
     // add/remove resolvables